@@ -176,6 +176,12 @@ CF_PRIVATE os_log_t _CFOSLog(void);
 
 CF_PRIVATE CFIndex __CFActiveProcessorCount(void);
 
+// Options for CFSortIndexes(); the values match NSSortOptions
+enum {
+    kCFSortConcurrent = (1 << 0),
+    kCFSortStable = (1 << 4),
+};
+
 #ifndef CLANG_ANALYZER_NORETURN
 #if __has_feature(attribute_analyzer_noreturn)
 #define CLANG_ANALYZER_NORETURN __attribute__((analyzer_noreturn))
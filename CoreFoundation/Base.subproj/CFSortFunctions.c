@@ -57,11 +57,6 @@ enum {
 
 #endif
 
-enum {
-    kCFSortConcurrent = (1 << 0),
-    kCFSortStable = (1 << 4),
-};
-
 typedef CFIndex VALUE_TYPE;
 typedef CFIndex INDEX_TYPE;
 typedef CFComparisonResult CMP_RESULT_TYPE;
@@ -302,13 +297,11 @@ _CF_SORT_INDEXES_EXPORT void CFSortIndexes(CFIndex *indexBuffer, CFIndex count,
         for (CFIndex idx = 0; idx < count; idx++) indexBuffer[idx] = idx;
     } else {
         /* Specifically hard-coded to 8; the count has to be very large before more chunks and/or cores is worthwhile. */
-        dispatch_queue_t q = dispatch_queue_create(__CF_QUEUE_NAME("NSSortIndexes"), DISPATCH_QUEUE_CONCURRENT);
         CFIndex sz = ((((size_t)count + 15) / 16) * 16) / 8;
         dispatch_apply(8, DISPATCH_APPLY_CURRENT_ROOT_QUEUE, ^(size_t n) {
                 CFIndex idx = n * sz, lim = __CFMin(idx + sz, count);
                 for (; idx < lim; idx++) indexBuffer[idx] = idx;
             });
-        dispatch_release(q);
     }
 #else
     for (CFIndex idx = 0; idx < count; idx++) indexBuffer[idx] = idx;
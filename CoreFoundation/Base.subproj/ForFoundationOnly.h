@@ -381,6 +381,21 @@ CF_EXPORT CFIndex __CFBinaryPlistWriteToStreamWithEstimate(CFPropertyListRef pli
 CF_EXPORT CFIndex __CFBinaryPlistWriteToStreamWithOptions(CFPropertyListRef plist, CFTypeRef stream, uint64_t estimate, CFOptionFlags options); // will be removed soon
 CF_EXPORT CFIndex __CFBinaryPlistWrite(CFPropertyListRef plist, CFTypeRef stream, uint64_t estimate, CFOptionFlags options, CFErrorRef *error);
 
+// A binary property list opened for reading in place. Objects are named by their offset in the data and nothing is decoded until an object is copied, so looking up a few values in a large file only touches the pages on the way to them. Files are memory mapped where the platform allows.
+typedef struct __CFBinaryPlistReader *_CFBinaryPlistReaderRef;
+CF_CROSS_PLATFORM_EXPORT _CFBinaryPlistReaderRef _Nullable _CFBinaryPlistReaderCreateWithData(CFAllocatorRef _Nullable allocator, CFDataRef data, CFErrorRef _Nullable * _Nullable error);
+CF_CROSS_PLATFORM_EXPORT _CFBinaryPlistReaderRef _Nullable _CFBinaryPlistReaderCreateWithContentsOfFile(CFAllocatorRef _Nullable allocator, CFStringRef path, CFErrorRef _Nullable * _Nullable error);
+CF_CROSS_PLATFORM_EXPORT void _CFBinaryPlistReaderRelease(_CFBinaryPlistReaderRef reader);
+CF_CROSS_PLATFORM_EXPORT uint64_t _CFBinaryPlistReaderGetTopLevelObject(_CFBinaryPlistReaderRef reader);
+// The type ID of the object that copying would produce, or _kCFRuntimeNotATypeID if the object is malformed.
+CF_CROSS_PLATFORM_EXPORT CFTypeID _CFBinaryPlistReaderGetTypeID(_CFBinaryPlistReaderRef reader, uint64_t object);
+// The number of values in an array or set, or of entries in a dictionary; -1 for any other object.
+CF_CROSS_PLATFORM_EXPORT CFIndex _CFBinaryPlistReaderGetCount(_CFBinaryPlistReaderRef reader, uint64_t object);
+CF_CROSS_PLATFORM_EXPORT bool _CFBinaryPlistReaderGetObjectAtIndex(_CFBinaryPlistReaderRef reader, uint64_t array, CFIndex idx, uint64_t *outObject);
+CF_CROSS_PLATFORM_EXPORT bool _CFBinaryPlistReaderGetObjectForKey(_CFBinaryPlistReaderRef reader, uint64_t dictionary, CFTypeRef key, uint64_t *outObject);
+CF_CROSS_PLATFORM_EXPORT bool _CFBinaryPlistReaderGetKeyAndObjectAtIndex(_CFBinaryPlistReaderRef reader, uint64_t dictionary, CFIndex idx, uint64_t *outKey, uint64_t *outObject);
+CF_CROSS_PLATFORM_EXPORT CFPropertyListRef _Nullable _CFBinaryPlistReaderCopyObject(_CFBinaryPlistReaderRef reader, uint64_t object, CFOptionFlags mutabilityOption);
+
 // ---- Used by property list parsing in Foundation
 
 CF_EXPORT CFTypeRef _CFPropertyListCreateFromXMLData(CFAllocatorRef _Nullable allocator, CFDataRef xmlData, CFOptionFlags option, CFStringRef _Nullable * _Nullable errorString, Boolean allowNewTypes, CFPropertyListFormat *_Nullable format);
@@ -571,6 +586,12 @@ CF_EXPORT void *_CFNumberFormatterGetFormatter(CFNumberFormatterRef formatter);
 CF_CROSS_PLATFORM_EXPORT void _CFDataInit(CFMutableDataRef memory, CFOptionFlags variety, CFIndex capacity, const uint8_t *_Nullable bytes, CFIndex length, Boolean noCopy);
 CF_EXPORT CFRange _CFDataFindBytes(CFDataRef data, CFDataRef dataToFind, CFRange searchRange, CFDataSearchFlags compareOptions);
 
+// A search for one needle, planned once so that it can be run over any number of buffers. The needle is copied.
+typedef struct __CFDataSearcher *_CFDataSearcherRef;
+CF_CROSS_PLATFORM_EXPORT _CFDataSearcherRef _CFDataSearcherCreate(CFAllocatorRef _Nullable allocator, const uint8_t *_Nullable needle, CFIndex needleLength, CFDataSearchFlags options);
+CF_CROSS_PLATFORM_EXPORT CFRange _CFDataSearcherFindInBytes(_CFDataSearcherRef searcher, const uint8_t *_Nullable bytes, CFIndex length, CFRange searchRange);
+CF_CROSS_PLATFORM_EXPORT void _CFDataSearcherRelease(_CFDataSearcherRef searcher);
+
 
 #if TARGET_OS_MAC
     #if !defined(__CFReadTSR)
@@ -930,6 +930,37 @@ static CFComparisonResult __CFArrayCompareValues(const void *v1, const void *v2,
     return (CFComparisonResult)(INVOKE_CALLBACK3(context->func, *val1, *val2, context->context));
 }
 
+// Sorts a buffer of values in place. Unlike CFQSortArray(), this can spread
+// the work across cores when opts contains kCFSortConcurrent.
+static void __CFArraySortBuffer(const void **values, CFIndex count, CFOptionFlags opts, struct _acompareContext *ctx) {
+    if (!(opts & kCFSortConcurrent)) {
+        CFQSortArray(values, count, sizeof(void *), (CFComparatorFunction)__CFArrayCompareValues, ctx);
+        return;
+    }
+    CFIndex *indexes = (CFIndex *)CFAllocatorAllocate(kCFAllocatorSystemDefault, count * sizeof(CFIndex), 0);
+    const void **sorted = (const void **)CFAllocatorAllocate(kCFAllocatorSystemDefault, count * sizeof(void *), 0);
+    CFSortIndexes(indexes, count, opts, ^(CFIndex a, CFIndex b) { return __CFArrayCompareValues(&values[a], &values[b], ctx); });
+    for (CFIndex idx = 0; idx < count; idx++) {
+        sorted[idx] = values[indexes[idx]];
+    }
+    memmove(values, sorted, count * sizeof(void *));
+    CFAllocatorDeallocate(kCFAllocatorSystemDefault, sorted);
+    CFAllocatorDeallocate(kCFAllocatorSystemDefault, indexes);
+}
+
+#define __kCFArrayConcurrentSortThreshold (16 * 1024)
+
+// CF's own comparators have no side effects and may be called from several
+// threads at once, so large sorts using them are spread across cores without
+// being asked. Any other comparator is only called concurrently on request.
+static CFOptionFlags __CFArrayDefaultSortOptions(CFComparatorFunction comparator, CFIndex count) {
+    if (count < __kCFArrayConcurrentSortThreshold) return 0;
+    if (comparator == (CFComparatorFunction)CFStringCompare || comparator == (CFComparatorFunction)CFNumberCompare || comparator == (CFComparatorFunction)CFDateCompare) {
+        return kCFSortConcurrent;
+    }
+    return 0;
+}
+
 CF_INLINE void __CFZSort(CFMutableArrayRef array, CFRange range, CFComparatorFunction comparator, void *context) {
     CFIndex cnt = range.length;
     while (1 < cnt) {
@@ -996,7 +1027,7 @@ void CFArraySortValues(CFMutableArrayRef array, CFRange range, CFComparatorFunct
     struct _acompareContext ctx;
     ctx.func = comparator;
     ctx.context = context;
-    CFQSortArray(values, range.length, sizeof(void *), (CFComparatorFunction)__CFArrayCompareValues, &ctx);
+    __CFArraySortBuffer(values, range.length, __CFArrayDefaultSortOptions(comparator, range.length), &ctx);
     if (!immutable) CFArrayReplaceValues(array, range, values, range.length);
     if (values != buffer) CFAllocatorDeallocate(kCFAllocatorSystemDefault, values);
 }
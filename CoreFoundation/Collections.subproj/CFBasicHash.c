@@ -19,6 +19,9 @@
 #include <dispatch/dispatch.h>
 #endif
 #include "CFOverflow.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #if TARGET_OS_MAC
 #define __SetLastAllocationEventName(A, B) do { if (__CFOASafe && (A)) __CFSetLastAllocationEventName(A, B); } while (0)
@@ -459,6 +462,78 @@ CF_INLINE void __CFBasicHashSetValues(CFBasicHashRef ht, CFBasicHashValue *ptr)
     __AssignWithWriteBarrier(&ht->pointers[0], ptr);
 }
 
+// Grouped hashing uses power-of-two tables and keeps one metadata byte per
+// bucket just past the end of the value-store: an empty or deleted marker,
+// or the low 7 bits of the key's mixed hash code. A lookup compares a whole
+// group of metadata bytes at once and only calls out to the equality
+// callback for buckets whose fingerprint matches. Tables smaller than a
+// group are padded to a full group with bytes which never match.
+#define __CFBasicHashGroupWidth		16
+#define __CFBasicHashMetadataEmpty	0x80
+#define __CFBasicHashMetadataDeleted	0xFE
+#define __CFBasicHashMetadataPad	0xFF
+
+#if TARGET_RT_64_BIT
+#define __CFBasicHashGroupedMaxIndex	31
+#else
+#define __CFBasicHashGroupedMaxIndex	26
+#endif
+
+CF_INLINE uintptr_t __CFBasicHashGetNumBucketsForIndex(CFConstBasicHashRef ht, CFIndex num_buckets_idx) {
+    if (__kCFBasicHashGroupedHashingValue == ht->bits.hash_style) {
+        return (0 == num_buckets_idx || __CFBasicHashGroupedMaxIndex < num_buckets_idx) ? 0 : ((uintptr_t)2 << num_buckets_idx);
+    }
+    return __CFBasicHashTableSizes[num_buckets_idx];
+}
+
+CF_INLINE CFIndex __CFBasicHashGetMetadataSize(CFIndex num_buckets) {
+    return (num_buckets < __CFBasicHashGroupWidth) ? __CFBasicHashGroupWidth : num_buckets;
+}
+
+// size in bytes of the value-store, including the metadata for grouped hashing
+CF_INLINE CFIndex __CFBasicHashGetValuesSize(CFConstBasicHashRef ht, CFIndex num_buckets) {
+    CFIndex size = num_buckets * sizeof(CFBasicHashValue);
+    if (__kCFBasicHashGroupedHashingValue == ht->bits.hash_style) {
+        size += __CFBasicHashGetMetadataSize(num_buckets);
+    }
+    return size;
+}
+
+CF_INLINE uint8_t *__CFBasicHashGetMetadata(CFConstBasicHashRef ht) {
+    return (uint8_t *)(__CFBasicHashGetValues(ht) + __CFBasicHashGetNumBucketsForIndex(ht, ht->bits.num_buckets_idx));
+}
+
+CF_INLINE void __CFBasicHashInitMetadata(uint8_t *metadata, CFIndex num_buckets) {
+    memset(metadata, __CFBasicHashMetadataEmpty, num_buckets);
+    memset(metadata + num_buckets, __CFBasicHashMetadataPad, __CFBasicHashGetMetadataSize(num_buckets) - num_buckets);
+}
+
+// Hash codes of pointers and small integers carry little entropy in their
+// low bits, which is all a power-of-two mask looks at, so spread every bit
+// of the hash code into the low half first.
+CF_INLINE uint64_t __CFBasicHashGroupedMix(CFHashCode hash_code) {
+    uint64_t mixed = (uint64_t)hash_code * 0x9E3779B97F4A7C15ULL;
+    return mixed ^ (mixed >> 32);
+}
+
+CF_INLINE uint8_t __CFBasicHashGroupedFingerprint(CFHashCode hash_code) {
+    return (uint8_t)(__CFBasicHashGroupedMix(hash_code) & 0x7F);
+}
+
+// Returns a mask with bit i set when byte i of the group equals byte
+CF_INLINE uint32_t __CFBasicHashGroupMatch(const uint8_t *group, uint8_t byte) {
+#if defined(__SSE2__)
+    __m128i ctrl = _mm_loadu_si128((const __m128i *)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)byte)));
+#else
+    uint32_t mask = 0;
+    for (CFIndex idx = 0; idx < __CFBasicHashGroupWidth; idx++) {
+        if (group[idx] == byte) mask |= (1U << idx);
+    }
+    return mask;
+#endif
+}
+
 CF_INLINE CFBasicHashValue *__CFBasicHashGetKeys(CFConstBasicHashRef ht) {
     return (CFBasicHashValue *)ht->pointers[ht->bits.keys_offset];
 }
@@ -559,7 +634,7 @@ CF_INLINE void __CFBasicHashBumpCounts(CFBasicHashRef ht) {
     case 0: {
         uint8_t *counts08 = (uint8_t *)counts;
         ht->bits.counts_width = 1;
-        CFIndex num_buckets = __CFBasicHashTableSizes[ht->bits.num_buckets_idx];
+        CFIndex num_buckets = __CFBasicHashGetNumBucketsForIndex(ht, ht->bits.num_buckets_idx);
         uint16_t *counts16 = (uint16_t *)__CFBasicHashAllocateMemory(ht, num_buckets, 2, false, false);
         if (!counts16) HALT;
         __SetLastAllocationEventName(counts16, "CFBasicHash (count-store)");
@@ -573,7 +648,7 @@ CF_INLINE void __CFBasicHashBumpCounts(CFBasicHashRef ht) {
     case 1: {
         uint16_t *counts16 = (uint16_t *)counts;
         ht->bits.counts_width = 2;
-        CFIndex num_buckets = __CFBasicHashTableSizes[ht->bits.num_buckets_idx];
+        CFIndex num_buckets = __CFBasicHashGetNumBucketsForIndex(ht, ht->bits.num_buckets_idx);
         uint32_t *counts32 = (uint32_t *)__CFBasicHashAllocateMemory(ht, num_buckets, 4, false, false);
         if (!counts32) HALT;
         __SetLastAllocationEventName(counts32, "CFBasicHash (count-store)");
@@ -587,7 +662,7 @@ CF_INLINE void __CFBasicHashBumpCounts(CFBasicHashRef ht) {
     case 2: {
         uint32_t *counts32 = (uint32_t *)counts;
         ht->bits.counts_width = 3;
-        CFIndex num_buckets = __CFBasicHashTableSizes[ht->bits.num_buckets_idx];
+        CFIndex num_buckets = __CFBasicHashGetNumBucketsForIndex(ht, ht->bits.num_buckets_idx);
         uint64_t *counts64 = (uint64_t *)__CFBasicHashAllocateMemory(ht, num_buckets, 8, false, false);
         if (!counts64) HALT;
         __SetLastAllocationEventName(counts64, "CFBasicHash (count-store)");
@@ -676,6 +751,12 @@ CF_INLINE void __CFBasicHashSetHashes(CFBasicHashRef ht, uintptr_t *ptr) {
 
 // to expose the load factor, expose this function to customization
 CF_INLINE CFIndex __CFBasicHashGetCapacityForNumBuckets(CFConstBasicHashRef ht, CFIndex num_buckets_idx) {
+    if (__kCFBasicHashGroupedHashingValue == ht->bits.hash_style) {
+        // 7/8 load factor; the smallest tables always keep one empty bucket
+        CFIndex num_buckets = __CFBasicHashGetNumBucketsForIndex(ht, num_buckets_idx);
+        if (num_buckets < 8) return (0 < num_buckets) ? num_buckets - 1 : 0;
+        return num_buckets - num_buckets / 8;
+    }
     return __CFBasicHashTableCapacities[num_buckets_idx];
 }
 
@@ -688,7 +769,7 @@ CF_INLINE CFIndex __CFBasicHashGetNumBucketsIndexForCapacity(CFConstBasicHashRef
 }
 
 CF_PRIVATE CFIndex CFBasicHashGetNumBuckets(CFConstBasicHashRef ht) {
-    return __CFBasicHashTableSizes[ht->bits.num_buckets_idx];
+    return __CFBasicHashGetNumBucketsForIndex(ht, ht->bits.num_buckets_idx);
 }
 
 CF_PRIVATE CFIndex CFBasicHashGetCapacity(CFConstBasicHashRef ht) {
@@ -764,6 +845,30 @@ static uintptr_t __CFBasicHashFold(uintptr_t dividend, uint8_t idx) {
 #endif
 
 
+#define FIND_BUCKET_NAME		___CFBasicHashFindBucket_Grouped
+#define FIND_BUCKET_HASH_STYLE		0
+#define FIND_BUCKET_FOR_REHASH		0
+#define FIND_BUCKET_FOR_INDIRECT_KEY	0
+#include "CFBasicHashFindBucket.m"
+
+#define FIND_BUCKET_NAME		___CFBasicHashFindBucket_Grouped_NoCollision
+#define FIND_BUCKET_HASH_STYLE		0
+#define FIND_BUCKET_FOR_REHASH		1
+#define FIND_BUCKET_FOR_INDIRECT_KEY	0
+#include "CFBasicHashFindBucket.m"
+
+#define FIND_BUCKET_NAME		___CFBasicHashFindBucket_Grouped_Indirect
+#define FIND_BUCKET_HASH_STYLE		0
+#define FIND_BUCKET_FOR_REHASH		0
+#define FIND_BUCKET_FOR_INDIRECT_KEY	1
+#include "CFBasicHashFindBucket.m"
+
+#define FIND_BUCKET_NAME		___CFBasicHashFindBucket_Grouped_Indirect_NoCollision
+#define FIND_BUCKET_HASH_STYLE		0
+#define FIND_BUCKET_FOR_REHASH		1
+#define FIND_BUCKET_FOR_INDIRECT_KEY	1
+#include "CFBasicHashFindBucket.m"
+
 #define FIND_BUCKET_NAME		___CFBasicHashFindBucket_Linear
 #define FIND_BUCKET_HASH_STYLE		1
 #define FIND_BUCKET_FOR_REHASH		0
@@ -837,22 +942,26 @@ static uintptr_t __CFBasicHashFold(uintptr_t dividend, uint8_t idx) {
 #include "CFBasicHashFindBucket.m"
 
 
-CF_INLINE CFBasicHashBucket __CFBasicHashFindBucket(CFConstBasicHashRef ht, uintptr_t stack_key) {
+// If out_hash_code is non-NULL and the table is not empty, it receives the
+// hash code of stack_key, so that an add which follows does not rehash it.
+CF_INLINE CFBasicHashBucket __CFBasicHashFindBucket(CFConstBasicHashRef ht, uintptr_t stack_key, CFHashCode *out_hash_code) {
     if (0 == ht->bits.num_buckets_idx) {
         CFBasicHashBucket result = {kCFNotFound, 0UL, 0UL, 0};
         return result;
     }
     if (ht->bits.indirect_keys) {
         switch (ht->bits.hash_style) {
-        case __kCFBasicHashLinearHashingValue: return ___CFBasicHashFindBucket_Linear_Indirect(ht, stack_key);
-        case __kCFBasicHashDoubleHashingValue: return ___CFBasicHashFindBucket_Double_Indirect(ht, stack_key);
-        case __kCFBasicHashExponentialHashingValue: return ___CFBasicHashFindBucket_Exponential_Indirect(ht, stack_key);
+        case __kCFBasicHashGroupedHashingValue: return ___CFBasicHashFindBucket_Grouped_Indirect(ht, stack_key, out_hash_code);
+        case __kCFBasicHashLinearHashingValue: return ___CFBasicHashFindBucket_Linear_Indirect(ht, stack_key, out_hash_code);
+        case __kCFBasicHashDoubleHashingValue: return ___CFBasicHashFindBucket_Double_Indirect(ht, stack_key, out_hash_code);
+        case __kCFBasicHashExponentialHashingValue: return ___CFBasicHashFindBucket_Exponential_Indirect(ht, stack_key, out_hash_code);
         }
     } else {
         switch (ht->bits.hash_style) {
-        case __kCFBasicHashLinearHashingValue: return ___CFBasicHashFindBucket_Linear(ht, stack_key);
-        case __kCFBasicHashDoubleHashingValue: return ___CFBasicHashFindBucket_Double(ht, stack_key);
-        case __kCFBasicHashExponentialHashingValue: return ___CFBasicHashFindBucket_Exponential(ht, stack_key);
+        case __kCFBasicHashGroupedHashingValue: return ___CFBasicHashFindBucket_Grouped(ht, stack_key, out_hash_code);
+        case __kCFBasicHashLinearHashingValue: return ___CFBasicHashFindBucket_Linear(ht, stack_key, out_hash_code);
+        case __kCFBasicHashDoubleHashingValue: return ___CFBasicHashFindBucket_Double(ht, stack_key, out_hash_code);
+        case __kCFBasicHashExponentialHashingValue: return ___CFBasicHashFindBucket_Exponential(ht, stack_key, out_hash_code);
         }
     }
     HALT;
@@ -866,12 +975,14 @@ CF_INLINE CFIndex __CFBasicHashFindBucket_NoCollision(CFConstBasicHashRef ht, ui
     }
     if (ht->bits.indirect_keys) {
         switch (ht->bits.hash_style) {
+        case __kCFBasicHashGroupedHashingValue: return ___CFBasicHashFindBucket_Grouped_Indirect_NoCollision(ht, stack_key, key_hash);
         case __kCFBasicHashLinearHashingValue: return ___CFBasicHashFindBucket_Linear_Indirect_NoCollision(ht, stack_key, key_hash);
         case __kCFBasicHashDoubleHashingValue: return ___CFBasicHashFindBucket_Double_Indirect_NoCollision(ht, stack_key, key_hash);
         case __kCFBasicHashExponentialHashingValue: return ___CFBasicHashFindBucket_Exponential_Indirect_NoCollision(ht, stack_key, key_hash);
         }
     } else {
         switch (ht->bits.hash_style) {
+        case __kCFBasicHashGroupedHashingValue: return ___CFBasicHashFindBucket_Grouped_NoCollision(ht, stack_key, key_hash);
         case __kCFBasicHashLinearHashingValue: return ___CFBasicHashFindBucket_Linear_NoCollision(ht, stack_key, key_hash);
         case __kCFBasicHashDoubleHashingValue: return ___CFBasicHashFindBucket_Double_NoCollision(ht, stack_key, key_hash);
         case __kCFBasicHashExponentialHashingValue: return ___CFBasicHashFindBucket_Exponential_NoCollision(ht, stack_key, key_hash);
@@ -886,7 +997,7 @@ CF_PRIVATE CFBasicHashBucket CFBasicHashFindBucket(CFConstBasicHashRef ht, uintp
         CFBasicHashBucket result = {kCFNotFound, 0UL, 0UL, 0};
         return result;
     }
-    return __CFBasicHashFindBucket(ht, stack_key);
+    return __CFBasicHashFindBucket(ht, stack_key, NULL);
 }
 
 CF_PRIVATE void CFBasicHashSuppressRC(CFBasicHashRef ht) {
@@ -911,7 +1022,7 @@ CF_PRIVATE CFOptionFlags CFBasicHashGetFlags(CFConstBasicHashRef ht) {
 CF_PRIVATE CFIndex CFBasicHashGetCount(CFConstBasicHashRef ht) {
     if (ht->bits.counts_offset) {
         CFIndex total = 0L;
-        CFIndex cnt = (CFIndex)__CFBasicHashTableSizes[ht->bits.num_buckets_idx];
+        CFIndex cnt = (CFIndex)__CFBasicHashGetNumBucketsForIndex(ht, ht->bits.num_buckets_idx);
         for (CFIndex idx = 0; idx < cnt; idx++) {
             total += __CFBasicHashGetSlotCount(ht, idx);
         }
@@ -927,7 +1038,7 @@ CF_PRIVATE CFIndex CFBasicHashGetCountOfKey(CFConstBasicHashRef ht, uintptr_t st
     if (0L == ht->bits.used_buckets) {
         return 0L;
     }
-    return __CFBasicHashFindBucket(ht, stack_key).count;
+    return __CFBasicHashFindBucket(ht, stack_key, NULL).count;
 }
 
 CF_PRIVATE CFIndex CFBasicHashGetCountOfValue(CFConstBasicHashRef ht, uintptr_t stack_value) {
@@ -938,7 +1049,7 @@ CF_PRIVATE CFIndex CFBasicHashGetCountOfValue(CFConstBasicHashRef ht, uintptr_t
         return 0L;
     }
     if (!(ht->bits.keys_offset)) {
-        return __CFBasicHashFindBucket(ht, stack_value).count;
+        return __CFBasicHashFindBucket(ht, stack_value, NULL).count;
     }
     __block CFIndex total = 0L;
     CFBasicHashApply(ht, ^(CFBasicHashBucket bkt) {
@@ -954,7 +1065,7 @@ CF_PRIVATE Boolean CFBasicHashesAreEqual(CFConstBasicHashRef ht1, CFConstBasicHa
     if (0 == cnt1) return true;
     __block Boolean equal = true;
     CFBasicHashApply(ht1, ^(CFBasicHashBucket bkt1) {
-            CFBasicHashBucket bkt2 = __CFBasicHashFindBucket(ht2, bkt1.weak_key);
+            CFBasicHashBucket bkt2 = __CFBasicHashFindBucket(ht2, bkt1.weak_key, NULL);
             if (bkt1.count != bkt2.count) {
                 equal = false;
                 return (Boolean)false;
@@ -969,7 +1080,7 @@ CF_PRIVATE Boolean CFBasicHashesAreEqual(CFConstBasicHashRef ht1, CFConstBasicHa
 }
 
 CF_PRIVATE void CFBasicHashApply(CFConstBasicHashRef ht, Boolean (^block)(CFBasicHashBucket)) {
-    CFIndex used = (CFIndex)ht->bits.used_buckets, cnt = (CFIndex)__CFBasicHashTableSizes[ht->bits.num_buckets_idx];
+    CFIndex used = (CFIndex)ht->bits.used_buckets, cnt = (CFIndex)__CFBasicHashGetNumBucketsForIndex(ht, ht->bits.num_buckets_idx);
     for (CFIndex idx = 0; 0 < used && idx < cnt; idx++) {
         CFBasicHashBucket bkt = CFBasicHashGetBucket(ht, idx);
         if (0 < bkt.count) {
@@ -984,7 +1095,7 @@ CF_PRIVATE void CFBasicHashApply(CFConstBasicHashRef ht, Boolean (^block)(CFBasi
 CF_PRIVATE void CFBasicHashApplyIndexed(CFConstBasicHashRef ht, CFRange range, Boolean (^block)(CFBasicHashBucket)) {
     if (range.length < 0) HALT;
     if (range.length == 0) return;
-    CFIndex cnt = (CFIndex)__CFBasicHashTableSizes[ht->bits.num_buckets_idx];
+    CFIndex cnt = (CFIndex)__CFBasicHashGetNumBucketsForIndex(ht, ht->bits.num_buckets_idx);
     if (cnt < range.location + range.length) HALT;
     for (CFIndex idx = 0; idx < range.length; idx++) {
         CFBasicHashBucket bkt = CFBasicHashGetBucket(ht, range.location + idx);
@@ -997,7 +1108,7 @@ CF_PRIVATE void CFBasicHashApplyIndexed(CFConstBasicHashRef ht, CFRange range, B
 }
 
 CF_PRIVATE void CFBasicHashGetElements(CFConstBasicHashRef ht, CFIndex bufferslen, uintptr_t *weak_values, uintptr_t *weak_keys) {
-    CFIndex used = (CFIndex)ht->bits.used_buckets, cnt = (CFIndex)__CFBasicHashTableSizes[ht->bits.num_buckets_idx];
+    CFIndex used = (CFIndex)ht->bits.used_buckets, cnt = (CFIndex)__CFBasicHashGetNumBucketsForIndex(ht, ht->bits.num_buckets_idx);
     CFIndex offset = 0;
     for (CFIndex idx = 0; 0 < used && idx < cnt && offset < bufferslen; idx++) {
         CFBasicHashBucket bkt = CFBasicHashGetBucket(ht, idx);
@@ -1019,7 +1130,7 @@ CF_PRIVATE unsigned long __CFBasicHashFastEnumeration(CFConstBasicHashRef ht, st
     }
     state->itemsPtr = (unsigned long *)stackbuffer;
     CFIndex cntx = 0;
-    CFIndex used = (CFIndex)ht->bits.used_buckets, cnt = (CFIndex)__CFBasicHashTableSizes[ht->bits.num_buckets_idx];
+    CFIndex used = (CFIndex)ht->bits.used_buckets, cnt = (CFIndex)__CFBasicHashGetNumBucketsForIndex(ht, ht->bits.num_buckets_idx);
     for (CFIndex idx = (CFIndex)state->state; 0 < used && idx < cnt && cntx < (CFIndex)count; idx++) {
         CFBasicHashBucket bkt = CFBasicHashGetBucket(ht, idx);
         if (0 < bkt.count) {
@@ -1044,7 +1155,7 @@ static void __CFBasicHashDrain(CFBasicHashRef ht) {
     OSAtomicAdd64Barrier(-1 * (int64_t) CFBasicHashGetSize(ht, true), & __CFBasicHashTotalSize);
 #endif
 
-    CFIndex old_num_buckets = __CFBasicHashTableSizes[ht->bits.num_buckets_idx];
+    CFIndex old_num_buckets = __CFBasicHashGetNumBucketsForIndex(ht, ht->bits.num_buckets_idx);
 
     CFAllocatorRef allocator = CFGetAllocator(ht);
 
@@ -1117,18 +1228,21 @@ static void __CFBasicHashRehash(CFBasicHashRef ht, CFIndex newItemCount) {
         }
     }
 
-    CFIndex new_num_buckets = __CFBasicHashTableSizes[new_num_buckets_idx];
-    CFIndex old_num_buckets = __CFBasicHashTableSizes[ht->bits.num_buckets_idx];
+    CFIndex new_num_buckets = __CFBasicHashGetNumBucketsForIndex(ht, new_num_buckets_idx);
+    CFIndex old_num_buckets = __CFBasicHashGetNumBucketsForIndex(ht, ht->bits.num_buckets_idx);
 
     CFBasicHashValue *new_values = NULL, *new_keys = NULL;
     void *new_counts = NULL;
     uintptr_t *new_hashes = NULL;
 
     if (0 < new_num_buckets) {
-        new_values = (CFBasicHashValue *)__CFBasicHashAllocateMemory(ht, new_num_buckets, sizeof(CFBasicHashValue), CFBasicHashHasStrongValues(ht), 0);
+        new_values = (CFBasicHashValue *)__CFBasicHashAllocateMemory(ht, __CFBasicHashGetValuesSize(ht, new_num_buckets), 1, CFBasicHashHasStrongValues(ht), 0);
         if (!new_values) HALT;
         __SetLastAllocationEventName(new_values, "CFBasicHash (value-store)");
         memset(new_values, 0, new_num_buckets * sizeof(CFBasicHashValue));
+        if (__kCFBasicHashGroupedHashingValue == ht->bits.hash_style) {
+            __CFBasicHashInitMetadata((uint8_t *)(new_values + new_num_buckets), new_num_buckets);
+        }
         if (ht->bits.keys_offset) {
             new_keys = (CFBasicHashValue *)__CFBasicHashAllocateMemory(ht, new_num_buckets, sizeof(CFBasicHashValue), CFBasicHashHasStrongKeys(ht), 0);
             if (!new_keys) HALT;
@@ -1186,8 +1300,15 @@ static void __CFBasicHashRehash(CFBasicHashRef ht, CFIndex newItemCount) {
                 if (ht->bits.indirect_keys) {
                     stack_key = __CFBasicHashGetIndirectKey(ht, stack_value);
                 }
-                CFIndex bkt_idx = __CFBasicHashFindBucket_NoCollision(ht, stack_key, old_hashes ? old_hashes[idx] : 0UL);
+                uintptr_t key_hash = old_hashes ? old_hashes[idx] : 0UL;
+                if (__kCFBasicHashGroupedHashingValue == ht->bits.hash_style && 0UL == key_hash) {
+                    key_hash = __CFBasicHashHashKey(ht, stack_key);
+                }
+                CFIndex bkt_idx = __CFBasicHashFindBucket_NoCollision(ht, stack_key, key_hash);
                 __CFBasicHashSetValue(ht, bkt_idx, stack_value, false, false);
+                if (__kCFBasicHashGroupedHashingValue == ht->bits.hash_style) {
+                    __CFBasicHashGetMetadata(ht)[bkt_idx] = __CFBasicHashGroupedFingerprint(key_hash);
+                }
                 if (old_keys) {
                     __CFBasicHashSetKey(ht, bkt_idx, stack_key, false, false);
                 }
@@ -1229,18 +1350,27 @@ CF_PRIVATE void CFBasicHashSetCapacity(CFBasicHashRef ht, CFIndex capacity) {
     }
 }
 
-static void __CFBasicHashAddValue(CFBasicHashRef ht, CFIndex bkt_idx, uintptr_t stack_key, uintptr_t stack_value) {
+// key_hash is the hash code of stack_key when the caller already has it, or 0
+static void __CFBasicHashAddValue(CFBasicHashRef ht, CFIndex bkt_idx, uintptr_t stack_key, uintptr_t stack_value, uintptr_t key_hash) {
     ht->bits.mutations++;
-    if (CFBasicHashGetCapacity(ht) < ht->bits.used_buckets + 1) {
+    Boolean reuse_deleted = (0 <= bkt_idx) && __CFBasicHashIsDeleted(ht, bkt_idx);
+    CFIndex needed = ht->bits.used_buckets + 1;
+    if (__kCFBasicHashGroupedHashingValue == ht->bits.hash_style && !reuse_deleted) {
+        // grouped probing only stops at an empty bucket, so deleted buckets use up capacity until reused
+        needed += ht->bits.deleted;
+    }
+    if (CFBasicHashGetCapacity(ht) < needed) {
         __CFBasicHashRehash(ht, 1);
-        bkt_idx = __CFBasicHashFindBucket_NoCollision(ht, stack_key, 0);
-    } else if (__CFBasicHashIsDeleted(ht, bkt_idx)) {
+        bkt_idx = __CFBasicHashFindBucket_NoCollision(ht, stack_key, key_hash);
+    } else if (reuse_deleted) {
         ht->bits.deleted--;
     }
-    uintptr_t key_hash = 0;
-    if (__CFBasicHashHasHashCache(ht)) {
+    if (0UL == key_hash && (__CFBasicHashHasHashCache(ht) || __kCFBasicHashGroupedHashingValue == ht->bits.hash_style)) {
         key_hash = __CFBasicHashHashKey(ht, stack_key);
     }
+    if (__kCFBasicHashGroupedHashingValue == ht->bits.hash_style) {
+        __CFBasicHashGetMetadata(ht)[bkt_idx] = __CFBasicHashGroupedFingerprint(key_hash);
+    }
     stack_value = __CFBasicHashImportValue(ht, stack_value);
     if (ht->bits.keys_offset) {
         stack_key = __CFBasicHashImportKey(ht, stack_key);
@@ -1282,6 +1412,9 @@ static void __CFBasicHashRemoveValue(CFBasicHashRef ht, CFIndex bkt_idx) {
     if (__CFBasicHashHasHashCache(ht)) {
         __CFBasicHashGetHashes(ht)[bkt_idx] = 0;
     }
+    if (__kCFBasicHashGroupedHashingValue == ht->bits.hash_style) {
+        __CFBasicHashGetMetadata(ht)[bkt_idx] = __CFBasicHashMetadataDeleted;
+    }
     ht->bits.used_buckets--;
     ht->bits.deleted++;
     Boolean do_shrink = false;
@@ -1295,7 +1428,7 @@ static void __CFBasicHashRemoveValue(CFBasicHashRef ht, CFIndex bkt_idx) {
         return;
     }
     do_shrink = (0 == ht->bits.deleted); // .deleted roll-over
-    CFIndex num_buckets = __CFBasicHashTableSizes[ht->bits.num_buckets_idx];
+    CFIndex num_buckets = __CFBasicHashGetNumBucketsForIndex(ht, ht->bits.num_buckets_idx);
     do_shrink = do_shrink || ((20 <= num_buckets) && (num_buckets / 4 <= ht->bits.deleted));
     if (do_shrink) {
         __CFBasicHashRehash(ht, 0);
@@ -1308,7 +1441,8 @@ CF_PRIVATE Boolean CFBasicHashAddValue(CFBasicHashRef ht, uintptr_t stack_key, u
     if (__CFBasicHashSubABOne == stack_key) HALT;
     if (__CFBasicHashSubABZero == stack_value) HALT;
     if (__CFBasicHashSubABOne == stack_value) HALT;
-    CFBasicHashBucket bkt = __CFBasicHashFindBucket(ht, stack_key);
+    CFHashCode key_hash = 0;
+    CFBasicHashBucket bkt = __CFBasicHashFindBucket(ht, stack_key, &key_hash);
     if (0 < bkt.count) {
         ht->bits.mutations++;
         if (ht->bits.counts_offset && bkt.count < LONG_MAX) { // if not yet as large as a CFIndex can be... otherwise clamp and do nothing
@@ -1316,7 +1450,7 @@ CF_PRIVATE Boolean CFBasicHashAddValue(CFBasicHashRef ht, uintptr_t stack_key, u
             return true;
         }
     } else {
-        __CFBasicHashAddValue(ht, bkt.idx, stack_key, stack_value);
+        __CFBasicHashAddValue(ht, bkt.idx, stack_key, stack_value, key_hash);
         return true;
     }
     return false;
@@ -1328,7 +1462,7 @@ CF_PRIVATE void CFBasicHashReplaceValue(CFBasicHashRef ht, uintptr_t stack_key,
     if (__CFBasicHashSubABOne == stack_key) HALT;
     if (__CFBasicHashSubABZero == stack_value) HALT;
     if (__CFBasicHashSubABOne == stack_value) HALT;
-    CFBasicHashBucket bkt = __CFBasicHashFindBucket(ht, stack_key);
+    CFBasicHashBucket bkt = __CFBasicHashFindBucket(ht, stack_key, NULL);
     if (0 < bkt.count) {
         __CFBasicHashReplaceValue(ht, bkt.idx, stack_key, stack_value);
     }
@@ -1340,18 +1474,19 @@ CF_PRIVATE void CFBasicHashSetValue(CFBasicHashRef ht, uintptr_t stack_key, uint
     if (__CFBasicHashSubABOne == stack_key) HALT;
     if (__CFBasicHashSubABZero == stack_value) HALT;
     if (__CFBasicHashSubABOne == stack_value) HALT;
-    CFBasicHashBucket bkt = __CFBasicHashFindBucket(ht, stack_key);
+    CFHashCode key_hash = 0;
+    CFBasicHashBucket bkt = __CFBasicHashFindBucket(ht, stack_key, &key_hash);
     if (0 < bkt.count) {
         __CFBasicHashReplaceValue(ht, bkt.idx, stack_key, stack_value);
     } else {
-        __CFBasicHashAddValue(ht, bkt.idx, stack_key, stack_value);
+        __CFBasicHashAddValue(ht, bkt.idx, stack_key, stack_value, key_hash);
     }
 }
 
 CF_PRIVATE CFIndex CFBasicHashRemoveValue(CFBasicHashRef ht, uintptr_t stack_key) {
     if (!CFBasicHashIsMutable(ht)) HALT;
     if (__CFBasicHashSubABZero == stack_key || __CFBasicHashSubABOne == stack_key) return 0;
-    CFBasicHashBucket bkt = __CFBasicHashFindBucket(ht, stack_key);
+    CFBasicHashBucket bkt = __CFBasicHashFindBucket(ht, stack_key, NULL);
     if (1 < bkt.count) {
         ht->bits.mutations++;
         if (ht->bits.counts_offset && bkt.count < LONG_MAX) { // if not as large as a CFIndex can be... otherwise clamp and do nothing
@@ -1389,16 +1524,17 @@ CF_PRIVATE Boolean CFBasicHashAddIntValueAndInc(CFBasicHashRef ht, uintptr_t sta
     if (__CFBasicHashSubABOne == stack_key) HALT;
     if (__CFBasicHashSubABZero == int_value) HALT;
     if (__CFBasicHashSubABOne == int_value) HALT;
-    CFBasicHashBucket bkt = __CFBasicHashFindBucket(ht, stack_key);
+    CFHashCode key_hash = 0;
+    CFBasicHashBucket bkt = __CFBasicHashFindBucket(ht, stack_key, &key_hash);
     if (0 < bkt.count) {
         ht->bits.mutations++;
     } else {
         // must rehash before renumbering
         if (CFBasicHashGetCapacity(ht) < ht->bits.used_buckets + 1) {
             __CFBasicHashRehash(ht, 1);
-            bkt.idx = __CFBasicHashFindBucket_NoCollision(ht, stack_key, 0);
+            bkt.idx = __CFBasicHashFindBucket_NoCollision(ht, stack_key, key_hash);
         }
-        CFIndex cnt = (CFIndex)__CFBasicHashTableSizes[ht->bits.num_buckets_idx];
+        CFIndex cnt = (CFIndex)__CFBasicHashGetNumBucketsForIndex(ht, ht->bits.num_buckets_idx);
         for (CFIndex idx = 0; idx < cnt; idx++) {
             if (!__CFBasicHashIsEmptyOrDeleted(ht, idx)) {
                 uintptr_t stack_value = __CFBasicHashGetValue(ht, idx);
@@ -1409,7 +1545,7 @@ CF_PRIVATE Boolean CFBasicHashAddIntValueAndInc(CFBasicHashRef ht, uintptr_t sta
                 }
             }
         }
-        __CFBasicHashAddValue(ht, bkt.idx, stack_key, int_value);
+        __CFBasicHashAddValue(ht, bkt.idx, stack_key, int_value, key_hash);
         return true;
     }
     return false;
@@ -1420,7 +1556,7 @@ CF_PRIVATE void CFBasicHashRemoveIntValueAndDec(CFBasicHashRef ht, uintptr_t int
     if (__CFBasicHashSubABZero == int_value) HALT;
     if (__CFBasicHashSubABOne == int_value) HALT;
     uintptr_t bkt_idx = ~0UL;
-    CFIndex cnt = (CFIndex)__CFBasicHashTableSizes[ht->bits.num_buckets_idx];
+    CFIndex cnt = (CFIndex)__CFBasicHashGetNumBucketsForIndex(ht, ht->bits.num_buckets_idx);
     for (CFIndex idx = 0; idx < cnt; idx++) {
         if (!__CFBasicHashIsEmptyOrDeleted(ht, idx)) {
             uintptr_t stack_value = __CFBasicHashGetValue(ht, idx);
@@ -1443,7 +1579,7 @@ CF_PRIVATE size_t CFBasicHashGetSize(CFConstBasicHashRef ht, Boolean total) {
     if (ht->bits.counts_offset) size += sizeof(void *);
     if (__CFBasicHashHasHashCache(ht)) size += sizeof(uintptr_t *);
     if (total) {
-        CFIndex num_buckets = __CFBasicHashTableSizes[ht->bits.num_buckets_idx];
+        CFIndex num_buckets = __CFBasicHashGetNumBucketsForIndex(ht, ht->bits.num_buckets_idx);
         if (0 < num_buckets) {
             size += malloc_size(__CFBasicHashGetValues(ht));
             if (ht->bits.keys_offset) size += malloc_size(__CFBasicHashGetKeys(ht));
@@ -1624,7 +1760,7 @@ CF_PRIVATE CFBasicHashRef CFBasicHashCreate(CFAllocatorRef allocator, CFOptionFl
 
 CF_PRIVATE CFBasicHashRef CFBasicHashCreateCopy(CFAllocatorRef allocator, CFConstBasicHashRef src_ht) {
     size_t size = CFBasicHashGetSize(src_ht, false) - sizeof(CFRuntimeBase);
-    CFIndex new_num_buckets = __CFBasicHashTableSizes[src_ht->bits.num_buckets_idx];
+    CFIndex new_num_buckets = __CFBasicHashGetNumBucketsForIndex(src_ht, src_ht->bits.num_buckets_idx);
     CFBasicHashValue *new_values = NULL, *new_keys = NULL;
     void *new_counts = NULL;
     uintptr_t *new_hashes = NULL;
@@ -1632,7 +1768,7 @@ CF_PRIVATE CFBasicHashRef CFBasicHashCreateCopy(CFAllocatorRef allocator, CFCons
     if (0 < new_num_buckets) {
         Boolean strongValues = CFBasicHashHasStrongValues(src_ht);
         Boolean strongKeys = CFBasicHashHasStrongKeys(src_ht);
-        new_values = (CFBasicHashValue *)__CFBasicHashAllocateMemory2(allocator, new_num_buckets, sizeof(CFBasicHashValue), strongValues, 0);
+        new_values = (CFBasicHashValue *)__CFBasicHashAllocateMemory2(allocator, __CFBasicHashGetValuesSize(src_ht, new_num_buckets), 1, strongValues, 0);
         if (!new_values) return NULL; // in this unusual circumstance, leak previously allocated blocks for now
         __SetLastAllocationEventName(new_values, "CFBasicHash (value-store)");
         if (src_ht->bits.keys_offset) {
@@ -1718,6 +1854,9 @@ CF_PRIVATE CFBasicHashRef CFBasicHashCreateCopy(CFAllocatorRef allocator, CFCons
     }
     if (new_counts) memmove(new_counts, old_counts, new_num_buckets * (1 << ht->bits.counts_width));
     if (new_hashes) memmove(new_hashes, old_hashes, new_num_buckets * sizeof(uintptr_t));
+    if (__kCFBasicHashGroupedHashingValue == ht->bits.hash_style) {
+        memmove(__CFBasicHashGetMetadata(ht), __CFBasicHashGetMetadata(src_ht), __CFBasicHashGetMetadataSize(new_num_buckets));
+    }
 
 #if ENABLE_MEMORY_COUNTERS
     int64_t size_now = OSAtomicAdd64Barrier((int64_t) CFBasicHashGetSize(ht, true), & __CFBasicHashTotalSize);
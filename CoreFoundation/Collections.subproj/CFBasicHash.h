@@ -21,6 +21,7 @@ struct __objcFastEnumerationStateEquivalent2 {
 };
 
 enum {
+    __kCFBasicHashGroupedHashingValue = 0,
     __kCFBasicHashLinearHashingValue = 1,
     __kCFBasicHashDoubleHashingValue = 2,
     __kCFBasicHashExponentialHashingValue = 3,
@@ -45,6 +46,7 @@ enum {
     kCFBasicHashLinearHashing = (__kCFBasicHashLinearHashingValue << 13), // bits 13-14
     kCFBasicHashDoubleHashing = (__kCFBasicHashDoubleHashingValue << 13),
     kCFBasicHashExponentialHashing = (__kCFBasicHashExponentialHashingValue << 13),
+    kCFBasicHashGroupedHashing = (__kCFBasicHashGroupedHashingValue << 13), // power-of-two table, probed a group of buckets at a time
 
     kCFBasicHashAggressiveGrowth = (1UL << 15),
 };
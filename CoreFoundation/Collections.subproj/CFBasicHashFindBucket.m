@@ -16,7 +16,8 @@
 
 // During rehashing of a mutable CFBasicHash, we know that there are no
 // deleted slots and the keys have already been uniqued. When rehashing,
-// if key_hash is non-0, we use it as the hash code.
+// if key_hash is non-0, we use it as the hash code. Otherwise, the hash
+// code is handed back through out_hash_code when that is non-NULL.
 static
 #if FIND_BUCKET_FOR_REHASH
 CFIndex
@@ -26,15 +27,108 @@ CFBasicHashBucket
 FIND_BUCKET_NAME (CFConstBasicHashRef ht, uintptr_t stack_key
 #if FIND_BUCKET_FOR_REHASH
 , uintptr_t key_hash
+#else
+, CFHashCode *out_hash_code
 #endif
 ) {
     uint8_t num_buckets_idx = ht->bits.num_buckets_idx;
+#if FIND_BUCKET_HASH_STYLE == 0	// __kCFBasicHashGroupedHashingValue
+    uintptr_t num_buckets = (uintptr_t)2 << num_buckets_idx;
+#else
     uintptr_t num_buckets = __CFBasicHashTableSizes[num_buckets_idx];
+#endif
 #if FIND_BUCKET_FOR_REHASH
     CFHashCode hash_code = key_hash ? key_hash : __CFBasicHashHashKey(ht, stack_key);
 #else
     CFHashCode hash_code = __CFBasicHashHashKey(ht, stack_key);
+    if (out_hash_code) *out_hash_code = hash_code;
+#endif
+
+#if FIND_BUCKET_HASH_STYLE == 0	// __kCFBasicHashGroupedHashingValue
+    // Grouped probing
+    // The buckets are split into num_groups groups of __CFBasicHashGroupWidth
+    // consecutive buckets (a single, padded group for the smallest tables).
+    // probe[0] = h1(k)
+    // probe[i] = (probe[i - 1] + i) mod num_groups, i = 1 .. num_groups - 1
+    // which visits every group since num_groups is a power of two.
+    // h1(k) = floor(mix(k) / 128) mod num_groups
+    // h2(k) = mix(k) mod 128, stored in the metadata byte of a full bucket
+    // Every bucket of a group whose metadata matches h2(k) is compared, and
+    // the probe sequence ends at the first group having an empty bucket.
+    uint64_t mixed = __CFBasicHashGroupedMix(hash_code);
+    uintptr_t group_mask = (num_buckets <= __CFBasicHashGroupWidth) ? 0 : (num_buckets / __CFBasicHashGroupWidth) - 1;
+    uintptr_t group = (uintptr_t)(mixed >> 7) & group_mask;
+#if !FIND_BUCKET_FOR_REHASH
+    uint8_t h2 = (uint8_t)(mixed & 0x7F);
+#endif
+    const uint8_t *metadata = (const uint8_t *)(__CFBasicHashGetValues(ht) + num_buckets);
+
+    COCOA_HASHTABLE_PROBING_START(ht, num_buckets);
+#if !FIND_BUCKET_FOR_REHASH
+    CFBasicHashValue *keys = (ht->bits.keys_offset) ? __CFBasicHashGetKeys(ht) : __CFBasicHashGetValues(ht);
+    uintptr_t *hashes = (__CFBasicHashHasHashCache(ht)) ? __CFBasicHashGetHashes(ht) : NULL;
+#endif
+    CFIndex deleted_idx = kCFNotFound;
+    CFIndex num_probes = 0;
+    for (uintptr_t step = 0; step <= group_mask; step++) {
+        uintptr_t base = group * __CFBasicHashGroupWidth;
+        const uint8_t *group_metadata = metadata + base;
+#if !FIND_BUCKET_FOR_REHASH
+        for (uint32_t match = __CFBasicHashGroupMatch(group_metadata, h2); match; match &= match - 1) {
+            uintptr_t probe = base + __builtin_ctz(match);
+            num_probes++;
+            COCOA_HASHTABLE_PROBE_VALID(ht, probe);
+            uintptr_t curr_key = keys[probe].neutral;
+            if (__CFBasicHashSubABZero == curr_key) curr_key = 0UL;
+            if (__CFBasicHashSubABOne == curr_key) curr_key = ~0UL;
+#if FIND_BUCKET_FOR_INDIRECT_KEY
+            // curr_key holds the value coming in here
+            curr_key = __CFBasicHashGetIndirectKey(ht, curr_key);
+#endif
+            if (curr_key == stack_key || ((!hashes || hashes[probe] == hash_code) && __CFBasicHashTestEqualKey(ht, curr_key, stack_key))) {
+                COCOA_HASHTABLE_PROBING_END(ht, num_probes);
+                CFBasicHashBucket result;
+                result.idx = probe;
+                result.weak_value = __CFBasicHashGetValue(ht, probe);
+                result.weak_key = curr_key;
+                result.count = (ht->bits.counts_offset) ? __CFBasicHashGetSlotCount(ht, probe) : 1;
+                return result;
+            }
+        }
+        if (kCFNotFound == deleted_idx) {
+            uint32_t deleted = __CFBasicHashGroupMatch(group_metadata, __CFBasicHashMetadataDeleted);
+            if (deleted) {
+                deleted_idx = base + __builtin_ctz(deleted);
+                COCOA_HASHTABLE_PROBE_DELETED(ht, deleted_idx);
+            }
+        }
+#endif
+        uint32_t empty = __CFBasicHashGroupMatch(group_metadata, __CFBasicHashMetadataEmpty);
+        if (empty) {
+            uintptr_t probe = base + __builtin_ctz(empty);
+            COCOA_HASHTABLE_PROBE_EMPTY(ht, probe);
+#if FIND_BUCKET_FOR_REHASH
+            CFIndex result = probe;
+#else
+            CFBasicHashBucket result;
+            result.idx = (kCFNotFound == deleted_idx) ? probe : deleted_idx;
+            result.count = 0;
 #endif
+            COCOA_HASHTABLE_PROBING_END(ht, num_probes + 1);
+            return result;
+        }
+        group = (group + step + 1) & group_mask;
+    }
+    COCOA_HASHTABLE_PROBING_END(ht, num_probes);
+#if FIND_BUCKET_FOR_REHASH
+    CFIndex result = deleted_idx;
+#else
+    CFBasicHashBucket result;
+    result.idx = deleted_idx;
+    result.count = 0;
+#endif
+    return result; // all buckets full or deleted, return first deleted element which was found
+#else
 
 #if FIND_BUCKET_HASH_STYLE == 1	// __kCFBasicHashLinearHashingValue
     // Linear probing, with c = 1
@@ -171,6 +265,7 @@ FIND_BUCKET_NAME (CFConstBasicHashRef ht, uintptr_t stack_key
     result.count = 0;
 #endif
     return result; // all buckets full or deleted, return first deleted element which was found
+#endif
 }
 
 #undef FIND_BUCKET_NAME
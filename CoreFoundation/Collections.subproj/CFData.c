@@ -749,15 +749,26 @@ static void _computeGoodSubstringShift(const uint8_t *needle, int needleLength,
     } \
     do {} while (0)
 
-static const uint8_t * __CFDataSearchBoyerMoore(const CFDataRef data, const uint8_t *haystack, unsigned long haystackLength, const uint8_t *needle, unsigned long needleLength, Boolean backwards) {
-    unsigned long badCharacterShift[UCHAR_MAX + 1] = {0};
-    new_ulong_array(goodSubstringShift, needleLength);
+/* Needles up to this length are found by scanning for their first byte and checking their last byte before comparing them in full. That needs no tables, so it is cheap to set up; longer needles use Boyer-Moore, whose tables pay for themselves over the longer comparisons.
+*/
+#define __CFDataFilterSearchMaxNeedleLength 32
+
+struct __CFDataSearcher {
+    CFAllocatorRef allocator;
+    CFDataSearchFlags options;
+    CFIndex needleLength;
+    uint8_t *needle;
+    unsigned long *goodSubstringShift;	// NULL for needles that are searched for by filtering
+    unsigned long badCharacterShift[UCHAR_MAX + 1];
+};
+
+static void __CFDataComputeShiftTables(CFTypeRef data, const uint8_t *needle, unsigned long needleLength, Boolean backwards, unsigned long badCharacterShift[], unsigned long goodSubstringShift[]) {
     new_ulong_array(suffixLengths, needleLength);
-    
+
+    for (int i = 0; i < UCHAR_MAX + 1; i++)
+	badCharacterShift[i] = needleLength;
+
     if(backwards) {
-	for (int i = 0; i < sizeof(badCharacterShift) / sizeof(*badCharacterShift); i++)
-	    badCharacterShift[i] = needleLength;
-	
 	for (int i = needleLength - 1; i >= 0; i--)
 	    badCharacterShift[needle[i]] = i;
 	
@@ -772,15 +783,16 @@ static const uint8_t * __CFDataSearchBoyerMoore(const CFDataRef data, const uint
 	REVERSE_BUFFER(unsigned long, goodSubstringShift, needleLength);
 	free(needleCopy);
     } else {
-	for (int i = 0; i < sizeof(badCharacterShift) / sizeof(*badCharacterShift); i++)
-	    badCharacterShift[i] = needleLength;
-	
 	for (int i = 0; i < needleLength; i++)
 	    badCharacterShift[needle[i]] = needleLength - i- 1;
 	
 	_computeGoodSubstringShift(needle, needleLength, goodSubstringShift, suffixLengths);
     }
-    
+
+    free_ulong_array(suffixLengths);
+}
+
+static const uint8_t * __CFDataSearchBoyerMoore(const uint8_t *haystack, unsigned long haystackLength, const uint8_t *needle, unsigned long needleLength, Boolean backwards, const unsigned long badCharacterShift[], const unsigned long goodSubstringShift[]) {
     const uint8_t *scan_needle;
     const uint8_t *scan_haystack;
     const uint8_t *result = NULL;
@@ -818,21 +830,51 @@ static const uint8_t * __CFDataSearchBoyerMoore(const CFDataRef data, const uint
 	}
     }
     
-    free_ulong_array(goodSubstringShift);
-    free_ulong_array(suffixLengths);
-    
     return result;
 }
 
-CFRange _CFDataFindBytes(CFDataRef data, CFDataRef dataToFind, CFRange searchRange, CFDataSearchFlags compareOptions) {
-    const uint8_t *fullHaystack = CFDataGetBytePtr(data);
-    const uint8_t *needle = CFDataGetBytePtr(dataToFind);
-    unsigned long fullHaystackLength = CFDataGetLength(data);
-    unsigned long needleLength = CFDataGetLength(dataToFind);
-    
+static const uint8_t * __CFDataSearchFiltered(const uint8_t *haystack, unsigned long haystackLength, const uint8_t *needle, unsigned long needleLength, Boolean backwards) {
+    const uint8_t first = needle[0], last = needle[needleLength - 1];
+    if(backwards) {
+#if TARGET_OS_LINUX
+	// memrchr() is the backwards counterpart of memchr(), and skips the haystack the same way
+	const uint8_t *candidate = haystack + haystackLength - needleLength;
+	while ((candidate = (const uint8_t *)memrchr(haystack, first, candidate - haystack + 1))) {
+	    if (candidate[needleLength - 1] == last && 0 == memcmp(candidate, needle, needleLength)) {
+		return candidate;
+	    }
+	    if (candidate == haystack) break;
+	    candidate--;
+	}
+#else
+	for (CFIndex idx = haystackLength - needleLength; idx >= 0; idx--) {
+	    if (haystack[idx] == first && haystack[idx + needleLength - 1] == last && 0 == memcmp(haystack + idx, needle, needleLength)) {
+		return haystack + idx;
+	    }
+	}
+#endif
+    } else {
+	// memchr() is vectorized by the C library, so most of the haystack is skipped a block at a time
+	const uint8_t *candidate = haystack;
+	const uint8_t *const lastCandidate = haystack + haystackLength - needleLength;
+	while (candidate <= lastCandidate && (candidate = (const uint8_t *)memchr(candidate, first, lastCandidate - candidate + 1))) {
+	    if (candidate[needleLength - 1] == last && 0 == memcmp(candidate, needle, needleLength)) {
+		return candidate;
+	    }
+	    candidate++;
+	}
+    }
+    return NULL;
+}
+
+/* Finds needle within searchRange of fullHaystack, which must lie within it. Boyer-Moore tables are used if provided and computed on the fly otherwise; data is only used for reporting allocation failures.
+*/
+static CFRange __CFDataFindInBytes(CFTypeRef data, const uint8_t *fullHaystack, unsigned long fullHaystackLength, const uint8_t *needle, unsigned long needleLength, CFRange searchRange, CFDataSearchFlags compareOptions, const unsigned long *badCharacterShift, const unsigned long *goodSubstringShift) {
+    Boolean backwards = (compareOptions & kCFDataSearchBackwards) != 0;
+
     if(compareOptions & kCFDataSearchAnchored) {
 	if(searchRange.length > needleLength) {
-	    if(compareOptions & kCFDataSearchBackwards) {
+	    if(backwards) {
 		searchRange.location += (searchRange.length - needleLength);
 	    }
 	    searchRange.length = needleLength;
@@ -847,12 +889,63 @@ CFRange _CFDataFindBytes(CFDataRef data, CFDataRef dataToFind, CFRange searchRan
     }
 	
     const uint8_t *haystack = fullHaystack + searchRange.location;
-    const uint8_t *searchResult = __CFDataSearchBoyerMoore(data, haystack, searchRange.length, needle, needleLength, (compareOptions & kCFDataSearchBackwards) != 0);
+    const uint8_t *searchResult;
+    if (searchRange.length == needleLength) {	// Anchored searches always end up here
+	searchResult = (0 == memcmp(haystack, needle, needleLength)) ? haystack : NULL;
+    } else if (needleLength <= __CFDataFilterSearchMaxNeedleLength) {
+	searchResult = __CFDataSearchFiltered(haystack, searchRange.length, needle, needleLength, backwards);
+    } else if (badCharacterShift && goodSubstringShift) {
+	searchResult = __CFDataSearchBoyerMoore(haystack, searchRange.length, needle, needleLength, backwards, badCharacterShift, goodSubstringShift);
+    } else {
+	unsigned long computedBadCharacterShift[UCHAR_MAX + 1];
+	new_ulong_array(computedGoodSubstringShift, needleLength);
+	__CFDataComputeShiftTables(data, needle, needleLength, backwards, computedBadCharacterShift, computedGoodSubstringShift);
+	searchResult = __CFDataSearchBoyerMoore(haystack, searchRange.length, needle, needleLength, backwards, computedBadCharacterShift, computedGoodSubstringShift);
+	free_ulong_array(computedGoodSubstringShift);
+    }
     CFIndex resultLocation = (searchResult == NULL) ? kCFNotFound : searchRange.location + (searchResult - haystack);
     
     return CFRangeMake(resultLocation, resultLocation == kCFNotFound ? 0: needleLength);
 }
 
+CFRange _CFDataFindBytes(CFDataRef data, CFDataRef dataToFind, CFRange searchRange, CFDataSearchFlags compareOptions) {
+    return __CFDataFindInBytes(data, CFDataGetBytePtr(data), CFDataGetLength(data), CFDataGetBytePtr(dataToFind), CFDataGetLength(dataToFind), searchRange, compareOptions, NULL, NULL);
+}
+
+_CFDataSearcherRef _CFDataSearcherCreate(CFAllocatorRef allocator, const uint8_t *needle, CFIndex needleLength, CFDataSearchFlags options) {
+    if (NULL == allocator) allocator = __CFGetDefaultAllocator();
+    struct __CFDataSearcher *searcher = (struct __CFDataSearcher *)CFAllocatorAllocate(allocator, sizeof(struct __CFDataSearcher), 0);
+    if (!searcher) __CFDataHandleOutOfMemory(NULL, sizeof(struct __CFDataSearcher));
+    searcher->allocator = (CFAllocatorRef)CFRetain(allocator);
+    searcher->options = options;
+    searcher->needleLength = needleLength;
+    searcher->needle = NULL;
+    searcher->goodSubstringShift = NULL;
+    if (0 < needleLength) {
+	searcher->needle = (uint8_t *)CFAllocatorAllocate(allocator, needleLength, 0);
+	if (!searcher->needle) __CFDataHandleOutOfMemory(NULL, needleLength);
+	memmove(searcher->needle, needle, needleLength);
+    }
+    if (__CFDataFilterSearchMaxNeedleLength < needleLength) {
+	searcher->goodSubstringShift = (unsigned long *)CFAllocatorAllocate(allocator, needleLength * sizeof(unsigned long), 0);
+	if (!searcher->goodSubstringShift) __CFDataHandleOutOfMemory(NULL, needleLength * sizeof(unsigned long));
+	__CFDataComputeShiftTables(NULL, needle, needleLength, (options & kCFDataSearchBackwards) != 0, searcher->badCharacterShift, searcher->goodSubstringShift);
+    }
+    return searcher;
+}
+
+CFRange _CFDataSearcherFindInBytes(_CFDataSearcherRef searcher, const uint8_t *bytes, CFIndex length, CFRange searchRange) {
+    return __CFDataFindInBytes(NULL, bytes, length, searcher->needle, searcher->needleLength, searchRange, searcher->options, searcher->badCharacterShift, searcher->goodSubstringShift);
+}
+
+void _CFDataSearcherRelease(_CFDataSearcherRef searcher) {
+    CFAllocatorRef allocator = searcher->allocator;
+    if (searcher->goodSubstringShift) CFAllocatorDeallocate(allocator, searcher->goodSubstringShift);
+    if (searcher->needle) CFAllocatorDeallocate(allocator, searcher->needle);
+    CFAllocatorDeallocate(allocator, searcher);
+    CFRelease(allocator);
+}
+
 CFRange CFDataFind(CFDataRef data, CFDataRef dataToFind, CFRange searchRange, CFDataSearchFlags compareOptions) {
     // No objc dispatch
     __CFGenericValidateType(data, CFDataGetTypeID());
@@ -109,6 +109,8 @@ CFTypeID CFDictionaryGetTypeID(void) {
 
 static CFBasicHashRef __CFDictionaryCreateGeneric(CFAllocatorRef allocator, const CFHashKeyCallBacks *keyCallBacks, const CFHashValueCallBacks *valueCallBacks, Boolean useValueCB) {
     CFOptionFlags flags = kCFBasicHashLinearHashing; // kCFBasicHashExponentialHashing
+    // CFType keys cost a CFEqual() call per probe, which grouped hashing mostly filters out
+    if ((CFDictionary || CFSet) && keyCallBacks && keyCallBacks->equal == CFEqual && keyCallBacks->hash == CFHash) flags = kCFBasicHashGroupedHashing;
     flags |= (CFDictionary ? kCFBasicHashHasKeys : 0) | (CFBag ? kCFBasicHashHasCounts : 0);
 
 
@@ -137,7 +139,7 @@ CF_PRIVATE CFHashRef __CFDictionaryCreateTransfer(CFAllocatorRef allocator, cons
 #endif
     CFTypeID typeID = CFDictionaryGetTypeID();
     CFAssert2(0 <= numValues, __kCFLogAssertion, "%s(): numValues (%ld) cannot be less than zero", __PRETTY_FUNCTION__, numValues);
-    CFOptionFlags flags = kCFBasicHashLinearHashing; // kCFBasicHashExponentialHashing
+    CFOptionFlags flags = (CFDictionary || CFSet) ? kCFBasicHashGroupedHashing : kCFBasicHashLinearHashing; // kCFBasicHashExponentialHashing
     flags |= (CFDictionary ? kCFBasicHashHasKeys : 0) | (CFBag ? kCFBasicHashHasCounts : 0);
 
     CFBasicHashCallbacks callbacks;
@@ -88,6 +88,7 @@ static CFMutableDictionaryRef __CFTimeZoneCompatibilityMappingDict = NULL;
 static CFLock_t __CFTimeZoneCompatibilityMappingLock = CFLockInit;
 static CFArrayRef __CFKnownTimeZoneList = NULL;
 static CFMutableDictionaryRef __CFTimeZoneCache = NULL;
+static CFMutableDictionaryRef __CFTimeZoneInitCache = NULL; // Names passed to _CFTimeZoneInit, mapped to the parsed zone they resolved to
 static CFLock_t __CFTimeZoneGlobalLock = CFLockInit;
 
 #if TARGET_OS_WIN32
@@ -1085,6 +1086,7 @@ void CFTimeZoneSetAbbreviationDictionary(CFDictionaryRef dict) {
 	    CFDictionaryApplyFunction(__CFTimeZoneAbbreviationDict, _removeFromCache, NULL);
 	    CFRelease(__CFTimeZoneAbbreviationDict);
 	}
+	if (__CFTimeZoneInitCache) CFDictionaryRemoveAllValues(__CFTimeZoneInitCache);
 	__CFTimeZoneAbbreviationDict = dict;
     }
     __CFTimeZoneUnlockGlobal();
@@ -1212,9 +1214,7 @@ Boolean _CFTimeZoneInitInternal(CFTimeZoneRef timezone, CFStringRef name, CFData
     CFIndex cnt = 0;
     Boolean success = false;
 
-    __CFTimeZoneLockGlobal();
     success = __CFParseTimeZoneData(kCFAllocatorSystemDefault, data, &tzp, &cnt);
-    __CFTimeZoneUnlockGlobal();
 
     if (success) {
         ((struct __CFTimeZone *)timezone)->_name = (CFStringRef)CFStringCreateCopy(kCFAllocatorSystemDefault, name);
@@ -1226,6 +1226,21 @@ Boolean _CFTimeZoneInitInternal(CFTimeZoneRef timezone, CFStringRef name, CFData
     return success;
 }
 
+// Initializes timeZone as a copy of source, sharing its (immutable) name, data and abbreviations
+static void __CFTimeZoneInitFromTimeZone(CFTimeZoneRef timeZone, CFTimeZoneRef source) {
+    CFIndex idx, cnt = source->_periodCnt;
+    CFTZPeriod *tzp = CFAllocatorAllocate(kCFAllocatorSystemDefault, cnt * sizeof(CFTZPeriod), 0);
+    if (__CFOASafe) __CFSetLastAllocationEventName(tzp, "CFTimeZone (store)");
+    memmove(tzp, source->_periods, cnt * sizeof(CFTZPeriod));
+    for (idx = 0; idx < cnt; idx++) {
+        if (NULL != tzp[idx].abbrev) CFRetain(tzp[idx].abbrev);
+    }
+    ((struct __CFTimeZone *)timeZone)->_name = (CFStringRef)CFRetain(source->_name);
+    ((struct __CFTimeZone *)timeZone)->_data = (CFDataRef)CFRetain(source->_data);
+    ((struct __CFTimeZone *)timeZone)->_periods = tzp;
+    ((struct __CFTimeZone *)timeZone)->_periodCnt = cnt;
+}
+
 CFDataRef _CFTimeZoneDataCreate(CFURLRef baseURL, CFStringRef tzName) {
 #if TARGET_OS_ANDROID
     CFDataRef data = NULL;
@@ -1277,6 +1292,20 @@ Boolean _CFTimeZoneInit(CFTimeZoneRef timeZone, CFStringRef name, CFDataRef data
         return _CFTimeZoneInitInternal(timeZone, name, data);
     }
 
+    // Every zone a name has resolved to before is kept parsed, so looking it up again costs no file system access or parsing
+    CFTimeZoneRef cached = NULL;
+    __CFTimeZoneLockGlobal();
+    if (NULL != __CFTimeZoneInitCache && CFDictionaryGetValueIfPresent(__CFTimeZoneInitCache, name, (const void **)&cached)) {
+        CFRetain(cached);
+    }
+    __CFTimeZoneUnlockGlobal();
+    if (cached) {
+        __CFTimeZoneInitFromTimeZone(timeZone, cached);
+        CFRelease(cached);
+        return true;
+    }
+    CFStringRef requestedName = name;
+
     CFIndex len = CFStringGetLength(name);
     if (6 == len || 8 == len) {
         UniChar buffer[8];
@@ -1371,7 +1400,20 @@ Boolean _CFTimeZoneInit(CFTimeZoneRef timeZone, CFStringRef name, CFDataRef data
         CFRelease(baseURL);
     }
     if (NULL != data) {
-        result = _CFTimeZoneInitInternal(timeZone, tzName, data);
+        cached = CFTimeZoneCreate(kCFAllocatorSystemDefault, tzName, data);
+        if (cached) {
+            __CFTimeZoneLockGlobal();
+            if (NULL == __CFTimeZoneInitCache) {
+                __CFTimeZoneInitCache = CFDictionaryCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+            }
+            CFStringRef nameCopy = CFStringCreateCopy(kCFAllocatorSystemDefault, requestedName);
+            CFDictionarySetValue(__CFTimeZoneInitCache, nameCopy, cached);
+            CFRelease(nameCopy);
+            __CFTimeZoneUnlockGlobal();
+            __CFTimeZoneInitFromTimeZone(timeZone, cached);
+            CFRelease(cached);
+            result = true;
+        }
         CFRelease(data);
     }
     return result;
@@ -1380,7 +1422,7 @@ Boolean _CFTimeZoneInit(CFTimeZoneRef timeZone, CFStringRef name, CFDataRef data
 
 CFTimeZoneRef CFTimeZoneCreate(CFAllocatorRef allocator, CFStringRef name, CFDataRef data) {
 // assert:    (NULL != name && NULL != data);
-    CFTimeZoneRef memory;
+    CFTimeZoneRef memory, existing;
     uint32_t size;
     CFTZPeriod *tzp = NULL;
     CFIndex idx, cnt = 0;
@@ -1394,14 +1436,14 @@ CFTimeZoneRef CFTimeZoneCreate(CFAllocatorRef allocator, CFStringRef name, CFDat
 	__CFTimeZoneUnlockGlobal();
 	return (CFTimeZoneRef)CFRetain(memory);
     }
+    __CFTimeZoneUnlockGlobal();
+    // Parse without holding the global lock, so creating one zone doesn't hold up lookups of others
     if (!__CFParseTimeZoneData(allocator, data, &tzp, &cnt)) {
-	__CFTimeZoneUnlockGlobal();
 	return NULL;
     }
     size = sizeof(struct __CFTimeZone) - sizeof(CFRuntimeBase);
     memory = (CFTimeZoneRef)_CFRuntimeCreateInstance(allocator, CFTimeZoneGetTypeID(), size, NULL);
     if (NULL == memory) {
-	__CFTimeZoneUnlockGlobal();
 	for (idx = 0; idx < cnt; idx++) {
 	    if (NULL != tzp[idx].abbrev) CFRelease(tzp[idx].abbrev);
 	}
@@ -1412,9 +1454,17 @@ CFTimeZoneRef CFTimeZoneCreate(CFAllocatorRef allocator, CFStringRef name, CFDat
     ((struct __CFTimeZone *)memory)->_data = CFDataCreateCopy(allocator, data);
     ((struct __CFTimeZone *)memory)->_periods = tzp;
     ((struct __CFTimeZone *)memory)->_periodCnt = cnt;
+    __CFTimeZoneLockGlobal();
     if (NULL == __CFTimeZoneCache) {
 	__CFTimeZoneCache = CFDictionaryCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
     }
+    if (CFDictionaryGetValueIfPresent(__CFTimeZoneCache, name, (const void **)&existing)) {
+	// Another thread created the same zone while we were parsing; use theirs
+	CFRetain(existing);
+	__CFTimeZoneUnlockGlobal();
+	CFRelease(memory);
+	return existing;
+    }
     CFDictionaryAddValue(__CFTimeZoneCache, ((struct __CFTimeZone *)memory)->_name, memory);
     __CFTimeZoneUnlockGlobal();
     return memory;
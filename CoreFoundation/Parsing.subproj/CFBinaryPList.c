@@ -29,6 +29,9 @@
 #include "CFInternal.h"
 #include "CFRuntime_Internal.h"
 #include <CoreFoundation/CFStream.h>
+#if TARGET_OS_MAC || TARGET_OS_LINUX || TARGET_OS_BSD
+#include <sys/mman.h>
+#endif
 
 typedef struct {
     int64_t high;
@@ -389,8 +392,91 @@ static void _appendNumber(__CFBinaryPlistWriteBuffer *buf, CFNumberRef num, Bool
     }
 }
 
-static Boolean _appendObject(__CFBinaryPlistWriteBuffer *buf, CFTypeRef obj, CFDictionaryRef objtable, uint32_t objRefSize, Boolean dryRun) {
-    uint64_t refnum;
+/* The writer assigns every object in the plist a reference number. Objects are found by identity, and strings, numbers, dates and data are also uniqued by value. The tables doing this are compact open-addressed arrays rather than CF collections, where each slot is a pointer plus two 32-bit numbers. The identity table retains its objects, so that none of them can be freed and its address reused while the plist is being written; the value table only ever holds objects that are also in the identity table.
+ */
+typedef struct {
+    CFTypeRef object;
+    uint32_t hash;
+    uint32_t refnum;
+} __CFBinaryPlistObjectSlot;
+
+typedef struct {
+    __CFBinaryPlistObjectSlot *slots;
+    uint64_t capacity;      // always a power of 2
+    uint64_t count;
+    Boolean retainsObjects;
+} __CFBinaryPlistObjectTable;
+
+CF_INLINE uint32_t __CFBinaryPlistMixHash(uint64_t value) {
+    value = (value ^ (value >> 31)) * 0x7fb5d329728ea185ULL;
+    value = (value ^ (value >> 27)) * 0x81dadef4bc2dd44dULL;
+    return (uint32_t)(value ^ (value >> 33));
+}
+
+static void __CFBinaryPlistObjectTableInit(__CFBinaryPlistObjectTable *table, uint64_t estimate, Boolean retainsObjects) {
+    uint64_t capacity = 64;
+    while (capacity < estimate + estimate / 3) capacity *= 2;
+    table->slots = (__CFBinaryPlistObjectSlot *)CFAllocatorAllocate(kCFAllocatorSystemDefault, (CFIndex)(capacity * sizeof(__CFBinaryPlistObjectSlot)), 0);
+    if (!table->slots) HALT;
+    memset(table->slots, 0, (size_t)(capacity * sizeof(__CFBinaryPlistObjectSlot)));
+    table->capacity = capacity;
+    table->count = 0;
+    table->retainsObjects = retainsObjects;
+}
+
+static void __CFBinaryPlistObjectTableDestroy(__CFBinaryPlistObjectTable *table) {
+    if (table->retainsObjects) {
+        for (uint64_t idx = 0; idx < table->capacity; idx++) {
+            if (table->slots[idx].object) CFRelease(table->slots[idx].object);
+        }
+    }
+    CFAllocatorDeallocate(kCFAllocatorSystemDefault, table->slots);
+    table->slots = NULL;
+}
+
+// Returns the slot holding obj, or the empty slot where it belongs. With byValue, any object CFEqual to obj matches; the hash must then be derived from CFHash.
+static __CFBinaryPlistObjectSlot *__CFBinaryPlistObjectTableFind(const __CFBinaryPlistObjectTable *table, CFTypeRef obj, uint32_t hash, Boolean byValue) {
+    const uint64_t mask = table->capacity - 1;
+    for (uint64_t idx = hash & mask; ; idx = (idx + 1) & mask) {
+        __CFBinaryPlistObjectSlot *slot = table->slots + idx;
+        if (!slot->object || slot->object == obj) return slot;
+        if (byValue && slot->hash == hash && CFEqual(slot->object, obj)) return slot;
+    }
+}
+
+// slot must have come from __CFBinaryPlistObjectTableFind with no insertion since
+static void __CFBinaryPlistObjectTableInsert(__CFBinaryPlistObjectTable *table, __CFBinaryPlistObjectSlot *slot, CFTypeRef obj, uint32_t hash, uint32_t refnum) {
+    slot->object = table->retainsObjects ? CFRetain(obj) : obj;
+    slot->hash = hash;
+    slot->refnum = refnum;
+    table->count++;
+    if (table->capacity * 3 < table->count * 4) {
+        __CFBinaryPlistObjectSlot *oldSlots = table->slots;
+        uint64_t oldCapacity = table->capacity;
+        uint64_t mask = oldCapacity * 2 - 1;
+        table->slots = (__CFBinaryPlistObjectSlot *)CFAllocatorAllocate(kCFAllocatorSystemDefault, (CFIndex)(oldCapacity * 2 * sizeof(__CFBinaryPlistObjectSlot)), 0);
+        if (!table->slots) HALT;
+        memset(table->slots, 0, (size_t)(oldCapacity * 2 * sizeof(__CFBinaryPlistObjectSlot)));
+        table->capacity = oldCapacity * 2;
+        for (uint64_t idx = 0; idx < oldCapacity; idx++) {
+            if (!oldSlots[idx].object) continue;
+            uint64_t newIdx = oldSlots[idx].hash & mask;
+            while (table->slots[newIdx].object) newIdx = (newIdx + 1) & mask;
+            table->slots[newIdx] = oldSlots[idx];
+        }
+        CFAllocatorDeallocate(kCFAllocatorSystemDefault, oldSlots);
+    }
+}
+
+// Returns false if obj was never numbered, which happens if a container hands out different objects each time it is asked for its contents
+CF_INLINE Boolean __CFBinaryPlistObjectTableGetRefnum(const __CFBinaryPlistObjectTable *table, CFTypeRef obj, uint32_t *refnum) {
+    const __CFBinaryPlistObjectSlot *slot = __CFBinaryPlistObjectTableFind(table, obj, __CFBinaryPlistMixHash((uintptr_t)obj), false);
+    *refnum = slot->refnum;
+    return slot->object != NULL;
+}
+
+static Boolean _appendObject(__CFBinaryPlistWriteBuffer *buf, CFTypeRef obj, const __CFBinaryPlistObjectTable *objtable, uint32_t objRefSize, Boolean dryRun) {
+    uint32_t refnum;
     CFIndex idx2;
     CFTypeID type = CFGetTypeID(obj);
 	if (_kCFRuntimeIDCFString == type) {
@@ -429,8 +515,11 @@ static Boolean _appendObject(__CFBinaryPlistWriteBuffer *buf, CFTypeRef obj, CFD
 		if (objtable) {
 		    uint32_t swapped = 0;
 		    uint8_t *source = (uint8_t *)&swapped;
-		    refnum = (uint32_t)(uintptr_t)CFDictionaryGetValue(objtable, value);
-		    swapped = CFSwapInt32HostToBig((uint32_t)refnum);
+		    if (!__CFBinaryPlistObjectTableGetRefnum(objtable, value, &refnum)) {
+			if (list != buffer) CFAllocatorDeallocate(kCFAllocatorSystemDefault, list);
+			return false;
+		    }
+		    swapped = CFSwapInt32HostToBig(refnum);
 		    bufferWrite(buf, source + sizeof(swapped) - objRefSize, objRefSize, dryRun);
 		} else {
 		    Boolean ret = _appendObject(buf, value, objtable, objRefSize, dryRun);
@@ -456,8 +545,11 @@ static Boolean _appendObject(__CFBinaryPlistWriteBuffer *buf, CFTypeRef obj, CFD
 		if (objtable) {
 		    uint32_t swapped = 0;
 		    uint8_t *source = (uint8_t *)&swapped;
-		    refnum = (uint32_t)(uintptr_t)CFDictionaryGetValue(objtable, value);
-		    swapped = CFSwapInt32HostToBig((uint32_t)refnum);
+		    if (!__CFBinaryPlistObjectTableGetRefnum(objtable, value, &refnum)) {
+			if (list != buffer) CFAllocatorDeallocate(kCFAllocatorSystemDefault, list);
+			return false;
+		    }
+		    swapped = CFSwapInt32HostToBig(refnum);
 		    bufferWrite(buf, source + sizeof(swapped) - objRefSize, objRefSize, dryRun);
 		} else {
 		    Boolean ret = _appendObject(buf, value, objtable, objRefSize, dryRun);
@@ -476,36 +568,49 @@ static Boolean _appendObject(__CFBinaryPlistWriteBuffer *buf, CFTypeRef obj, CFD
     return true;
 }
 
-static void _flattenPlist(CFPropertyListRef plist, CFMutableArrayRef objlist, CFMutableDictionaryRef objtable, CFMutableSetRef uniquingset) {
-    uint32_t refnum;
+// The objects to write, indexed by reference number; where several objects share a number by value, the first one reached holds it
+typedef struct {
+    CFTypeRef *objects;
+    uint32_t count;
+    uint32_t capacity;
+} __CFBinaryPlistObjectList;
+
+static void __CFBinaryPlistObjectListAppend(__CFBinaryPlistObjectList *list, CFTypeRef obj) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 64;
+        list->objects = (CFTypeRef *)CFAllocatorReallocate(kCFAllocatorSystemDefault, list->objects, (CFIndex)(list->capacity * sizeof(CFTypeRef)), 0);
+        if (!list->objects) HALT;
+    }
+    list->objects[list->count++] = obj;
+}
+
+static void _flattenPlist(CFPropertyListRef plist, __CFBinaryPlistObjectTable *objtable, __CFBinaryPlistObjectTable *uniquingtable, __CFBinaryPlistObjectList *objlist) {
+    const uint32_t identityHash = __CFBinaryPlistMixHash((uintptr_t)plist);
+    __CFBinaryPlistObjectSlot *slot = __CFBinaryPlistObjectTableFind(objtable, plist, identityHash, false);
+    if (slot->object) return;	// this very object was seen before
     CFTypeID type = CFGetTypeID(plist);
 
-    // Do not unique dictionaries or arrays, because: they
+    // Do not unique dictionaries or arrays by value, because: they
     // are slow to compare, and have poor hash codes.
-    // Uniquing bools is unnecessary.
+    // Uniquing bools by value is unnecessary.
     if (_kCFRuntimeIDCFString == type || _kCFRuntimeIDCFNumber == type || _kCFRuntimeIDCFDate == type || _kCFRuntimeIDCFData == type) {
-	CFIndex before = CFSetGetCount(uniquingset);
-	CFSetAddValue(uniquingset, plist);
-	CFIndex after = CFSetGetCount(uniquingset);
-	if (after == before) {	// already in set
-	    CFPropertyListRef unique = CFSetGetValue(uniquingset, plist);
-	    if (unique != plist) {
-		refnum = (uint32_t)(uintptr_t)CFDictionaryGetValue(objtable, unique);
-		CFDictionaryAddValue(objtable, plist, (const void *)(uintptr_t)refnum);
-	    }
+	const uint32_t valueHash = __CFBinaryPlistMixHash(CFHash(plist));
+	__CFBinaryPlistObjectSlot *unique = __CFBinaryPlistObjectTableFind(uniquingtable, plist, valueHash, true);
+	if (unique->object) {	// an equal object was seen before
+	    __CFBinaryPlistObjectTableInsert(objtable, slot, plist, identityHash, unique->refnum);
 	    return;
 	}
+	__CFBinaryPlistObjectTableInsert(uniquingtable, unique, plist, valueHash, objlist->count);
     }
-    refnum = CFArrayGetCount(objlist);
-    CFArrayAppendValue(objlist, plist);
-    CFDictionaryAddValue(objtable, plist, (const void *)(uintptr_t)refnum);
+    __CFBinaryPlistObjectTableInsert(objtable, slot, plist, identityHash, objlist->count);
+    __CFBinaryPlistObjectListAppend(objlist, plist);
     if (_kCFRuntimeIDCFDictionary == type) {
         CFIndex count = CFDictionaryGetCount((CFDictionaryRef)plist);
         STACK_BUFFER_DECL(CFPropertyListRef, buffer, count <= 128 ? count * 2 : 1);
         CFPropertyListRef *list = (count <= 128) ? buffer : (CFPropertyListRef *)CFAllocatorAllocate(kCFAllocatorSystemDefault, 2 * count * sizeof(CFTypeRef), 0);
         CFDictionaryGetKeysAndValues((CFDictionaryRef)plist, list, list + count);
         for (CFIndex idx = 0; idx < 2 * count; idx++) {
-            _flattenPlist(list[idx], objlist, objtable, uniquingset);
+            _flattenPlist(list[idx], objtable, uniquingtable, objlist);
         }
         if (list != buffer) CFAllocatorDeallocate(kCFAllocatorSystemDefault, list);
     } else if (_kCFRuntimeIDCFArray == type) {
@@ -514,7 +619,7 @@ static void _flattenPlist(CFPropertyListRef plist, CFMutableArrayRef objlist, CF
         CFPropertyListRef *list = (count <= 256) ? buffer : (CFPropertyListRef *)CFAllocatorAllocate(kCFAllocatorSystemDefault, count * sizeof(CFTypeRef), 0);
         CFArrayGetValues((CFArrayRef)plist, CFRangeMake(0, count), list);
         for (CFIndex idx = 0; idx < count; idx++) {
-            _flattenPlist(list[idx], objlist, objtable, uniquingset);
+            _flattenPlist(list[idx], objtable, uniquingtable, objlist);
         }
         if (list != buffer) CFAllocatorDeallocate(kCFAllocatorSystemDefault, list);
     }
@@ -544,41 +649,24 @@ CF_INLINE uint8_t _byteCount(uint64_t count) {
 // stream can be a CFWriteStreamRef (on supported platforms) or a CFMutableDataRef
 /* Write a property list to a stream, in binary format. plist is the property list to write (one of the basic property list types), stream is the destination of the property list, and estimate is a best-guess at the total number of objects in the property list. The estimate parameter is for efficiency in pre-allocating memory for the uniquing step. Pass in a 0 if no estimate is available. The options flag specifies sort options. If sizeOnly is true, then no actual buffer allocations will be done, but the necessary buffer size will be calculated and return. If the error parameter is non-NULL and an error occurs, it will be used to return a CFError explaining the problem. It is the callers responsibility to release the error. */
 CF_PRIVATE CFIndex __CFBinaryPlistWriteOrPresize(CFPropertyListRef plist, CFTypeRef stream, uint64_t estimate, CFOptionFlags options, Boolean sizeOnly, CFErrorRef *error) {
-    CFMutableDictionaryRef objtable = NULL;
-    CFMutableArrayRef objlist = NULL;
-    CFMutableSetRef uniquingset = NULL;
+    __CFBinaryPlistObjectTable objtable;
+    __CFBinaryPlistObjectTable uniquingtable;
+    __CFBinaryPlistObjectList objlist = {NULL, 0, 0};
     CFBinaryPlistTrailer trailer;
     uint64_t *offsets, length_so_far;
-    int64_t idx, cnt;
+    uint32_t idx, cnt = 0;
     __CFBinaryPlistWriteBuffer *buf;
 
     //If we're actually serializing, rather than just pre-sizing, we have to have something to serialize into.
     CFAssert(stream || sizeOnly, __kCFLogAssertion, "Passing NULL for the stream argument to __CFBinaryPlistWriteOrPresize is only valid if sizeOnly is true");
 
-    /*
-     This is exactly the same as a CFDictionary with NULL callbacks, except that it has the "aggressive growth" flag set, since we're not keeping it around. Radar 21883482
-     */
-    CFBasicHashCallbacks callbacks = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-    objtable = 	(CFMutableDictionaryRef)CFBasicHashCreate(kCFAllocatorSystemDefault, kCFBasicHashHasKeys | kCFBasicHashLinearHashing | kCFBasicHashAggressiveGrowth, &callbacks);
-    _CFRuntimeSetInstanceTypeIDAndIsa(objtable, CFDictionaryGetTypeID());
-    
-    const CFArrayCallBacks arrayCallbacks = {0, __CFTypeCollectionRetain, __CFTypeCollectionRelease, 0, 0};
-    objlist = CFArrayCreateMutable(kCFAllocatorSystemDefault, 0, &arrayCallbacks);
-    
-    const CFSetCallBacks setCallbacks = {0, __CFTypeCollectionRetain, __CFTypeCollectionRelease, 0, 0, 0};
-    uniquingset = CFSetCreateMutable(kCFAllocatorSystemDefault, 0, &setCallbacks);
-
-#if TARGET_OS_OSX
-    _CFDictionarySetCapacity(objtable, estimate ? estimate : 650);
-    _CFArraySetCapacity(objlist, estimate ? estimate : 650);
-    _CFSetSetCapacity(uniquingset, estimate ? estimate : 1000);
-#endif
-
-    _flattenPlist(plist, objlist, objtable, uniquingset);
+    // The reference size depends on the total number of objects, so they all have to be numbered before the first container can be written
+    __CFBinaryPlistObjectTableInit(&objtable, estimate, true);
+    __CFBinaryPlistObjectTableInit(&uniquingtable, estimate, false);
+    _flattenPlist(plist, &objtable, &uniquingtable, &objlist);
+    __CFBinaryPlistObjectTableDestroy(&uniquingtable);
+    cnt = objlist.count;
 
-    CFRelease(uniquingset);
-    
-    cnt = CFArrayGetCount(objlist);
     offsets = (uint64_t *)CFAllocatorAllocate(kCFAllocatorSystemDefault, (CFIndex)(cnt * sizeof(*offsets)), 0);
 
     buf = (__CFBinaryPlistWriteBuffer *)CFAllocatorAllocate(kCFAllocatorSystemDefault, sizeof(__CFBinaryPlistWriteBuffer), 0);
@@ -595,27 +683,25 @@ CF_PRIVATE CFIndex __CFBinaryPlistWriteOrPresize(CFPropertyListRef plist, CFType
     trailer._numObjects = CFSwapInt64HostToBig(cnt);
     trailer._topObject = 0;	// true for this implementation
     trailer._objectRefSize = _byteCount(cnt);    
-    for (idx = 0; idx < cnt; idx++) {
+    Boolean success = true;
+    for (idx = 0; success && idx < cnt; idx++) {
 	offsets[idx] = buf->written + buf->used;
-	CFPropertyListRef obj = CFArrayGetValueAtIndex(objlist, (CFIndex)idx);
-	Boolean success = _appendObject(buf, obj, objtable, trailer._objectRefSize, sizeOnly);
-	if (!success) {
-	    CFRelease(objtable);
-	    CFRelease(objlist);
-	    if (error && buf->error) {
-		// caller will release error
-		*error = buf->error;
-	    } else if (buf->error) {
-		// caller is not interested in error, release it here
-		CFRelease(buf->error);
-	    }
-	    CFAllocatorDeallocate(kCFAllocatorSystemDefault, buf);
-            CFAllocatorDeallocate(kCFAllocatorSystemDefault, offsets);
-	    return 0;
+	success = _appendObject(buf, objlist.objects[idx], &objtable, trailer._objectRefSize, sizeOnly);
+    }
+    CFAllocatorDeallocate(kCFAllocatorSystemDefault, objlist.objects);
+    __CFBinaryPlistObjectTableDestroy(&objtable);
+    if (!success) {
+	if (error && buf->error) {
+	    // caller will release error
+	    *error = buf->error;
+	} else if (buf->error) {
+	    // caller is not interested in error, release it here
+	    CFRelease(buf->error);
 	}
+	CFAllocatorDeallocate(kCFAllocatorSystemDefault, buf);
+        CFAllocatorDeallocate(kCFAllocatorSystemDefault, offsets);
+	return 0;
     }
-    CFRelease(objtable);
-    CFRelease(objlist);
     
     length_so_far = buf->written + buf->used;
     trailer._offsetTableOffset = CFSwapInt64HostToBig(length_so_far);
@@ -626,7 +712,7 @@ CF_PRIVATE CFIndex __CFBinaryPlistWriteOrPresize(CFPropertyListRef plist, CFType
 	uint8_t *source = (uint8_t *)&swapped;
 	bufferWrite(buf, source + sizeof(*offsets) - trailer._offsetIntSize, trailer._offsetIntSize, sizeOnly);
     }
-    length_so_far += cnt * trailer._offsetIntSize;
+    length_so_far += (uint64_t)cnt * trailer._offsetIntSize;
     CFAllocatorDeallocate(kCFAllocatorSystemDefault, offsets);
 
     bufferWrite(buf, (uint8_t *)&trailer, sizeof(trailer), sizeOnly);
@@ -1716,3 +1802,184 @@ if (!CFEqual(pl, pl2)) CFLog(3, CFSTR("*** error: plists before and after are no
     FAIL_FALSE;
 }
 
+
+#pragma mark -
+#pragma mark Lazy Reading
+
+// from CFUtilities.c
+CF_PRIVATE Boolean _CFReadMappedFromFile(CFStringRef path, Boolean map, Boolean uncached, void **outBytes, CFIndex *outLength, CFErrorRef *errorPtr);
+
+struct __CFBinaryPlistReader {
+    CFAllocatorRef allocator;
+    CFDataRef data;             // retained when the reader was created from data
+    const uint8_t *bytes;
+    uint64_t length;
+    Boolean mapped;
+    uint64_t topObject;
+    CFBinaryPlistTrailer trailer;
+};
+
+static void __CFBinaryPlistReaderFreeFileBytes(void *bytes, CFIndex length, Boolean mapped) {
+#if TARGET_OS_MAC || TARGET_OS_LINUX || TARGET_OS_BSD
+    // _CFReadMappedFromFile mallocs a placeholder rather than mapping an empty file
+    if (mapped && 0 < length) {
+        munmap(bytes, length);
+        return;
+    }
+#endif
+    free(bytes);
+}
+
+static _CFBinaryPlistReaderRef __CFBinaryPlistReaderCreate(CFAllocatorRef allocator, CFDataRef data, const uint8_t *bytes, uint64_t length, Boolean mapped, CFErrorRef *error) {
+    uint8_t marker;
+    uint64_t offset;
+    CFBinaryPlistTrailer trailer;
+    if (length < 8 || !__CFBinaryPlistGetTopLevelInfo(bytes, length, &marker, &offset, &trailer)) {
+        if (error) *error = __CFPropertyListCreateError(kCFPropertyListReadCorruptError, CFSTR("Cannot open a binary property list reader on data that is not a binary property list"));
+        return NULL;
+    }
+    if (NULL == allocator) allocator = __CFGetDefaultAllocator();
+    struct __CFBinaryPlistReader *reader = (struct __CFBinaryPlistReader *)CFAllocatorAllocate(allocator, sizeof(struct __CFBinaryPlistReader), 0);
+    if (!reader) HALT;
+    reader->allocator = (CFAllocatorRef)CFRetain(allocator);
+    reader->data = data ? (CFDataRef)CFRetain(data) : NULL;
+    reader->bytes = bytes;
+    reader->length = length;
+    reader->mapped = mapped;
+    reader->topObject = offset;
+    reader->trailer = trailer;
+    return reader;
+}
+
+_CFBinaryPlistReaderRef _CFBinaryPlistReaderCreateWithData(CFAllocatorRef allocator, CFDataRef data, CFErrorRef *error) {
+    return __CFBinaryPlistReaderCreate(allocator, data, CFDataGetBytePtr(data), CFDataGetLength(data), false, error);
+}
+
+_CFBinaryPlistReaderRef _CFBinaryPlistReaderCreateWithContentsOfFile(CFAllocatorRef allocator, CFStringRef path, CFErrorRef *error) {
+    void *bytes = NULL;
+    CFIndex length = 0;
+#if TARGET_OS_MAC || TARGET_OS_LINUX || TARGET_OS_BSD
+    Boolean mapped = true;
+#else
+    Boolean mapped = false;
+#endif
+    if (!_CFReadMappedFromFile(path, mapped, false, &bytes, &length, error)) return NULL;
+    _CFBinaryPlistReaderRef reader = __CFBinaryPlistReaderCreate(allocator, NULL, (const uint8_t *)bytes, length, mapped, error);
+    if (!reader) __CFBinaryPlistReaderFreeFileBytes(bytes, length, mapped);
+    return reader;
+}
+
+void _CFBinaryPlistReaderRelease(_CFBinaryPlistReaderRef reader) {
+    CFAllocatorRef allocator = reader->allocator;
+    if (reader->data) {
+        CFRelease(reader->data);
+    } else {
+        __CFBinaryPlistReaderFreeFileBytes((void *)reader->bytes, (CFIndex)reader->length, reader->mapped);
+    }
+    CFAllocatorDeallocate(allocator, reader);
+    CFRelease(allocator);
+}
+
+uint64_t _CFBinaryPlistReaderGetTopLevelObject(_CFBinaryPlistReaderRef reader) {
+    return reader->topObject;
+}
+
+CFTypeID _CFBinaryPlistReaderGetTypeID(_CFBinaryPlistReaderRef reader, uint64_t object) {
+    if (object < 8 || _CFBinaryPlistTrailer_objectsRangeEnd(&reader->trailer) < object) return _kCFRuntimeNotATypeID;
+    uint8_t marker = *(reader->bytes + object);
+    switch (marker & 0xf0) {
+    case kCFBinaryPlistMarkerNull:
+        if (kCFBinaryPlistMarkerNull == marker) return _kCFRuntimeIDCFNull;
+        if (kCFBinaryPlistMarkerFalse == marker || kCFBinaryPlistMarkerTrue == marker) return _kCFRuntimeIDCFBoolean;
+        return _kCFRuntimeNotATypeID;
+    case kCFBinaryPlistMarkerInt:
+    case kCFBinaryPlistMarkerReal:
+        return _kCFRuntimeIDCFNumber;
+    case kCFBinaryPlistMarkerDate & 0xf0:
+        return kCFBinaryPlistMarkerDate == marker ? _kCFRuntimeIDCFDate : _kCFRuntimeNotATypeID;
+    case kCFBinaryPlistMarkerData:
+        return _kCFRuntimeIDCFData;
+    case kCFBinaryPlistMarkerASCIIString:
+    case kCFBinaryPlistMarkerUnicode16String:
+        return _kCFRuntimeIDCFString;
+    case kCFBinaryPlistMarkerUID:
+        return _CFKeyedArchiverUIDGetTypeID();
+    case kCFBinaryPlistMarkerArray:
+        return _kCFRuntimeIDCFArray;
+    case kCFBinaryPlistMarkerSet:
+        return _kCFRuntimeIDCFSet;
+    case kCFBinaryPlistMarkerDict:
+        return _kCFRuntimeIDCFDictionary;
+    }
+    return _kCFRuntimeNotATypeID;
+}
+
+// Reads the header of the array, set or dictionary at startOffset. For dictionaries the count is the number of entries; the refs are the keys followed by the values.
+static bool __CFBinaryPlistReaderGetCollectionInfo(_CFBinaryPlistReaderRef reader, uint64_t startOffset, uint8_t *outType, uint64_t *outCount, const uint8_t **outRefs) {
+    const uint8_t *databytes = reader->bytes;
+    const uint64_t objectsRangeEnd = _CFBinaryPlistTrailer_objectsRangeEnd(&reader->trailer);
+    if (startOffset < 8 || objectsRangeEnd < startOffset) FAIL_FALSE;
+    const uint8_t *ptr = databytes + startOffset;
+    uint8_t marker = *ptr;
+    uint8_t type = marker & 0xf0;
+    if (kCFBinaryPlistMarkerArray != type && kCFBinaryPlistMarkerSet != type && kCFBinaryPlistMarkerDict != type) FAIL_FALSE;
+    int32_t err = CF_NO_ERROR;
+    ptr = check_ptr_add(ptr, 1, &err);
+    if (CF_NO_ERROR != err) FAIL_FALSE;
+    uint64_t cnt = (marker & 0x0f);
+    if (0xf == cnt) {
+        uint64_t bigint = 0;
+        if (!_readInt(ptr, databytes + objectsRangeEnd, &bigint, &ptr)) FAIL_FALSE;
+        if (LONG_MAX < bigint) FAIL_FALSE;
+        cnt = bigint;
+    }
+    size_t refCount = check_size_t_mul(cnt, kCFBinaryPlistMarkerDict == type ? 2 : 1, &err);
+    if (CF_NO_ERROR != err) FAIL_FALSE;
+    size_t byte_cnt = check_size_t_mul(refCount, reader->trailer._objectRefSize, &err);
+    if (CF_NO_ERROR != err) FAIL_FALSE;
+    const uint8_t *extent = check_ptr_add(ptr, byte_cnt, &err) - 1;
+    if (CF_NO_ERROR != err) FAIL_FALSE;
+    if (databytes + objectsRangeEnd < extent) FAIL_FALSE;
+    if (outType) *outType = type;
+    if (outCount) *outCount = cnt;
+    if (outRefs) *outRefs = ptr;
+    return true;
+}
+
+CFIndex _CFBinaryPlistReaderGetCount(_CFBinaryPlistReaderRef reader, uint64_t object) {
+    uint64_t cnt;
+    if (!__CFBinaryPlistReaderGetCollectionInfo(reader, object, NULL, &cnt, NULL)) return -1;
+    return (CFIndex)cnt;
+}
+
+bool _CFBinaryPlistReaderGetObjectAtIndex(_CFBinaryPlistReaderRef reader, uint64_t array, CFIndex idx, uint64_t *outObject) {
+    if (idx < 0) FAIL_FALSE;
+    return __CFBinaryPlistGetOffsetForValueFromArray2(reader->bytes, reader->length, array, &reader->trailer, idx, outObject, NULL);
+}
+
+bool _CFBinaryPlistReaderGetObjectForKey(_CFBinaryPlistReaderRef reader, uint64_t dictionary, CFTypeRef key, uint64_t *outObject) {
+    return __CFBinaryPlistGetOffsetForValueFromDictionary3(reader->bytes, reader->length, dictionary, &reader->trailer, key, NULL, outObject, false, NULL);
+}
+
+bool _CFBinaryPlistReaderGetKeyAndObjectAtIndex(_CFBinaryPlistReaderRef reader, uint64_t dictionary, CFIndex idx, uint64_t *outKey, uint64_t *outObject) {
+    uint8_t type;
+    uint64_t cnt;
+    const uint8_t *refs;
+    if (!__CFBinaryPlistReaderGetCollectionInfo(reader, dictionary, &type, &cnt, &refs)) FAIL_FALSE;
+    if (kCFBinaryPlistMarkerDict != type || idx < 0 || cnt <= idx) FAIL_FALSE;
+    const uint8_t refSize = reader->trailer._objectRefSize;
+    if (!_getOffsetOfRefAt(reader->bytes, refs + idx * refSize, &reader->trailer, outKey)) FAIL_FALSE;
+    if (!_getOffsetOfRefAt(reader->bytes, refs + (cnt + idx) * refSize, &reader->trailer, outObject)) FAIL_FALSE;
+    return true;
+}
+
+CFPropertyListRef _CFBinaryPlistReaderCopyObject(_CFBinaryPlistReaderRef reader, uint64_t object, CFOptionFlags mutabilityOption) {
+    // The cache only lives as long as this copy; see __CFTryParseBinaryPlist for why it does not retain its keys
+    CFMutableDictionaryRef objects = CFDictionaryCreateMutable(kCFAllocatorSystemDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+    CFPropertyListRef plist = NULL;
+    if (!__CFBinaryPlistCreateObjectFiltered(reader->bytes, reader->length, object, &reader->trailer, reader->allocator, mutabilityOption, objects, NULL, 0, NULL, &plist)) {
+        plist = NULL;
+    }
+    CFRelease(objects);
+    return plist;
+}
@@ -343,6 +343,50 @@ CFArrayRef CFBundleCopyExecutableArchitecturesForURL(CFURLRef url) {
     return result;
 }
 
+#pragma mark -
+#pragma mark Resource Lookup - Persistent Index
+
+/*
+ Building a query table reads every resource and lproj directory it covers, and every process pays for that again on its first lookup. When the CFBundleResourceIndexDirectory environment variable names a writable directory, each query table built is also saved there as a binary property list, along with the modification time of every directory read to build it. Later processes map that file and use the saved table instead of reading the directories again, for as long as none of those directories has changed.
+ 
+ An index file holds a dictionary with these keys:
+    Version       _CFBundleResourceIndexVersion
+    Key           the bundle path, subdirectory, languages and product and platform suffixes the table was built for
+    Directories   each directory read, mapped to its modification time in nanoseconds, or -1 if it did not exist
+    Table         the query table
+ Files are named after the hash of their key; a file whose key does not match is simply rebuilt and replaced.
+*/
+
+#define _CFBundleResourceIndexVersion 1
+
+static CFStringRef _CFBundleCopyResourceIndexDirectory(void) {
+    const char *path = __CFgetenv("CFBundleResourceIndexDirectory");
+    return (path && path[0]) ? CFStringCreateWithFileSystemRepresentation(kCFAllocatorSystemDefault, path) : NULL;
+}
+
+static int64_t _CFBundleGetDirectoryStamp(CFStringRef path) {
+    char cpath[CFMaxPathSize];
+    struct statinfo statBuf;
+    if (!CFStringGetFileSystemRepresentation(path, cpath, CFMaxPathSize) || stat(cpath, &statBuf) != 0) {
+        return -1;
+    }
+#if TARGET_OS_MAC
+    struct timespec ts = statBuf.st_mtimespec;
+#elif TARGET_OS_LINUX || TARGET_OS_BSD
+    struct timespec ts = statBuf.st_mtim;
+#else
+    struct timespec ts = {statBuf.st_mtime, 0};
+#endif
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void _CFBundleRecordDirectoryStamp(CFMutableDictionaryRef directoryStamps, CFStringRef path) {
+    int64_t stamp = _CFBundleGetDirectoryStamp(path);
+    CFNumberRef number = CFNumberCreate(kCFAllocatorSystemDefault, kCFNumberSInt64Type, &stamp);
+    CFDictionarySetValue(directoryStamps, path, number);
+    CFRelease(number);
+}
+
 #pragma mark -
 #pragma mark Resource Lookup - Query Table
 
@@ -530,7 +574,10 @@ static void _CFBundleSplitFileName(CFStringRef fileName, CFStringRef *noProductO
     }    
 }
 
-static Boolean _CFBundleReadDirectory(CFStringRef pathOfDir, CFStringRef subdirectory, CFMutableArrayRef allFiles, Boolean hasFileAdded, CFMutableDictionaryRef queryTable, CFMutableDictionaryRef typeDir, CFMutableDictionaryRef addedTypes, Boolean firstLproj, CFStringRef lprojName) {
+static Boolean _CFBundleReadDirectory(CFStringRef pathOfDir, CFStringRef subdirectory, CFMutableArrayRef allFiles, Boolean hasFileAdded, CFMutableDictionaryRef queryTable, CFMutableDictionaryRef typeDir, CFMutableDictionaryRef addedTypes, Boolean firstLproj, CFStringRef lprojName, CFMutableDictionaryRef directoryStamps) {
+    
+    // Stamp the directory before reading it, so that a change made while it is being read invalidates the index
+    if (directoryStamps) _CFBundleRecordDirectoryStamp(directoryStamps, pathOfDir);
     
     CFStringRef product = _CFBundleGetProductNameSuffix();
     CFStringRef platform = _CFBundleGetPlatformNameSuffix();
@@ -626,7 +673,7 @@ static Boolean _CFBundleReadDirectory(CFStringRef pathOfDir, CFStringRef subdire
 }
 
 
-static CFDictionaryRef _createQueryTableAtPath(CFStringRef inPath, CFArrayRef languages, CFStringRef resourcesDirectory, CFStringRef subdirectory)
+static CFDictionaryRef _createQueryTableAtPath(CFStringRef inPath, CFArrayRef languages, CFStringRef resourcesDirectory, CFStringRef subdirectory, CFMutableDictionaryRef directoryStamps)
 {
     
     CFMutableDictionaryRef queryTable = CFDictionaryCreateMutable(kCFAllocatorSystemDefault, 0, &kCFCopyStringDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
@@ -646,7 +693,7 @@ static CFDictionaryRef _createQueryTableAtPath(CFStringRef inPath, CFArrayRef la
         _CFAppendPathComponent2(path, subdirectory);
     }
     // read the content in sub dir and put them into query table
-    _CFBundleReadDirectory(path, subdirectory, allFiles, false, queryTable, typeDir, NULL, false, NULL);
+    _CFBundleReadDirectory(path, subdirectory, allFiles, false, queryTable, typeDir, NULL, false, NULL, directoryStamps);
     CFStringDelete(path, CFRangeMake(basePathLen, CFStringGetLength(path) - basePathLen));    // Strip the string back to the base path
     
     CFIndex numOfAllFiles = CFArrayGetCount(allFiles);
@@ -667,7 +714,7 @@ static CFDictionaryRef _createQueryTableAtPath(CFStringRef inPath, CFArrayRef la
         if (subdirectory) {
             _CFAppendPathComponent2(path, subdirectory);
         }
-        _CFBundleReadDirectory(path, subdirectory, allFiles, hasFileAdded, queryTable, typeDir, addedTypes, firstLproj, lprojTargetWithLproj);
+        _CFBundleReadDirectory(path, subdirectory, allFiles, hasFileAdded, queryTable, typeDir, addedTypes, firstLproj, lprojTargetWithLproj, directoryStamps);
         CFRelease(lprojTargetWithLproj);
         CFStringDelete(path, CFRangeMake(basePathLen, CFStringGetLength(path) - basePathLen));         // Strip the string back to the base path
         
@@ -683,7 +730,7 @@ static CFDictionaryRef _createQueryTableAtPath(CFStringRef inPath, CFArrayRef la
     if (subdirectory) {
         _CFAppendPathComponent2(path, subdirectory);
     }
-    _CFBundleReadDirectory(path, subdirectory, allFiles, hasFileAdded, queryTable, typeDir, addedTypes, YES, _CFBundleBaseDirectoryWithLproj);
+    _CFBundleReadDirectory(path, subdirectory, allFiles, hasFileAdded, queryTable, typeDir, addedTypes, YES, _CFBundleBaseDirectoryWithLproj, directoryStamps);
     CFStringDelete(path, CFRangeMake(basePathLen, CFStringGetLength(path) - basePathLen));    // Strip the string back to the base path
     
     if (!hasFileAdded && numOfAllFiles < CFArrayGetCount(allFiles)) {
@@ -702,7 +749,7 @@ static CFDictionaryRef _createQueryTableAtPath(CFStringRef inPath, CFArrayRef la
             if (subdirectory) {
                 _CFAppendPathComponent2(path, subdirectory);
             }
-            _CFBundleReadDirectory(path, subdirectory, allFiles, hasFileAdded, queryTable, typeDir, addedTypes, false, lprojTargetWithLproj);
+            _CFBundleReadDirectory(path, subdirectory, allFiles, hasFileAdded, queryTable, typeDir, addedTypes, false, lprojTargetWithLproj, directoryStamps);
             CFRelease(lprojTargetWithLproj);
             CFStringDelete(path, CFRangeMake(basePathLen, CFStringGetLength(path) - basePathLen));         // Strip the string back to the base path
 
@@ -726,6 +773,162 @@ static CFDictionaryRef _createQueryTableAtPath(CFStringRef inPath, CFArrayRef la
     return queryTable;
 }   
 
+static CFStringRef _CFBundleCopyResourceIndexKey(CFStringRef bundlePath, CFArrayRef languages, CFStringRef resourcesDirectory, CFStringRef subdirectory) {
+    CFStringRef languageList = languages ? CFStringCreateByCombiningStrings(kCFAllocatorSystemDefault, languages, CFSTR(",")) : (CFStringRef)CFRetain(CFSTR(""));
+    CFStringRef product = _CFBundleGetProductNameSuffix();
+    CFStringRef platform = _CFBundleGetPlatformNameSuffix();
+    CFStringRef key = CFStringCreateWithFormat(kCFAllocatorSystemDefault, NULL, CFSTR("%@\n%@\n%@\n%@\n%@\n%@"), bundlePath, resourcesDirectory ? resourcesDirectory : CFSTR(""), subdirectory ? subdirectory : CFSTR(""), languageList, product ? product : CFSTR(""), platform ? platform : CFSTR(""));
+    CFRelease(languageList);
+    return key;
+}
+
+// A 64-bit FNV-1a hash of the key's UTF-8 bytes. Unlike CFHash it is the same in every process, so the index written by one run is found by the next.
+static uint64_t _CFBundleHashResourceIndexKey(CFStringRef key) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    uint8_t buffer[256];
+    CFIndex length = CFStringGetLength(key);
+    CFIndex location = 0;
+    while (location < length) {
+        CFIndex usedBufLen = 0;
+        CFIndex converted = CFStringGetBytes(key, CFRangeMake(location, length - location), kCFStringEncodingUTF8, '?', false, buffer, sizeof(buffer), &usedBufLen);
+        if (converted <= 0) break;
+        for (CFIndex idx = 0; idx < usedBufLen; idx++) {
+            hash ^= buffer[idx];
+            hash *= 0x100000001b3ULL;
+        }
+        location += converted;
+    }
+    return hash;
+}
+
+static CFStringRef _CFBundleCopyResourceIndexPath(CFStringRef indexDirectory, CFStringRef key) {
+    CFMutableStringRef path = CFStringCreateMutableCopy(kCFAllocatorSystemDefault, 0, indexDirectory);
+    CFStringRef fileName = CFStringCreateWithFormat(kCFAllocatorSystemDefault, NULL, CFSTR("%016llx.cfbundleindex"), (unsigned long long)_CFBundleHashResourceIndexKey(key));
+    _CFAppendPathComponent2(path, fileName);
+    CFRelease(fileName);
+    return path;
+}
+
+// Returns the value for key in the index dictionary if it has the given type
+static CFTypeRef _CFBundleCopyResourceIndexValue(_CFBinaryPlistReaderRef reader, uint64_t index, CFStringRef key, CFTypeID typeID) {
+    uint64_t object;
+    if (!_CFBinaryPlistReaderGetObjectForKey(reader, index, key, &object) || _CFBinaryPlistReaderGetTypeID(reader, object) != typeID) {
+        return NULL;
+    }
+    return _CFBinaryPlistReaderCopyObject(reader, object, kCFPropertyListImmutable);
+}
+
+static void _CFBundleCheckDirectoryStamp(const void *key, const void *value, void *context) {
+    Boolean *valid = (Boolean *)context;
+    int64_t stamp;
+    if (!*valid) return;
+    if (CFGetTypeID(key) != CFStringGetTypeID() || CFGetTypeID(value) != CFNumberGetTypeID() || !CFNumberGetValue((CFNumberRef)value, kCFNumberSInt64Type, &stamp)) {
+        *valid = false;
+        return;
+    }
+    *valid = (stamp == _CFBundleGetDirectoryStamp((CFStringRef)key));
+}
+
+// Returns the saved query table if the index at indexPath was built for key and none of its directories has changed since
+static CFDictionaryRef _CFBundleCopyQueryTableFromIndex(CFStringRef indexPath, CFStringRef key) {
+    _CFBinaryPlistReaderRef reader = _CFBinaryPlistReaderCreateWithContentsOfFile(kCFAllocatorSystemDefault, indexPath, NULL);
+    if (!reader) return NULL;
+    
+    CFDictionaryRef table = NULL;
+    uint64_t index = _CFBinaryPlistReaderGetTopLevelObject(reader);
+    if (_CFBinaryPlistReaderGetTypeID(reader, index) == CFDictionaryGetTypeID()) {
+        CFNumberRef version = (CFNumberRef)_CFBundleCopyResourceIndexValue(reader, index, CFSTR("Version"), CFNumberGetTypeID());
+        CFStringRef indexKey = (CFStringRef)_CFBundleCopyResourceIndexValue(reader, index, CFSTR("Key"), CFStringGetTypeID());
+        int32_t versionValue = 0;
+        Boolean valid = version && CFNumberGetValue(version, kCFNumberSInt32Type, &versionValue) && versionValue == _CFBundleResourceIndexVersion && indexKey && CFEqual(indexKey, key);
+        
+        // Only stat the directories, and only then copy the table, once the index is known to be the right one
+        if (valid) {
+            CFDictionaryRef directoryStamps = (CFDictionaryRef)_CFBundleCopyResourceIndexValue(reader, index, CFSTR("Directories"), CFDictionaryGetTypeID());
+            valid = (directoryStamps != NULL);
+            if (directoryStamps) {
+                CFDictionaryApplyFunction(directoryStamps, _CFBundleCheckDirectoryStamp, &valid);
+                CFRelease(directoryStamps);
+            }
+        }
+        if (valid) {
+            table = (CFDictionaryRef)_CFBundleCopyResourceIndexValue(reader, index, CFSTR("Table"), CFDictionaryGetTypeID());
+        }
+        
+        if (version) CFRelease(version);
+        if (indexKey) CFRelease(indexKey);
+    }
+    _CFBinaryPlistReaderRelease(reader);
+    return table;
+}
+
+static void _CFBundleCheckDirectoryStampIsSettled(const void *key, const void *value, void *context) {
+    int64_t *threshold = (int64_t *)context;
+    int64_t stamp = 0;
+    CFNumberGetValue((CFNumberRef)value, kCFNumberSInt64Type, &stamp);
+    if (stamp >= *threshold) *threshold = -1;
+}
+
+static void _CFBundleWriteResourceIndex(CFStringRef indexDirectory, CFStringRef indexPath, CFStringRef key, CFDictionaryRef directoryStamps, CFDictionaryRef table) {
+#if TARGET_OS_MAC || TARGET_OS_LINUX || TARGET_OS_BSD
+    // A directory changed within the last second may change again without its modification time moving on file systems with coarse timestamps; leave its index for a later process to save.
+    int64_t threshold = (int64_t)((CFAbsoluteTimeGetCurrent() + kCFAbsoluteTimeIntervalSince1970 - 1.0) * 1000000000.0);
+    CFDictionaryApplyFunction(directoryStamps, _CFBundleCheckDirectoryStampIsSettled, &threshold);
+    if (threshold < 0) return;
+    
+    int32_t versionValue = _CFBundleResourceIndexVersion;
+    CFNumberRef version = CFNumberCreate(kCFAllocatorSystemDefault, kCFNumberSInt32Type, &versionValue);
+    CFTypeRef keys[4] = {CFSTR("Version"), CFSTR("Key"), CFSTR("Directories"), CFSTR("Table")};
+    CFTypeRef values[4] = {version, key, directoryStamps, table};
+    CFDictionaryRef index = CFDictionaryCreate(kCFAllocatorSystemDefault, keys, values, 4, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+    CFRelease(version);
+    CFDataRef data = CFPropertyListCreateData(kCFAllocatorSystemDefault, index, kCFPropertyListBinaryFormat_v1_0, 0, NULL);
+    CFRelease(index);
+    if (!data) return;
+    
+    // Write to a temporary file and rename it into place, so that readers never see a partial index
+    char tempPath[CFMaxPathSize];
+    char cpath[CFMaxPathSize];
+    CFMutableStringRef tempTemplate = CFStringCreateMutableCopy(kCFAllocatorSystemDefault, 0, indexDirectory);
+    _CFAppendPathComponent2(tempTemplate, CFSTR("cfbundleindex#XXXXXX"));
+    Boolean havePaths = CFStringGetFileSystemRepresentation(tempTemplate, tempPath, CFMaxPathSize) && CFStringGetFileSystemRepresentation(indexPath, cpath, CFMaxPathSize);
+    CFRelease(tempTemplate);
+    int fd = havePaths ? mkstemp(tempPath) : -1;
+    if (fd >= 0) {
+        CFIndex length = CFDataGetLength(data);
+        Boolean written = (write(fd, CFDataGetBytePtr(data), length) == length);
+        fchmod(fd, 0644);
+        close(fd);
+        if (!written || 0 != rename(tempPath, cpath)) {
+            unlink(tempPath);
+        }
+    }
+    CFRelease(data);
+#endif
+}
+
+// Creates the query table, or loads it from the resource index when one is configured and still valid
+static CFDictionaryRef _CFBundleCopyQueryTableUsingIndex(CFStringRef bundlePath, CFArrayRef languages, CFStringRef resourcesDirectory, CFStringRef subdirectory) {
+    CFStringRef indexDirectory = _CFBundleCopyResourceIndexDirectory();
+    if (!indexDirectory) {
+        return _createQueryTableAtPath(bundlePath, languages, resourcesDirectory, subdirectory, NULL);
+    }
+    
+    CFStringRef key = _CFBundleCopyResourceIndexKey(bundlePath, languages, resourcesDirectory, subdirectory);
+    CFStringRef indexPath = _CFBundleCopyResourceIndexPath(indexDirectory, key);
+    CFDictionaryRef table = _CFBundleCopyQueryTableFromIndex(indexPath, key);
+    if (!table) {
+        CFMutableDictionaryRef directoryStamps = CFDictionaryCreateMutable(kCFAllocatorSystemDefault, 0, &kCFCopyStringDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+        table = _createQueryTableAtPath(bundlePath, languages, resourcesDirectory, subdirectory, directoryStamps);
+        _CFBundleWriteResourceIndex(indexDirectory, indexPath, key, directoryStamps, table);
+        CFRelease(directoryStamps);
+    }
+    CFRelease(indexPath);
+    CFRelease(key);
+    CFRelease(indexDirectory);
+    return table;
+}
+
 // caller need to release the table
 static CFDictionaryRef _copyQueryTable(CFBundleRef bundle, CFURLRef bundleURL, CFArrayRef languages, CFStringRef resourcesDirectory, CFStringRef subdirectory)
 {
@@ -757,7 +960,7 @@ static CFDictionaryRef _copyQueryTable(CFBundleRef bundle, CFURLRef bundleURL, C
         
         if (!subTable) {
             // create the query table for the given sub dir
-            subTable = _createQueryTableAtPath(bundle->_bundleBasePath, languages, resourcesDirectory, subdirectory);
+            subTable = _CFBundleCopyQueryTableUsingIndex(bundle->_bundleBasePath, languages, resourcesDirectory, subdirectory);
             
             CFDictionarySetValue(bundle->_queryTable, argDirStr, subTable);
         } else {
@@ -769,7 +972,7 @@ static CFDictionaryRef _copyQueryTable(CFBundleRef bundle, CFURLRef bundleURL, C
         CFURLRef url = CFURLCopyAbsoluteURL(bundleURL);
         CFStringRef bundlePath = CFURLCopyFileSystemPath(url, PLATFORM_PATH_STYLE);
         CFRelease(url);
-        subTable = _createQueryTableAtPath(bundlePath, languages, resourcesDirectory, subdirectory);
+        subTable = _CFBundleCopyQueryTableUsingIndex(bundlePath, languages, resourcesDirectory, subdirectory);
         CFRelease(bundlePath);
     }
     
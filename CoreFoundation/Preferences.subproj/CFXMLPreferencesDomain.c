@@ -14,6 +14,7 @@
 #include <CoreFoundation/CFPropertyList.h>
 #include <CoreFoundation/CFNumber.h>
 #include <CoreFoundation/CFDate.h>
+#include <CoreFoundation/CFByteOrder.h>
 #include "CFInternal.h"
 #include <time.h>
 #if TARGET_OS_OSX
@@ -23,13 +24,28 @@
 #include <mach/mach.h>
 #include <mach/mach_syscalls.h>
 #endif
+#if TARGET_OS_OSX || TARGET_OS_LINUX
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#endif
 
 Boolean __CFPreferencesShouldWriteXML(void);
 
+// Identifies one version of a file on disk
+typedef struct {
+    uint64_t inode;
+    uint64_t size;
+    uint64_t modTime; // In nanoseconds
+} _CFXMLPreferencesFileStamp;
+
 typedef struct {
     CFMutableDictionaryRef _domainDict; // Current value of the domain dictionary
     CFMutableArrayRef _dirtyKeys; // The array of keys which must be synchronized
     CFAbsoluteTime _lastReadTime; // The last time we synchronized with the disk
+    _CFXMLPreferencesFileStamp _fileStamp; // The version of the file _domainDict was loaded from
+    uint64_t _journalLength; // How much of the journal has been applied to _domainDict; 0 if none was
     CFLock_t _lock; // Lock for accessing fields in the domain
     Boolean _isWorldReadable; // HACK - this is because we have no good way to propagate the kCFPreferencesAnyUser information from the upper level CFPreferences routines  REW, 1/13/00
     char _padding[3];
@@ -123,6 +139,8 @@ static void *createXMLDomain(CFAllocatorRef allocator, CFTypeRef context) {
     domain->_lastReadTime = 0.0;
     domain->_domainDict = NULL;
     domain->_dirtyKeys = CFArrayCreateMutable(allocator, 0, & kCFTypeArrayCallBacks);
+    memset(&domain->_fileStamp, 0, sizeof(domain->_fileStamp));
+    domain->_journalLength = 0;
 	const CFLock_t lock = CFLockInit;
     domain->_lock = lock;
     domain->_isWorldReadable = false;
@@ -136,34 +154,10 @@ static void freeXMLDomain(CFAllocatorRef allocator, CFTypeRef context, void *tDo
     CFAllocatorDeallocate(allocator, domain);
 }
 
-// Assumes the domain has already been locked
-static void _loadXMLDomainIfStale(CFURLRef url, _CFXMLPreferencesDomain *domain) {
+// Assumes the domain has already been locked; replaces domain->_domainDict with the contents of the file
+static void _readXMLDomainFile(CFURLRef url, _CFXMLPreferencesDomain *domain) {
     CFAllocatorRef alloc = __CFPreferencesAllocator();
     int idx;
-    if (domain->_domainDict) {
-        CFDateRef modDate;
-        CFAbsoluteTime modTime;
-    	CFURLRef testURL = url;
-
-        if (CFDictionaryGetCount(domain->_domainDict) == 0) {
-            // domain never existed; check the parent directory, not the child
-            testURL = CFURLCreateWithFileSystemPathRelativeToBase(alloc, CFSTR(".."), kCFURLPOSIXPathStyle, true, url);
-        }
-
-        modDate = (CFDateRef )CFURLCreatePropertyFromResource(alloc, testURL, kCFURLFileLastModificationTime, NULL);
-        modTime = modDate ? CFDateGetAbsoluteTime(modDate) : 0.0;
-
-        // free before possible return. we can test non-NULL of modDate but don't depend on contents after this.
-        if (testURL != url) CFRelease(testURL);
-        if (modDate) CFRelease(modDate);
-        
-        if (modDate != NULL && modTime < domain->_lastReadTime) {            // We're up-to-date
-            return;
-        }
-    }
-
-	
-    // We're out-of-date; destroy domainDict and reload
     if (domain->_domainDict) {
         CFRelease(domain->_domainDict);
         domain->_domainDict = NULL;
@@ -198,6 +192,184 @@ static void _loadXMLDomainIfStale(CFURLRef url, _CFXMLPreferencesDomain *domain)
     domain->_lastReadTime = CFAbsoluteTimeGetCurrent();
 }
 
+#if TARGET_OS_OSX || TARGET_OS_LINUX
+
+/* Change journal
+
+ Writing out the whole domain on every synchronize costs time in proportion to the size of the domain rather than to the size of the change. So next to its property list file, each domain keeps a journal ("<file>.journal") of the changes made since the file was last written. A synchronize normally appends one record holding just the keys it changed; the file is rewritten, and the journal emptied, only once the journal has grown to half the size of the file. Loading a domain reads the file and replays the journal over it, and a domain that is already loaded only reads the records appended since it last looked, so checking for changes costs two stats when nothing changed.
+
+ The journal starts with a header identifying the version of the file it applies to; a journal whose header does not match the file on disk (say, because the file was written by something unaware of the journal) is ignored. Each record is a 4-byte big-endian length followed by a binary property list dictionary of the keys set and an array of the keys removed. Writers hold an exclusive flock on the journal while they update the file or the journal, and readers a shared one, so a reader always sees the two in step.
+*/
+
+#define JOURNAL_MAGIC "CFPJRNL1"
+#define JOURNAL_HEADER_LENGTH 32 // The magic followed by the file's inode, size and modification time
+#define JOURNAL_MIN_COMPACTION_LENGTH (32 * 1024)
+
+static CFStringRef _journalSetKey = CFSTR("Set");
+static CFStringRef _journalRemoveKey = CFSTR("Remove");
+
+// Returns false, with a zeroed stamp, if the file does not exist
+static Boolean _getFileStamp(CFURLRef url, _CFXMLPreferencesFileStamp *stamp) {
+    char cpath[CFMaxPathSize];
+    struct stat statBuf;
+    memset(stamp, 0, sizeof(*stamp));
+    if (!CFURLGetFileSystemRepresentation(url, true, (uint8_t *)cpath, CFMaxPathSize) || stat(cpath, &statBuf) != 0) {
+        return false;
+    }
+#if TARGET_OS_OSX
+    struct timespec ts = statBuf.st_mtimespec;
+#else
+    struct timespec ts = statBuf.st_mtim;
+#endif
+    stamp->inode = (uint64_t)statBuf.st_ino;
+    stamp->size = (uint64_t)statBuf.st_size;
+    stamp->modTime = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    return true;
+}
+
+static Boolean _fileStampsEqual(const _CFXMLPreferencesFileStamp *a, const _CFXMLPreferencesFileStamp *b) {
+    return a->inode == b->inode && a->size == b->size && a->modTime == b->modTime;
+}
+
+static Boolean _getJournalPath(CFURLRef url, char cpath[CFMaxPathSize + 8]) {
+    if (!CFURLGetFileSystemRepresentation(url, true, (uint8_t *)cpath, CFMaxPathSize)) {
+        return false;
+    }
+    strlcat(cpath, ".journal", CFMaxPathSize + 8);
+    return true;
+}
+
+static int _openJournal(CFURLRef url, int flags, mode_t mode) {
+    char cpath[CFMaxPathSize + 8];
+    if (!_getJournalPath(url, cpath)) {
+        return -1;
+    }
+    return open(cpath, flags | O_CLOEXEC, mode);
+}
+
+static void _encodeJournalHeader(uint8_t header[JOURNAL_HEADER_LENGTH], const _CFXMLPreferencesFileStamp *stamp) {
+    uint64_t fields[3] = {CFSwapInt64HostToBig(stamp->inode), CFSwapInt64HostToBig(stamp->size), CFSwapInt64HostToBig(stamp->modTime)};
+    memmove(header, JOURNAL_MAGIC, 8);
+    memmove(header + 8, fields, sizeof(fields));
+}
+
+static Boolean _journalAppliesToFile(int journal, const _CFXMLPreferencesFileStamp *stamp) {
+    uint8_t header[JOURNAL_HEADER_LENGTH];
+    uint8_t expected[JOURNAL_HEADER_LENGTH];
+    if (pread(journal, header, JOURNAL_HEADER_LENGTH, 0) != JOURNAL_HEADER_LENGTH) return false;
+    _encodeJournalHeader(expected, stamp);
+    return 0 == memcmp(header, expected, JOURNAL_HEADER_LENGTH);
+}
+
+static void _setJournaledValue(const void *key, const void *value, void *context) {
+    CFDictionarySetValue((CFMutableDictionaryRef)context, key, value);
+}
+
+static void _applyJournalRecord(CFMutableDictionaryRef dict, CFDictionaryRef record) {
+    CFDictionaryRef set = (CFDictionaryRef)CFDictionaryGetValue(record, _journalSetKey);
+    CFArrayRef removed = (CFArrayRef)CFDictionaryGetValue(record, _journalRemoveKey);
+    if (set && CFGetTypeID(set) == CFDictionaryGetTypeID()) {
+        CFDictionaryApplyFunction(set, _setJournaledValue, dict);
+    }
+    if (removed && CFGetTypeID(removed) == CFArrayGetTypeID()) {
+        for (CFIndex idx = 0; idx < CFArrayGetCount(removed); idx++) {
+            CFDictionaryRemoveValue(dict, CFArrayGetValueAtIndex(removed, idx));
+        }
+    }
+}
+
+// Applies the complete records between from and to, and returns where the last one ends. A record cut short by a writer that died stops the replay.
+static uint64_t _replayJournal(int journal, uint64_t from, uint64_t to, CFMutableDictionaryRef dict) {
+    if (to <= from || to - from > (uint64_t)LONG_MAX) return from;
+    size_t length = (size_t)(to - from);
+    uint8_t *bytes = (uint8_t *)malloc(length);
+    if (!bytes) return from;
+    ssize_t got = pread(journal, bytes, length, (off_t)from);
+    size_t available = got > 0 ? (size_t)got : 0;
+    size_t offset = 0;
+    while (available - offset >= 4) {
+        uint32_t recordLength;
+        memmove(&recordLength, bytes + offset, 4);
+        recordLength = CFSwapInt32BigToHost(recordLength);
+        if (available - offset - 4 < recordLength) break;
+        CFDataRef data = CFDataCreateWithBytesNoCopy(kCFAllocatorSystemDefault, bytes + offset + 4, recordLength, kCFAllocatorNull);
+        CFPropertyListRef record = CFPropertyListCreateWithData(__CFPreferencesAllocator(), data, kCFPropertyListImmutable, NULL, NULL);
+        CFRelease(data);
+        if (!record) break;
+        if (CFGetTypeID(record) == CFDictionaryGetTypeID()) {
+            _applyJournalRecord(dict, (CFDictionaryRef)record);
+        }
+        CFRelease(record);
+        offset += 4 + recordLength;
+    }
+    free(bytes);
+    return from + offset;
+}
+
+// Assumes the domain has already been locked, and the journal (if there is one) is flocked
+static void _loadXMLDomainWithJournalIfStale(CFURLRef url, _CFXMLPreferencesDomain *domain, int journal) {
+    _CFXMLPreferencesFileStamp stamp;
+    Boolean exists = _getFileStamp(url, &stamp);
+    struct stat journalStat;
+    uint64_t journalLength = (journal >= 0 && 0 == fstat(journal, &journalStat)) ? (uint64_t)journalStat.st_size : 0;
+    Boolean journalApplies = exists && journalLength >= JOURNAL_HEADER_LENGTH && _journalAppliesToFile(journal, &stamp);
+
+    if (domain->_domainDict && _fileStampsEqual(&stamp, &domain->_fileStamp)) {
+        if (!journalApplies && domain->_journalLength == 0) {
+            return;     // We're up-to-date
+        }
+        if (journalApplies && domain->_journalLength >= JOURNAL_HEADER_LENGTH && journalLength >= domain->_journalLength) {
+            // Only records were added since we last looked
+            domain->_journalLength = _replayJournal(journal, domain->_journalLength, journalLength, domain->_domainDict);
+            domain->_lastReadTime = CFAbsoluteTimeGetCurrent();
+            return;
+        }
+    }
+
+    _readXMLDomainFile(url, domain);
+    domain->_fileStamp = stamp;
+    domain->_journalLength = journalApplies ? _replayJournal(journal, JOURNAL_HEADER_LENGTH, journalLength, domain->_domainDict) : 0;
+}
+
+#endif
+
+// Assumes the domain has already been locked
+static void _loadXMLDomainIfStale(CFURLRef url, _CFXMLPreferencesDomain *domain) {
+#if TARGET_OS_OSX || TARGET_OS_LINUX
+    int journal = _openJournal(url, O_RDONLY, 0);
+    if (journal >= 0) flock(journal, LOCK_SH);
+    _loadXMLDomainWithJournalIfStale(url, domain, journal);
+    if (journal >= 0) close(journal);
+#else
+    CFAllocatorRef alloc = __CFPreferencesAllocator();
+    if (domain->_domainDict) {
+        CFDateRef modDate;
+        CFAbsoluteTime modTime;
+    	CFURLRef testURL = url;
+
+        if (CFDictionaryGetCount(domain->_domainDict) == 0) {
+            // domain never existed; check the parent directory, not the child
+            testURL = CFURLCreateWithFileSystemPathRelativeToBase(alloc, CFSTR(".."), kCFURLPOSIXPathStyle, true, url);
+        }
+
+        modDate = (CFDateRef )CFURLCreatePropertyFromResource(alloc, testURL, kCFURLFileLastModificationTime, NULL);
+        modTime = modDate ? CFDateGetAbsoluteTime(modDate) : 0.0;
+
+        // free before possible return. we can test non-NULL of modDate but don't depend on contents after this.
+        if (testURL != url) CFRelease(testURL);
+        if (modDate) CFRelease(modDate);
+        
+        if (modDate != NULL && modTime < domain->_lastReadTime) {            // We're up-to-date
+            return;
+        }
+    }
+
+    // We're out-of-date; reload
+    _readXMLDomainFile(url, domain);
+#endif
+}
+
+
 static CFTypeRef fetchXMLValue(CFTypeRef context, void *xmlDomain, CFStringRef key) {
     _CFXMLPreferencesDomain *domain = (_CFXMLPreferencesDomain *)xmlDomain;
     CFTypeRef result;
@@ -473,6 +645,93 @@ static void setXMLDomainIsWorldReadable(CFTypeRef context, void *domain, Boolean
     ((_CFXMLPreferencesDomain *)domain)->_isWorldReadable = isWorldReadable;
 }
 
+#if TARGET_OS_OSX || TARGET_OS_LINUX
+// Assumes the domain has already been locked, and the journal is flocked exclusively
+static Boolean _synchronizeXMLDomainWithJournal(CFURLRef url, _CFXMLPreferencesDomain *domain, int journal) {
+    CFAllocatorRef alloc = __CFPreferencesAllocator();
+    CFArrayRef changedKeys = domain->_dirtyKeys;
+    CFIndex idx, count = CFArrayGetCount(changedKeys);
+    CFMutableDictionaryRef set = CFDictionaryCreateMutable(alloc, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+    CFMutableArrayRef removed = CFArrayCreateMutable(alloc, 0, &kCFTypeArrayCallBacks);
+    CFDataRef record = NULL;
+    Boolean success = false, tryAgain;
+
+    // Catching up with the disk may overwrite our changes, so set them aside first and reapply them afterwards
+    for (idx = 0; idx < count; idx ++) {
+        CFStringRef key = (CFStringRef) CFArrayGetValueAtIndex(changedKeys, idx);
+        CFTypeRef value = domain->_domainDict ? CFDictionaryGetValue(domain->_domainDict, key) : NULL;
+        if (value)
+            CFDictionarySetValue(set, key, value);
+        else
+            CFArrayAppendValue(removed, key);
+    }
+    _loadXMLDomainWithJournalIfStale(url, domain, journal);
+    CFDictionaryApplyFunction(set, _setJournaledValue, domain->_domainDict);
+    for (idx = 0; idx < CFArrayGetCount(removed); idx ++) {
+        CFDictionaryRemoveValue(domain->_domainDict, CFArrayGetValueAtIndex(removed, idx));
+    }
+
+    // Append a record if the journal applies to the file on disk and compacting would not be worth it yet
+    uint64_t journalLength = domain->_journalLength;
+    if (journalLength >= JOURNAL_HEADER_LENGTH && CFDictionaryGetCount(domain->_domainDict) > 0) {
+        const void *recordKeys[2] = {_journalSetKey, _journalRemoveKey};
+        const void *recordValues[2] = {set, removed};
+        CFDictionaryRef recordDict = CFDictionaryCreate(alloc, recordKeys, recordValues, 2, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+        record = CFPropertyListCreateData(alloc, recordDict, kCFPropertyListBinaryFormat_v1_0, 0, NULL);
+        CFRelease(recordDict);
+        uint64_t compactionLength = __CFMax(JOURNAL_MIN_COMPACTION_LENGTH, domain->_fileStamp.size / 2);
+        if (record && (CFDataGetLength(record) > UINT32_MAX - 4 || journalLength + 4 + CFDataGetLength(record) > compactionLength)) {
+            CFRelease(record);
+            record = NULL;
+        }
+    }
+    if (record) {
+        CFIndex recordLength = CFDataGetLength(record);
+        uint8_t *bytes = (uint8_t *)malloc(4 + recordLength);
+        uint32_t swappedLength = CFSwapInt32HostToBig((uint32_t)recordLength);
+        memmove(bytes, &swappedLength, 4);
+        memmove(bytes + 4, CFDataGetBytePtr(record), recordLength);
+        success = (pwrite(journal, bytes, 4 + recordLength, (off_t)journalLength) == 4 + recordLength) && 0 == ftruncate(journal, (off_t)(journalLength + 4 + recordLength)) && 0 == fsync(journal);
+        if (success) {
+            domain->_journalLength = journalLength + 4 + recordLength;
+        } else {
+            // Don't leave a partial record behind for readers to trip over; the file gets rewritten below instead
+            ftruncate(journal, (off_t)journalLength);
+        }
+        free(bytes);
+        CFRelease(record);
+    }
+    if (!success) {
+        do {
+            success = _writeXMLFile(url, domain->_domainDict, domain->_isWorldReadable, &tryAgain);
+            if (tryAgain) {
+                __CFMilliSleep(50);
+            }
+        } while (tryAgain);
+        if (success) {
+            // Empty the journal before stamping it with the new file, so a crash in between can't replay stale records over it
+            _CFXMLPreferencesFileStamp stamp;
+            Boolean exists = _getFileStamp(url, &stamp);
+            uint8_t header[JOURNAL_HEADER_LENGTH];
+            _encodeJournalHeader(header, &stamp);
+            domain->_fileStamp = stamp;
+            domain->_journalLength = 0;
+            if (0 == ftruncate(journal, 0) && exists && pwrite(journal, header, JOURNAL_HEADER_LENGTH, 0) == JOURNAL_HEADER_LENGTH) {
+                domain->_journalLength = JOURNAL_HEADER_LENGTH;
+            }
+            // An empty domain has no file, so its journal goes with it rather than lingering next to nothing
+            char cpath[CFMaxPathSize + 8];
+            if (!exists && _getJournalPath(url, cpath)) {
+                unlink(cpath);
+            }
+        }
+    }
+    CFRelease(set);
+    CFRelease(removed);
+    return success;
+}
+#endif
+
 static Boolean synchronizeXMLDomain(CFTypeRef context, void *xmlDomain) {
     _CFXMLPreferencesDomain *domain = (_CFXMLPreferencesDomain *)xmlDomain;
     CFMutableDictionaryRef cachedDict;
@@ -485,6 +744,31 @@ static Boolean synchronizeXMLDomain(CFTypeRef context, void *xmlDomain) {
     changedKeys = domain->_dirtyKeys;
     count = CFArrayGetCount(changedKeys);
     
+#if TARGET_OS_OSX || TARGET_OS_LINUX
+    if (count == 0) {
+        // no changes were made to this domain; just pick up whatever was written to disk since we last looked
+        if (cachedDict) {
+            _loadXMLDomainIfStale((CFURLRef )context, domain);
+        }
+        __CFUnlock(&domain->_lock);
+        return true;
+    }
+
+    int journal = _openJournal((CFURLRef )context, O_RDWR | O_CREAT, domain->_isWorldReadable ? S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH : S_IRUSR|S_IWUSR);
+    if (journal >= 0) {
+        flock(journal, LOCK_EX);
+        success = _synchronizeXMLDomainWithJournal((CFURLRef )context, domain, journal);
+        close(journal);
+        if (success) {
+            CFArrayRemoveAllValues(domain->_dirtyKeys);
+        }
+        domain->_lastReadTime = CFAbsoluteTimeGetCurrent();
+        __CFUnlock(&domain->_lock);
+        return success;
+    }
+    // Most likely the directory doesn't exist yet; writing the whole file creates it
+#endif
+
     if (count == 0) {
         // no changes were made to this domain; just remove it from the cache to guarantee it will be taken from disk next access
         if (cachedDict) {
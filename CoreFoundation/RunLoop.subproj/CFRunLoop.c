@@ -673,7 +673,8 @@ struct __CFRunLoopMode {
     CFMutableSetRef _sources0;
     CFMutableSetRef _sources1;
     CFMutableArrayRef _observers;
-    CFMutableArrayRef _timers;
+    CFMutableArrayRef _timers; // A binary min-heap ordered by fire TSR
+    CFMutableDictionaryRef _timerIndices; // Each timer in _timers mapped to its index there, plus 1
     CFMutableDictionaryRef _portToV1SourceMap;
     __CFPortSet _portSet;
     CFIndex _observerMask;
@@ -742,6 +743,7 @@ static void __CFRunLoopModeDeallocate(CFTypeRef cf) {
     if (NULL != rlm->_sources1) CFRelease(rlm->_sources1);
     if (NULL != rlm->_observers) CFRelease(rlm->_observers);
     if (NULL != rlm->_timers) CFRelease(rlm->_timers);
+    if (NULL != rlm->_timerIndices) CFRelease(rlm->_timerIndices);
     if (NULL != rlm->_portToV1SourceMap) CFRelease(rlm->_portToV1SourceMap);
     CFRelease(rlm->_name);
     __CFPortSetFree(rlm->_portSet);
@@ -918,6 +920,7 @@ static CFRunLoopModeRef __CFRunLoopFindMode(CFRunLoopRef rl, CFStringRef modeNam
     rlm->_sources1 = NULL;
     rlm->_observers = NULL;
     rlm->_timers = NULL;
+    rlm->_timerIndices = NULL;
     rlm->_observerMask = 0;
     rlm->_portSet = __CFPortSetAllocate();
     rlm->_timerSoftDeadline = UINT64_MAX;
@@ -1358,6 +1361,7 @@ static void __CFRunLoopDeallocateTimers(const void *value, void *context) {
     if (range.length) {
         CFArrayApplyFunction(rlm->_timers, range, __CFRunLoopKillOneTimer, context);
         CFArrayRemoveAllValues(rlm->_timers);
+        CFDictionaryRemoveAllValues(rlm->_timerIndices);
     }
 }
 
@@ -2097,40 +2101,100 @@ static Boolean __CFRunLoopDoSource1(CFRunLoopRef rl, CFRunLoopModeRef rlm, CFRun
     return sourceHandled;
 }
 
-static CFIndex __CFRunLoopInsertionIndexInTimerArray(CFArrayRef array, CFRunLoopTimerRef rlt) __attribute__((noinline));
-static CFIndex __CFRunLoopInsertionIndexInTimerArray(CFArrayRef array, CFRunLoopTimerRef rlt) {
-    CFIndex cnt = CFArrayGetCount(array);
-    if (cnt <= 0) {
-        return 0;
+/* Each mode keeps its timers in a binary min-heap ordered by fire TSR, with a side table giving each timer's index in the heap, so that a timer can be rescheduled or removed in O(log n) time. The timer that fires next is always at index 0. Code that needs every timer due before some deadline walks down from the root, skipping any subtree whose root is already past the deadline, since nothing below it can be earlier. */
+
+CF_INLINE uint64_t __CFRunLoopTimerHeapKey(CFArrayRef heap, CFIndex idx) {
+    return ((CFRunLoopTimerRef)CFArrayGetValueAtIndex(heap, idx))->_fireTSR;
+}
+
+CF_INLINE void __CFRunLoopTimerHeapSetIndex(CFRunLoopModeRef rlm, CFIndex idx) {
+    CFDictionarySetValue(rlm->_timerIndices, CFArrayGetValueAtIndex(rlm->_timers, idx), (const void *)(uintptr_t)(idx + 1));
+}
+
+static CFIndex __CFRunLoopTimerHeapIndexOf(CFRunLoopModeRef rlm, CFRunLoopTimerRef rlt) {
+    uintptr_t value = rlm->_timerIndices ? (uintptr_t)CFDictionaryGetValue(rlm->_timerIndices, rlt) : 0;
+    return value ? (CFIndex)value - 1 : kCFNotFound;
+}
+
+static void __CFRunLoopTimerHeapSwap(CFRunLoopModeRef rlm, CFIndex idx1, CFIndex idx2) {
+    CFArrayExchangeValuesAtIndices(rlm->_timers, idx1, idx2);
+    __CFRunLoopTimerHeapSetIndex(rlm, idx1);
+    __CFRunLoopTimerHeapSetIndex(rlm, idx2);
+}
+
+// Restores heap order after the fire TSR of the timer at idx has changed in either direction
+static void __CFRunLoopTimerHeapFix(CFRunLoopModeRef rlm, CFIndex idx) {
+    CFArrayRef heap = rlm->_timers;
+    while (0 < idx) {
+        CFIndex parent = (idx - 1) / 2;
+        if (__CFRunLoopTimerHeapKey(heap, parent) <= __CFRunLoopTimerHeapKey(heap, idx)) break;
+        __CFRunLoopTimerHeapSwap(rlm, idx, parent);
+        idx = parent;
     }
-    if (256 < cnt) {
-        CFRunLoopTimerRef item = (CFRunLoopTimerRef)CFArrayGetValueAtIndex(array, cnt - 1);
-        if (item->_fireTSR <= rlt->_fireTSR) {
-            return cnt;
-        }
-        item = (CFRunLoopTimerRef)CFArrayGetValueAtIndex(array, 0);
-        if (rlt->_fireTSR < item->_fireTSR) {
-            return 0;
-        }
+    for (CFIndex cnt = CFArrayGetCount(heap); ; ) {
+        CFIndex smallest = idx, left = 2 * idx + 1, right = 2 * idx + 2;
+        if (left < cnt && __CFRunLoopTimerHeapKey(heap, left) < __CFRunLoopTimerHeapKey(heap, smallest)) smallest = left;
+        if (right < cnt && __CFRunLoopTimerHeapKey(heap, right) < __CFRunLoopTimerHeapKey(heap, smallest)) smallest = right;
+        if (smallest == idx) break;
+        __CFRunLoopTimerHeapSwap(rlm, idx, smallest);
+        idx = smallest;
     }
+}
 
-    CFIndex add = (1 << flsl(cnt)) * 2;
-    CFIndex idx = 0;
-    Boolean lastTestLEQ;
-    do {
-        add = add / 2;
-	lastTestLEQ = false;
-        CFIndex testIdx = idx + add;
-        if (testIdx < cnt) {
-            CFRunLoopTimerRef item = (CFRunLoopTimerRef)CFArrayGetValueAtIndex(array, testIdx);
-            if (item->_fireTSR <= rlt->_fireTSR) {
-                idx = testIdx;
-		lastTestLEQ = true;
-            }
-        }
-    } while (0 < add);
+static void __CFRunLoopTimerHeapInsert(CFRunLoopModeRef rlm, CFRunLoopTimerRef rlt) {
+    CFArrayAppendValue(rlm->_timers, rlt);
+    CFIndex idx = CFArrayGetCount(rlm->_timers) - 1;
+    __CFRunLoopTimerHeapSetIndex(rlm, idx);
+    __CFRunLoopTimerHeapFix(rlm, idx);
+}
 
-    return lastTestLEQ ? idx + 1 : idx;
+static void __CFRunLoopTimerHeapRemove(CFRunLoopModeRef rlm, CFIndex idx) {
+    CFIndex last = CFArrayGetCount(rlm->_timers) - 1;
+    CFDictionaryRemoveValue(rlm->_timerIndices, CFArrayGetValueAtIndex(rlm->_timers, idx));
+    if (idx != last) {
+        CFArrayExchangeValuesAtIndices(rlm->_timers, idx, last);
+        CFArrayRemoveValueAtIndex(rlm->_timers, last);
+        __CFRunLoopTimerHeapSetIndex(rlm, idx);
+        __CFRunLoopTimerHeapFix(rlm, idx);
+    } else {
+        CFArrayRemoveValueAtIndex(rlm->_timers, last);
+    }
+}
+
+// Lowers *softDeadline and *hardDeadline to those of the timers at or below idx, as for __CFArmNextTimerInMode
+static void __CFRunLoopTimerHeapFindDeadlines(CFArrayRef heap, CFIndex idx, uint64_t *softDeadline, uint64_t *hardDeadline) {
+    if (CFArrayGetCount(heap) <= idx) return;
+    CFRunLoopTimerRef t = (CFRunLoopTimerRef)CFArrayGetValueAtIndex(heap, idx);
+    // Nothing below this timer can come due before the current hard deadline
+    if (t->_fireTSR > *hardDeadline) return;
+    // discount timers currently firing
+    if (!__CFRunLoopTimerIsFiring(t)) {
+        int32_t err = CHECKINT_NO_ERROR;
+        uint64_t oneTimerHardDeadline = check_uint64_add(t->_fireTSR, __CFTimeIntervalToTSR(t->_tolerance), &err);
+        if (err != CHECKINT_NO_ERROR) oneTimerHardDeadline = UINT64_MAX;
+        if (t->_fireTSR < *softDeadline) *softDeadline = t->_fireTSR;
+        if (oneTimerHardDeadline < *hardDeadline) *hardDeadline = oneTimerHardDeadline;
+    }
+    __CFRunLoopTimerHeapFindDeadlines(heap, 2 * idx + 1, softDeadline, hardDeadline);
+    __CFRunLoopTimerHeapFindDeadlines(heap, 2 * idx + 2, softDeadline, hardDeadline);
+}
+
+// Appends the valid, not currently firing timers at or below idx that are due by limitTSR to timers, creating it if need be
+static void __CFRunLoopTimerHeapCollectDue(CFArrayRef heap, CFIndex idx, uint64_t limitTSR, CFMutableArrayRef *timers) {
+    if (CFArrayGetCount(heap) <= idx) return;
+    CFRunLoopTimerRef rlt = (CFRunLoopTimerRef)CFArrayGetValueAtIndex(heap, idx);
+    if (limitTSR < rlt->_fireTSR) return;
+    if (__CFIsValid(rlt) && !__CFRunLoopTimerIsFiring(rlt)) {
+        if (!*timers) *timers = CFArrayCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeArrayCallBacks);
+        CFArrayAppendValue(*timers, rlt);
+    }
+    __CFRunLoopTimerHeapCollectDue(heap, 2 * idx + 1, limitTSR, timers);
+    __CFRunLoopTimerHeapCollectDue(heap, 2 * idx + 2, limitTSR, timers);
+}
+
+static CFComparisonResult __CFRunLoopTimerCompareFireTSR(const void *val1, const void *val2, void *context) {
+    uint64_t tsr1 = ((CFRunLoopTimerRef)val1)->_fireTSR, tsr2 = ((CFRunLoopTimerRef)val2)->_fireTSR;
+    return (tsr1 < tsr2) ? kCFCompareLessThan : ((tsr1 > tsr2) ? kCFCompareGreaterThan : kCFCompareEqualTo);
 }
 
 static void __CFArmNextTimerInMode(CFRunLoopModeRef rlm, CFRunLoopRef rl) {    
@@ -2138,32 +2202,11 @@ static void __CFArmNextTimerInMode(CFRunLoopModeRef rlm, CFRunLoopRef rl) {
     uint64_t nextSoftDeadline = UINT64_MAX;
 
     if (rlm->_timers) {
-        // Look at the list of timers. We will calculate two TSR values; the next soft and next hard deadline.
-        // The next soft deadline is the first time we can fire any timer. This is the fire date of the first timer in our sorted list of timers.
+        // Look at the heap of timers. We will calculate two TSR values; the next soft and next hard deadline.
+        // The next soft deadline is the first time we can fire any timer. This is the earliest fire date of the timers that aren't firing.
         // The next hard deadline is the last time at which we can fire the timer before we've moved out of the allowable tolerance of the timers in our list.
-        for (CFIndex idx = 0, cnt = CFArrayGetCount(rlm->_timers); idx < cnt; idx++) {
-            CFRunLoopTimerRef t = (CFRunLoopTimerRef)CFArrayGetValueAtIndex(rlm->_timers , idx);
-            // discount timers currently firing
-            if (__CFRunLoopTimerIsFiring(t)) continue;
-            
-            int32_t err = CHECKINT_NO_ERROR;
-            uint64_t oneTimerSoftDeadline = t->_fireTSR;
-            uint64_t oneTimerHardDeadline = check_uint64_add(t->_fireTSR, __CFTimeIntervalToTSR(t->_tolerance), &err);
-            if (err != CHECKINT_NO_ERROR) oneTimerHardDeadline = UINT64_MAX;
-            
-            // We can stop searching if the soft deadline for this timer exceeds the current hard deadline. Otherwise, later timers with lower tolerance could still have earlier hard deadlines.
-            if (oneTimerSoftDeadline > nextHardDeadline) {
-                break;
-            }
-            
-            if (oneTimerSoftDeadline < nextSoftDeadline) {
-                nextSoftDeadline = oneTimerSoftDeadline;
-            }
-            
-            if (oneTimerHardDeadline < nextHardDeadline) {
-                nextHardDeadline = oneTimerHardDeadline;
-            }
-        }
+        // Timers whose soft deadline exceeds the current hard deadline are skipped, along with everything below them in the heap. Otherwise, later timers with lower tolerance could still have earlier hard deadlines.
+        __CFRunLoopTimerHeapFindDeadlines(rlm->_timers, 0, &nextSoftDeadline, &nextHardDeadline);
         
         if (nextSoftDeadline < UINT64_MAX && (nextHardDeadline != rlm->_timerHardDeadline || nextSoftDeadline != rlm->_timerSoftDeadline)) {
             if (CFRUNLOOP_NEXT_TIMER_ARMED_ENABLED()) {
@@ -2238,24 +2281,17 @@ static void __CFRepositionTimerInMode(CFRunLoopModeRef rlm, CFRunLoopTimerRef rl
 static void __CFRepositionTimerInMode(CFRunLoopModeRef rlm, CFRunLoopTimerRef rlt, Boolean isInArray) {
     if (!rlt) return;
     
-    CFMutableArrayRef timerArray = rlm->_timers;
-    if (!timerArray) return;
-    Boolean found = false;
+    if (!rlm->_timers) return;
     
-    // If we know in advance that the timer is not in the array (just being added now) then we can skip this search
+    // If we know in advance that the timer is not in the heap (just being added now) then we can skip the lookup
     if (isInArray) {
-        CFIndex idx = CFArrayGetFirstIndexOfValue(timerArray, CFRangeMake(0, CFArrayGetCount(timerArray)), rlt);
-        if (kCFNotFound != idx) {
-            CFRetain(rlt);
-            CFArrayRemoveValueAtIndex(timerArray, idx);
-            found = true;
-        }
+        CFIndex idx = __CFRunLoopTimerHeapIndexOf(rlm, rlt);
+        if (kCFNotFound == idx) return;
+        __CFRunLoopTimerHeapFix(rlm, idx);
+    } else {
+        __CFRunLoopTimerHeapInsert(rlm, rlt);
     }
-    if (!found && isInArray) return;
-    CFIndex newIdx = __CFRunLoopInsertionIndexInTimerArray(timerArray, rlt);
-    CFArrayInsertValueAtIndex(timerArray, newIdx, rlt);
     __CFArmNextTimerInMode(rlm, rlt->_runLoop);
-    if (isInArray) CFRelease(rlt);
 }
 
 
@@ -2409,15 +2445,12 @@ static Boolean __CFRunLoopDoTimers(CFRunLoopRef rl, CFRunLoopModeRef rlm, uint64
     
     Boolean timerHandled = false;
     CFMutableArrayRef timers = NULL;
-    for (CFIndex idx = 0, cnt = rlm->_timers ? CFArrayGetCount(rlm->_timers) : 0; idx < cnt; idx++) {
-        CFRunLoopTimerRef rlt = (CFRunLoopTimerRef)CFArrayGetValueAtIndex(rlm->_timers, idx);
-        
-        if (__CFIsValid(rlt) && !__CFRunLoopTimerIsFiring(rlt)) {
-            if (rlt->_fireTSR <= limitTSR) {
-                if (!timers) timers = CFArrayCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeArrayCallBacks);
-                CFArrayAppendValue(timers, rlt);
-            }
-        }
+    if (rlm->_timers) {
+        __CFRunLoopTimerHeapCollectDue(rlm->_timers, 0, limitTSR, &timers);
+    }
+    // Fire them in the order they came due
+    if (timers) {
+        CFArraySortValues(timers, CFRangeMake(0, CFArrayGetCount(timers)), __CFRunLoopTimerCompareFireTSR, NULL);
     }
     
     for (CFIndex idx = 0, cnt = timers ? CFArrayGetCount(timers) : 0; idx < cnt; idx++) {
@@ -2542,60 +2575,101 @@ static int __CFPollFileDescriptors(struct pollfd *fds, nfds_t nfds, uint64_t tim
     }
 }
 
+// Upper bound on the number of ready ports harvested from the epoll set by a single wait.
+#define __CFRUNLOOP_MAX_LIVE_PORTS 16
+
 // pass in either a portSet or onePort. portSet is an epollfd, onePort is either a timerfd or an eventfd.
+// When waiting on a portSet, up to maxLivePorts ready ports are harvested with one epoll_wait and
+// acknowledged; they are returned in livePorts and their number in *livePortCount, so the caller
+// can service all of them in a single pass of the run loop.
 // TODO: Better error handling. What should happen if we get an error on a file descriptor?
-static Boolean __CFRunLoopServiceFileDescriptors(__CFPortSet portSet, __CFPort onePort, uint64_t timeout, int *livePort) {
+static Boolean __CFRunLoopServiceFileDescriptors(__CFPortSet portSet, __CFPort onePort, uint64_t timeout, int *livePorts, CFIndex maxLivePorts, CFIndex *livePortCount) {
     struct pollfd fdInfo = {
         .fd = (onePort == CFPORT_NULL) ? portSet : onePort,
         .events = POLLIN
     };
     
+    if (livePortCount)
+        *livePortCount = 0;
+    
     ssize_t result = __CFPollFileDescriptors(&fdInfo, 1, timeout);
     if (result == 0)
         return false;
     
     CFAssert2(result != -1, __kCFLogAssertion, "%s(): error %d from ppoll", __PRETTY_FUNCTION__, errno);
     
-    int awokenFd;
+    int awokenFds[__CFRUNLOOP_MAX_LIVE_PORTS];
+    CFIndex awokenCount = 0;
     
     if (onePort != CFPORT_NULL) {
         CFAssert1(0 == (fdInfo.revents & (POLLERR|POLLHUP)), __kCFLogAssertion, "%s(): ppoll reported error for fd", __PRETTY_FUNCTION__);
-        awokenFd = onePort;
+        awokenFds[0] = onePort;
+        awokenCount = 1;
         
     } else {
-        struct epoll_event event;
+        struct epoll_event events[__CFRUNLOOP_MAX_LIVE_PORTS];
+        int numEvents = (int)__CFMax(1, __CFMin(maxLivePorts, __CFRUNLOOP_MAX_LIVE_PORTS));
         do {
-            result = epoll_wait(portSet, &event, 1 /*numEvents*/, 0 /*timeout*/);
+            result = epoll_wait(portSet, events, numEvents, 0 /*timeout*/);
         } while (result == -1 && errno == EINTR);
         CFAssert2(result >= 0, __kCFLogAssertion, "%s(): error %d from epoll_wait", __PRETTY_FUNCTION__, errno);
         
-        if (result == 0) {
+        if (result <= 0) {
             return false;
         }
         
-        awokenFd = event.data.fd;
+        for (CFIndex idx = 0; idx < result; idx++) {
+            awokenFds[idx] = events[idx].data.fd;
+        }
+        awokenCount = result;
     }
     
-    // Now we acknowledge the wakeup. awokenFd is an eventfd (or possibly a
-    // timerfd ?). In either case, we read an 8-byte integer, as per eventfd(2)
-    // and timerfd_create(2).
-    uint64_t value;
-    do {
-        result = read(awokenFd, &value, sizeof(value));
-    } while (result == -1 && errno == EINTR);
-    
-    if (result == -1 && errno == EAGAIN) {
-        // Another thread stole the wakeup for this fd. (FIXME Can this actually
-        // happen?)
-        return false;
+    CFIndex liveCount = 0;
+    for (CFIndex idx = 0; idx < awokenCount; idx++) {
+        // Now we acknowledge the wakeup. The awoken fd is an eventfd (or possibly a
+        // timerfd ?). In either case, we read an 8-byte integer, as per eventfd(2)
+        // and timerfd_create(2).
+        uint64_t value;
+        do {
+            result = read(awokenFds[idx], &value, sizeof(value));
+        } while (result == -1 && errno == EINTR);
+        
+        if (result == -1 && errno == EAGAIN) {
+            // Another thread stole the wakeup for this fd. (FIXME Can this actually
+            // happen?)
+            continue;
+        }
+        
+        CFAssert2(result == sizeof(value), __kCFLogAssertion, "%s(): error %d from read(2) while acknowledging wakeup", __PRETTY_FUNCTION__, errno);
+        
+        if (livePorts)
+            livePorts[liveCount] = awokenFds[idx];
+        liveCount++;
     }
     
-    CFAssert2(result == sizeof(value), __kCFLogAssertion, "%s(): error %d from read(2) while acknowledging wakeup", __PRETTY_FUNCTION__, errno);
+    if (livePortCount)
+        *livePortCount = liveCount;
     
-    if (livePort)
-        *livePort = awokenFd;
-    
-    return true;
+    return (liveCount > 0);
+}
+
+// Signals again ports that __CFRunLoopServiceFileDescriptors harvested and acknowledged but that were
+// not serviced, so that the next wait on the mode's port set picks them up. Timer ports are timerfds,
+// which can't be written to, so the mode's next timer is armed afresh instead.
+static void __CFRunLoopResignalFileDescriptors(CFRunLoopRef rl, CFRunLoopModeRef rlm, const int *ports, CFIndex count) {
+    for (CFIndex idx = 0; idx < count; idx++) {
+        if (ports[idx] == rlm->_timerPort) {
+            rlm->_timerSoftDeadline = UINT64_MAX;
+            rlm->_timerHardDeadline = UINT64_MAX;
+            __CFArmNextTimerInMode(rlm, rl);
+            continue;
+        }
+        uint64_t value = 1;
+        ssize_t result;
+        do {
+            result = write(ports[idx], &value, sizeof(value));
+        } while (result == -1 && errno == EINTR);
+    }
 }
 
 #elif TARGET_OS_WIN32 || TARGET_OS_CYGWIN
@@ -2755,6 +2829,8 @@ static int32_t __CFRunLoopRun(CFRunLoopRef rl, CFRunLoopModeRef rlm, CFTimeInter
         Boolean windowsMessageReceived = false;
 #elif TARGET_OS_LINUX
         int livePort = -1;
+        int livePorts[__CFRUNLOOP_MAX_LIVE_PORTS];
+        CFIndex livePortCount = 0, livePortIndex = 1;
 #endif
 	__CFPortSet waitSet = rlm->_portSet;
 
@@ -2785,7 +2861,7 @@ static int32_t __CFRunLoopRun(CFRunLoopRef rl, CFRunLoopModeRef rlm, CFTimeInter
                 goto handle_msg;
             }
 #elif TARGET_OS_LINUX && !TARGET_OS_CYGWIN
-            if (__CFRunLoopServiceFileDescriptors(CFPORTSET_NULL, dispatchPort, 0, &livePort)) {
+            if (__CFRunLoopServiceFileDescriptors(CFPORTSET_NULL, dispatchPort, 0, &livePort, 1, NULL)) {
                 goto handle_msg;
             }
 #elif TARGET_OS_WIN32 || TARGET_OS_CYGWIN
@@ -2846,7 +2922,11 @@ static int32_t __CFRunLoopRun(CFRunLoopRef rl, CFRunLoopModeRef rlm, CFTimeInter
         // Here, use the app-supplied message queue mask. They will set this if they are interested in having this run loop receive windows messages.
         __CFRunLoopWaitForMultipleObjects(waitSet, NULL, poll ? 0 : TIMEOUT_INFINITY, rlm->_msgQMask, &livePort, &windowsMessageReceived);
 #elif TARGET_OS_LINUX
-        __CFRunLoopServiceFileDescriptors(waitSet, CFPORT_NULL, TIMEOUT_INFINITY, &livePort);
+        // Ports are registered edge-triggered and acknowledged as they are harvested, so only take a
+        // batch when every harvested port is going to be serviced before returning.
+        if (__CFRunLoopServiceFileDescriptors(waitSet, CFPORT_NULL, poll ? 0 : TIMEOUT_INFINITY, livePorts, stopAfterHandle ? 1 : __CFRUNLOOP_MAX_LIVE_PORTS, &livePortCount)) {
+            livePort = livePorts[0];
+        }
 #endif
         
         __CFRunLoopLock(rl);
@@ -2871,6 +2951,10 @@ static int32_t __CFRunLoopRun(CFRunLoopRef rl, CFRunLoopModeRef rlm, CFTimeInter
         handle_msg:;
         __CFRunLoopSetIgnoreWakeUps(rl);
 
+#if TARGET_OS_LINUX
+        handle_live_port:;
+#endif
+
 #if TARGET_OS_WIN32
         if (windowsMessageReceived) {
             // These Win32 APIs cause a callout, so make sure we're unlocked first and relocked after
@@ -2989,6 +3073,19 @@ static int32_t __CFRunLoopRun(CFRunLoopRef rl, CFRunLoopModeRef rlm, CFTimeInter
             }
             
         }
+
+#if TARGET_OS_LINUX
+        // Service the rest of the ports that were ready when we woke up before going around again,
+        // unless a callout stopped the run loop; those ports are then left for the next run.
+        if (livePortIndex < livePortCount) {
+            if (!__CFRunLoopIsStopped(rl) && !rlm->_stopped) {
+                livePort = livePorts[livePortIndex++];
+                goto handle_live_port;
+            }
+            __CFRunLoopResignalFileDescriptors(rl, rlm, livePorts + livePortIndex, livePortCount - livePortIndex);
+            livePortIndex = livePortCount;
+        }
+#endif
         
         /* --- BLOCKS --- */
         
@@ -3566,10 +3663,7 @@ Boolean CFRunLoopContainsTimer(CFRunLoopRef rl, CFRunLoopTimerRef rlt, CFStringR
     } else {
 	CFRunLoopModeRef rlm = __CFRunLoopFindMode(rl, modeName, false);
 	if (NULL != rlm) {
-            if (NULL != rlm->_timers) {
-                CFIndex idx = CFArrayGetFirstIndexOfValue(rlm->_timers, CFRangeMake(0, CFArrayGetCount(rlm->_timers)), rlt);
-                hasValue = (kCFNotFound != idx);
-            }
+            hasValue = (kCFNotFound != __CFRunLoopTimerHeapIndexOf(rlm, rlt));
 	    __CFRunLoopModeUnlock(rlm);
 	}
     }
@@ -3609,6 +3703,7 @@ void CFRunLoopAddTimer(CFRunLoopRef rl, CFRunLoopTimerRef rlt, CFStringRef modeN
                 CFArrayCallBacks cb = kCFTypeArrayCallBacks;
                 cb.equal = NULL;
                 rlm->_timers = CFArrayCreateMutable(kCFAllocatorSystemDefault, 0, &cb);
+                rlm->_timerIndices = CFDictionaryCreateMutable(kCFAllocatorSystemDefault, 0, NULL, NULL);
             }
 	}
 	if (NULL != rlm && !CFSetContainsValue(rlt->_rlModes, rlm->_name)) {
@@ -3657,12 +3752,8 @@ void CFRunLoopRemoveTimer(CFRunLoopRef rl, CFRunLoopTimerRef rlt, CFStringRef mo
     } else {
 	CFRunLoopModeRef rlm = __CFRunLoopFindMode(rl, modeName, false);
         CFIndex idx = kCFNotFound;
-        CFMutableArrayRef timerList = NULL;
         if (NULL != rlm) {
-            timerList = rlm->_timers;
-            if (NULL != timerList) {
-                idx = CFArrayGetFirstIndexOfValue(timerList, CFRangeMake(0, CFArrayGetCount(timerList)), rlt);
-            }
+            idx = __CFRunLoopTimerHeapIndexOf(rlm, rlt);
         }
         if (kCFNotFound != idx) {
             __CFRunLoopTimerLock(rlt);
@@ -3671,7 +3762,7 @@ void CFRunLoopRemoveTimer(CFRunLoopRef rl, CFRunLoopTimerRef rlt, CFStringRef mo
                 rlt->_runLoop = NULL;
             }
             __CFRunLoopTimerUnlock(rlt);
-	    CFArrayRemoveValueAtIndex(timerList, idx);
+            __CFRunLoopTimerHeapRemove(rlm, idx);
             __CFArmNextTimerInMode(rlm, rl);
         }
         if (NULL != rlm) {
@@ -969,6 +969,18 @@ Boolean __CFSocketGetBytesAvailable(CFSocketRef s, CFIndex* ctBytesAvailable) {
 #if TARGET_OS_WIN32
 #include <process.h>
 #endif
+#if TARGET_OS_LINUX
+#include <sys/epoll.h>
+#endif
+
+// On Linux the SocketManager thread waits on a persistent epoll set instead of rebuilding fd_sets
+// for select() on every iteration, so its cost scales with ready sockets rather than with the
+// highest descriptor number, and it is not limited to FD_SETSIZE descriptors.
+#if TARGET_OS_LINUX
+#define USE_EPOLL_SOCKET_MANAGER 1
+#else
+#define USE_EPOLL_SOCKET_MANAGER 0
+#endif
 
 #ifndef NBBY
 #define NBBY 8
@@ -1017,7 +1029,7 @@ static void timeradd(struct timeval *a, struct timeval *b, struct timeval *res)
 
 
 // On Mach we use a v0 RunLoopSource to make client callbacks.  That source is signalled by a
-// separate SocketManager thread who uses select() to watch the sockets' fds.
+// separate SocketManager thread who uses select() (epoll on Linux) to watch the sockets' fds.
 
 #undef LOG_CFSOCKET
 //#define LOG_CFSOCKET            1
@@ -1135,6 +1147,10 @@ CF_INLINE CFIndex __CFSocketFdGetSize(CFDataRef fdSet) {
     return NBBY * CFDataGetLength(fdSet);
 }
 
+CF_INLINE Boolean __CFSocketFdIsSet(CFSocketNativeHandle sock, CFDataRef fdSet) {
+    return (INVALID_SOCKET != sock && 0 <= sock && sock < __CFSocketFdGetSize(fdSet) && FD_ISSET(sock, (fd_set *)CFDataGetBytePtr(fdSet)));
+}
+
 CF_INLINE Boolean __CFSocketFdSet(CFSocketNativeHandle sock, CFMutableDataRef fdSet) {
     /* returns true if a change occurred, false otherwise */
     Boolean retval = false;
@@ -1180,6 +1196,12 @@ static Boolean __CFReadSocketsTimeoutInvalid = true;  /* rebuild the timeout val
 
 static CFSocketNativeHandle __CFWakeupSocketPair[2] = {INVALID_SOCKET, INVALID_SOCKET};
 static void *__CFSocketManagerThread = NULL;
+#if USE_EPOLL_SOCKET_MANAGER
+#define __CFSOCKET_EPOLL_EVENT_COUNT 256
+static int __CFSocketManagerEpollFd = -1;
+static CFMutableDictionaryRef __CFEpollSockets = NULL; /* fd -> CFSocketRef for every fd in the epoll set, controlled by __CFActiveSocketsLock */
+static CFMutableArrayRef __CFEpollInvalidSockets = NULL; /* sockets whose fd was closed behind our back, controlled by __CFActiveSocketsLock */
+#endif
 
 static void __CFSocketDoCallback(CFSocketRef s, CFDataRef data, CFDataRef address, CFSocketNativeHandle sock);
 
@@ -1391,6 +1413,101 @@ static SInt32 __CFSocketCreateWakeupSocketPair(void) {
 }
 
 
+#if USE_EPOLL_SOCKET_MANAGER
+CF_INLINE void __CFSocketWakeUpManager(uint8_t c) {
+    if (INVALID_SOCKET != __CFWakeupSocketPair[0]) {
+        send(__CFWakeupSocketPair[0], (const char *)&c, sizeof(c), 0);
+    }
+}
+
+CF_INLINE Boolean __CFSocketAffectsReadTimeout(CFSocketRef s) {
+    return (timerisset(&s->_readBufferTimeout) || NULL != s->_leftoverBytes);
+}
+
+// Brings the epoll registration of the socket's fd in line with its bits in the master fd sets.
+// Registrations are level-triggered and persist until the socket loses all interest, so the
+// manager thread never has to rebuild anything before waiting.  Called with __CFActiveSocketsLock held.
+static void __CFSocketUpdateEpollInterest(CFSocketRef s) {
+    CFSocketNativeHandle sock = s->_socket;
+    if (INVALID_SOCKET == sock || 0 > sock || 0 > __CFSocketManagerEpollFd) return;
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    if (__CFSocketFdIsSet(sock, __CFReadSocketsFds)) event.events |= EPOLLIN;
+    if (__CFSocketFdIsSet(sock, __CFWriteSocketsFds)) event.events |= EPOLLOUT;
+    event.data.fd = sock;
+    Boolean registered = CFDictionaryContainsKey(__CFEpollSockets, (void *)(uintptr_t)sock);
+    if (0 == event.events) {
+        if (registered) {
+            epoll_ctl(__CFSocketManagerEpollFd, EPOLL_CTL_DEL, sock, &event);
+            CFDictionaryRemoveValue(__CFEpollSockets, (void *)(uintptr_t)sock);
+        }
+        return;
+    }
+    int ret = epoll_ctl(__CFSocketManagerEpollFd, registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, sock, &event);
+    if (0 > ret && registered && ENOENT == errno) {
+        // the fd was closed and reused without the socket being invalidated
+        ret = epoll_ctl(__CFSocketManagerEpollFd, EPOLL_CTL_ADD, sock, &event);
+    } else if (0 > ret && !registered && EEXIST == errno) {
+        ret = epoll_ctl(__CFSocketManagerEpollFd, EPOLL_CTL_MOD, sock, &event);
+    }
+    if (0 > ret) {
+        __CFSOCKETLOG_WS(s, "epoll_ctl failed with errno %d", errno);
+        if (registered) CFDictionaryRemoveValue(__CFEpollSockets, (void *)(uintptr_t)sock);
+        if (EBADF == errno) {
+            // select() reported this as EBADF; hand the socket to the manager thread to invalidate
+            if (kCFNotFound == CFArrayGetFirstIndexOfValue(__CFEpollInvalidSockets, CFRangeMake(0, CFArrayGetCount(__CFEpollInvalidSockets)), s)) {
+                CFArrayAppendValue(__CFEpollInvalidSockets, s);
+            }
+            __CFSocketWakeUpManager('b');
+        }
+        return;
+    }
+    CFDictionarySetValue(__CFEpollSockets, (void *)(uintptr_t)sock, s);
+}
+
+// Version 0 RunLoopSources set a mask in an FD set to control what socket activity we hear about.
+// Changes to the master fs_sets occur via these 4 functions.  Each change is applied to the epoll
+// set directly, so the manager thread only needs waking when its read timeout must be recomputed.
+CF_INLINE Boolean __CFSocketSetFDForRead(CFSocketRef s) {
+    __CFSOCKETLOG_WS(s, "");
+    Boolean b = __CFSocketFdSet(s->_socket, __CFReadSocketsFds);
+    if (b) {
+        __CFSocketUpdateEpollInterest(s);
+        if (__CFSocketAffectsReadTimeout(s)) {
+            __CFReadSocketsTimeoutInvalid = true;
+            __CFSocketWakeUpManager('r');
+        }
+    }
+    return b;
+}
+
+CF_INLINE Boolean __CFSocketClearFDForRead(CFSocketRef s) {
+    __CFSOCKETLOG_WS(s, "");
+    Boolean b = __CFSocketFdClr(s->_socket, __CFReadSocketsFds);
+    if (b) {
+        __CFSocketUpdateEpollInterest(s);
+        if (__CFSocketAffectsReadTimeout(s)) {
+            __CFReadSocketsTimeoutInvalid = true;
+            __CFSocketWakeUpManager('s');
+        }
+    }
+    return b;
+}
+
+CF_INLINE Boolean __CFSocketSetFDForWrite(CFSocketRef s) {
+    __CFSOCKETLOG_WS(s, "");
+    Boolean b = __CFSocketFdSet(s->_socket, __CFWriteSocketsFds);
+    if (b) __CFSocketUpdateEpollInterest(s);
+    return b;
+}
+
+CF_INLINE Boolean __CFSocketClearFDForWrite(CFSocketRef s) {
+    __CFSOCKETLOG_WS(s, "");
+    Boolean b = __CFSocketFdClr(s->_socket, __CFWriteSocketsFds);
+    if (b) __CFSocketUpdateEpollInterest(s);
+    return b;
+}
+#else
 // Version 0 RunLoopSources set a mask in an FD set to control what socket activity we hear about.
 // Changes to the master fs_sets occur via these 4 functions.
 CF_INLINE Boolean __CFSocketSetFDForRead(CFSocketRef s) {
@@ -1434,6 +1551,7 @@ CF_INLINE Boolean __CFSocketClearFDForWrite(CFSocketRef s) {
     }
     return b;
 }
+#endif
 
 #if TARGET_OS_WIN32
 static Boolean WinSockUsed = FALSE;
@@ -1493,6 +1611,20 @@ static void __CFSocketInitializeSockets(void) {
         ioctlsocket(__CFWakeupSocketPair[1], FIONBIO, (u_long *)&yes);
         __CFSocketFdSet(__CFWakeupSocketPair[1], __CFReadSocketsFds);
     }
+#if USE_EPOLL_SOCKET_MANAGER
+    __CFEpollSockets = CFDictionaryCreateMutable(kCFAllocatorSystemDefault, 0, NULL, NULL);
+    __CFEpollInvalidSockets = CFArrayCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeArrayCallBacks);
+    __CFSocketManagerEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (0 > __CFSocketManagerEpollFd) {
+        CFLog(kCFLogLevelWarning, CFSTR("*** Could not create epoll instance for CFSocket!!!"));
+    } else if (INVALID_SOCKET != __CFWakeupSocketPair[1]) {
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = __CFWakeupSocketPair[1];
+        epoll_ctl(__CFSocketManagerEpollFd, EPOLL_CTL_ADD, __CFWakeupSocketPair[1], &event);
+    }
+#endif
 }
 
 static CFRunLoopRef __CFSocketCopyRunLoopToWakeUp(CFRunLoopSourceRef src, CFMutableArrayRef runLoops) {
@@ -2103,6 +2235,185 @@ static void __CFSocketWriteSocketList(CFArrayRef sockets, CFDataRef fdSet, char*
 }
 #endif
 
+#if USE_EPOLL_SOCKET_MANAGER
+static void __CFSocketManagerInvalidatePendingSockets(void) {
+    CFArrayRef invalidSockets = NULL;
+    __CFLock(&__CFActiveSocketsLock);
+    if (0 < CFArrayGetCount(__CFEpollInvalidSockets)) {
+        invalidSockets = CFArrayCreateCopy(kCFAllocatorSystemDefault, __CFEpollInvalidSockets);
+        CFArrayRemoveAllValues(__CFEpollInvalidSockets);
+    }
+    __CFUnlock(&__CFActiveSocketsLock);
+    if (NULL != invalidSockets) {
+        CFIndex idx, cnt = CFArrayGetCount(invalidSockets);
+        for (idx = 0; idx < cnt; idx++) {
+            CFSocketRef s = (CFSocketRef)CFArrayGetValueAtIndex(invalidSockets, idx);
+            __CFSOCKETLOG_WS(s, "socket manager found socket invalid");
+            CFSocketInvalidate(s);
+        }
+        CFRelease(invalidSockets);
+    }
+}
+
+static void *__CFSocketManager(void * arg)
+{
+#if !TARGET_OS_CYGWIN
+    pthread_setname_np(pthread_self(), "com.apple.CFSocket.private");
+#endif
+    struct epoll_event *events = (struct epoll_event *)CFAllocatorAllocate(kCFAllocatorSystemDefault, __CFSOCKET_EPOLL_EVENT_COUNT * sizeof(struct epoll_event), 0);
+    SInt32 nevents, idx, cnt;
+    uint8_t buffer[256];
+    CFMutableArrayRef selectedWriteSockets = CFArrayCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeArrayCallBacks);
+    CFMutableArrayRef selectedReadSockets = CFArrayCreateMutable(kCFAllocatorSystemDefault, 0, &kCFTypeArrayCallBacks);
+    CFIndex selectedWriteSocketsIndex = 0, selectedReadSocketsIndex = 0;
+
+    struct timeval tv;
+    struct timeval* pTimeout = NULL;
+    struct timeval timeBeforeWait;
+
+    for (;;) {
+        int timeoutMS = -1;
+        __CFLock(&__CFActiveSocketsLock);
+        __CFSocketManagerIteration++;
+
+        if (__CFReadSocketsTimeoutInvalid) {
+            struct timeval* minTimeout = NULL;
+            __CFReadSocketsTimeoutInvalid = false;
+
+            __CFSOCKETLOG("Figuring out which sockets have timeouts...");
+
+            CFArrayApplyFunction(__CFReadSockets, CFRangeMake(0, CFArrayGetCount(__CFReadSockets)), _calcMinTimeout_locked, (void*) &minTimeout);
+
+            if (minTimeout == NULL) {
+                __CFSOCKETLOG("No one wants a timeout!");
+                pTimeout = NULL;
+            } else {
+                __CFSOCKETLOG("timeout will be %ld, %d!", minTimeout->tv_sec, minTimeout->tv_usec);
+                tv = *minTimeout;
+                pTimeout = &tv;
+            }
+        }
+
+        if (pTimeout) {
+            __CFSOCKETLOG("epoll_wait will have a %ld, %d timeout", pTimeout->tv_sec, pTimeout->tv_usec);
+            gettimeofday(&timeBeforeWait, NULL);
+            // round up so that a sub-millisecond timeout does not turn into a busy poll
+            int64_t ms = (int64_t)pTimeout->tv_sec * 1000 + (pTimeout->tv_usec + 999) / 1000;
+            timeoutMS = (ms > INT_MAX) ? INT_MAX : (int)ms;
+        }
+
+        __CFUnlock(&__CFActiveSocketsLock);
+
+        nevents = epoll_wait(__CFSocketManagerEpollFd, events, __CFSOCKET_EPOLL_EVENT_COUNT, timeoutMS);
+
+        __CFSOCKETLOG("socket manager woke from epoll_wait, ret=%ld", (long)nevents);
+
+        if (0 > nevents) {
+            if (EINTR != errno) {
+                __CFSOCKETLOG("socket manager received error %d from epoll_wait", errno);
+            }
+            continue;
+        }
+
+        /*
+         * epoll_wait returned a timeout
+         */
+        if (0 == nevents) {
+            __CFSOCKETLOG("Socket manager received timeout - kicking off expired reads");
+
+            __CFLock(&__CFActiveSocketsLock);
+            cnt = CFArrayGetCount(__CFReadSockets);
+            for (idx = 0; idx < cnt; idx++) {
+                CFSocketRef s = (CFSocketRef)CFArrayGetValueAtIndex(__CFReadSockets, idx);
+                if ((timerisset(&s->_readBufferTimeout) || s->_leftoverBytes) && INVALID_SOCKET != s->_socket) {
+                    __CFSOCKETLOG_WS(s, "Expiring socket (delta %ld, %d)", s->_readBufferTimeout.tv_sec, s->_readBufferTimeout.tv_usec);
+
+                    CFArraySetValueAtIndex(selectedReadSockets, selectedReadSocketsIndex, s);
+                    selectedReadSocketsIndex++;
+                    /* socket is removed from fds here, will be restored in read handling or in perform function */
+                    if (__CFSocketFdClr(s->_socket, __CFReadSocketsFds)) __CFSocketUpdateEpollInterest(s);
+                }
+            }
+            __CFUnlock(&__CFActiveSocketsLock);
+        }
+
+        __CFLock(&__CFActiveSocketsLock);
+        for (idx = 0; idx < nevents; idx++) {
+            CFSocketNativeHandle sock = events[idx].data.fd;
+            if (sock == __CFWakeupSocketPair[1]) {
+                recv(__CFWakeupSocketPair[1], (char *)buffer, sizeof(buffer), 0);
+                __CFSOCKETLOG("socket manager received %c on wakeup socket\n", buffer[0]);
+                continue;
+            }
+            // The registration may have been dropped while we were waiting, in which case the event is stale.
+            CFSocketRef s = (CFSocketRef)CFDictionaryGetValue(__CFEpollSockets, (void *)(uintptr_t)sock);
+            if (NULL == s) continue;
+            // Errors and hangups are reported to whichever callbacks are waiting, as select() would.
+            Boolean failed = (0 != (events[idx].events & (EPOLLERR | EPOLLHUP)));
+            Boolean changed = false;
+            if ((failed || 0 != (events[idx].events & EPOLLOUT)) && __CFSocketFdClr(sock, __CFWriteSocketsFds)) {
+                /* socket is removed from fds here, restored by CFSocketReschedule */
+                CFArraySetValueAtIndex(selectedWriteSockets, selectedWriteSocketsIndex, s);
+                selectedWriteSocketsIndex++;
+                changed = true;
+                __CFSOCKETLOG_WS(s, "Manager: cleared socket from write fds");
+            }
+            if ((failed || 0 != (events[idx].events & EPOLLIN)) && __CFSocketFdClr(sock, __CFReadSocketsFds)) {
+                /* socket is removed from fds here, will be restored in read handling or in perform function */
+                s->_hitTheTimeout = false;
+                CFArraySetValueAtIndex(selectedReadSockets, selectedReadSocketsIndex, s);
+                selectedReadSocketsIndex++;
+                changed = true;
+            }
+            if (changed) __CFSocketUpdateEpollInterest(s);
+        }
+
+        // Buffered readers with a timeout must still be told when it passes, even if other sockets
+        // keep the manager from ever seeing an epoll_wait timeout (e.g. while having a large download).
+        if (pTimeout && 0 != nevents) {
+            struct timeval timeNow = { 0 };
+            gettimeofday(&timeNow, NULL);
+            cnt = CFArrayGetCount(__CFReadSockets);
+            for (idx = 0; idx < cnt; idx++) {
+                CFSocketRef s = (CFSocketRef)CFArrayGetValueAtIndex(__CFReadSockets, idx);
+                if (__CFSocketFdIsSet(s->_socket, __CFReadSocketsFds) &&
+                    timerisset(&s->_readBufferTimeoutNotificationTime) &&
+                    timercmp(&timeNow, &s->_readBufferTimeoutNotificationTime, >))
+                {
+                    s->_hitTheTimeout = true;
+                    CFArraySetValueAtIndex(selectedReadSockets, selectedReadSocketsIndex, s);
+                    selectedReadSocketsIndex++;
+                    __CFSocketFdClr(s->_socket, __CFReadSocketsFds);
+                    __CFSocketUpdateEpollInterest(s);
+                }
+            }
+        }
+        __CFUnlock(&__CFActiveSocketsLock);
+
+        for (idx = 0; idx < selectedWriteSocketsIndex; idx++) {
+            CFSocketRef s = (CFSocketRef)CFArrayGetValueAtIndex(selectedWriteSockets, idx);
+            if (kCFNull == (CFNullRef)s) continue;
+            __CFSOCKETLOG_WS(s, "socket manager signaling for write", s, s->_socket);
+            __CFSocketHandleWrite(s, FALSE);
+            CFArraySetValueAtIndex(selectedWriteSockets, idx, kCFNull);
+        }
+        selectedWriteSocketsIndex = 0;
+
+        for (idx = 0; idx < selectedReadSocketsIndex; idx++) {
+            CFSocketRef s = (CFSocketRef)CFArrayGetValueAtIndex(selectedReadSockets, idx);
+            if (kCFNull == (CFNullRef)s) continue;
+            __CFSOCKETLOG_WS(s, "socket manager signaling for read", s, s->_socket);
+            __CFSocketHandleRead(s, nevents == 0 || s->_hitTheTimeout);
+            CFArraySetValueAtIndex(selectedReadSockets, idx, kCFNull);
+        }
+        selectedReadSocketsIndex = 0;
+
+        __CFSocketManagerInvalidatePendingSockets();
+    }
+    return NULL;
+}
+#else
+
 static void
 clearInvalidFileDescriptors(CFMutableDataRef d)
 {
@@ -2437,6 +2748,7 @@ static void *__CFSocketManager(void * arg)
     }
     return NULL;
 }
+#endif
 
 static CFStringRef __CFSocketCopyDescription(CFTypeRef cf) {
     CFSocketRef s = (CFSocketRef)cf;
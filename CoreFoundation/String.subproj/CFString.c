@@ -22,6 +22,7 @@
 #include <CoreFoundation/CFNumber.h>
 #include <CoreFoundation/CFNumberFormatter.h>
 #include <CoreFoundation/CFError_Private.h>
+#include <CoreFoundation/CFStorage.h>
 #include "CFInternal.h"
 #include "CFUniCharPriv.h"
 #include "CFString_Internal.h"
@@ -34,9 +35,21 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
+#if TARGET_OS_WIN32
+#include <Rpc.h>
+#else
+#if DEPLOYMENT_RUNTIME_SWIFT
+#include "uuid/uuid.h"
+#else
+#include <uuid/uuid.h>
+#endif
+#endif
 #if TARGET_OS_MAC || TARGET_OS_LINUX || TARGET_OS_BSD
 #include <unistd.h>
 #endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #if defined(__GNUC__)
 #define LONG_DOUBLE_SUPPORT 1
@@ -132,7 +145,7 @@ struct __notInlineMutable {
     void *buffer;
     CFIndex length;
         CFIndex capacity;                           // Capacity in bytes
-    unsigned int hasGap:1;                      // Currently unused
+    unsigned int hasStore:1;                    // buffer is a CFStorageRef; see __CFStrMakeStore()
     unsigned int isFixedCapacity:1;
     unsigned int isExternalMutable:1;
     unsigned int capacityProvidedExternally:1;
@@ -180,7 +193,7 @@ C = length field is CFIndex (rather than UInt32); only meaningful for 64-bit, re
 
 Also need (only for mutable)
 F = is fixed
-G = has gap
+G = has store (contents are held in a CFStorage)
 Cap, DesCap = capacity
 
 B7 B6 B5 B4 B3 B2 B1 B0
@@ -270,16 +283,27 @@ CF_INLINE Boolean __CFStrIsConstant(CFStringRef str) {
 
 CF_INLINE SInt32 __CFStrSkipAnyLengthByte(CFStringRef str)          {return __CFRuntimeGetFlag(str, __kCFHasLengthByte) ? 1 : 0;}	// Number of bytes to skip over the length byte in the contents
 
-/* Returns ptr to the buffer (which might include the length byte).
+CF_INLINE Boolean __CFStrHasStore(CFStringRef str)                  {return __CFStrIsMutable(str) && str->variants.notInlineMutable.hasStore;}
+
+static void __CFStrFlattenStore(CFMutableStringRef str);
+
+/* Returns ptr to the buffer (which might include the length byte). Must not be called on a string whose contents are held in a CFStorage; see __CFStrEnsureContiguous().
 */
 CF_INLINE const void *__CFStrContents(CFStringRef str) {
     if (__CFStrIsInline(str)) {
 	return (const void *)(((uintptr_t)&(str->variants)) + (__CFStrHasExplicitLength(str) ? sizeof(CFIndex) : 0));
     } else {	// Not inline; pointer is always word 2
+	CFAssert(!__CFStrHasStore(str), __kCFLogAssertion, "Asking for the contents of a string held in a CFStorage");
 	return str->variants.notInlineImmutable1.buffer;
     }
 }
 
+/* Called by mutating functions before they work on the buffer of str directly. Only these may move the contents out of a CFStorage; read-only functions read the store instead, as they may be running on several threads at once.
+*/
+CF_INLINE void __CFStrEnsureContiguous(CFMutableStringRef str) {
+    if (__CFStrHasStore(str)) __CFStrFlattenStore(str);
+}
+
 static CFAllocatorRef *__CFStrContentsDeallocatorPtr(CFStringRef str) {
     return __CFStrHasExplicitLength(str) ? &(((CFMutableStringRef)str)->variants.notInlineImmutable1.contentsDeallocator) : &(((CFMutableStringRef)str)->variants.notInlineImmutable2.contentsDeallocator); }
 
@@ -362,7 +386,6 @@ CF_INLINE Boolean __CFStrIsFixed(CFStringRef str)   		{return str->variants.notI
 CF_INLINE Boolean __CFStrIsExternalMutable(CFStringRef str)	{return str->variants.notInlineMutable.isExternalMutable;}
 CF_INLINE void __CFStrSetIsFixed(CFMutableStringRef str)		    {str->variants.notInlineMutable.isFixedCapacity = 1;}
 CF_INLINE void __CFStrSetIsExternalMutable(CFMutableStringRef str)	    {str->variants.notInlineMutable.isExternalMutable = 1;}
-//CF_INLINE void __CFStrSetHasGap(CFMutableStringRef str)			    {str->variants.notInlineMutable.hasGap = 1;} currently unused
 
 // If capacity is provided externally, we only change it when we need to grow beyond it
 CF_INLINE Boolean __CFStrCapacityProvidedExternally(CFStringRef str)   		{return str->variants.notInlineMutable.capacityProvidedExternally;}
@@ -814,6 +837,7 @@ static void __CFStringHandleOutOfMemory(CFTypeRef obj) {
 /* Reallocates the backing store of the string to accomodate the new length. Space is reserved or characters are deleted as indicated by insertLength and the ranges in deleteRanges. The length is updated to reflect the new state. Will also maintain a length byte and a null byte in 8-bit strings. If length cannot fit in length byte, the space will still be reserved, but will be 0. (Hence the reason the length byte should never be looked at as length unless there is no explicit length.)
 */
 static void __CFStringChangeSizeMultiple(CFMutableStringRef str, const CFRange *deleteRanges, CFIndex numDeleteRanges, CFIndex insertLength, Boolean makeUnicode) {
+    __CFStrEnsureContiguous(str);
     const uint8_t *curContents = (uint8_t *)__CFStrContents(str);
     CFIndex curLength = curContents ? __CFStrLength2(str, curContents) : 0;
     unsigned long newLength;	// We use unsigned to better keep track of overflow
@@ -935,6 +959,161 @@ CF_INLINE void __CFStringChangeSize(CFMutableStringRef str, CFRange range, CFInd
 }
 
 
+/* Large mutable strings that are edited away from their end are moved into a CFStorage, which makes such edits logarithmic rather than linear in the length of the string. While a string is store-backed its buffer is the CFStorageRef and it has no capacity; the explicit length is kept current, and the length and null byte flags describe the buffer it will get back, so that they do not change under callers that check them before calling __CFStrContents(). CFStringGetCharacters(), CFStringGetCharacterAtIndex() and CFHash() read the store directly, appends go into it, and CFStringGetCharactersPtr() and CFStringGetCStringPtr() return NULL. Other read-only functions that want contiguous contents work on a copy made by __CFStrCreateCopyFromStore(), and leave the string alone. Mutating functions that do not go through the store copy the contents back into a contiguous buffer with __CFStrEnsureContiguous() first.
+*/
+#define __kCFStringStoreThreshold (128 * 1024)	// In characters; below this, moving the rest of the buffer is cheap enough
+
+CF_INLINE CFStorageRef __CFStrStore(CFStringRef str) {
+    return (CFStorageRef)str->variants.notInlineMutable.buffer;
+}
+
+/* Returns whether an edit of range in the mutable string str should be made in a store. Only strings whose buffer CFString fully controls qualify, and appends are left to the buffer, where they are already amortized.
+*/
+CF_INLINE Boolean __CFStrShouldUseStore(CFStringRef str, CFRange range, Boolean makeUnicode) {
+    if (makeUnicode && !__CFStrIsUnicode(str)) return false;
+    if (__CFStrHasStore(str)) return true;
+    if ((__CFRuntimeGetValue(str, 6, 5) != __kCFNotInlineContentsDefaultFree) || __CFStrIsFixed(str) || __CFStrIsExternalMutable(str) || __CFStrCapacityProvidedExternally(str)) return false;
+    CFIndex length = __CFStrLength(str);
+    return (length >= __kCFStringStoreThreshold) && (range.location + range.length < length);
+}
+
+static void __CFStrMakeStore(CFMutableStringRef str) {
+    const uint8_t *contents = (const uint8_t *)__CFStrContents(str);
+    CFIndex length = __CFStrLength2(str, contents);
+    CFStorageRef store = CFStorageCreate(__CFGetAllocator(str), __CFStrIsUnicode(str) ? sizeof(UniChar) : sizeof(uint8_t));
+    CFStorageInsertValues(store, CFRangeMake(0, length));
+    CFStorageReplaceValues(store, CFRangeMake(0, length), contents + __CFStrSkipAnyLengthByte(str));
+    __CFStrDeallocateMutableContents(str, (void *)contents);
+    __CFStrSetCapacity(str, 0);
+    __CFStrSetContentPtr(str, store);
+    str->variants.notInlineMutable.hasStore = 1;
+}
+
+static void __CFStrFlattenStore(CFMutableStringRef str) {
+    CFStorageRef store = __CFStrStore(str);
+    CFIndex length = __CFStrLength(str);
+    Boolean isUnicode = __CFStrIsUnicode(str);
+    CFIndex charSize = isUnicode ? sizeof(UniChar) : sizeof(uint8_t);
+    CFIndex numExtraBytes = isUnicode ? 0 : 2;	/* Length byte & null byte */
+    CFIndex capacity = __CFStrNewCapacity(str, length * charSize + numExtraBytes, 0, true, charSize);
+    uint8_t *contents = (capacity == -1) ? NULL : (uint8_t *)__CFStrAllocateMutableContents(str, capacity);
+    if (!contents) __CFStringHandleOutOfMemory(str);	// Does not return
+
+    str->variants.notInlineMutable.hasStore = 0;
+    CFStorageGetValues(store, CFRangeMake(0, length), isUnicode ? contents : (contents + 1));
+    if (!isUnicode) {
+        contents[length + 1] = 0;
+        contents[0] = __CFCanUseLengthByte(length) ? (uint8_t)length : 0;
+    }
+    __CFStrSetCapacity(str, capacity);
+    __CFStrSetContentPtr(str, contents);
+    CFRelease(store);
+}
+
+/* Replaces range with length characters taken from either replacement or chars, moving the string into a store first if needed. chars must be ASCII if the string is 8-bit.
+*/
+static void __CFStrStoreReplace(CFMutableStringRef str, CFRange range, CFStringRef replacement, const UniChar *chars, CFIndex length) {
+    if (!__CFStrHasStore(str)) __CFStrMakeStore(str);
+
+    CFStorageRef store = __CFStrStore(str);
+    CFIndex newLength = __CFStrLength(str) - range.length + length;
+    if (newLength == 0) {
+        CFRelease(store);
+        str->variants.notInlineMutable.hasStore = 0;
+        __CFStrSetContentPtr(str, NULL);
+        __CFStrClearHasLengthAndNullBytes(str);
+        __CFStrSetUnicode(str, false);
+        __CFStrSetExplicitLength(str, 0);
+        return;
+    }
+
+    // Overwrite what the range and the new characters have in common, then delete or insert the difference
+    if (range.length > length) {
+        CFStorageDeleteValues(store, CFRangeMake(range.location + length, range.length - length));
+    } else if (length > range.length) {
+        CFStorageInsertValues(store, CFRangeMake(range.location + range.length, length - range.length));
+    }
+    __CFStrSetExplicitLength(str, newLength);
+
+    Boolean isUnicode = __CFStrIsUnicode(str);
+    CFIndex filled = 0;
+    while (filled < length) {
+        CFRange validRange;
+        uint8_t *values = (uint8_t *)CFStorageGetValueAtIndex(store, range.location + filled, &validRange);
+        CFIndex count = __CFMin(validRange.location + validRange.length - (range.location + filled), length - filled);
+        if (isUnicode) {
+            if (chars) {
+                memmove(values, chars + filled, count * sizeof(UniChar));
+            } else {
+                CFStringGetCharacters(replacement, CFRangeMake(filled, count), (UniChar *)values);
+            }
+        } else {
+            if (chars) {
+                for (CFIndex idx = 0; idx < count; idx++) values[idx] = (uint8_t)chars[filled + idx];
+            } else {
+                CFStringGetBytes(replacement, CFRangeMake(filled, count), __CFStringGetEightBitStringEncoding(), 0, false, values, count, NULL);
+            }
+        }
+        filled += count;
+    }
+}
+
+/* Appends length characters in the eight bit string encoding to the store-backed string str.
+*/
+static void __CFStrStoreAppendBytes(CFMutableStringRef str, const uint8_t *bytes, CFIndex length) {
+    if (length == 0) return;
+    CFStorageRef store = __CFStrStore(str);
+    CFIndex location = __CFStrLength(str);
+    CFStorageInsertValues(store, CFRangeMake(location, length));
+    __CFStrSetExplicitLength(str, location + length);
+
+    Boolean isUnicode = __CFStrIsUnicode(str);
+    CFIndex filled = 0;
+    while (filled < length) {
+        CFRange validRange;
+        uint8_t *values = (uint8_t *)CFStorageGetValueAtIndex(store, location + filled, &validRange);
+        CFIndex count = __CFMin(validRange.location + validRange.length - (location + filled), length - filled);
+        if (isUnicode) {
+            __CFStrConvertBytesToUnicode(bytes + filled, (UniChar *)values, count);
+        } else {
+            memmove(values, bytes + filled, count);
+        }
+        filled += count;
+    }
+}
+
+static void __CFStrStoreGetCharacters(CFStringRef str, CFRange range, UniChar *buffer) {
+    CFStorageRef store = __CFStrStore(str);
+    Boolean isUnicode = __CFStrIsUnicode(str);
+    while (range.length > 0) {
+        CFRange validRange;
+        const uint8_t *values = (const uint8_t *)CFStorageGetConstValueAtIndex(store, range.location, &validRange);
+        CFIndex count = __CFMin(validRange.location + validRange.length - range.location, range.length);
+        if (isUnicode) {
+            memmove(buffer, values, count * sizeof(UniChar));
+        } else {
+            __CFStrConvertBytesToUnicode(values, buffer, count);
+        }
+        buffer += count;
+        range.location += count;
+        range.length -= count;
+    }
+}
+
+/* Creates an immutable string with the characters in range of the store-backed string str.
+*/
+static CFStringRef __CFStrCreateCopyFromStore(CFAllocatorRef alloc, CFStringRef str, CFRange range) {
+    if (alloc == NULL) alloc = __CFGetDefaultAllocator();
+    if (range.length == 0) return __CFStringCreateImmutableFunnel3(alloc, "", 0, kCFStringEncodingASCII, false, false, false, false, false, kCFAllocatorNull, 0);
+    Boolean isUnicode = __CFStrIsUnicode(str);
+    CFIndex numBytes = range.length * (isUnicode ? sizeof(UniChar) : sizeof(uint8_t));
+    void *bytes = CFAllocatorAllocate(alloc, numBytes, 0);
+    if (!bytes) __CFStringHandleOutOfMemory(str);	// Does not return
+    CFStorageGetValues(__CFStrStore(str), range, bytes);
+    return __CFStringCreateImmutableFunnel3(alloc, bytes, numBytes, isUnicode ? kCFStringEncodingUnicode : __CFStringGetEightBitStringEncoding(), false, isUnicode, false, false, true, alloc, 0);
+}
+
+
 #if defined(DEBUG)
 static Boolean __CFStrIsConstantString(CFStringRef str);
 #endif
@@ -948,7 +1127,9 @@ static void __CFStringDeallocate(CFTypeRef cf) {
     if (!__CFStrIsInline(str)) {
         uint8_t *contents;
 	Boolean isMutable = __CFStrIsMutable(str);
-        if (__CFStrFreeContentsWhenDone(str) && (contents = (uint8_t *)__CFStrContents(str))) {
+        if (isMutable && __CFStrHasStore(str)) {
+            CFRelease(__CFStrStore(str));
+        } else if (__CFStrFreeContentsWhenDone(str) && (contents = (uint8_t *)__CFStrContents(str))) {
             if (isMutable) {
 	        __CFStrDeallocateMutableContents((CFMutableStringRef)str, contents);
 	    } else {
@@ -979,6 +1160,16 @@ static Boolean __CFStringEqual(CFTypeRef cf1, CFTypeRef cf2) {
     /* !!! We do not need IsString assertions, as the CFBase runtime assures this */
     /* !!! We do not need == test, as the CFBase runtime assures this */
 
+    if (__CFStrHasStore(str1) || __CFStrHasStore(str2)) {
+        if (__CFStrLength(str1) != __CFStrLength(str2)) return false;
+        CFStringRef copy1 = __CFStrHasStore(str1) ? __CFStrCreateCopyFromStore(kCFAllocatorSystemDefault, str1, CFRangeMake(0, __CFStrLength(str1))) : (CFStringRef)CFRetain(str1);
+        CFStringRef copy2 = __CFStrHasStore(str2) ? __CFStrCreateCopyFromStore(kCFAllocatorSystemDefault, str2, CFRangeMake(0, __CFStrLength(str2))) : (CFStringRef)CFRetain(str2);
+        Boolean result = __CFStringEqual(copy1, copy2);
+        CFRelease(copy1);
+        CFRelease(copy2);
+        return result;
+    }
+
     contents1 = (uint8_t *)__CFStrContents(str1);
     contents2 = (uint8_t *)__CFStrContents(str2);
     len1 = __CFStrLength2(str1, contents1);
@@ -1047,6 +1238,121 @@ Hash function was changed between Panther and Tiger, and Tiger and Leopard.
 #define HashNextUniChar(accessStart, accessEnd, pointer) \
     {result = result * 257 + (accessStart 0 accessEnd); pointer++;}
 
+/* Seeded string hashing: The sampled hash above only looks at 96 characters of long strings, so
+keys which share long prefixes and suffixes (URLs, paths) collide heavily. Setting CFSTRING_SEEDED_HASH=1
+in the environment switches CFHash(), CFStringHashNSString() and friends to a hash of the full contents,
+keyed with a random per-process seed (CFSTRING_HASH_SEED=<n> fixes the seed, for reproducing a problem).
+
+The hash is computed over UniChars, so 8-bit and Unicode backing stores of the same string agree. It
+consumes 8 UniChars per step as two 64-bit words, folding each block into the state with a 64x64->128
+bit multiply; the tail block is zero-padded and the length is mixed in last. The choice is made once
+per process, before the first string is hashed, and hash codes are not stable across processes.
+*/
+#define __CFStrSeededHashBlock 8
+#define __CFStrSeededHashP0 0xa0761d6478bd642fULL
+#define __CFStrSeededHashP1 0xe7037ed1a0b428dbULL
+#define __CFStrSeededHashP2 0x8ebc6af09c88c6e3ULL
+#define __CFStrSeededHashP3 0x589965cc75374cc3ULL
+
+static Boolean __CFStrHashIsSeeded = false;
+static uint64_t __CFStrHashSeed = 0;
+
+static Boolean __CFStrUsesSeededHash(void) {
+    static dispatch_once_t initOnce;
+    dispatch_once(&initOnce, ^{
+        const char *enabled = __CFgetenv("CFSTRING_SEEDED_HASH");
+        const char *fixedSeed = __CFgetenvIfNotRestricted("CFSTRING_HASH_SEED");
+        if (fixedSeed) {
+            __CFStrHashSeed = strtoull(fixedSeed, NULL, 0);
+            __CFStrHashIsSeeded = true;
+        } else if (enabled && 0 != strcmp(enabled, "0")) {
+#if TARGET_OS_WIN32
+            UUID u;
+            UuidCreate(&u);
+            memmove(&__CFStrHashSeed, &u, sizeof(__CFStrHashSeed));
+#else
+            uuid_t u;
+            uuid_generate_random(u);
+            memmove(&__CFStrHashSeed, u, sizeof(__CFStrHashSeed));
+#endif
+            __CFStrHashIsSeeded = true;
+        }
+    });
+    return __CFStrHashIsSeeded;
+}
+
+CF_INLINE uint64_t __CFStrSeededHashMix(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+#else
+    uint64_t ha = a >> 32, la = (uint32_t)a, hb = b >> 32, lb = (uint32_t)b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32), carry = (t < rl);
+    uint64_t lo = t + (rm1 << 32);
+    carry += (lo < t);
+    uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+    return lo ^ hi;
+#endif
+}
+
+CF_INLINE uint64_t __CFStrSeededHashWord(const UniChar *u) {
+    return (uint64_t)u[0] | ((uint64_t)u[1] << 16) | ((uint64_t)u[2] << 32) | ((uint64_t)u[3] << 48);
+}
+
+// Widens 4 bytes to 4 UniChars, through table unless they are all ASCII; table is NULL for ISO Latin 1
+CF_INLINE uint64_t __CFStrSeededHashEightBitWord(const uint8_t *c, const UniChar *table) {
+    if (table && ((c[0] | c[1] | c[2] | c[3]) & 0x80)) {
+        return (uint64_t)table[c[0]] | ((uint64_t)table[c[1]] << 16) | ((uint64_t)table[c[2]] << 32) | ((uint64_t)table[c[3]] << 48);
+    }
+    return (uint64_t)c[0] | ((uint64_t)c[1] << 16) | ((uint64_t)c[2] << 32) | ((uint64_t)c[3] << 48);
+}
+
+CF_INLINE uint64_t __CFStrSeededHashStart(void) {
+    return __CFStrHashSeed ^ __CFStrSeededHashP0;
+}
+
+CF_INLINE uint64_t __CFStrSeededHashStep(uint64_t state, uint64_t w0, uint64_t w1) {
+    return __CFStrSeededHashMix(w0 ^ __CFStrSeededHashP1, w1 ^ state);
+}
+
+CF_INLINE CFHashCode __CFStrSeededHashFinish(uint64_t state, CFIndex len) {
+    return (CFHashCode)__CFStrSeededHashMix(state ^ __CFStrSeededHashP2, (uint64_t)len ^ __CFStrSeededHashP3);
+}
+
+// Hashes the whole blocks of uContents and, if isLast, the tail; returns the state otherwise
+CF_INLINE uint64_t __CFStrSeededHashCharacters(uint64_t state, const UniChar *uContents, CFIndex len, Boolean isLast) {
+    const UniChar *end = uContents + (len & ~(__CFStrSeededHashBlock - 1));
+    while (uContents < end) {
+        state = __CFStrSeededHashStep(state, __CFStrSeededHashWord(uContents), __CFStrSeededHashWord(uContents + 4));
+        uContents += __CFStrSeededHashBlock;
+    }
+    CFIndex tailLen = len & (__CFStrSeededHashBlock - 1);
+    if (isLast && 0 < tailLen) {
+        UniChar tail[__CFStrSeededHashBlock] = {0};
+        memmove(tail, uContents, tailLen * sizeof(UniChar));
+        state = __CFStrSeededHashStep(state, __CFStrSeededHashWord(tail), __CFStrSeededHashWord(tail + 4));
+    }
+    return state;
+}
+
+CF_INLINE CFHashCode __CFStrSeededHashEightBit(const uint8_t *cContents, CFIndex len, const UniChar *table) {
+    uint64_t state = __CFStrSeededHashStart();
+    const uint8_t *end = cContents + (len & ~(__CFStrSeededHashBlock - 1));
+    while (cContents < end) {
+        state = __CFStrSeededHashStep(state, __CFStrSeededHashEightBitWord(cContents, table), __CFStrSeededHashEightBitWord(cContents + 4, table));
+        cContents += __CFStrSeededHashBlock;
+    }
+    CFIndex tailLen = len & (__CFStrSeededHashBlock - 1);
+    if (0 < tailLen) {
+        // NUL maps to 0 in every 8-bit encoding, so the padding hashes like that of UniChars
+        uint8_t tail[__CFStrSeededHashBlock] = {0};
+        memmove(tail, cContents, tailLen);
+        state = __CFStrSeededHashStep(state, __CFStrSeededHashEightBitWord(tail, table), __CFStrSeededHashEightBitWord(tail + 4, table));
+    }
+    return __CFStrSeededHashFinish(state, len);
+}
+
 
 /* In this function, actualLen is the length of the original string; but len is the number of characters in buffer. The buffer is expected to contain the parts of the string relevant to hashing.
 */
@@ -1115,10 +1421,12 @@ CF_INLINE CFHashCode __CFStrHashEightBit(const uint8_t *cContents, CFIndex len)
 
 // This is for NSStringROMKeySet.
 CF_PRIVATE CFHashCode __CFStrHashEightBit2(const uint8_t *cContents, CFIndex len) {
+    if (__CFStrUsesSeededHash()) return __CFStrSeededHashEightBit(cContents, len, __CFCharToUniCharTable);
     return __CFStrHashEightBit(cContents, len);
 }
 
 CFHashCode CFStringHashISOLatin1CString(const uint8_t *bytes, CFIndex len) {
+    if (__CFStrUsesSeededHash()) return __CFStrSeededHashEightBit(bytes, len, NULL);
     CFHashCode result = len;
     if (len <= HashEverythingLimit) {
         const uint8_t *end4 = bytes + (len & ~3);
@@ -1141,19 +1449,44 @@ CFHashCode CFStringHashISOLatin1CString(const uint8_t *bytes, CFIndex len) {
 }
 
 CFHashCode CFStringHashCString(const uint8_t *bytes, CFIndex len) {
+    if (__CFStrUsesSeededHash()) return __CFStrSeededHashEightBit(bytes, len, __CFCharToUniCharTable);
     return __CFStrHashEightBit(bytes, len);
 }
 
 CFHashCode CFStringHashCharacters(const UniChar *characters, CFIndex len) {
+    if (__CFStrUsesSeededHash()) return __CFStrSeededHashFinish(__CFStrSeededHashCharacters(__CFStrSeededHashStart(), characters, len, true), len);
     return __CFStrHashCharacters(characters, len, len);
 }
 
+static void __CFStrGetNSStringCharacters(CFStringRef str, CFRange range, UniChar *buffer) {
+#if DEPLOYMENT_RUNTIME_SWIFT
+    (void)CF_SWIFT_CALLV(str, NSString.getCharacters, range, buffer);
+#else
+    (void)CF_OBJC_CALLV((NSString *)str, getCharacters:buffer range:NSMakeRange(range.location, range.length));
+#endif
+}
+
 /* This is meant to be called from NSString or subclassers only. It is an error for this to be called without the ObjC runtime or an argument which is not an NSString or subclass. It can be called with NSCFString, although that would be inefficient (causing indirection) and won't normally happen anyway, as NSCFString overrides hash.
 */
 CFHashCode CFStringHashNSString(CFStringRef str) {
     UniChar buffer[HashEverythingLimit];
     CFIndex bufLen;		// Number of characters in the buffer for hashing
     CFIndex len = 0;	// Actual length of the string
+    if (__CFStrUsesSeededHash()) {
+#if DEPLOYMENT_RUNTIME_SWIFT
+        len = CF_SWIFT_CALLV(str, NSString.length);
+#else
+        len = CF_OBJC_CALLV((NSString *)str, length);
+#endif
+        // HashEverythingLimit is a multiple of the block size, so only the last chunk has a partial block
+        uint64_t state = __CFStrSeededHashStart();
+        for (CFIndex loc = 0; loc < len; loc += HashEverythingLimit) {
+            bufLen = __CFMin(len - loc, HashEverythingLimit);
+            __CFStrGetNSStringCharacters(str, CFRangeMake(loc, bufLen), buffer);
+            state = __CFStrSeededHashCharacters(state, buffer, bufLen, (loc + bufLen == len));
+        }
+        return __CFStrSeededHashFinish(state, len);
+    }
 #if DEPLOYMENT_RUNTIME_SWIFT
     len = CF_SWIFT_CALLV(str, NSString.length);
     if (len <= HashEverythingLimit) {
@@ -1183,13 +1516,40 @@ CFHashCode CFStringHashNSString(CFStringRef str) {
 CFHashCode __CFStringHash(CFTypeRef cf) {
     /* !!! We do not need an IsString assertion here, as this is called by the CFBase runtime only */
     CFStringRef str = (CFStringRef)cf;
+    if (__CFStrHasStore(str)) {
+        // Read only the characters that get hashed, a chunk at a time, rather than copying the whole store
+        UniChar buffer[HashEverythingLimit];
+        CFIndex bufLen;
+        CFIndex len = __CFStrLength(str);
+        if (__CFStrUsesSeededHash()) {
+            uint64_t state = __CFStrSeededHashStart();
+            for (CFIndex loc = 0; loc < len; loc += HashEverythingLimit) {
+                bufLen = __CFMin(len - loc, HashEverythingLimit);
+                __CFStrStoreGetCharacters(str, CFRangeMake(loc, bufLen), buffer);
+                state = __CFStrSeededHashCharacters(state, buffer, bufLen, (loc + bufLen == len));
+            }
+            return __CFStrSeededHashFinish(state, len);
+        }
+        if (len <= HashEverythingLimit) {
+            __CFStrStoreGetCharacters(str, CFRangeMake(0, len), buffer);
+            bufLen = len;
+        } else {
+            __CFStrStoreGetCharacters(str, CFRangeMake(0, 32), buffer);
+            __CFStrStoreGetCharacters(str, CFRangeMake((len >> 1) - 16, 32), buffer + 32);
+            __CFStrStoreGetCharacters(str, CFRangeMake(len - 32, 32), buffer + 64);
+            bufLen = HashEverythingLimit;
+        }
+        return __CFStrHashCharacters(buffer, bufLen, len);
+    }
     const uint8_t *contents = (uint8_t *)__CFStrContents(str);
     CFIndex len = __CFStrLength2(str, contents);
 
     if (__CFStrIsEightBit(str)) {
         contents += __CFStrSkipAnyLengthByte(str);
+        if (__CFStrUsesSeededHash()) return __CFStrSeededHashEightBit(contents, len, __CFCharToUniCharTable);
         return __CFStrHashEightBit(contents, len);
     } else {
+        if (__CFStrUsesSeededHash()) return __CFStrSeededHashFinish(__CFStrSeededHashCharacters(__CFStrSeededHashStart(), (const UniChar *)contents, len, true), len);
         return __CFStrHashCharacters((const UniChar *)contents, len, len);
     }
 }
@@ -1678,6 +2038,8 @@ CFStringRef CFStringCreateWithSubstring(CFAllocatorRef alloc, CFStringRef str, C
 
     if ((range.location == 0) && (range.length == __CFStrLength(str))) {	/* The substring is the whole string... */
 	return (CFStringRef)CFStringCreateCopy(alloc, str);
+    } else if (__CFStrHasStore(str)) {
+        return __CFStrCreateCopyFromStore(alloc, str, range);
     } else if (__CFStrIsEightBit(str)) {
 	const uint8_t *contents = (const uint8_t *)__CFStrContents(str);
         return __CFStringCreateImmutableFunnel3(alloc, contents + range.location + __CFStrSkipAnyLengthByte(str), range.length, __CFStringGetEightBitStringEncoding(), false, false, false, false, false, ALLOCATORSFREEFUNC, 0);
@@ -1723,6 +2085,9 @@ CFStringRef CFStringCreateCopy(CFAllocatorRef alloc, CFStringRef str) {
         CFRetain(str);			// Then just retain instead of making a true copy
 	return str;
     }
+    if (__CFStrHasStore(str)) {
+        return __CFStrCreateCopyFromStore(alloc, str, CFRangeMake(0, __CFStrLength(str)));
+    }
     if (__CFStrIsEightBit((CFStringRef)str)) {
         const uint8_t *contents = (const uint8_t *)__CFStrContents((CFStringRef)str);
         return __CFStringCreateImmutableFunnel3(alloc, contents + __CFStrSkipAnyLengthByte((CFStringRef)str), __CFStrLength2((CFStringRef)str, contents), __CFStringGetEightBitStringEncoding(), false, false, false, false, false, ALLOCATORSFREEFUNC, 0);
@@ -1926,15 +2291,20 @@ CF_INLINE void __CFStringReplace(CFMutableStringRef str, CFRange range, CFString
     CFStringRef copy = NULL;
     if (replacement == str) copy = replacement = (CFStringRef)CFStringCreateCopy(kCFAllocatorSystemDefault, replacement);   // Very special and hopefully rare case
     CFIndex replacementLength = CFStringGetLength(replacement);
+    Boolean makeUnicode = (replacementLength > 0) && CFStrIsUnicode(replacement);
 
-    __CFStringChangeSize(str, range, replacementLength, (replacementLength > 0) && CFStrIsUnicode(replacement));
-
-    if (__CFStrIsUnicode(str)) {
-        UniChar *contents = (UniChar *)__CFStrContents(str);
-        CFStringGetCharacters(replacement, CFRangeMake(0, replacementLength), contents + range.location);
+    if (__CFStrShouldUseStore(str, range, makeUnicode)) {
+        __CFStrStoreReplace(str, range, replacement, NULL, replacementLength);
     } else {
-        uint8_t *contents = (uint8_t *)__CFStrContents(str);
-        CFStringGetBytes(replacement, CFRangeMake(0, replacementLength), __CFStringGetEightBitStringEncoding(), 0, false, contents + range.location + __CFStrSkipAnyLengthByte(str), replacementLength, NULL);
+        __CFStringChangeSize(str, range, replacementLength, makeUnicode);
+
+        if (__CFStrIsUnicode(str)) {
+            UniChar *contents = (UniChar *)__CFStrContents(str);
+            CFStringGetCharacters(replacement, CFRangeMake(0, replacementLength), contents + range.location);
+        } else {
+            uint8_t *contents = (uint8_t *)__CFStrContents(str);
+            CFStringGetBytes(replacement, CFRangeMake(0, replacementLength), __CFStringGetEightBitStringEncoding(), 0, false, contents + range.location + __CFStrSkipAnyLengthByte(str), replacementLength, NULL);
+        }
     }
 
     if (copy) CFRelease(copy);
@@ -1960,7 +2330,7 @@ CF_INLINE CFMutableStringRef __CFStringCreateMutableFunnel(CFAllocatorRef alloc,
         __CFStrSetIsMutable(str);
         str->variants.notInlineMutable.buffer = NULL;
         __CFStrSetExplicitLength(str, 0);
-	str->variants.notInlineMutable.hasGap = str->variants.notInlineMutable.isFixedCapacity = str->variants.notInlineMutable.isExternalMutable = str->variants.notInlineMutable.capacityProvidedExternally = 0;
+	str->variants.notInlineMutable.hasStore = str->variants.notInlineMutable.isFixedCapacity = str->variants.notInlineMutable.isExternalMutable = str->variants.notInlineMutable.capacityProvidedExternally = 0;
 	if (maxLength != 0) __CFStrSetIsFixed(str);
         __CFStrSetDesiredCapacity(str, (maxLength == 0) ? DEFAULTMINCAPACITY : maxLength);
         __CFStrSetCapacity(str, 0);
@@ -2053,12 +2423,22 @@ UniChar CFStringGetCharacterAtIndex(CFStringRef str, CFIndex idx) {
 
     __CFAssertIsString(str);
     __CFAssertIndexIsInStringBounds(str, idx);
+    if (__CFStrHasStore(str)) {
+        UniChar ch;
+        __CFStrStoreGetCharacters(str, CFRangeMake(idx, 1), &ch);
+        return ch;
+    }
     return __CFStringGetCharacterAtIndexGuts(str, idx, (const uint8_t *)__CFStrContents(str));
 }
 
 /* This one is for NSCFString usage; it doesn't do ObjC dispatch; but it does do range check
 */
 int _CFStringCheckAndGetCharacterAtIndex(CFStringRef str, CFIndex idx, UniChar *ch) {
+    if (__CFStrHasStore(str)) {
+        if (idx >= __CFStrLength(str) && __CFStringNoteErrors()) return _CFStringErrBounds;
+        __CFStrStoreGetCharacters(str, CFRangeMake(idx, 1), ch);
+        return _CFStringErrNone;
+    }
     const uint8_t *contents = (const uint8_t *)__CFStrContents(str);
     if (idx >= __CFStrLength2(str, contents) && __CFStringNoteErrors()) return _CFStringErrBounds;
     *ch = __CFStringGetCharacterAtIndexGuts(str, idx, contents);
@@ -2085,12 +2465,21 @@ void CFStringGetCharacters(CFStringRef str, CFRange range, UniChar *buffer) {
 
     __CFAssertIsString(str);
     __CFAssertRangeIsInStringBounds(str, range.location, range.length);
-    __CFStringGetCharactersGuts(str, range, buffer, (const uint8_t *)__CFStrContents(str));
+    if (__CFStrHasStore(str)) {
+        __CFStrStoreGetCharacters(str, range, buffer);
+    } else {
+        __CFStringGetCharactersGuts(str, range, buffer, (const uint8_t *)__CFStrContents(str));
+    }
 }
 
 /* This one is for NSCFString usage; it doesn't do ObjC dispatch; but it does do range check
 */
 int _CFStringCheckAndGetCharacters(CFStringRef str, CFRange range, UniChar *buffer) {
+     if (__CFStrHasStore(str)) {
+         if (range.location + range.length > __CFStrLength(str) && __CFStringNoteErrors()) return _CFStringErrBounds;
+         __CFStrStoreGetCharacters(str, range, buffer);
+         return _CFStringErrNone;
+     }
      const uint8_t *contents = (const uint8_t *)__CFStrContents(str);
      if (range.location + range.length > __CFStrLength2(str, contents) && __CFStringNoteErrors()) return _CFStringErrBounds;
      __CFStringGetCharactersGuts(str, range, buffer, contents);
@@ -2110,6 +2499,13 @@ CFIndex CFStringGetBytes(CFStringRef str, CFRange range, CFStringEncoding encodi
         __CFAssertIsString(str);
         __CFAssertRangeIsInStringBounds(str, range.location, range.length);
 
+        if (__CFStrHasStore(str)) {
+            CFStringRef copy = __CFStrCreateCopyFromStore(kCFAllocatorSystemDefault, str, range);
+            CFIndex result = CFStringGetBytes(copy, CFRangeMake(0, range.length), encoding, lossByte, isExternalRepresentation, buffer, maxBufLen, usedBufLen);
+            CFRelease(copy);
+            return result;
+        }
+
         if (__CFStrIsEightBit(str) && ((__CFStringGetEightBitStringEncoding() == encoding) || (__CFStringGetEightBitStringEncoding() == kCFStringEncodingASCII && __CFStringEncodingIsSupersetOfASCII(encoding)))) {	// Requested encoding is equal to the encoding in string
             const unsigned char *contents = (const unsigned char *)__CFStrContents(str);
             CFIndex cLength = range.length;
@@ -2132,7 +2528,7 @@ ConstStringPtr CFStringGetPascalStringPtr (CFStringRef str, CFStringEncoding enc
 
     if (!CF_IS_OBJC(_kCFRuntimeIDCFString, str) && !CF_IS_SWIFT(_kCFRuntimeIDCFString, str)) {	/* ??? Hope the compiler optimizes this away if OBJC_MAPPINGS is not on */
         __CFAssertIsString(str);
-        if (__CFStrHasLengthByte(str) && __CFStrIsEightBit(str) && ((__CFStringGetEightBitStringEncoding() == encoding) || (__CFStringGetEightBitStringEncoding() == kCFStringEncodingASCII && __CFStringEncodingIsSupersetOfASCII(encoding)))) {	// Requested encoding is equal to the encoding in string || the contents is in ASCII
+        if (__CFStrHasLengthByte(str) && !__CFStrHasStore(str) && __CFStrIsEightBit(str) && ((__CFStringGetEightBitStringEncoding() == encoding) || (__CFStringGetEightBitStringEncoding() == kCFStringEncodingASCII && __CFStringEncodingIsSupersetOfASCII(encoding)))) {	// Requested encoding is equal to the encoding in string || the contents is in ASCII
 	    const uint8_t *contents = (const uint8_t *)__CFStrContents(str);
 	    if (__CFStrHasExplicitLength(str) && (__CFStrLength2(str, contents) != (SInt32)(*contents))) return NULL;	// Invalid length byte
 	    return (ConstStringPtr)contents;
@@ -2155,7 +2551,7 @@ const char * CFStringGetCStringPtr(CFStringRef str, CFStringEncoding encoding) {
 
     __CFAssertIsString(str);
 
-    if (__CFStrHasNullByte(str)) {
+    if (__CFStrHasNullByte(str) && !__CFStrHasStore(str)) {
         // Note: this is called a lot, 27000 times to open a small xcode project with one file open.
         // Of these uses about 1500 are for cStrings/utf8strings.
 	return (const char *)__CFStrContents(str) + __CFStrSkipAnyLengthByte(str);
@@ -2170,7 +2566,7 @@ const UniChar *CFStringGetCharactersPtr(CFStringRef str) {
     CF_OBJC_FUNCDISPATCHV(_kCFRuntimeIDCFString, const UniChar *, (NSString *)str, _fastCharacterContents);
     
     __CFAssertIsString(str);
-    if (__CFStrIsUnicode(str)) return (const UniChar *)__CFStrContents(str);
+    if (__CFStrIsUnicode(str) && !__CFStrHasStore(str)) return (const UniChar *)__CFStrContents(str);
     return NULL;
 }
 
@@ -2190,6 +2586,13 @@ Boolean CFStringGetPascalString(CFStringRef str, Str255 buffer, CFIndex bufferSi
 
         __CFAssertIsString(str);
 
+        if (__CFStrHasStore(str)) {
+            CFStringRef copy = __CFStrCreateCopyFromStore(kCFAllocatorSystemDefault, str, CFRangeMake(0, __CFStrLength(str)));
+            Boolean result = CFStringGetPascalString(copy, buffer, bufferSize, encoding);
+            CFRelease(copy);
+            return result;
+        }
+
         contents = (const uint8_t *)__CFStrContents(str);
         length = __CFStrLength2(str, contents);
 
@@ -2230,6 +2633,13 @@ Boolean CFStringGetCString(CFStringRef str, char *buffer, CFIndex bufferSize, CF
 
     __CFAssertIsString(str);
 
+    if (__CFStrHasStore(str)) {
+        CFStringRef copy = __CFStrCreateCopyFromStore(kCFAllocatorSystemDefault, str, CFRangeMake(0, __CFStrLength(str)));
+        Boolean result = CFStringGetCString(copy, buffer, bufferSize, encoding);
+        CFRelease(copy);
+        return result;
+    }
+
     contents = (const uint8_t *)__CFStrContents(str);
     len = __CFStrLength2(str, contents);
 
@@ -2925,6 +3335,126 @@ CFComparisonResult CFStringCompare(CFStringRef string, CFStringRef str2, CFStrin
     return CFStringCompareWithOptions(string, str2, CFRangeMake(0, CFStringGetLength(string)), options);
 }
 
+/* Literal search over directly accessible contents. fromLoc and toLoc are the first and last candidate positions in search order, as in CFStringFindWithOptionsAndLocale(). Candidates are filtered on both the first and the last unit of the needle, a block of positions at a time, and only the survivors are compared in full.
+*/
+static Boolean __CFStringFindBytesLiteral(const uint8_t *haystack, const uint8_t *needle, CFIndex needleLen, CFIndex fromLoc, CFIndex toLoc, CFIndex *foundLoc) {
+    const uint8_t first = needle[0], last = needle[needleLen - 1];
+    CFIndex loc = fromLoc;
+#if defined(__SSE2__)
+    const __m128i firstVec = _mm_set1_epi8((char)first), lastVec = _mm_set1_epi8((char)last);
+#endif
+
+    if (fromLoc <= toLoc) {
+#if defined(__SSE2__)
+        while (toLoc - loc >= 15) {
+            __m128i firstMatch = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(haystack + loc)), firstVec);
+            __m128i lastMatch = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(haystack + loc + needleLen - 1)), lastVec);
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(firstMatch, lastMatch));
+            while (mask) {
+                CFIndex candidate = loc + __builtin_ctz(mask);
+                if (0 == memcmp(haystack + candidate, needle, needleLen)) {
+                    *foundLoc = candidate;
+                    return true;
+                }
+                mask &= mask - 1;
+            }
+            loc += 16;
+        }
+#endif
+        for (; loc <= toLoc; loc++) {
+            if ((haystack[loc] == first) && (haystack[loc + needleLen - 1] == last) && (0 == memcmp(haystack + loc, needle, needleLen))) {
+                *foundLoc = loc;
+                return true;
+            }
+        }
+    } else {
+#if defined(__SSE2__)
+        while (loc - toLoc >= 15) {
+            CFIndex block = loc - 15;
+            __m128i firstMatch = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(haystack + block)), firstVec);
+            __m128i lastMatch = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(haystack + block + needleLen - 1)), lastVec);
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(firstMatch, lastMatch));
+            while (mask) {
+                int bit = 31 - __builtin_clz(mask);
+                if (0 == memcmp(haystack + block + bit, needle, needleLen)) {
+                    *foundLoc = block + bit;
+                    return true;
+                }
+                mask &= ~(1U << bit);
+            }
+            loc -= 16;
+        }
+#endif
+        for (; loc >= toLoc; loc--) {
+            if ((haystack[loc] == first) && (haystack[loc + needleLen - 1] == last) && (0 == memcmp(haystack + loc, needle, needleLen))) {
+                *foundLoc = loc;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static Boolean __CFStringFindCharactersLiteral(const UniChar *haystack, const UniChar *needle, CFIndex needleLen, CFIndex fromLoc, CFIndex toLoc, CFIndex *foundLoc) {
+    const UniChar first = needle[0], last = needle[needleLen - 1];
+    CFIndex loc = fromLoc;
+#if defined(__SSE2__)
+    const __m128i firstVec = _mm_set1_epi16((short)first), lastVec = _mm_set1_epi16((short)last);
+#endif
+
+    if (fromLoc <= toLoc) {
+#if defined(__SSE2__)
+        while (toLoc - loc >= 7) {
+            __m128i firstMatch = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)(haystack + loc)), firstVec);
+            __m128i lastMatch = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)(haystack + loc + needleLen - 1)), lastVec);
+            // Each matching position sets two adjacent bits of the mask
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(firstMatch, lastMatch));
+            while (mask) {
+                CFIndex candidate = loc + (__builtin_ctz(mask) >> 1);
+                if (0 == memcmp(haystack + candidate, needle, needleLen * sizeof(UniChar))) {
+                    *foundLoc = candidate;
+                    return true;
+                }
+                mask &= mask - 1;
+                mask &= mask - 1;
+            }
+            loc += 8;
+        }
+#endif
+        for (; loc <= toLoc; loc++) {
+            if ((haystack[loc] == first) && (haystack[loc + needleLen - 1] == last) && (0 == memcmp(haystack + loc, needle, needleLen * sizeof(UniChar)))) {
+                *foundLoc = loc;
+                return true;
+            }
+        }
+    } else {
+#if defined(__SSE2__)
+        while (loc - toLoc >= 7) {
+            CFIndex block = loc - 7;
+            __m128i firstMatch = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)(haystack + block)), firstVec);
+            __m128i lastMatch = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *)(haystack + block + needleLen - 1)), lastVec);
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(firstMatch, lastMatch));
+            while (mask) {
+                int bit = 31 - __builtin_clz(mask);
+                if (0 == memcmp(haystack + block + (bit >> 1), needle, needleLen * sizeof(UniChar))) {
+                    *foundLoc = block + (bit >> 1);
+                    return true;
+                }
+                mask &= ~(3U << (bit - 1));
+            }
+            loc -= 8;
+        }
+#endif
+        for (; loc >= toLoc; loc--) {
+            if ((haystack[loc] == first) && (haystack[loc + needleLen - 1] == last) && (0 == memcmp(haystack + loc, needle, needleLen * sizeof(UniChar)))) {
+                *foundLoc = loc;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 Boolean CFStringFindWithOptionsAndLocale(CFStringRef string, CFStringRef stringToFind, CFRange rangeToSearch, CFStringCompareFlags compareOptions, CFLocaleRef locale, CFRange *result)  {
     /* No objc dispatch needed here since CFStringInlineBuffer works with both CFString and NSString */
     CFIndex findStrLen = CFStringGetLength(stringToFind);
@@ -2938,6 +3468,35 @@ Boolean CFStringFindWithOptionsAndLocale(CFStringRef string, CFStringRef stringT
 	lengthVariants = true;
     }
 
+    if (!lengthVariants && !(compareOptions & kCFCompareWidthInsensitive) && (findStrLen > 0) && (findStrLen <= rangeToSearch.length)) {
+        // Literal search: when both strings expose their contents in the same representation, search them in place
+        CFStringEncoding eightBitEncoding = __CFStringGetEightBitStringEncoding();
+        const uint8_t *str1Bytes = (const uint8_t *)CFStringGetCStringPtr(string, eightBitEncoding);
+        const uint8_t *str2Bytes = (const uint8_t *)CFStringGetCStringPtr(stringToFind, eightBitEncoding);
+        const UniChar *str1Chars = (NULL == str1Bytes) ? CFStringGetCharactersPtr(string) : NULL;
+        const UniChar *str2Chars = (NULL == str2Bytes) ? CFStringGetCharactersPtr(stringToFind) : NULL;
+
+        if (((NULL != str1Bytes) && (NULL != str2Bytes)) || ((NULL != str1Chars) && (NULL != str2Chars))) {
+            CFIndex fromLoc, toLoc, foundLoc;
+
+            if (compareOptions & kCFCompareBackwards) {
+                fromLoc = rangeToSearch.location + rangeToSearch.length - findStrLen;
+                toLoc = ((compareOptions & kCFCompareAnchored) ? fromLoc : rangeToSearch.location);
+            } else {
+                fromLoc = rangeToSearch.location;
+                toLoc = ((compareOptions & kCFCompareAnchored) ? fromLoc : rangeToSearch.location + rangeToSearch.length - findStrLen);
+            }
+
+            if (NULL != str1Bytes) {
+                didFind = __CFStringFindBytesLiteral(str1Bytes, str2Bytes, findStrLen, fromLoc, toLoc, &foundLoc);
+            } else {
+                didFind = __CFStringFindCharactersLiteral(str1Chars, str2Chars, findStrLen, fromLoc, toLoc, &foundLoc);
+            }
+            if (didFind && result) *result = CFRangeMake(foundLoc, findStrLen);
+            return didFind;
+        }
+    }
+
     if ((findStrLen > 0) && (rangeToSearch.length > 0) && ((findStrLen <= rangeToSearch.length) || lengthVariants)) {
         UTF32Char strBuf1[kCFStringStackBufferLength];
         UTF32Char strBuf2[kCFStringStackBufferLength];
@@ -4526,7 +5085,8 @@ CFStringRef CFStringCreateByCombiningStrings(CFAllocatorRef alloc, CFArrayRef ar
     CFIndex numChars;
     CFIndex separatorNumByte;
     CFIndex stringCount = CFArrayGetCount(array);
-    Boolean isSepCFString = !CF_IS_OBJC(_kCFRuntimeIDCFString, separatorString) && !CF_IS_SWIFT(_kCFRuntimeIDCFString, separatorString);
+    // Store-backed strings are read like NSStrings, through CFStringGetCharacters()
+    Boolean isSepCFString = !CF_IS_OBJC(_kCFRuntimeIDCFString, separatorString) && !CF_IS_SWIFT(_kCFRuntimeIDCFString, separatorString) && !__CFStrHasStore(separatorString);
     Boolean canBeEightbit = isSepCFString && __CFStrIsEightBit(separatorString);
     CFIndex idx;
     CFStringRef otherString;
@@ -4547,7 +5107,7 @@ CFStringRef CFStringCreateByCombiningStrings(CFAllocatorRef alloc, CFArrayRef ar
         otherString = (CFStringRef)CFArrayGetValueAtIndex(array, idx);
         numChars += CFStringGetLength(otherString);
 	// canBeEightbit is already false if the separator is an NSString...
-        if (CF_IS_OBJC(_kCFRuntimeIDCFString, otherString) || CF_IS_SWIFT(_kCFRuntimeIDCFString, otherString) || ! __CFStrIsEightBit(otherString)) canBeEightbit = false;
+        if (CF_IS_OBJC(_kCFRuntimeIDCFString, otherString) || CF_IS_SWIFT(_kCFRuntimeIDCFString, otherString) || __CFStrHasStore(otherString) || ! __CFStrIsEightBit(otherString)) canBeEightbit = false;
     }
 
     buffer = (uint8_t *)CFAllocatorAllocate(alloc, canBeEightbit ? ((numChars + 1) * sizeof(uint8_t)) : (numChars * sizeof(UniChar)), 0);
@@ -4573,7 +5133,7 @@ CFStringRef CFStringCreateByCombiningStrings(CFAllocatorRef alloc, CFArrayRef ar
         }
 
         otherString = (CFStringRef )CFArrayGetValueAtIndex(array, idx);
-        if (CF_IS_OBJC(_kCFRuntimeIDCFString, otherString) || CF_IS_SWIFT(_kCFRuntimeIDCFString, otherString)) {
+        if (CF_IS_OBJC(_kCFRuntimeIDCFString, otherString) || CF_IS_SWIFT(_kCFRuntimeIDCFString, otherString) || __CFStrHasStore(otherString)) {
             CFIndex otherLength = CFStringGetLength(otherString);
             CFStringGetCharacters(otherString, CFRangeMake(0, otherLength), (UniChar *)bufPtr);
             bufPtr += otherLength * sizeof(UniChar);
@@ -4646,6 +5206,12 @@ CFDataRef CFStringCreateExternalRepresentation(CFAllocatorRef alloc, CFStringRef
 	length = CFStringGetLength(string);
     } else {
         __CFAssertIsString(string);
+        if (__CFStrHasStore(string)) {
+            CFStringRef copy = __CFStrCreateCopyFromStore(kCFAllocatorSystemDefault, string, CFRangeMake(0, __CFStrLength(string)));
+            CFDataRef result = CFStringCreateExternalRepresentation(alloc, copy, encoding, lossByte);
+            CFRelease(copy);
+            return result;
+        }
         length = __CFStrLength(string);
         if (__CFStrIsEightBit(string) && ((__CFStringGetEightBitStringEncoding() == encoding) || (__CFStringGetEightBitStringEncoding() == kCFStringEncodingASCII && __CFStringEncodingIsSupersetOfASCII(encoding)))) {	// Requested encoding is equal to the encoding in string
             return CFDataCreate(alloc, ((uint8_t *)__CFStrContents(string) + __CFStrSkipAnyLengthByte(string)), __CFStrLength(string));
@@ -4765,7 +5331,11 @@ void CFStringDelete(CFMutableStringRef str, CFRange range) {
     CF_OBJC_FUNCDISPATCHV(_kCFRuntimeIDCFString, void, (NSMutableString *)str, deleteCharactersInRange:NSMakeRange(range.location, range.length));
     __CFAssertIsStringAndMutable(str);
     __CFAssertRangeIsInStringBounds(str, range.location, range.length);
-    __CFStringChangeSize(str, range, 0, false);
+    if (__CFStrShouldUseStore(str, range, false)) {
+        __CFStrStoreReplace(str, range, NULL, NULL, 0);
+    } else {
+        __CFStringChangeSize(str, range, 0, false);
+    }
 }
 
 
@@ -4804,6 +5374,14 @@ void CFStringAppendCharacters(CFMutableStringRef str, const UniChar *chars, CFIn
     __CFAssertIsStringAndMutable(str);
 
     strLength = __CFStrLength(str);
+    if (__CFStrHasStore(str)) {
+	bool canStore = true;
+	if (!__CFStrIsUnicode(str)) for (idx = 0; canStore && idx < appendedLength; idx++) canStore = (chars[idx] < 0x80);
+	if (canStore) {
+	    __CFStrStoreReplace(str, CFRangeMake(strLength, 0), NULL, chars, appendedLength);
+	    return;
+	}
+    }
     if (__CFStrIsUnicode(str)) {
 	__CFStringChangeSize(str, CFRangeMake(strLength, 0), appendedLength, true);
 	memmove((UniChar *)__CFStrContents(str) + strLength, chars, appendedLength * sizeof(UniChar));
@@ -4873,6 +5451,14 @@ void __CFStringAppendBytes(CFMutableStringRef str, const char *cStr, CFIndex app
         } else {
             CF_SWIFT_FUNCDISPATCHV(_kCFRuntimeIDCFString, void, (CFSwiftRef)str, NSMutableString.appendCharacters, (const UniChar *)cStr, appendedLength);
         }
+    } else if (__CFStrHasStore(str) && (__CFStrIsUnicode(str) || !appendedIsUnicode)) {
+        // Append to the store, rather than moving the whole string back into a buffer first
+        __CFAssertIsStringAndMutable(str);
+        if (appendedIsUnicode || demoteAppendedUnicode) {
+            __CFStrStoreReplace(str, CFRangeMake(__CFStrLength(str), 0), NULL, (const UniChar *)cStr, appendedLength);
+        } else {
+            __CFStrStoreAppendBytes(str, (const uint8_t *)cStr, appendedLength);
+        }
     } else {
         CFIndex strLength;
         __CFAssertIsStringAndMutable(str);
@@ -5011,6 +5597,7 @@ void CFStringPad(CFMutableStringRef string, CFStringRef padString, CFIndex lengt
     CF_OBJC_FUNCDISPATCHV(_kCFRuntimeIDCFString, void, (NSMutableString *)string, _cfPad:padString length:(uint32_t)length padIndex:(uint32_t)indexIntoPad);
 
     __CFAssertIsStringAndMutable(string);
+    __CFStrEnsureContiguous(string);
 
     originalLength = __CFStrLength(string);
     if (length < originalLength) {
@@ -5062,6 +5649,7 @@ void CFStringTrim(CFMutableStringRef string, CFStringRef trimString) {
     CF_OBJC_FUNCDISPATCHV(_kCFRuntimeIDCFString, void, (NSMutableString *)string, _cfTrim:trimString);
 
     __CFAssertIsStringAndMutable(string);
+    __CFStrEnsureContiguous(string);
     __CFAssertIsString(trimString);
 
     newStartIndex = 0;
@@ -5096,6 +5684,7 @@ void CFStringTrimWhitespace(CFMutableStringRef string) {
     CF_OBJC_FUNCDISPATCHV(_kCFRuntimeIDCFString, void, (NSMutableString *)string, _cfTrimWS);
 
     __CFAssertIsStringAndMutable(string);
+    __CFStrEnsureContiguous(string);
 
     newStartIndex = 0;
     length = __CFStrLength(string);
@@ -5132,6 +5721,7 @@ void CFStringLowercase(CFMutableStringRef string, CFLocaleRef locale) {
     CF_OBJC_FUNCDISPATCHV(_kCFRuntimeIDCFString, void, (NSMutableString *)string, _cfLowercase:(const void *)locale);
 
     __CFAssertIsStringAndMutable(string);
+    __CFStrEnsureContiguous(string);
 
     length = __CFStrLength(string);
 
@@ -5223,6 +5813,7 @@ void CFStringUppercase(CFMutableStringRef string, CFLocaleRef locale) {
     CF_OBJC_FUNCDISPATCHV(_kCFRuntimeIDCFString, void, (NSMutableString *)string, _cfUppercase:(const void *)locale);
 
     __CFAssertIsStringAndMutable(string);
+    __CFStrEnsureContiguous(string);
 
     length = __CFStrLength(string);
 
@@ -5317,6 +5908,7 @@ void CFStringCapitalize(CFMutableStringRef string, CFLocaleRef locale) {
     CF_OBJC_FUNCDISPATCHV(_kCFRuntimeIDCFString, void, (NSMutableString *)string, _cfCapitalize:(const void *)locale);
 
     __CFAssertIsStringAndMutable(string);
+    __CFStrEnsureContiguous(string);
 
     length = __CFStrLength(string);
 
@@ -5456,6 +6048,7 @@ void CFStringNormalize(CFMutableStringRef string, CFStringNormalizationForm theF
     CF_OBJC_FUNCDISPATCHV(_kCFRuntimeIDCFString, void, (NSMutableString *)string, _cfNormalize:theForm);
 
     __CFAssertIsStringAndMutable(string);
+    __CFStrEnsureContiguous(string);
 
     length = __CFStrLength(string);
 
@@ -5773,6 +6366,8 @@ void CFStringFold(CFMutableStringRef theString, CFStringCompareFlags theFlags, C
     
     if ((0 == theFlags) || (0 == length)) goto bail; // nothing to do
 
+    if (!isObjcOrSwift) __CFStrEnsureContiguous(theString);
+
     langCode = ((NULL == theLocale) ? NULL : (const uint8_t *)_CFStrGetLanguageIdentifierForLocale(theLocale, true));
 
     eightBitEncoding = __CFStringGetEightBitStringEncoding();
@@ -6644,7 +7239,7 @@ static void __CFStringSetUpFormatAndSpecBuffers(CFStringRef formatString, CFInde
     SInt32 formatIdx, sizeSpecs = 0;
     CFAllocatorRef tmpAlloc = __CFGetDefaultAllocator();
 
-    if (!CF_IS_OBJC(_kCFRuntimeIDCFString, formatString) && !CF_IS_SWIFT(CFStringGetTypeID(), formatString)) {
+    if (!CF_IS_OBJC(_kCFRuntimeIDCFString, formatString) && !CF_IS_SWIFT(CFStringGetTypeID(), formatString) && !__CFStrHasStore(formatString)) {
         __CFAssertIsString(formatString);
         if (!__CFStrIsUnicode(formatString)) {
             *cformat = (const uint8_t *)__CFStrContents(formatString);
@@ -6867,7 +7462,7 @@ static Boolean __CFStringAppendFormatCore(CFMutableStringRef outputString, CFStr
         goto cleanup;
     }
     
-    if (!CF_IS_OBJC(_kCFRuntimeIDCFString, formatString) && !CF_IS_SWIFT(CFStringGetTypeID(), formatString)) {
+    if (!CF_IS_OBJC(_kCFRuntimeIDCFString, formatString) && !CF_IS_SWIFT(CFStringGetTypeID(), formatString) && !__CFStrHasStore(formatString)) {
         __CFAssertIsString(formatString);
         if (!__CFStrIsUnicode(formatString)) {
             cformat = (const uint8_t *)__CFStrContents(formatString);
@@ -7506,7 +8101,7 @@ void CFShowStr(CFStringRef str) {
     if (__CFStrIsMutable(str)) {
         fprintf(stdout, "CurrentCapacity %d\n%sCapacity %d\n", (int)__CFStrCapacity(str), __CFStrIsFixed(str) ? "Fixed" : "Desired", (int)__CFStrDesiredCapacity(str));
     }
-    fprintf(stdout, "Contents %p\n", (void *)__CFStrContents(str));
+    fprintf(stdout, "Contents %p\n", __CFStrHasStore(str) ? (void *)__CFStrStore(str) : (void *)__CFStrContents(str));
 }
 
 
@@ -285,14 +285,8 @@ Boolean __CFStringDecodeByteStream3(const uint8_t *bytes, CFIndex len, CFStringE
             len -= 3;
             if (0 == len) return true;
         }
-        if (buffer->isASCII) {
-            for (idx = 0; idx < len; idx++) {
-                if (128 <= chars[idx]) {
-                    buffer->isASCII = false;
-                    break;
-                }
-            }
-        }
+        CFIndex asciiLength = __CFASCIIPrefixLength(chars, len);
+        if (asciiLength < len) buffer->isASCII = false;
         if (buffer->isASCII) {
             buffer->numChars = len;
             buffer->shouldFreeChars = !buffer->chars.ascii && (len <= MAX_LOCAL_CHARS) ? false : true;
@@ -311,7 +305,9 @@ Boolean __CFStringDecodeByteStream3(const uint8_t *bytes, CFIndex len, CFStringE
             buffer->shouldFreeChars = !buffer->chars.unicode && (len <= MAX_LOCAL_UNICHARS) ? false : true;
             buffer->chars.unicode = (buffer->chars.unicode ? buffer->chars.unicode : (len <= MAX_LOCAL_UNICHARS) ? (UniChar *)buffer->localBuffer : (UniChar *)CFAllocatorAllocate(buffer->allocator, len * sizeof(UniChar), 0));
 	    if (!buffer->chars.unicode) goto memoryErrorExit;
-            buffer->numChars = 0;
+            // The ASCII prefix has been scanned already; don't run it through the converter again
+            buffer->numChars = __CFWidenASCII(chars, asciiLength, buffer->chars.unicode);
+            chars += asciiLength;
             while (chars < end) {
                 numDone = 0;
                 chars += __CFFromUTF8(converterFlags, chars, end - chars, &(buffer->chars.unicode[buffer->numChars]), len - buffer->numChars, &numDone);
@@ -638,10 +634,9 @@ CFIndex __CFStringEncodeByteStream(CFStringRef string, CFIndex rangeLoc, CFIndex
                 }
 		
                 CFIndex uninterestingTailLen = buffer ? (rangeLen - MIN(max, rangeLen)) : 0;
-                while (*ptr < 0x80 && rangeLen > uninterestingTailLen) {
-                    ++ptr;
-                    --rangeLen;
-                }
+                CFIndex asciiLength = __CFASCIIPrefixLength(ptr, rangeLen - uninterestingTailLen);
+                ptr += asciiLength;
+                rangeLen -= asciiLength;
                 numCharsProcessed = ptr - cString;
                 if (buffer) {
                     numCharsProcessed = (numCharsProcessed < max ? numCharsProcessed : max);
@@ -664,10 +659,9 @@ CFIndex __CFStringEncodeByteStream(CFStringRef string, CFIndex rangeLoc, CFIndex
                     if (usedBufLen) *usedBufLen = numCharsProcessed;
                     return numCharsProcessed;
                 }
-                while (*ptr < 0x80 && rangeLen > 0) {
-                    ++ptr;
-                    --rangeLen;
-                }
+                CFIndex asciiLength = __CFASCIIPrefixLength(ptr, rangeLen);
+                ptr += asciiLength;
+                rangeLen -= asciiLength;
                 numCharsProcessed = ptr - cString;
                 if (buffer) {
                     numCharsProcessed = (numCharsProcessed < max ? numCharsProcessed : max);
@@ -15,6 +15,9 @@
 #include "CFUnicodePrecomposition.h"
 #include "CFStringEncodingConverterPriv.h"
 #include "CFInternal.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #define ASCIINewLine 0x0a
 
@@ -916,6 +919,67 @@ static const UTF32Char offsetsFromUTF8[6] = { 0x00000000UL, 0x00003080UL, 0x000E
 
 static const uint8_t firstByteMark[7] = { 0x00, 0x00, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC };
 
+/* ASCII runs
+ * Most text converted through here is largely ASCII, which needs no
+ * validation and maps one-to-one onto UTF-16. These move whole runs of it at
+ * a time, 16 code units per step with SSE2 or a word at a time otherwise.
+ */
+CF_PRIVATE CFIndex __CFASCIIPrefixLength(const uint8_t *bytes, CFIndex numBytes) {
+    const uint8_t *source = bytes;
+    const uint8_t *end = bytes + numBytes;
+#if defined(__SSE2__)
+    while (end - source >= 16) {
+        int nonASCII = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)source));
+        if (nonASCII) return (source - bytes) + __builtin_ctz(nonASCII);
+        source += 16;
+    }
+#else
+    const uintptr_t highBits = (UINTPTR_MAX / 0xFF) * 0x80;
+    while (end - source >= (CFIndex)sizeof(uintptr_t)) {
+        uintptr_t word;
+        memcpy(&word, source, sizeof(word));
+        if (word & highBits) break;
+        source += sizeof(uintptr_t);
+    }
+#endif
+    while ((source < end) && (*source < 0x80)) ++source;
+    return source - bytes;
+}
+
+CF_PRIVATE CFIndex __CFWidenASCII(const uint8_t *bytes, CFIndex numBytes, UniChar *characters) {
+    CFIndex idx = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; numBytes - idx >= 16; idx += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)(bytes + idx));
+        if (_mm_movemask_epi8(chunk)) break;
+        _mm_storeu_si128((__m128i *)(characters + idx), _mm_unpacklo_epi8(chunk, zero));
+        _mm_storeu_si128((__m128i *)(characters + idx + 8), _mm_unpackhi_epi8(chunk, zero));
+    }
+#endif
+    for (; (idx < numBytes) && (bytes[idx] < 0x80); idx++) characters[idx] = bytes[idx];
+    return idx;
+}
+
+CF_PRIVATE CFIndex __CFNarrowASCII(const UniChar *characters, CFIndex numChars, uint8_t *bytes) {
+    CFIndex idx = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i nonASCIIBits = _mm_set1_epi16((short)0xFF80);
+    for (; numChars - idx >= 16; idx += 16) {
+        __m128i low = _mm_loadu_si128((const __m128i *)(characters + idx));
+        __m128i high = _mm_loadu_si128((const __m128i *)(characters + idx + 8));
+        __m128i nonASCII = _mm_and_si128(_mm_or_si128(low, high), nonASCIIBits);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(nonASCII, zero)) != 0xFFFF) break;
+        if (bytes) _mm_storeu_si128((__m128i *)(bytes + idx), _mm_packus_epi16(low, high));
+    }
+#endif
+    for (; (idx < numChars) && (characters[idx] < 0x80); idx++) {
+        if (bytes) bytes[idx] = (uint8_t)characters[idx];
+    }
+    return idx;
+}
+
 /* This code is similar in effect to making successive calls on the mbtowc and wctomb routines in FSS-UTF. However, it is considerably different in code:
         * it is adapted to be consistent with UTF16,
         * constants have been gathered.
@@ -966,32 +1030,36 @@ static CFIndex __CFToUTF8(uint32_t flags, const UniChar *characters, CFIndex num
     bool isStrict = (flags & kCFStringEncodingUseHFSPlusCanonical ? false : true);
 
     while ((characters < endCharacter) && (!maxByteLen || (bytes < endBytes))) {
+        if (*characters < 0x80) { // ASCII
+            CFIndex runLength = endCharacter - characters;
+            if (maxByteLen && (endBytes - bytes < runLength)) runLength = endBytes - bytes;
+            runLength = __CFNarrowASCII(characters, runLength, (maxByteLen ? bytes : NULL));
+            characters += runLength;
+            bytes += runLength;
+            continue;
+        }
+
         ch = *(characters++);
 
-        if (ch < 0x80) { // ASCII
-            if (maxByteLen) *bytes = ch;
-            ++bytes;
-        } else {
-            if (ch >= kSurrogateHighStart) {
-                if (ch <= kSurrogateHighEnd) {
-                    if ((characters < endCharacter) && ((*characters >= kSurrogateLowStart) && (*characters <= kSurrogateLowEnd))) {
-                        ch = ((ch - kSurrogateHighStart) << halfShift) + (*(characters++) - kSurrogateLowStart) + halfBase;
-                    } else if (isStrict) {
-                        --characters;
-                        break;
-                    }
-                } else if (isStrict && (ch <= kSurrogateLowEnd)) {
+        if (ch >= kSurrogateHighStart) {
+            if (ch <= kSurrogateHighEnd) {
+                if ((characters < endCharacter) && ((*characters >= kSurrogateLowStart) && (*characters <= kSurrogateLowEnd))) {
+                    ch = ((ch - kSurrogateHighStart) << halfShift) + (*(characters++) - kSurrogateLowStart) + halfBase;
+                } else if (isStrict) {
                     --characters;
                     break;
                 }
-            }
-    
-            if (!(bytesWritten = (maxByteLen ? __CFToUTF8Core(ch, bytes, endBytes - bytes) : __CFUTF8BytesToWriteForCharacter(ch)))) {
-                characters -= (ch < 0x10000 ? 1 : 2);
+            } else if (isStrict && (ch <= kSurrogateLowEnd)) {
+                --characters;
                 break;
             }
-            bytes += bytesWritten;
         }
+    
+        if (!(bytesWritten = (maxByteLen ? __CFToUTF8Core(ch, bytes, endBytes - bytes) : __CFUTF8BytesToWriteForCharacter(ch)))) {
+            characters -= (ch < 0x10000 ? 1 : 2);
+            break;
+        }
+        bytes += bytesWritten;
     }
 
     if (usedByteLen) *usedByteLen = bytes - beginBytes;
@@ -1036,6 +1104,17 @@ static CFIndex __CFFromUTF8(uint32_t flags, const uint8_t *bytes, CFIndex numByt
     bool isStrict = !isHFSPlus;
 
     while (numBytes && (!maxCharLen || (theUsedCharLen < maxCharLen))) {
+        if (*source < 0x80) { // ASCII is always legal and never decomposes
+            CFIndex runLength = numBytes;
+            if (maxCharLen && (maxCharLen - theUsedCharLen < runLength)) runLength = maxCharLen - theUsedCharLen;
+            runLength = (maxCharLen ? __CFWidenASCII(source, runLength, characters) : __CFASCIIPrefixLength(source, runLength));
+            if (maxCharLen) characters += runLength;
+            source += runLength;
+            numBytes -= runLength;
+            theUsedCharLen += runLength;
+            continue;
+        }
+
         extraBytesToRead = trailingBytesForUTF8[*source];
 
         if (extraBytesToRead > --numBytes) break;
@@ -1123,6 +1202,13 @@ static CFIndex __CFToUTF8Len(uint32_t flags, const UniChar *characters, CFIndex
     uint32_t ch;
 
     while (numChars) {
+        if (*characters < 0x80) {
+            CFIndex runLength = __CFNarrowASCII(characters, numChars, NULL);
+            characters += runLength;
+            numChars -= runLength;
+            bytesToWrite += runLength;
+            continue;
+        }
         ch = *characters++;
         numChars--;
         if ((ch >= kSurrogateHighStart && ch <= kSurrogateHighEnd) && numChars && (*characters >= kSurrogateLowStart && *characters <= kSurrogateLowEnd)) {
@@ -1147,6 +1233,14 @@ static CFIndex __CFFromUTF8Len(uint32_t flags, const uint8_t *source, CFIndex nu
     bool isStrict = !isHFSPlus;
 
     while (numBytes) {
+        if (*source < 0x80) {
+            CFIndex runLength = __CFASCIIPrefixLength(source, numBytes);
+            source += runLength;
+            numBytes -= runLength;
+            theUsedCharLen += runLength;
+            continue;
+        }
+
         extraBytesToRead = trailingBytesForUTF8[*source];
 
         if (extraBytesToRead > --numBytes) break;
@@ -32,6 +32,12 @@ CF_PRIVATE  CFIndex __CFStringEncodingPlatformByteLengthForCharacters(uint32_t e
 CF_PRIVATE CFIndex CFStringEncodingCharLengthForBytes(uint32_t encoding, uint32_t flags, const uint8_t *bytes, CFIndex numBytes);
 CF_PRIVATE CFIndex CFStringEncodingByteLengthForCharacters(uint32_t encoding, uint32_t flags, const UniChar *characters, CFIndex numChars);
 
+/* Bulk handling of leading ASCII. __CFASCIIPrefixLength() returns the number of leading bytes below 0x80; __CFWidenASCII() and __CFNarrowASCII() copy that prefix to/from UTF-16 and return its length. bytes may be NULL for __CFNarrowASCII() to only measure.
+ */
+CF_PRIVATE CFIndex __CFASCIIPrefixLength(const uint8_t *bytes, CFIndex numBytes);
+CF_PRIVATE CFIndex __CFWidenASCII(const uint8_t *bytes, CFIndex numBytes, UniChar *characters);
+CF_PRIVATE CFIndex __CFNarrowASCII(const UniChar *characters, CFIndex numChars, uint8_t *bytes);
+
 CF_PRIVATE bool CFStringEncodingIsValidEncoding(uint32_t encoding);
 
 /* Returns kCFStringEncodingInvalidId terminated encoding list
@@ -20,6 +20,7 @@
 
 #include "CFURLSessionInterface.h"
 #include <CoreFoundation/CFString.h>
+#include <CoreFoundation/CFLocking.h>
 #include <curl/curl.h>
 
 FILE* aa = NULL;
@@ -47,6 +48,50 @@ CFURLSessionEasyCode CFURLSessionEasyHandleSetPauseState(CFURLSessionEasyHandle
     return MakeEasyCode(curl_easy_pause(handle, bitmask));
 }
 
+// Every session has its own multi handle, so connections are not reused
+// across sessions. Name resolutions and TLS sessions can be, which saves the
+// DNS round trip and the full handshake when another session connects to a
+// host that has been seen before. The connection cache itself is not shared:
+// libcurl does not support using a shared connection cache from several
+// threads at once, and each session drives its transfers on its own queue.
+static CURLSH *_sharedCachesHandle = NULL;
+static CFLock_t _sharedCachesInitLock = CFLockInit;
+static CFLock_t _sharedCachesLocks[CURL_LOCK_DATA_LAST];
+
+static void _sharedCachesLock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr) {
+    __CFLock(&_sharedCachesLocks[data]);
+}
+static void _sharedCachesUnlock(CURL *handle, curl_lock_data data, void *userptr) {
+    __CFUnlock(&_sharedCachesLocks[data]);
+}
+
+static CURLSH *_sharedCachesGet(void) {
+    __CFLock(&_sharedCachesInitLock);
+    if (_sharedCachesHandle == NULL) {
+        CURLSH *share = curl_share_init();
+        if (share != NULL) {
+            for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+                CF_LOCK_INIT_FOR_STRUCTS(_sharedCachesLocks[i]);
+            }
+            curl_share_setopt(share, CURLSHOPT_LOCKFUNC, _sharedCachesLock);
+            curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, _sharedCachesUnlock);
+            curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+            curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+            _sharedCachesHandle = share;
+        }
+    }
+    __CFUnlock(&_sharedCachesInitLock);
+    return _sharedCachesHandle;
+}
+
+CFURLSessionEasyCode CFURLSessionEasyHandleSetSharedCaches(CFURLSessionEasyHandle _Nonnull handle) {
+    CURLSH *share = _sharedCachesGet();
+    if (share == NULL) {
+        return MakeEasyCode(CURLE_OUT_OF_MEMORY);
+    }
+    return MakeEasyCode(curl_easy_setopt(handle, CURLOPT_SHARE, share));
+}
+
 CFURLSessionMultiHandle _Nonnull CFURLSessionMultiHandleInit() {
     return curl_multi_init();
 }
@@ -490,7 +535,12 @@ CFURLSessionOption const CFURLSessionOptionSSL_FALSESTART = { CURLOPT_SSL_FALSES
 CFURLSessionOption const CFURLSessionOptionPATH_AS_IS = { CURLOPT_PATH_AS_IS };
 CFURLSessionOption const CFURLSessionOptionPROXY_SERVICE_NAME = { CURLOPT_PROXY_SERVICE_NAME };
 CFURLSessionOption const CFURLSessionOptionSERVICE_NAME = { CURLOPT_SERVICE_NAME };
-CFURLSessionOption const CFURLSessionOptionPIPEWAIT = { CURLOPT_PIPEWAIT };*/
+*/
+#if LIBCURL_VERSION_NUM >= 0x072b00
+CFURLSessionOption const CFURLSessionOptionPIPEWAIT = { CURLOPT_PIPEWAIT };
+#else
+CFURLSessionOption const CFURLSessionOptionPIPEWAIT = { CURLOPT_LASTENTRY };
+#endif
 
 
 CFURLSessionInfo const CFURLSessionInfoTEXT = { CURLINFO_TEXT };
@@ -595,12 +645,21 @@ CFURLSessionCurlVersion CFURLSessionCurlVersionInfo(void) {
 }
 
 
+#if LIBCURL_VERSION_NUM >= 0x072f00
+long const CFURLSessionHTTPVersion2TLS = CURL_HTTP_VERSION_2TLS;
+#else
+long const CFURLSessionHTTPVersion2TLS = CURL_HTTP_VERSION_NONE;
+#endif
+
+
 int const CFURLSessionWriteFuncPause = CURL_WRITEFUNC_PAUSE;
 int const CFURLSessionReadFuncPause = CURL_READFUNC_PAUSE;
 int const CFURLSessionReadFuncAbort = CURL_READFUNC_ABORT;
 
 
 CFURLSession_socket_t const CFURLSessionSocketTimeout = CURL_SOCKET_TIMEOUT;
+int const CFURLSessionCSelectIn = CURL_CSELECT_IN;
+int const CFURLSessionCSelectOut = CURL_CSELECT_OUT;
 
 int const CFURLSessionSeekOk = CURL_SEEKFUNC_OK;
 int const CFURLSessionSeekCantSeek = CURL_SEEKFUNC_CANTSEEK;
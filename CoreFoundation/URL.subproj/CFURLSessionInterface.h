@@ -390,7 +390,9 @@ CF_EXPORT CFURLSessionOption const CFURLSessionOptionLOGIN_OPTIONS; // CURLOPT_L
 //CF_EXPORT CFURLSessionOption const CFURLSessionOptionPATH_AS_IS; // CURLOPT_PATH_AS_IS
 //CF_EXPORT CFURLSessionOption const CFURLSessionOptionPROXY_SERVICE_NAME; // CURLOPT_PROXY_SERVICE_NAME
 //CF_EXPORT CFURLSessionOption const CFURLSessionOptionSERVICE_NAME; // CURLOPT_SERVICE_NAME
-//CF_EXPORT CFURLSessionOption const CFURLSessionOptionPIPEWAIT; // CURLOPT_PIPEWAIT
+
+/// On a libcurl older than 7.43.0 this is CURLOPT_LASTENTRY, and setting it has no effect.
+CF_EXPORT CFURLSessionOption const CFURLSessionOptionPIPEWAIT; // CURLOPT_PIPEWAIT
 
 
 /// This is a mash-up of these two types:
@@ -539,6 +541,9 @@ CF_EXPORT CFURLSessionProtocol const CFURLSessionProtocolALL; // CURLPROTO_ALL
 
 CF_EXPORT size_t const CFURLSessionMaxWriteSize; // CURL_MAX_WRITE_SIZE
 
+/// CURL_HTTP_VERSION_2TLS, or CURL_HTTP_VERSION_NONE (the libcurl default) on libcurl older than 7.47.0.
+CF_EXPORT long const CFURLSessionHTTPVersion2TLS;
+
 CF_EXPORT char * _Nonnull CFURLSessionCurlVersionString(void);
 typedef struct CFURLSessionCurlVersion {
     int major;
@@ -553,6 +558,8 @@ CF_EXPORT int const CFURLSessionReadFuncPause;
 CF_EXPORT int const CFURLSessionReadFuncAbort;
 
 CF_EXPORT CFURLSession_socket_t const CFURLSessionSocketTimeout;
+CF_EXPORT int const CFURLSessionCSelectIn; // CURL_CSELECT_IN
+CF_EXPORT int const CFURLSessionCSelectOut; // CURL_CSELECT_OUT
 
 CF_EXPORT int const CFURLSessionSeekOk;
 CF_EXPORT int const CFURLSessionSeekCantSeek;
@@ -561,6 +568,8 @@ CF_EXPORT int const CFURLSessionSeekFail;
 CF_EXPORT CFURLSessionEasyHandle _Nonnull CFURLSessionEasyHandleInit(void);
 CF_EXPORT void CFURLSessionEasyHandleDeinit(CFURLSessionEasyHandle _Nonnull handle);
 CF_EXPORT CFURLSessionEasyCode CFURLSessionEasyHandleSetPauseState(CFURLSessionEasyHandle _Nonnull handle, int send, int receive);
+/// Makes the handle use the DNS and TLS session caches shared by every handle in the process.
+CF_EXPORT CFURLSessionEasyCode CFURLSessionEasyHandleSetSharedCaches(CFURLSessionEasyHandle _Nonnull handle);
 
 CF_EXPORT CFURLSessionMultiHandle _Nonnull CFURLSessionMultiHandleInit(void);
 CF_EXPORT CFURLSessionMultiCode CFURLSessionMultiHandleDeinit(CFURLSessionMultiHandle _Nonnull handle);
@@ -49,7 +49,8 @@ open class HTTPCookieStorage: NSObject {
     /* only modified in init */
     private var cookieFilePath: String?
 
-    /* synchronized on syncQ, please don't use _allCookies directly outside of init/deinit */
+    /* synchronized on syncQ, please don't use _allCookies directly outside of init/deinit.
+       syncQ is concurrent: readers use sync, anything that mutates uses sync(flags: .barrier) */
     private var _allCookies: [String: HTTPCookie]
     private var allCookies: [String: HTTPCookie] {
         get {
@@ -65,11 +66,30 @@ open class HTTPCookieStorage: NSObject {
             self._allCookies = newValue
         }
     }
-    private let syncQ = DispatchQueue(label: "org.swift.HTTPCookieStorage.syncQ")
+    private let syncQ = DispatchQueue(label: "org.swift.HTTPCookieStorage.syncQ", attributes: .concurrent)
+
+    /* synchronized on syncQ. The cookies of allCookies, grouped by their domain without the leading
+       dot, so that cookies(for:) only has to look at the domains a host can match */
+    private var cookiesByDomain: [String: [String: HTTPCookie]] = [:]
+
+    /* synchronized on syncQ. No cookie expires before this date, so there is nothing to sweep until then */
+    private var nextExpiryDate: Date?
+
+    /* synchronized on syncQ. The persistent store is a property list snapshot of the cookies, followed by
+       a journal of the changes made since. Changes are appended to the journal; the snapshot is only
+       rewritten once the journal has grown larger than it. Other storages, in this process or another, may
+       share the store, so each remembers which journal it has read and how far. The journal starts with a
+       random identifier that is replaced whenever the snapshot is rewritten */
+    private var hasSnapshot = false
+    private var snapshotSize = 0
+    private var journalID: Data?
+    private var journalSize = 0
+    private static let minimumJournalSizeForCompaction = 64 * 1024
+    private static let journalIDLength = 16
 
     private let isEphemeral: Bool
 
-    private init(cookieStorageName: String, isEphemeral: Bool = false) {
+    internal init(cookieStorageName: String, isEphemeral: Bool = false) {
         _allCookies = [:]
         cookieAcceptPolicy = .always
         self.isEphemeral = isEphemeral
@@ -87,16 +107,121 @@ open class HTTPCookieStorage: NSObject {
     }
 
     private func loadPersistedCookies() {
-        guard let cookieFilePath = self.cookieFilePath, let cookiesData = try? Data(contentsOf: URL(fileURLWithPath: cookieFilePath)) else { return }
-        guard let cookies = try? PropertyListSerialization.propertyList(from: cookiesData, format: nil) else { return }
-        let cookies0 = cookies as? [String: [String: Any]] ?? [:]
-        self.syncQ.sync {
-            for (key, value) in cookies0 {
-                if let cookie = createCookie(value) {
-                    allCookies[key] = cookie
+        guard let cookieFilePath = self.cookieFilePath else { return }
+        self.syncQ.sync(flags: .barrier) {
+            let journal = openJournal(for: cookieFilePath, forWriting: false)
+            _ = lockedCatchUp(with: cookieFilePath, journal: journal, excluding: [])
+            try? journal?.close()
+        }
+    }
+
+    private func journalFilePath(for cookieFilePath: String) -> String {
+        return cookieFilePath + ".journal"
+    }
+
+    /*!
+        @method openJournal:forWriting:
+        @abstract Open the journal and lock it against the other storages sharing the persistent store.
+        @discussion A journal opened for writing is locked exclusively, and is created if need be. Writes to
+        it always append, so they can't overwrite what another storage has appended. Closing the handle
+        releases the lock.
+    */
+    private func openJournal(for cookieFilePath: String, forWriting: Bool) -> FileHandle? {
+        let path = journalFilePath(for: cookieFilePath)
+#if os(Windows)
+        if forWriting && !FileManager.default.fileExists(atPath: path) {
+            guard FileManager.default.createFile(atPath: path, contents: nil) else { return nil }
+        }
+        return forWriting ? FileHandle(forUpdatingAtPath: path) : FileHandle(forReadingAtPath: path)
+#else
+        let fd = open(path, forWriting ? O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC : O_RDONLY | O_CLOEXEC, 0o600)
+        guard fd >= 0 else { return nil }
+        flock(fd, forWriting ? LOCK_EX : LOCK_SH)
+        return FileHandle(fileDescriptor: fd, closeOnDealloc: true)
+#endif
+    }
+
+    /*!
+        @method lockedCatchUp:journal:excluding:
+        @abstract Bring the persisted cookies up to date with the persistent store, with the journal locked.
+        @discussion Records appended to the journal since this storage last read it are applied. A journal
+        with a different identifier was started afresh when the snapshot was rewritten, so the persisted
+        cookies are reloaded from the snapshot and the whole of the journal. Cookies under the excluded keys
+        are left alone, as the caller is about to record newer changes to them.
+        @result false if the journal ends in an incomplete record or identifier, and needs compacting.
+    */
+    private func lockedCatchUp(with cookieFilePath: String, journal: FileHandle?, excluding pendingKeys: Set<String>) -> Bool {
+        try? journal?.seek(toOffset: 0)
+        let id = try? journal?.read(upToCount: HTTPCookieStorage.journalIDLength)
+        if id == nil || id != journalID {
+            lockedReloadSnapshot(from: cookieFilePath, excluding: pendingKeys)
+            journalID = id?.count == HTTPCookieStorage.journalIDLength ? id : nil
+            journalSize = journalID?.count ?? 0
+        }
+        guard let journal = journal, journalID != nil else { return id == nil }
+
+        guard (try? journal.seek(toOffset: UInt64(journalSize))) != nil,
+            let records = try? journal.readToEnd() else {
+            return true
+        }
+        let applied = lockedReplayJournal(records, excluding: pendingKeys)
+        journalSize += applied
+        return applied == records.count
+    }
+
+    /*!
+        @method lockedReloadSnapshot:excluding:
+        @abstract Replace the persisted cookies with those in the snapshot.
+        @discussion Cookies that were never persisted, such as session cookies, are kept.
+    */
+    private func lockedReloadSnapshot(from cookieFilePath: String, excluding pendingKeys: Set<String>) {
+        for (key, cookie) in allCookies where mayHaveBeenPersisted(cookie) && !pendingKeys.contains(key) {
+            lockedRemoveCookie(forKey: key)
+        }
+        hasSnapshot = false
+        snapshotSize = 0
+        guard let cookiesData = try? Data(contentsOf: URL(fileURLWithPath: cookieFilePath)),
+            let cookies = try? PropertyListSerialization.propertyList(from: cookiesData, format: nil) else { return }
+        hasSnapshot = true
+        snapshotSize = cookiesData.count
+        for (key, value) in cookies as? [String: [String: Any]] ?? [:] where !pendingKeys.contains(key) {
+            if let cookie = createCookie(value) {
+                lockedInsert(cookie, forKey: key)
+            }
+        }
+    }
+
+    /*!
+        @method lockedReplayJournal:excluding:
+        @abstract Apply journaled changes, and return the length of the records applied.
+        @discussion Each record is a binary property list, preceded by its length as a 32-bit big-endian
+        integer. Replay stops at the first incomplete record, which is what an interrupted append leaves
+        behind; the next storage to write compacts the journal instead of appending after it.
+    */
+    private func lockedReplayJournal(_ data: Data, excluding pendingKeys: Set<String>) -> Int {
+        var offset = 0
+        while data.count - offset >= 4 {
+            let length = data[offset..<offset + 4].reduce(0) { $0 << 8 | Int($1) }
+            let recordStart = offset + 4
+            guard data.count - recordStart >= length,
+                let record = try? PropertyListSerialization.propertyList(from: data.subdata(in: recordStart..<recordStart + length), format: nil) as? [String: Any] else {
+                break
+            }
+            if let set = record["Set"] as? [String: [String: Any]] {
+                for (key, value) in set where !pendingKeys.contains(key) {
+                    if let cookie = createCookie(value) {
+                        lockedInsert(cookie, forKey: key)
+                    }
+                }
+            }
+            if let removed = record["Remove"] as? [String] {
+                for key in removed where !pendingKeys.contains(key) {
+                    lockedRemoveCookie(forKey: key)
                 }
             }
+            offset = recordStart + length
         }
+        return offset
     }
 
     private func directory(with path: String) -> Bool {
@@ -126,7 +251,7 @@ open class HTTPCookieStorage: NSObject {
     }
 
     open var cookies: [HTTPCookie]? {
-        return Array(self.syncQ.sync { self.allCookies.values })
+        return self.syncQ.sync { Array(self.allCookies.values) }
     }
     
     /*!
@@ -170,25 +295,95 @@ open class HTTPCookieStorage: NSObject {
         same name, domain and path, if any.
     */
     open func setCookie(_ cookie: HTTPCookie) {
-        self.syncQ.sync {
-            guard cookieAcceptPolicy != .never else { return }
+        self.syncQ.sync(flags: .barrier) {
+            lockedSetCookies([cookie])
+        }
+    }
+
+    /*!
+        @method lockedSetCookies:
+        @abstract Add or override the specified cookies, for internal callers already on syncQ.
+        @discussion All of the cookies go into the persistent store as a single change.
+    */
+    private func lockedSetCookies(_ cookies: [HTTPCookie]) {
+        guard cookieAcceptPolicy != .never else { return }
 
+        // A key ends up in at most one of these, so the order they are applied in does not matter
+        var persisted: [String: HTTPCookie] = [:]
+        var removedKeys: Set<String> = []
+        for cookie in cookies {
             //add or override
             let key = cookie.domain + cookie.path + cookie.name
-            if let _ = allCookies.index(forKey: key) {
-                allCookies.updateValue(cookie, forKey: key)
-            } else {
-                allCookies[key] = cookie
+            let replaced = lockedInsert(cookie, forKey: key)
+            if isPersistable(cookie) {
+                persisted[key] = cookie
+                removedKeys.remove(key)
+            } else if persisted.removeValue(forKey: key) != nil || replaced.map(mayHaveBeenPersisted) ?? false {
+                removedKeys.insert(key)
             }
+        }
 
-            //remove stale cookies, these may include the one we just added
-            let expired = allCookies.filter { (_, value) in value.expiresDate != nil && value.expiresDate!.timeIntervalSinceNow < 0 }
-            for (key,_) in expired {
-                self.allCookies.removeValue(forKey: key)
+        //remove stale cookies, these may include the ones we just added
+        for (key, cookie) in lockedRemoveExpiredCookies() {
+            if persisted.removeValue(forKey: key) != nil || mayHaveBeenPersisted(cookie) {
+                removedKeys.insert(key)
             }
+        }
+
+        updatePersistentStore(setting: persisted, removing: Array(removedKeys))
+    }
 
-            updatePersistentStore()
+    /*!
+        @method lockedInsert:forKey:
+        @abstract Store the cookie under the given key, returning the one it replaces, if any.
+    */
+    @discardableResult
+    private func lockedInsert(_ cookie: HTTPCookie, forKey key: String) -> HTTPCookie? {
+        let replaced = lockedRemoveCookie(forKey: key)
+        allCookies[key] = cookie
+        cookiesByDomain[HTTPCookieStorage.indexDomain(for: cookie.domain), default: [:]][key] = cookie
+        if let expiresDate = cookie.expiresDate, nextExpiryDate.map({ expiresDate < $0 }) ?? true {
+            nextExpiryDate = expiresDate
+        }
+        return replaced
+    }
+
+    @discardableResult
+    private func lockedRemoveCookie(forKey key: String) -> HTTPCookie? {
+        guard let cookie = allCookies.removeValue(forKey: key) else { return nil }
+        let domain = HTTPCookieStorage.indexDomain(for: cookie.domain)
+        cookiesByDomain[domain]?.removeValue(forKey: key)
+        if cookiesByDomain[domain]?.isEmpty ?? false {
+            cookiesByDomain.removeValue(forKey: domain)
+        }
+        return cookie
+    }
+
+    /*!
+        @method lockedRemoveExpiredCookies
+        @abstract Remove the cookies that have expired and return them.
+        @discussion The whole store is only swept once the earliest expiry date has passed.
+    */
+    private func lockedRemoveExpiredCookies() -> [(String, HTTPCookie)] {
+        guard let nextExpiryDate = self.nextExpiryDate, nextExpiryDate.timeIntervalSinceNow < 0 else { return [] }
+        self.nextExpiryDate = nil
+        var expired: [(String, HTTPCookie)] = []
+        for (key, cookie) in allCookies {
+            guard let expiresDate = cookie.expiresDate else { continue }
+            if expiresDate.timeIntervalSinceNow < 0 {
+                expired.append((key, cookie))
+            } else if self.nextExpiryDate.map({ expiresDate < $0 }) ?? true {
+                self.nextExpiryDate = expiresDate
+            }
         }
+        for (key, _) in expired {
+            lockedRemoveCookie(forKey: key)
+        }
+        return expired
+    }
+
+    private static func indexDomain(for cookieDomain: String) -> String {
+        return cookieDomain.hasPrefix(".") ? String(cookieDomain.dropFirst()) : cookieDomain
     }
     
     open override var description: String {
@@ -208,7 +403,24 @@ open class HTTPCookieStorage: NSObject {
         return HTTPCookie(properties: cookieProperties)
     }
 
-    private func updatePersistentStore() {
+    private func isPersistable(_ cookie: HTTPCookie) -> Bool {
+        guard let expiresDate = cookie.expiresDate else { return false }
+        return cookie.isSessionOnly == false && expiresDate.timeIntervalSinceNow > 0
+    }
+
+    /* A cookie that is no longer persistable may still be in the persistent store */
+    private func mayHaveBeenPersisted(_ cookie: HTTPCookie) -> Bool {
+        return cookie.expiresDate != nil && cookie.isSessionOnly == false
+    }
+
+    /*!
+        @method updatePersistentStore:removing:
+        @abstract Record a change to the cookies in the persistent store.
+        @discussion The change is appended to the journal, after catching up with whatever other storages
+        have appended to it. The snapshot is rewritten instead, and the journal started afresh, if there is
+        no snapshot yet or the journal has outgrown it.
+    */
+    private func updatePersistentStore(setting cookies: [String: HTTPCookie], removing removedKeys: [String]) {
         // No persistence if this is an ephemeral storage
         if self.isEphemeral { return }
 
@@ -218,30 +430,82 @@ open class HTTPCookieStorage: NSObject {
             dispatchPrecondition(condition: DispatchPredicate.onQueue(self.syncQ))
         }
 
-        //persist cookies
-        var persistDictionary: [String : [String : Any]] = [:]
-        let persistable = self.allCookies.filter { (_, value) in
-            value.expiresDate != nil &&
-            value.isSessionOnly == false &&
-            value.expiresDate!.timeIntervalSinceNow > 0
+        guard !hasSnapshot || !cookies.isEmpty || !removedKeys.isEmpty else { return }
+
+        let journal = openJournal(for: cookieFilePath, forWriting: true)
+        defer { try? journal?.close() }
+        let pendingKeys = Set(cookies.keys).union(removedKeys)
+        guard lockedCatchUp(with: cookieFilePath, journal: journal, excluding: pendingKeys),
+            let appendableJournal = journal, journalID != nil,
+            hasSnapshot && journalSize <= max(HTTPCookieStorage.minimumJournalSizeForCompaction, snapshotSize) else {
+            lockedWriteSnapshot(to: cookieFilePath, journal: journal)
+            return
         }
 
-        for (key,cookie) in persistable {
+        var record: [String: Any] = [:]
+        if !cookies.isEmpty {
+            record["Set"] = cookies.mapValues { $0.persistableDictionary() }
+        }
+        if !removedKeys.isEmpty {
+            record["Remove"] = removedKeys
+        }
+        guard let recordData = try? PropertyListSerialization.data(fromPropertyList: record, format: .binary, options: 0) else {
+            lockedWriteSnapshot(to: cookieFilePath, journal: journal)
+            return
+        }
+        let length = UInt32(recordData.count)
+        var framed = Data([UInt8(truncatingIfNeeded: length >> 24), UInt8(truncatingIfNeeded: length >> 16),
+                           UInt8(truncatingIfNeeded: length >> 8), UInt8(truncatingIfNeeded: length)])
+        framed.append(recordData)
+        do {
+            try appendableJournal.seekToEnd()
+            try appendableJournal.write(contentsOf: framed)
+            journalSize += framed.count
+        } catch {
+            // Whatever part of the record made it to the journal is cut off by the snapshot
+            lockedWriteSnapshot(to: cookieFilePath, journal: journal)
+        }
+    }
+
+    /*!
+        @method lockedWriteSnapshot:journal:
+        @abstract Rewrite the snapshot, with the journal locked for writing, and start the journal afresh.
+        @discussion The caller has caught up with the journal, so the snapshot includes every change
+        recorded by any of the storages sharing the persistent store.
+    */
+    private func lockedWriteSnapshot(to cookieFilePath: String, journal: FileHandle?) {
+        //persist cookies
+        var persistDictionary: [String : [String : Any]] = [:]
+        for (key, cookie) in self.allCookies where isPersistable(cookie) {
             persistDictionary[key] = cookie.persistableDictionary()
         }
 
-        let nsdict = persistDictionary as NSDictionary
-        _ = nsdict.write(toFile: cookieFilePath, atomically: true)
+        guard let data = try? PropertyListSerialization.data(fromPropertyList: persistDictionary, format: .xml, options: 0),
+            (try? data.write(to: URL(fileURLWithPath: cookieFilePath), options: .atomic)) != nil else { return }
+        hasSnapshot = true
+        snapshotSize = data.count
+
+        // A new identifier tells the other storages to reload. If the journal can't be emptied it is left
+        // as it is: replaying it over the new snapshot, which already has its changes, changes nothing
+        guard let journal = journal, (try? journal.truncate(toOffset: 0)) != nil else { return }
+        let id = withUnsafeBytes(of: UUID().uuid) { Data($0) }
+        journalID = (try? journal.write(contentsOf: id)) != nil ? id : nil
+        journalSize = journalID?.count ?? 0
     }
 
     /*!
-        @method lockedDeleteCookie:
-        @abstract Delete the specified cookie, for internal callers already on syncQ.
+        @method lockedDeleteCookies:
+        @abstract Delete the specified cookies, for internal callers already on syncQ.
     */
-    private func lockedDeleteCookie(_ cookie: HTTPCookie) {
-        let key = cookie.domain + cookie.path + cookie.name
-        self.allCookies.removeValue(forKey: key)
-        updatePersistentStore()
+    private func lockedDeleteCookies(_ cookies: [HTTPCookie]) {
+        var removedKeys: [String] = []
+        for cookie in cookies {
+            let key = cookie.domain + cookie.path + cookie.name
+            if let removed = lockedRemoveCookie(forKey: key), mayHaveBeenPersisted(removed) {
+                removedKeys.append(key)
+            }
+        }
+        updatePersistentStore(setting: [:], removing: removedKeys)
     }
 
     /*!
@@ -249,8 +513,8 @@ open class HTTPCookieStorage: NSObject {
         @abstract Delete the specified cookie
     */
     open func deleteCookie(_ cookie: HTTPCookie) {
-        self.syncQ.sync {
-            self.lockedDeleteCookie(cookie)
+        self.syncQ.sync(flags: .barrier) {
+            self.lockedDeleteCookies([cookie])
         }
     }
     
@@ -259,14 +523,11 @@ open class HTTPCookieStorage: NSObject {
      @abstract Delete all cookies from the cookie storage since the provided date.
      */
     open func removeCookies(since date: Date) {
-        self.syncQ.sync {
+        self.syncQ.sync(flags: .barrier) {
             let cookiesSinceDate = self.allCookies.values.filter {
                 $0.properties![.created] as! Double >  date.timeIntervalSinceReferenceDate
             }
-            for cookie in cookiesSinceDate {
-                lockedDeleteCookie(cookie)
-            }
-            updatePersistentStore()
+            lockedDeleteCookies(cookiesSinceDate)
         }
     }
 
@@ -282,7 +543,26 @@ open class HTTPCookieStorage: NSObject {
     */
     open func cookies(for url: URL) -> [HTTPCookie]? {
         guard let host = url.host?.lowercased() else { return nil }
-        return Array(self.syncQ.sync(execute: {allCookies}).values.filter{ $0.validFor(host: host) })
+        return self.syncQ.sync {
+            var cookies: [HTTPCookie] = []
+            for domain in HTTPCookieStorage.domains(matching: host) {
+                guard let domainCookies = cookiesByDomain[String(domain)] else { continue }
+                cookies.append(contentsOf: domainCookies.values.filter { $0.validFor(host: host) })
+            }
+            return cookies
+        }
+    }
+
+    /* The host itself and each of its suffixes that follow a ".": the only domains, without their
+       leading dot, of cookies that can be valid for the host */
+    private static func domains(matching host: String) -> [Substring] {
+        var domains = [host[...]]
+        var remainder = host[...]
+        while let dot = remainder.firstIndex(of: ".") {
+            remainder = remainder[remainder.index(after: dot)...]
+            domains.append(remainder)
+        }
+        return domains
     }
     
     /*!
@@ -318,8 +598,9 @@ open class HTTPCookieStorage: NSObject {
 
         //save only those cookies whose domain matches with the url.host
         let validCookies = cookies.filter { $0.validFor(host: urlHost) }
-        for cookie in validCookies {
-            setCookie(cookie)
+        guard !validCookies.isEmpty else { return }
+        syncQ.sync(flags: .barrier) {
+            lockedSetCookies(validCookies)
         }
     }
     
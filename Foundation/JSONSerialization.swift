@@ -122,39 +122,17 @@ open class JSONSerialization : NSObject {
     
     /* Generate JSON data from a Foundation object. If the object will not produce valid JSON then an exception will be thrown. Setting the NSJSONWritingPrettyPrinted option will generate JSON with whitespace designed to make the output more readable. If that option is not set, the most compact possible JSON will be generated. If an error occurs, the error parameter will be set and the return value will be nil. The resulting data is a encoded in UTF-8.
      */
-    internal class func _data(withJSONObject value: Any, options opt: WritingOptions, stream: Bool) throws -> Data {
-        var jsonStr = String()
-        
+    internal class func _bytes(withJSONObject value: Any, options opt: WritingOptions) throws -> [UInt8] {
         var writer = JSONWriter(
             pretty: opt.contains(.prettyPrinted),
-            sortedKeys: opt.contains(.sortedKeys),
-            writer: { (str: String?) in
-                if let str = str {
-                    jsonStr.append(str)
-                }
-            }
+            sortedKeys: opt.contains(.sortedKeys)
         )
-        
-        if let container = value as? NSArray {
-            try writer.serializeJSON(container._bridgeToSwift())
-        } else if let container = value as? NSDictionary {
-            try writer.serializeJSON(container._bridgeToSwift())
-        } else if let container = value as? Array<Any> {
-            try writer.serializeJSON(container)
-        } else if let container = value as? Dictionary<AnyHashable, Any> {
-            try writer.serializeJSON(container)
-        } else {
-            fatalError("Top-level object was not NSArray or NSDictionary") // This is a fatal error in objective-c too (it is an NSInvalidArgumentException)
-        }
-
-        let count = jsonStr.utf8.count
-        return jsonStr.withCString {
-            Data(bytes: $0, count: count)
-        }
+        try writer.serializeTopLevel(value)
+        return writer.output
     }
 
     open class func data(withJSONObject value: Any, options opt: WritingOptions = []) throws -> Data {
-        return try _data(withJSONObject: value, options: opt, stream: false)
+        return Data(try _bytes(withJSONObject: value, options: opt))
     }
     
     /* Create a Foundation object from JSON data. Set the NSJSONReadingAllowFragments option if the parser should allow top-level objects that are not an NSArray or NSDictionary. Setting the NSJSONReadingMutableContainers option will make the parser generate mutable NSArrays and NSDictionaries. Setting the NSJSONReadingMutableLeaves option will make the parser generate mutable NSString objects. If an error occurs during the parse, then the error parameter will be set and the result will be nil.
@@ -194,12 +172,25 @@ open class JSONSerialization : NSObject {
     /* Write JSON data into a stream. The stream should be opened and configured. The return value is the number of bytes written to the stream, or 0 on error. All other behavior of this method is the same as the dataWithJSONObject:options:error: method.
      */
     open class func writeJSONObject(_ obj: Any, toStream stream: OutputStream, options opt: WritingOptions) throws -> Int {
-        let jsonData = try _data(withJSONObject: obj, options: opt, stream: true)
-        let count = jsonData.count
-        return jsonData.withUnsafeBytes { (bytePtr: UnsafePointer<UInt8>) -> Int in
-            let res: Int = stream.write(bytePtr, maxLength: count)
-            /// TODO: If the result here is negative the error should be obtained from the stream to propagate as a throw
-            return res
+        // Serialize the whole document first, so an invalid object leaves nothing on the stream
+        let bytes = try _bytes(withJSONObject: obj, options: opt)
+        return try bytes.withUnsafeBufferPointer { (buffer: UnsafeBufferPointer<UInt8>) -> Int in
+            var written = 0
+            while written < buffer.count {
+                let res: Int = stream.write(buffer.baseAddress!.advanced(by: written), maxLength: buffer.count - written)
+                guard res > 0 else {
+                    // Report what did get written; the stream's error only if nothing did
+                    if res < 0 && written == 0 {
+                        if let error = stream.streamError {
+                            throw error
+                        }
+                        return res
+                    }
+                    return written
+                }
+                written += res
+            }
+            return written
         }
     }
     
@@ -210,10 +201,10 @@ open class JSONSerialization : NSObject {
         guard stream.streamStatus == .open || stream.streamStatus == .reading else {
             fatalError("Stream is not available for reading")
         }
+        // Read into one reusable buffer rather than allocating a new one per chunk.
+        var buffer = [UInt8](repeating: 0, count: 64 * 1024)
         repeat {
-            var buffer = [UInt8](repeating: 0, count: 1024)
-            var bytesRead: Int = 0
-            bytesRead = stream.read(&buffer, maxLength: buffer.count)
+            let bytesRead = stream.read(&buffer, maxLength: buffer.count)
             if bytesRead < 0 {
                 throw stream.streamError!
             } else {
@@ -290,14 +281,56 @@ private struct JSONWriter {
     var indent = 0
     let pretty: Bool
     let sortedKeys: Bool
-    let writer: (String?) -> Void
 
-    init(pretty: Bool = false, sortedKeys: Bool = false, writer: @escaping (String?) -> Void) {
+    // The document is produced directly as UTF-8
+    private(set) var output: [UInt8] = []
+
+    init(pretty: Bool = false, sortedKeys: Bool = false) {
         self.pretty = pretty
         self.sortedKeys = sortedKeys
-        self.writer = writer
+        output.reserveCapacity(256)
     }
-    
+
+    mutating func serializeTopLevel(_ value: Any) throws {
+        if let container = value as? NSArray {
+            try serializeJSON(container._bridgeToSwift())
+        } else if let container = value as? NSDictionary {
+            try serializeJSON(container._bridgeToSwift())
+        } else if let container = value as? Array<Any> {
+            try serializeJSON(container)
+        } else if let container = value as? Dictionary<AnyHashable, Any> {
+            try serializeJSON(container)
+        } else {
+            fatalError("Top-level object was not NSArray or NSDictionary") // This is a fatal error in objective-c too (it is an NSInvalidArgumentException)
+        }
+    }
+
+    mutating func write(_ literal: StaticString) {
+        literal.withUTF8Buffer { output.append(contentsOf: $0) }
+    }
+
+    mutating func write(contentsOf string: String) {
+        output.append(contentsOf: string.utf8)
+    }
+
+    mutating func writeInteger(_ value: Int64) {
+        writeInteger(value.magnitude, isNegative: value < 0)
+    }
+
+    mutating func writeInteger(_ value: UInt64, isNegative: Bool = false) {
+        if isNegative {
+            output.append(UInt8(ascii: "-"))
+        }
+        // Emit the digits least significant first, then reverse them in place
+        let start = output.endIndex
+        var remaining = value
+        repeat {
+            output.append(UInt8(ascii: "0") + UInt8(truncatingIfNeeded: remaining % 10))
+            remaining /= 10
+        } while remaining != 0
+        output[start...].reverse()
+    }
+
     mutating func serializeJSON(_ object: Any?) throws {
 
         var toSerialize = object
@@ -305,38 +338,38 @@ private struct JSONWriter {
         if let number = toSerialize as? _NSNumberCastingWithoutBridging {
             toSerialize = number._swiftValueOfOptimalType
         }
-        
+
         guard let obj = toSerialize else {
             try serializeNull()
             return
         }
-        
+
         // For better performance, the most expensive conditions to evaluate should be last.
         switch (obj) {
         case let str as String:
             try serializeString(str)
         case let boolValue as Bool:
-            writer(boolValue.description)
+            write(boolValue ? "true" : "false")
         case let num as Int:
-            writer(num.description)
+            writeInteger(Int64(num))
         case let num as Int8:
-            writer(num.description)
+            writeInteger(Int64(num))
         case let num as Int16:
-            writer(num.description)
+            writeInteger(Int64(num))
         case let num as Int32:
-            writer(num.description)
+            writeInteger(Int64(num))
         case let num as Int64:
-            writer(num.description)
+            writeInteger(num)
         case let num as UInt:
-            writer(num.description)
+            writeInteger(UInt64(num))
         case let num as UInt8:
-            writer(num.description)
+            writeInteger(UInt64(num))
         case let num as UInt16:
-            writer(num.description)
+            writeInteger(UInt64(num))
         case let num as UInt32:
-            writer(num.description)
+            writeInteger(UInt64(num))
         case let num as UInt64:
-            writer(num.description)
+            writeInteger(num)
         case let array as Array<Any?>:
             try serializeArray(array)
         case let dict as Dictionary<AnyHashable, Any?>:
@@ -346,59 +379,65 @@ private struct JSONWriter {
         case let num as Double:
             try serializeFloat(num)
         case let num as Decimal:
-            writer(num.description)
+            write(contentsOf: num.description)
         case let num as NSDecimalNumber:
-            writer(num.description)
+            write(contentsOf: num.description)
         case is NSNull:
             try serializeNull()
         case _ where __SwiftValue.store(obj) is NSNumber:
             let num = __SwiftValue.store(obj) as! NSNumber
-            writer(num.description)
+            write(contentsOf: num.description)
         default:
             throw NSError(domain: NSCocoaErrorDomain, code: CocoaError.propertyListReadCorrupt.rawValue, userInfo: ["NSDebugDescription" : "Invalid object cannot be serialized"])
         }
     }
 
-    func serializeString(_ str: String) throws {
-        writer("\"")
-        for scalar in str.unicodeScalars {
-            switch scalar {
-                case "\"":
-                    writer("\\\"") // U+0022 quotation mark
-                case "\\":
-                    writer("\\\\") // U+005C reverse solidus
-                case "/":
-                    writer("\\/") // U+002F solidus
-                case "\u{8}":
-                    writer("\\b") // U+0008 backspace
-                case "\u{c}":
-                    writer("\\f") // U+000C form feed
-                case "\n":
-                    writer("\\n") // U+000A line feed
-                case "\r":
-                    writer("\\r") // U+000D carriage return
-                case "\t":
-                    writer("\\t") // U+0009 tab
-                case "\u{0}"..."\u{f}":
-                    writer("\\u000\(String(scalar.value, radix: 16))") // U+0000 to U+000F
-                case "\u{10}"..."\u{1f}":
-                    writer("\\u00\(String(scalar.value, radix: 16))") // U+0010 to U+001F
+    private static let hexDigits: [UInt8] = Array("0123456789abcdef".utf8)
+
+    mutating func serializeString(_ str: String) throws {
+        write("\"")
+        // Every character that needs escaping is ASCII and the bytes of a
+        // multi-byte UTF-8 sequence are all >= 0x80, so escaping can work on
+        // the UTF-8 view directly and copy everything else through unchanged.
+        for byte in str.utf8 {
+            switch byte {
+                case 0x22:
+                    write("\\\"") // U+0022 quotation mark
+                case 0x5C:
+                    write("\\\\") // U+005C reverse solidus
+                case 0x2F:
+                    write("\\/") // U+002F solidus
+                case 0x08:
+                    write("\\b") // U+0008 backspace
+                case 0x0C:
+                    write("\\f") // U+000C form feed
+                case 0x0A:
+                    write("\\n") // U+000A line feed
+                case 0x0D:
+                    write("\\r") // U+000D carriage return
+                case 0x09:
+                    write("\\t") // U+0009 tab
+                case 0x00...0x1F:
+                    write("\\u00") // U+0000 to U+001F
+                    output.append(JSONWriter.hexDigits[Int(byte >> 4)])
+                    output.append(JSONWriter.hexDigits[Int(byte & 0xF)])
                 default:
-                    writer(String(scalar))
+                    output.append(byte)
             }
         }
-        writer("\"")
+        write("\"")
     }
 
-    private func serializeFloat<T: FloatingPoint & LosslessStringConvertible>(_ num: T) throws {
+    private mutating func serializeFloat<T: FloatingPoint & LosslessStringConvertible>(_ num: T) throws {
         guard num.isFinite else {
              throw NSError(domain: NSCocoaErrorDomain, code: CocoaError.propertyListReadCorrupt.rawValue, userInfo: ["NSDebugDescription" : "Invalid number value (\(num)) in JSON write"])
         }
+        // description is already the shortest representation that round-trips
         var str = num.description
         if str.hasSuffix(".0") {
             str.removeLast(2)
         }
-        writer(str)
+        write(contentsOf: str)
     }
 
     mutating func serializeNumber(_ num: NSNumber) throws {
@@ -407,43 +446,43 @@ private struct JSONWriter {
         } else {
             switch num._cfTypeID {
             case CFBooleanGetTypeID():
-                writer(num.boolValue.description)
+                write(num.boolValue ? "true" : "false")
             default:
-                writer(num.stringValue)
+                write(contentsOf: num.stringValue)
             }
         }
     }
 
     mutating func serializeArray(_ array: [Any?]) throws {
-        writer("[")
+        write("[")
         if pretty {
-            writer("\n")
+            write("\n")
             incAndWriteIndent()
         }
-        
+
         var first = true
         for elem in array {
             if first {
                 first = false
             } else if pretty {
-                writer(",\n")
+                write(",\n")
                 writeIndent()
             } else {
-                writer(",")
+                write(",")
             }
             try serializeJSON(elem)
         }
         if pretty {
-            writer("\n")
+            write("\n")
             decAndWriteIndent()
         }
-        writer("]")
+        write("]")
     }
 
     mutating func serializeDictionary(_ dict: Dictionary<AnyHashable, Any?>) throws {
-        writer("{")
+        write("{")
         if pretty {
-            writer("\n")
+            write("\n")
             incAndWriteIndent()
         }
 
@@ -453,10 +492,10 @@ private struct JSONWriter {
             if first {
                 first = false
             } else if pretty {
-                writer(",\n")
+                write(",\n")
                 writeIndent()
             } else {
-                writer(",")
+                write(",")
             }
 
             if let key = key as? String {
@@ -464,7 +503,7 @@ private struct JSONWriter {
             } else {
                 throw NSError(domain: NSCocoaErrorDomain, code: CocoaError.propertyListReadCorrupt.rawValue, userInfo: ["NSDebugDescription" : "NSDictionary key must be NSString"])
             }
-            pretty ? writer(" : ") : writer(":")
+            pretty ? write(" : ") : write(":")
             try serializeJSON(value)
         }
 
@@ -490,32 +529,30 @@ private struct JSONWriter {
         }
 
         if pretty {
-            writer("\n")
+            write("\n")
             decAndWriteIndent()
         }
-        writer("}")
+        write("}")
     }
 
-    func serializeNull() throws {
-        writer("null")
+    mutating func serializeNull() throws {
+        write("null")
     }
-    
+
     let indentAmount = 2
-    
+
     mutating func incAndWriteIndent() {
         indent += indentAmount
         writeIndent()
     }
-    
+
     mutating func decAndWriteIndent() {
         indent -= indentAmount
         writeIndent()
     }
-    
-    func writeIndent() {
-        for _ in 0..<indent {
-            writer(" ")
-        }
+
+    mutating func writeIndent() {
+        output.append(contentsOf: repeatElement(UInt8(ascii: " "), count: indent))
     }
 
 }
@@ -523,12 +560,17 @@ private struct JSONWriter {
 //MARK: - JSONDeserializer
 private struct JSONReader {
 
-    static let whitespaceASCII: [UInt8] = [
-        0x09, // Horizontal tab
-        0x0A, // Line feed or New line
-        0x0D, // Carriage return
-        0x20, // Space
-    ]
+    static func isWhitespace(_ byte: UInt8) -> Bool {
+        switch byte {
+        case 0x09, // Horizontal tab
+             0x0A, // Line feed or New line
+             0x0D, // Carriage return
+             0x20: // Space
+            return true
+        default:
+            return false
+        }
+    }
 
     struct Structure {
         static let BeginArray: UInt8     = 0x5B // [
@@ -614,7 +656,14 @@ private struct JSONReader {
 
     func consumeWhitespace(_ input: Index) -> Index? {
         var index = input
-        while let (char, nextIndex) = source.takeASCII(index), JSONReader.whitespaceASCII.contains(char) {
+        if source.encoding == .utf8 {
+            let buffer = source.buffer
+            while index < buffer.endIndex && JSONReader.isWhitespace(buffer[index]) {
+                index += 1
+            }
+            return index
+        }
+        while let (char, nextIndex) = source.takeASCII(index), JSONReader.isWhitespace(char) {
             index = nextIndex
         }
         return index
@@ -650,21 +699,15 @@ private struct JSONReader {
         return index
     }
 
-    func takeMatching(_ match: @escaping (UInt8) -> Bool) -> ([Character], Index) -> ([Character], Index)? {
-        return { input, index in
-            guard let (byte, index) = self.source.takeASCII(index), match(byte) else {
-                return nil
-            }
-            return (input + [Character(UnicodeScalar(byte))], index)
-        }
-    }
-
     //MARK: - String Parsing
 
     func parseString(_ input: Index) throws -> (String, Index)? {
         guard let beginIndex = try consumeWhitespace(input).flatMap(consumeASCII(Structure.QuotationMark)) else {
             return nil
         }
+        if source.encoding == .utf8, let result = try parseUTF8StringWithoutEscapes(beginIndex) {
+            return result
+        }
         var chunkIndex: Int = beginIndex
         var currentIndex: Int = chunkIndex
 
@@ -700,6 +743,34 @@ private struct JSONReader {
         ])
     }
 
+    // Most strings in real documents contain no escapes, so for UTF-8 input scan
+    // straight to the closing quote and build the String from the bytes in
+    // place rather than going through Data and String(data:encoding:). Returns
+    // nil when the string needs the general path (escapes or end of input).
+    func parseUTF8StringWithoutEscapes(_ beginIndex: Index) throws -> (String, Index)? {
+        let buffer = source.buffer
+        var index = beginIndex
+        var isASCII = true
+        while index < buffer.endIndex {
+            let byte = buffer[index]
+            if byte == Structure.QuotationMark || byte == Structure.Escape {
+                break
+            }
+            if byte >= 0x80 {
+                isASCII = false
+            }
+            index += 1
+        }
+        guard index < buffer.endIndex && buffer[index] == Structure.QuotationMark else {
+            return nil
+        }
+        if isASCII {
+            // ASCII is always valid UTF-8, so no validation is needed
+            return (String(decoding: UnsafeBufferPointer(rebasing: buffer[beginIndex..<index]), as: UTF8.self), index + 1)
+        }
+        return (try source.takeString(beginIndex, end: index), index + 1)
+    }
+
     func parseEscapeSequence(_ input: Index) throws -> (String, Index)? {
         guard let (byte, index) = source.takeASCII(input) else {
             throw NSError(domain: NSCocoaErrorDomain, code: CocoaError.propertyListReadCorrupt.rawValue, userInfo: [
@@ -764,19 +835,26 @@ private struct JSONReader {
         return (String(UTF16.decode(UTF16.EncodedScalar([codeUnit, trailCodeUnit]))), finalIndex)
     }
 
-    func isHexChr(_ byte: UInt8) -> Bool {
-        return (byte >= 0x30 && byte <= 0x39)
-            || (byte >= 0x41 && byte <= 0x46)
-            || (byte >= 0x61 && byte <= 0x66)
+    static func hexValue(_ byte: UInt8) -> UInt8? {
+        switch byte {
+        case 0x30...0x39: return byte - 0x30
+        case 0x41...0x46: return byte - 0x41 + 10
+        case 0x61...0x66: return byte - 0x61 + 10
+        default: return nil
+        }
     }
 
     func parseCodeUnit(_ input: Index) -> (UTF16.CodeUnit, Index)? {
-        let hexParser = takeMatching(isHexChr)
-        guard let (result, index) = hexParser([], input).flatMap(hexParser).flatMap(hexParser).flatMap(hexParser),
-            let value = Int(String(result), radix: 16) else {
+        var index = input
+        var value: UTF16.CodeUnit = 0
+        for _ in 0..<4 {
+            guard let (byte, nextIndex) = source.takeASCII(index), let digit = JSONReader.hexValue(byte) else {
                 return nil
+            }
+            value = (value << 4) | UTF16.CodeUnit(digit)
+            index = nextIndex
         }
-        return (UTF16.CodeUnit(value), index)
+        return (value, index)
     }
     
     //MARK: - Number parsing
@@ -791,11 +869,14 @@ private struct JSONReader {
     private static let allDigits = (ZERO...NINE)
     private static let oneToNine = (ONE...NINE)
 
-    private static let numberCodePoints: [UInt8] = {
-        var numberCodePoints = Array(ZERO...NINE)
-        numberCodePoints.append(contentsOf: [DECIMAL_SEPARATOR, MINUS, PLUS, LOWER_EXPONENT, UPPER_EXPONENT])
-        return numberCodePoints
-    }()
+    private static func isNumberCodePoint(_ byte: UInt8) -> Bool {
+        switch byte {
+        case ZERO...NINE, DECIMAL_SEPARATOR, MINUS, PLUS, LOWER_EXPONENT, UPPER_EXPONENT:
+            return true
+        default:
+            return false
+        }
+    }
 
 
     func parseNumber(_ input: Index, options opt: JSONSerialization.ReadingOptions) throws -> (Any, Index)? {
@@ -816,7 +897,7 @@ private struct JSONReader {
             // Return true if the next character is any one of the valid JSON number characters
             func nextASCII() -> Bool {
                 guard let (ch, nextIndex) = source.takeASCII(index),
-                    JSONReader.numberCodePoints.contains(ch) else { return false }
+                    JSONReader.isNumberCodePoint(ch) else { return false }
 
                 index = nextIndex
                 ascii = ch
@@ -847,7 +928,7 @@ private struct JSONReader {
             if JSONReader.oneToNine.contains(ascii) {
                 guard let ch = readDigits() else { return true }
                 ascii = ch
-                if [ JSONReader.DECIMAL_SEPARATOR, JSONReader.LOWER_EXPONENT, JSONReader.UPPER_EXPONENT ].contains(ascii) {
+                if ascii == JSONReader.DECIMAL_SEPARATOR || ascii == JSONReader.LOWER_EXPONENT || ascii == JSONReader.UPPER_EXPONENT {
                     guard nextASCII() else { return false } // There should be at least one char as readDigits didn't remove the '.eE'
                 }
             } else if ascii == JSONReader.ZERO {
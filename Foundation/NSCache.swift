@@ -11,12 +11,13 @@ private class NSCacheEntry<KeyType : AnyObject, ObjectType : AnyObject> {
     var key: KeyType
     var value: ObjectType
     var cost: Int
-    var prevByCost: NSCacheEntry?
-    var nextByCost: NSCacheEntry?
-    init(key: KeyType, value: ObjectType, cost: Int) {
+    var sequenceNumber: UInt64
+    var heapIndex = 0
+    init(key: KeyType, value: ObjectType, cost: Int, sequenceNumber: UInt64) {
         self.key = key
         self.value = value
         self.cost = cost
+        self.sequenceNumber = sequenceNumber
     }
 }
 
@@ -58,7 +59,13 @@ open class NSCache<KeyType : AnyObject, ObjectType : AnyObject> : NSObject {
     private var _entries = Dictionary<NSCacheKey, NSCacheEntry<KeyType, ObjectType>>()
     private let _lock = NSLock()
     private var _totalCost = 0
-    private var _head: NSCacheEntry<KeyType, ObjectType>?
+    
+    // Entries in eviction order as a binary min-heap: the root is the
+    // cheapest entry and, among equally cheap ones, the least recently set.
+    // Each entry records its position so it can be moved or removed in
+    // O(log n) without searching.
+    private var _heap = [NSCacheEntry<KeyType, ObjectType>]()
+    private var _nextSequenceNumber: UInt64 = 0
     
     open var name: String = ""
     open var totalCostLimit: Int = 0 // limits are imprecise/not strict
@@ -87,50 +94,77 @@ open class NSCache<KeyType : AnyObject, ObjectType : AnyObject> : NSObject {
         setObject(obj, forKey: key, cost: 0)
     }
     
+    private func evictsBefore(_ lhs: NSCacheEntry<KeyType, ObjectType>, _ rhs: NSCacheEntry<KeyType, ObjectType>) -> Bool {
+        if lhs.cost != rhs.cost {
+            return lhs.cost < rhs.cost
+        }
+        return lhs.sequenceNumber < rhs.sequenceNumber
+    }
+    
+    private func swapAt(_ i: Int, _ j: Int) {
+        _heap.swapAt(i, j)
+        _heap[i].heapIndex = i
+        _heap[j].heapIndex = j
+    }
+    
+    private func siftUp(_ index: Int) {
+        var child = index
+        while child > 0 {
+            let parent = (child - 1) / 2
+            guard evictsBefore(_heap[child], _heap[parent]) else { break }
+            swapAt(child, parent)
+            child = parent
+        }
+    }
+    
+    private func siftDown(_ index: Int) {
+        var parent = index
+        while true {
+            let left = 2 * parent + 1
+            let right = left + 1
+            var first = parent
+            if left < _heap.count && evictsBefore(_heap[left], _heap[first]) {
+                first = left
+            }
+            if right < _heap.count && evictsBefore(_heap[right], _heap[first]) {
+                first = right
+            }
+            guard first != parent else { break }
+            swapAt(parent, first)
+            parent = first
+        }
+    }
+    
     private func remove(_ entry: NSCacheEntry<KeyType, ObjectType>) {
-        let oldPrev = entry.prevByCost
-        let oldNext = entry.nextByCost
-        
-        oldPrev?.nextByCost = oldNext
-        oldNext?.prevByCost = oldPrev
-        
-        if entry === _head {
-            _head = oldNext
+        let index = entry.heapIndex
+        let last = _heap.count - 1
+        if index != last {
+            swapAt(index, last)
+        }
+        _heap.removeLast()
+        if index < _heap.count {
+            // The entry moved into the hole may belong above or below it
+            siftUp(index)
+            siftDown(index)
         }
     }
    
     private func insert(_ entry: NSCacheEntry<KeyType, ObjectType>) {
-        guard var currentElement = _head else {
-            // The cache is empty
-            entry.prevByCost = nil
-            entry.nextByCost = nil
-            
-            _head = entry
-            return
-        }
-        
-        guard entry.cost > currentElement.cost else {
-            // Insert entry at the head
-            entry.prevByCost = nil
-            entry.nextByCost = currentElement
-            currentElement.prevByCost = entry
-            
-            _head = entry
-            return
-        }
-        
-        while let nextByCost = currentElement.nextByCost, nextByCost.cost < entry.cost {
-            currentElement = nextByCost
+        entry.heapIndex = _heap.count
+        _heap.append(entry)
+        siftUp(entry.heapIndex)
+    }
+    
+    private func evictFirst() -> NSCacheEntry<KeyType, ObjectType>? {
+        guard let entry = _heap.first else {
+            return nil
         }
+        delegate?.cache(unsafeDowncast(self, to:NSCache<AnyObject, AnyObject>.self), willEvictObject: entry.value)
         
-        // Insert entry between currentElement and nextElement
-        let nextElement = currentElement.nextByCost
-        
-        currentElement.nextByCost = entry
-        entry.prevByCost = currentElement
-        
-        entry.nextByCost = nextElement
-        nextElement?.prevByCost = entry
+        _totalCost -= entry.cost
+        remove(entry)
+        _entries[NSCacheKey(entry.key)] = nil
+        return entry
     }
     
     open func setObject(_ obj: ObjectType, forKey key: KeyType, cost g: Int) {
@@ -140,19 +174,21 @@ open class NSCache<KeyType : AnyObject, ObjectType : AnyObject> : NSObject {
         _lock.lock()
         
         let costDiff: Int
+        let sequenceNumber = _nextSequenceNumber
+        _nextSequenceNumber += 1
         
         if let entry = _entries[keyRef] {
             costDiff = g - entry.cost
             entry.cost = g
+            entry.sequenceNumber = sequenceNumber
             
             entry.value = obj
             
-            if costDiff != 0 {
-                remove(entry)
-                insert(entry)
-            }
+            // Its cost changed and it is now the most recently set
+            siftUp(entry.heapIndex)
+            siftDown(entry.heapIndex)
         } else {
-            let entry = NSCacheEntry(key: key, value: obj, cost: g)
+            let entry = NSCacheEntry(key: key, value: obj, cost: g, sequenceNumber: sequenceNumber)
             _entries[keyRef] = entry
             insert(entry)
             
@@ -162,33 +198,13 @@ open class NSCache<KeyType : AnyObject, ObjectType : AnyObject> : NSObject {
         _totalCost += costDiff
         
         var purgeAmount = (totalCostLimit > 0) ? (_totalCost - totalCostLimit) : 0
-        while purgeAmount > 0 {
-            if let entry = _head {
-                delegate?.cache(unsafeDowncast(self, to:NSCache<AnyObject, AnyObject>.self), willEvictObject: entry.value)
-                
-                _totalCost -= entry.cost
-                purgeAmount -= entry.cost
-                
-                remove(entry) // _head will be changed to next entry in remove(_:)
-                _entries[NSCacheKey(entry.key)] = nil
-            } else {
-                break
-            }
+        while purgeAmount > 0, let entry = evictFirst() {
+            purgeAmount -= entry.cost
         }
         
         var purgeCount = (countLimit > 0) ? (_entries.count - countLimit) : 0
-        while purgeCount > 0 {
-            if let entry = _head {
-                delegate?.cache(unsafeDowncast(self, to:NSCache<AnyObject, AnyObject>.self), willEvictObject: entry.value)
-                
-                _totalCost -= entry.cost
-                purgeCount -= 1
-                
-                remove(entry) // _head will be changed to next entry in remove(_:)
-                _entries[NSCacheKey(entry.key)] = nil
-            } else {
-                break
-            }
+        while purgeCount > 0, evictFirst() != nil {
+            purgeCount -= 1
         }
         
         _lock.unlock()
@@ -208,16 +224,7 @@ open class NSCache<KeyType : AnyObject, ObjectType : AnyObject> : NSObject {
     open func removeAllObjects() {
         _lock.lock()
         _entries.removeAll()
-        
-        while let currentElement = _head {
-            let nextElement = currentElement.nextByCost
-            
-            currentElement.prevByCost = nil
-            currentElement.nextByCost = nil
-            
-            _head = nextElement
-        }
-        
+        _heap.removeAll()
         _totalCost = 0
         _lock.unlock()
     }    
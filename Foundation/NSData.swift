@@ -537,29 +537,8 @@ open class NSData : NSObject, NSCopying, NSMutableCopying, NSSecureCoding {
         
         precondition(searchRange.upperBound <= self.length, "range outside the bounds of data")
 
-        let basePtr = self.bytes.bindMemory(to: UInt8.self, capacity: self.length)
-        let baseData = UnsafeBufferPointer<UInt8>(start: basePtr, count: self.length)[searchRange]
-        let searchPtr = dataToFind.bytes.bindMemory(to: UInt8.self, capacity: dataToFind.length)
-        let search = UnsafeBufferPointer<UInt8>(start: searchPtr, count: dataToFind.length)
-        
-        let location : Int?
-        let anchored = mask.contains(.anchored)
-        if mask.contains(.backwards) {
-            location = NSData.searchSubSequence(search.reversed(), inSequence: baseData.reversed(),anchored : anchored).map {$0.base-search.count}
-        } else {
-            location = NSData.searchSubSequence(search, inSequence: baseData,anchored : anchored)
-        }
-        return location.map {NSRange(location: $0, length: search.count)} ?? NSRange(location: NSNotFound, length: 0)
-    }
-
-    private static func searchSubSequence<T : Collection, T2 : Sequence>(_ subSequence : T2, inSequence seq: T,anchored : Bool) -> T.Index? where T.Iterator.Element : Equatable, T.Iterator.Element == T2.Iterator.Element {
-        for index in seq.indices {
-            if seq.suffix(from: index).starts(with: subSequence) {
-                return index
-            }
-            if anchored {return nil}
-        }
-        return nil
+        let result = _CFDataFindBytes(_cfObject, dataToFind._cfObject, CFRangeMake(searchRange.lowerBound, searchRange.count), CFDataSearchFlags(rawValue: mask.rawValue))
+        return result.location == kCFNotFound ? NSRange(location: NSNotFound, length: 0) : NSRange(location: result.location, length: result.length)
     }
     
     internal func enumerateByteRangesUsingBlockRethrows(_ block: (UnsafeRawPointer, NSRange, UnsafeMutablePointer<Bool>) throws -> Void) throws {
@@ -88,46 +88,106 @@ private class NSNotificationReceiver : NSObject {
     fileprivate var block: ((Notification) -> Void)?
     fileprivate var sender: AnyObject?
     fileprivate var queue: OperationQueue?
+    fileprivate var sequenceNumber: UInt64 = 0
 }
 
-extension Sequence where Iterator.Element : NSNotificationReceiver {
+/// Registered observers, indexed so that posting only visits the observers
+/// that can match.
+///
+/// Receivers are bucketed by name and then by sender, with a `nil` key
+/// holding the receivers that accept any name or any sender. A notification
+/// can therefore only match the receivers in at most four buckets. A second
+/// index by observer token keeps removal from scanning unrelated buckets.
+///
+/// The table is a value type built from copy-on-write collections, so
+/// `NotificationCenter` can hand a snapshot to a posting thread by copying it
+/// under the lock in O(1); mutations made while a snapshot is in use copy
+/// only the storage they touch.
+private struct NSNotificationReceiverTable {
+    private var receiversByName = [Notification.Name? : [ObjectIdentifier? : [NSNotificationReceiver]]]()
+    private var receiversByObserver = [ObjectIdentifier : [NSNotificationReceiver]]()
 
-    /// Returns collection of `NSNotificationReceiver`.
-    ///
-    /// Will return:
-    ///  - elements that property `object` is not equal to `observerToFilter`
-    ///  - elements that property `name` is not equal to parameter `name` if specified.
-    ///  - elements that property `sender` is not equal to parameter `object` if specified.
-    ///
-    fileprivate func filterOutObserver(_ observerToFilter: AnyObject, name:Notification.Name? = nil, object: Any? = nil) -> [Iterator.Element] {
-        return self.filter { observer in
+    private static func senderKey(_ sender: AnyObject?) -> ObjectIdentifier? {
+        guard let sender = sender else {
+            return nil
+        }
+        return ObjectIdentifier(sender)
+    }
+
+    mutating func insert(_ receiver: NSNotificationReceiver, observer: NSObject) {
+        receiversByName[receiver.name, default: [:]][NSNotificationReceiverTable.senderKey(receiver.sender), default: []].append(receiver)
+
+        // An observer token that has been deallocated without being removed
+        // leaves its receivers behind, and its identifier may be reused by
+        // the new token; drop those stale entries from the observer index.
+        let observerKey = ObjectIdentifier(observer)
+        var receivers = receiversByObserver[observerKey]?.filter { $0.object != nil } ?? []
+        receivers.append(receiver)
+        receiversByObserver[observerKey] = receivers
+    }
 
-            let differentObserver = observer.object !== observerToFilter
-            let nameSpecified = name != nil
-            let differentName = observer.name != name
-            let objectSpecified = object != nil
-            let differentSender = observer.sender !== __SwiftValue.store(object)
+    /// Removes the receivers registered for `observer`, restricted to `name`
+    /// and `sender` when they are specified.
+    mutating func remove(_ observer: NSObject, name: Notification.Name?, sender: AnyObject?) {
+        let observerKey = ObjectIdentifier(observer)
+        guard let receivers = receiversByObserver[observerKey] else {
+            return
+        }
 
-            return differentObserver || (nameSpecified  && differentName) || (objectSpecified && differentSender)
+        var kept = [NSNotificationReceiver]()
+        for receiver in receivers where receiver.object != nil {
+            let sameObserver = receiver.object === observer
+            let sameName = name == nil || receiver.name == name
+            let sameSender = sender == nil || receiver.sender === sender
+            if sameObserver && sameName && sameSender {
+                removeFromBuckets(receiver)
+            } else {
+                kept.append(receiver)
+            }
         }
+        receiversByObserver[observerKey] = kept.isEmpty ? nil : kept
     }
 
-    /// Returns collection of `NSNotificationReceiver`.
-    ///
-    /// Will return:
-    ///  - elements that property `sender` is `nil` or equals specified parameter `sender`.
-    ///  - elements that property `name` is `nil` or equals specified parameter `name`.
-    ///
-    fileprivate func observersMatchingName(_ name:Notification.Name? = nil, sender: Any? = nil) -> [Iterator.Element] {
-        return self.filter { observer in
+    private mutating func removeFromBuckets(_ receiver: NSNotificationReceiver) {
+        let senderKey = NSNotificationReceiverTable.senderKey(receiver.sender)
+        receiversByName[receiver.name]?[senderKey]?.removeAll(where: { $0 === receiver })
+        if receiversByName[receiver.name]?[senderKey]?.isEmpty == true {
+            receiversByName[receiver.name]?[senderKey] = nil
+        }
+        if receiversByName[receiver.name]?.isEmpty == true {
+            receiversByName[receiver.name] = nil
+        }
+    }
+
+    /// Returns the receivers whose name is `nil` or equals `name` and whose
+    /// sender is `nil` or equals `sender`, in registration order.
+    func receivers(matching name: Notification.Name, sender: AnyObject?) -> [NSNotificationReceiver] {
+        let senderKey = NSNotificationReceiverTable.senderKey(sender)
+        var matching = [NSNotificationReceiver]()
+        var bucketCount = 0
+
+        func collect(_ receiversBySender: [ObjectIdentifier? : [NSNotificationReceiver]]?) {
+            guard let receiversBySender = receiversBySender else {
+                return
+            }
+            if senderKey != nil, let bucket = receiversBySender[senderKey] {
+                matching.append(contentsOf: bucket)
+                bucketCount += 1
+            }
+            if let bucket = receiversBySender[nil] {
+                matching.append(contentsOf: bucket)
+                bucketCount += 1
+            }
+        }
 
-            let emptyName = observer.name == nil
-            let sameName = observer.name == name
-            let emptySender = observer.sender == nil
-            let sameSender = observer.sender === __SwiftValue.store(sender)
+        collect(receiversByName[name])
+        collect(receiversByName[nil])
 
-            return (emptySender || sameSender) && (emptyName || sameName)
+        // Each bucket is already in registration order
+        if bucketCount > 1 {
+            matching.sort(by: { $0.sequenceNumber < $1.sequenceNumber })
         }
+        return matching
     }
 }
 
@@ -135,11 +195,12 @@ private let _defaultCenter: NotificationCenter = NotificationCenter()
 
 open class NotificationCenter: NSObject {
     
-    private var _observers: [NSNotificationReceiver]
+    private var _observers: NSNotificationReceiverTable
+    private var _nextSequenceNumber: UInt64 = 0
     private let _observersLock = NSLock()
     
     public required override init() {
-        _observers = [NSNotificationReceiver]()
+        _observers = NSNotificationReceiverTable()
     }
     
     open class var `default`: NotificationCenter {
@@ -148,9 +209,11 @@ open class NotificationCenter: NSObject {
     
     open func post(_ notification: Notification) {
 
-        let sendTo = _observersLock.synchronized({
-            return _observers.observersMatchingName(notification.name, sender: notification.object)
+        // Only the snapshot is taken under the lock; matching happens outside it
+        let observers = _observersLock.synchronized({
+            return _observers
         })
+        let sendTo = observers.receivers(matching: notification.name, sender: __SwiftValue.store(optional: notification.object))
 
         for observer in sendTo {
             guard let block = observer.block else {
@@ -181,7 +244,7 @@ open class NotificationCenter: NSObject {
         }
 
         _observersLock.synchronized({
-            self._observers = _observers.filterOutObserver(observer, name: aName, object: object)
+            _observers.remove(observer, name: aName, sender: __SwiftValue.store(optional: object))
         })
     }
 
@@ -201,7 +264,9 @@ open class NotificationCenter: NSObject {
         newObserver.queue = queue
 
         _observersLock.synchronized({
-            _observers.append(newObserver)
+            newObserver.sequenceNumber = _nextSequenceNumber
+            _nextSequenceNumber += 1
+            _observers.insert(newObserver, observer: object)
         })
         
         return object
@@ -57,23 +57,32 @@ open class PropertyListEncoder {
     /// - throws: `EncodingError.invalidValue` if a non-conforming floating-point value is encountered during encoding, and the encoding strategy is `.throw`.
     /// - throws: An error if any value throws an error during encoding.
     open func encode<Value : Encodable>(_ value: Value) throws -> Data {
-      let topLevel = try encodeToTopLevelContainer(value)
-      if topLevel is NSNumber {
+      let topLevel = try encodeToTopLevelValue(value)
+      switch topLevel {
+      case .bool, .integer, .unsignedInteger, .float, .double:
           throw EncodingError.invalidValue(value,
                                            EncodingError.Context(codingPath: [],
                                                                  debugDescription: "Top-level \(Value.self) encoded as number property list fragment."))
-      } else if topLevel is NSString {
+      case .string:
           throw EncodingError.invalidValue(value,
                                            EncodingError.Context(codingPath: [],
                                                                  debugDescription: "Top-level \(Value.self) encoded as string property list fragment."))
-      } else if topLevel is NSDate {
+      case .date:
           throw EncodingError.invalidValue(value,
                                            EncodingError.Context(codingPath: [],
                                                                  debugDescription: "Top-level \(Value.self) encoded as date property list fragment."))
+      default:
+          break
       }
-      
+
+      // Binary property lists are written straight from the encoded values;
+      // the other formats still go through the CF writers.
+      if self.outputFormat == .binary {
+          return _BinaryPlistWriter.data(for: topLevel)
+      }
+
       do {
-          return try PropertyListSerialization.data(fromPropertyList: topLevel, format: self.outputFormat, options: 0)
+          return try PropertyListSerialization.data(fromPropertyList: topLevel.propertyListObject, format: self.outputFormat, options: 0)
       } catch {
           throw EncodingError.invalidValue(value, 
                                            EncodingError.Context(codingPath: [], debugDescription: "Unable to encode the given top-level value as a property list", underlyingError: error))
@@ -87,6 +96,10 @@ open class PropertyListEncoder {
     /// - throws: `EncodingError.invalidValue` if a non-conforming floating-point value is encountered during encoding, and the encoding strategy is `.throw`.
     /// - throws: An error if any value throws an error during encoding.
     internal func encodeToTopLevelContainer<Value : Encodable>(_ value: Value) throws -> Any {
+        return try encodeToTopLevelValue(value).propertyListObject
+    }
+
+    fileprivate func encodeToTopLevelValue<Value : Encodable>(_ value: Value) throws -> _PlistEncodedValue {
         let encoder = __PlistEncoder(options: self.options)
         guard let topLevel = try encoder.box_(value) else {
             throw EncodingError.invalidValue(value,
@@ -145,12 +158,12 @@ fileprivate class __PlistEncoder : Encoder {
     // MARK: - Encoder Methods
     public func container<Key>(keyedBy: Key.Type) -> KeyedEncodingContainer<Key> {
         // If an existing keyed container was already requested, return that one.
-        let topContainer: NSMutableDictionary
+        let topContainer: _PlistEncodedDictionary
         if self.canEncodeNewValue {
             // We haven't yet pushed a container at this level; do so here.
             topContainer = self.storage.pushKeyedContainer()
         } else {
-            guard let container = self.storage.containers.last as? NSMutableDictionary else {
+            guard case .dictionary(let container)? = self.storage.containers.last else {
                 preconditionFailure("Attempt to push new keyed encoding container when already previously encoded at this path.")
             }
 
@@ -163,12 +176,12 @@ fileprivate class __PlistEncoder : Encoder {
 
     public func unkeyedContainer() -> UnkeyedEncodingContainer {
         // If an existing unkeyed container was already requested, return that one.
-        let topContainer: NSMutableArray
+        let topContainer: _PlistEncodedArray
         if self.canEncodeNewValue {
             // We haven't yet pushed a container at this level; do so here.
             topContainer = self.storage.pushUnkeyedContainer()
         } else {
-            guard let container = self.storage.containers.last as? NSMutableArray else {
+            guard case .array(let container)? = self.storage.containers.last else {
                 preconditionFailure("Attempt to push new unkeyed encoding container when already previously encoded at this path.")
             }
 
@@ -189,8 +202,8 @@ fileprivate struct _PlistEncodingStorage {
     // MARK: Properties
 
     /// The container stack.
-    /// Elements may be any one of the plist types (NSNumber, NSString, NSDate, NSArray, NSDictionary).
-    private(set) fileprivate var containers: [NSObject] = []
+    /// Elements may be any one of the plist types (string, number, date, data, array, dictionary).
+    private(set) fileprivate var containers: [_PlistEncodedValue] = []
 
     // MARK: - Initialization
 
@@ -203,23 +216,23 @@ fileprivate struct _PlistEncodingStorage {
         return self.containers.count
     }
 
-    fileprivate mutating func pushKeyedContainer() -> NSMutableDictionary {
-        let dictionary = NSMutableDictionary()
-        self.containers.append(dictionary)
+    fileprivate mutating func pushKeyedContainer() -> _PlistEncodedDictionary {
+        let dictionary = _PlistEncodedDictionary()
+        self.containers.append(.dictionary(dictionary))
         return dictionary
     }
 
-    fileprivate mutating func pushUnkeyedContainer() -> NSMutableArray {
-        let array = NSMutableArray()
-        self.containers.append(array)
+    fileprivate mutating func pushUnkeyedContainer() -> _PlistEncodedArray {
+        let array = _PlistEncodedArray()
+        self.containers.append(.array(array))
         return array
     }
 
-    fileprivate mutating func push(container: __owned NSObject) {
+    fileprivate mutating func push(container: __owned _PlistEncodedValue) {
         self.containers.append(container)
     }
 
-    fileprivate mutating func popContainer() -> NSObject {
+    fileprivate mutating func popContainer() -> _PlistEncodedValue {
         precondition(!self.containers.isEmpty, "Empty container stack.")
         return self.containers.popLast()!
     }
@@ -236,7 +249,7 @@ fileprivate struct _PlistKeyedEncodingContainer<K : CodingKey> : KeyedEncodingCo
     private let encoder: __PlistEncoder
 
     /// A reference to the container we're writing to.
-    private let container: NSMutableDictionary
+    private let container: _PlistEncodedDictionary
 
     /// The path of coding keys taken to get to this point in encoding.
     private(set) public var codingPath: [CodingKey]
@@ -244,7 +257,7 @@ fileprivate struct _PlistKeyedEncodingContainer<K : CodingKey> : KeyedEncodingCo
     // MARK: - Initialization
 
     /// Initializes `self` with the given references.
-    fileprivate init(referencing encoder: __PlistEncoder, codingPath: [CodingKey], wrapping container: NSMutableDictionary) {
+    fileprivate init(referencing encoder: __PlistEncoder, codingPath: [CodingKey], wrapping container: _PlistEncodedDictionary) {
         self.encoder = encoder
         self.codingPath = codingPath
         self.container = container
@@ -252,7 +265,7 @@ fileprivate struct _PlistKeyedEncodingContainer<K : CodingKey> : KeyedEncodingCo
 
     // MARK: - KeyedEncodingContainerProtocol Methods
 
-    public mutating func encodeNil(forKey key: Key)               throws { self.container[key.stringValue] = _plistNullNSString }
+    public mutating func encodeNil(forKey key: Key)               throws { self.container[key.stringValue] = .string(_plistNull) }
     public mutating func encode(_ value: Bool, forKey key: Key)   throws { self.container[key.stringValue] = self.encoder.box(value) }
     public mutating func encode(_ value: Int, forKey key: Key)    throws { self.container[key.stringValue] = self.encoder.box(value) }
     public mutating func encode(_ value: Int8, forKey key: Key)   throws { self.container[key.stringValue] = self.encoder.box(value) }
@@ -275,8 +288,8 @@ fileprivate struct _PlistKeyedEncodingContainer<K : CodingKey> : KeyedEncodingCo
     }
 
     public mutating func nestedContainer<NestedKey>(keyedBy keyType: NestedKey.Type, forKey key: Key) -> KeyedEncodingContainer<NestedKey> {
-        let dictionary = NSMutableDictionary()
-        self.container[key.stringValue] = dictionary
+        let dictionary = _PlistEncodedDictionary()
+        self.container[key.stringValue] = .dictionary(dictionary)
 
         self.codingPath.append(key)
         defer { self.codingPath.removeLast() }
@@ -286,8 +299,8 @@ fileprivate struct _PlistKeyedEncodingContainer<K : CodingKey> : KeyedEncodingCo
     }
 
     public mutating func nestedUnkeyedContainer(forKey key: Key) -> UnkeyedEncodingContainer {
-        let array = NSMutableArray()
-        self.container[key.stringValue] = array
+        let array = _PlistEncodedArray()
+        self.container[key.stringValue] = .array(array)
 
         self.codingPath.append(key)
         defer { self.codingPath.removeLast() }
@@ -310,7 +323,7 @@ fileprivate struct _PlistUnkeyedEncodingContainer : UnkeyedEncodingContainer {
     private let encoder: __PlistEncoder
 
     /// A reference to the container we're writing to.
-    private let container: NSMutableArray
+    private let container: _PlistEncodedArray
 
     /// The path of coding keys taken to get to this point in encoding.
     private(set) public var codingPath: [CodingKey]
@@ -323,7 +336,7 @@ fileprivate struct _PlistUnkeyedEncodingContainer : UnkeyedEncodingContainer {
     // MARK: - Initialization
 
     /// Initializes `self` with the given references.
-    fileprivate init(referencing encoder: __PlistEncoder, codingPath: [CodingKey], wrapping container: NSMutableArray) {
+    fileprivate init(referencing encoder: __PlistEncoder, codingPath: [CodingKey], wrapping container: _PlistEncodedArray) {
         self.encoder = encoder
         self.codingPath = codingPath
         self.container = container
@@ -331,7 +344,7 @@ fileprivate struct _PlistUnkeyedEncodingContainer : UnkeyedEncodingContainer {
 
     // MARK: - UnkeyedEncodingContainer Methods
 
-    public mutating func encodeNil()             throws { self.container.add(_plistNullNSString) }
+    public mutating func encodeNil()             throws { self.container.add(.string(_plistNull)) }
     public mutating func encode(_ value: Bool)   throws { self.container.add(self.encoder.box(value)) }
     public mutating func encode(_ value: Int)    throws { self.container.add(self.encoder.box(value)) }
     public mutating func encode(_ value: Int8)   throws { self.container.add(self.encoder.box(value)) }
@@ -357,8 +370,8 @@ fileprivate struct _PlistUnkeyedEncodingContainer : UnkeyedEncodingContainer {
         self.codingPath.append(_PlistKey(index: self.count))
         defer { self.codingPath.removeLast() }
 
-        let dictionary = NSMutableDictionary()
-        self.container.add(dictionary)
+        let dictionary = _PlistEncodedDictionary()
+        self.container.add(.dictionary(dictionary))
 
         let container = _PlistKeyedEncodingContainer<NestedKey>(referencing: self.encoder, codingPath: self.codingPath, wrapping: dictionary)
         return KeyedEncodingContainer(container)
@@ -368,8 +381,8 @@ fileprivate struct _PlistUnkeyedEncodingContainer : UnkeyedEncodingContainer {
         self.codingPath.append(_PlistKey(index: self.count))
         defer { self.codingPath.removeLast() }
 
-        let array = NSMutableArray()
-        self.container.add(array)
+        let array = _PlistEncodedArray()
+        self.container.add(.array(array))
         return _PlistUnkeyedEncodingContainer(referencing: self.encoder, codingPath: self.codingPath, wrapping: array)
     }
 
@@ -387,7 +400,7 @@ extension __PlistEncoder : SingleValueEncodingContainer {
 
     public func encodeNil() throws {
         assertCanEncodeNewValue()
-        self.storage.push(container: _plistNullNSString)
+        self.storage.push(container: .string(_plistNull))
     }
 
     public func encode(_ value: Bool) throws {
@@ -471,32 +484,32 @@ extension __PlistEncoder : SingleValueEncodingContainer {
 extension __PlistEncoder {
 
     /// Returns the given value boxed in a container appropriate for pushing onto the container stack.
-    fileprivate func box(_ value: Bool)   -> NSObject { return NSNumber(value: value) }
-    fileprivate func box(_ value: Int)    -> NSObject { return NSNumber(value: value) }
-    fileprivate func box(_ value: Int8)   -> NSObject { return NSNumber(value: value) }
-    fileprivate func box(_ value: Int16)  -> NSObject { return NSNumber(value: value) }
-    fileprivate func box(_ value: Int32)  -> NSObject { return NSNumber(value: value) }
-    fileprivate func box(_ value: Int64)  -> NSObject { return NSNumber(value: value) }
-    fileprivate func box(_ value: UInt)   -> NSObject { return NSNumber(value: value) }
-    fileprivate func box(_ value: UInt8)  -> NSObject { return NSNumber(value: value) }
-    fileprivate func box(_ value: UInt16) -> NSObject { return NSNumber(value: value) }
-    fileprivate func box(_ value: UInt32) -> NSObject { return NSNumber(value: value) }
-    fileprivate func box(_ value: UInt64) -> NSObject { return NSNumber(value: value) }
-    fileprivate func box(_ value: Float)  -> NSObject { return NSNumber(value: value) }
-    fileprivate func box(_ value: Double) -> NSObject { return NSNumber(value: value) }
-    fileprivate func box(_ value: String) -> NSObject { return NSString(string: value) }
-
-    fileprivate func box<T : Encodable>(_ value: T) throws -> NSObject {
-        return try self.box_(value) ?? NSDictionary()
-    }
-
-    fileprivate func box_<T : Encodable>(_ value: T) throws -> NSObject? {
+    fileprivate func box(_ value: Bool)   -> _PlistEncodedValue { return .bool(value) }
+    fileprivate func box(_ value: Int)    -> _PlistEncodedValue { return .integer(Int64(value)) }
+    fileprivate func box(_ value: Int8)   -> _PlistEncodedValue { return .integer(Int64(value)) }
+    fileprivate func box(_ value: Int16)  -> _PlistEncodedValue { return .integer(Int64(value)) }
+    fileprivate func box(_ value: Int32)  -> _PlistEncodedValue { return .integer(Int64(value)) }
+    fileprivate func box(_ value: Int64)  -> _PlistEncodedValue { return .integer(value) }
+    fileprivate func box(_ value: UInt)   -> _PlistEncodedValue { return .unsignedInteger(UInt64(value)) }
+    fileprivate func box(_ value: UInt8)  -> _PlistEncodedValue { return .integer(Int64(value)) }
+    fileprivate func box(_ value: UInt16) -> _PlistEncodedValue { return .integer(Int64(value)) }
+    fileprivate func box(_ value: UInt32) -> _PlistEncodedValue { return .integer(Int64(value)) }
+    fileprivate func box(_ value: UInt64) -> _PlistEncodedValue { return .unsignedInteger(value) }
+    fileprivate func box(_ value: Float)  -> _PlistEncodedValue { return .float(value) }
+    fileprivate func box(_ value: Double) -> _PlistEncodedValue { return .double(value) }
+    fileprivate func box(_ value: String) -> _PlistEncodedValue { return .string(value) }
+
+    fileprivate func box<T : Encodable>(_ value: T) throws -> _PlistEncodedValue {
+        return try self.box_(value) ?? .dictionary(_PlistEncodedDictionary())
+    }
+
+    fileprivate func box_<T : Encodable>(_ value: T) throws -> _PlistEncodedValue? {
         if T.self == Date.self || T.self == NSDate.self {
-            // PropertyListSerialization handles NSDate directly.
-            return (value as! NSDate)
+            // Property lists handle dates directly.
+            return .date((value as! NSDate)._swiftObject)
         } else if T.self == Data.self || T.self == NSData.self {
-            // PropertyListSerialization handles NSData directly.
-            return (value as! NSData)
+            // Property lists handle data directly.
+            return .data((value as! NSData)._swiftObject)
         }
 
         // The value should request a container from the __PlistEncoder.
@@ -534,10 +547,10 @@ fileprivate class __PlistReferencingEncoder : __PlistEncoder {
     /// The type of container we're referencing.
     private enum Reference {
         /// Referencing a specific index in an array container.
-        case array(NSMutableArray, Int)
+        case array(_PlistEncodedArray, Int)
 
         /// Referencing a specific key in a dictionary container.
-        case dictionary(NSMutableDictionary, String)
+        case dictionary(_PlistEncodedDictionary, String)
     }
 
     // MARK: - Properties
@@ -551,7 +564,7 @@ fileprivate class __PlistReferencingEncoder : __PlistEncoder {
     // MARK: - Initialization
 
     /// Initializes `self` by referencing the given array container in the given encoder.
-    fileprivate init(referencing encoder: __PlistEncoder, at index: Int, wrapping array: NSMutableArray) {
+    fileprivate init(referencing encoder: __PlistEncoder, at index: Int, wrapping array: _PlistEncodedArray) {
         self.encoder = encoder
         self.reference = .array(array, index)
         super.init(options: encoder.options, codingPath: encoder.codingPath)
@@ -560,7 +573,7 @@ fileprivate class __PlistReferencingEncoder : __PlistEncoder {
     }
 
     /// Initializes `self` by referencing the given dictionary container in the given encoder.
-    fileprivate init(referencing encoder: __PlistEncoder, at key: CodingKey, wrapping dictionary: NSMutableDictionary) {
+    fileprivate init(referencing encoder: __PlistEncoder, at key: CodingKey, wrapping dictionary: _PlistEncodedDictionary) {
         self.encoder = encoder
         self.reference = .dictionary(dictionary, key.stringValue)
         super.init(options: encoder.options, codingPath: encoder.codingPath)
@@ -581,9 +594,9 @@ fileprivate class __PlistReferencingEncoder : __PlistEncoder {
 
     // Finalizes `self` by writing the contents of our storage to the referenced encoder's storage.
     deinit {
-        let value: Any
+        let value: _PlistEncodedValue
         switch self.storage.count {
-        case 0: value = NSDictionary()
+        case 0: value = .dictionary(_PlistEncodedDictionary())
         case 1: value = self.storage.popContainer()
         default: fatalError("Referencing encoder deallocated with multiple containers on stack.")
         }
@@ -593,7 +606,304 @@ fileprivate class __PlistReferencingEncoder : __PlistEncoder {
             array.insert(value, at: index)
 
         case .dictionary(let dictionary, let key):
-            dictionary[NSString(string: key)] = value
+            dictionary[key] = value
+        }
+    }
+}
+
+// MARK: - Encoded Values
+
+/// A property list value produced by `__PlistEncoder`.
+/// Arrays and dictionaries are boxed so that containers handed out to an `Encodable` value keep writing into the same storage; everything else is stored inline.
+fileprivate enum _PlistEncodedValue {
+    case string(String)
+    case bool(Bool)
+    case integer(Int64)
+    case unsignedInteger(UInt64)
+    case float(Float)
+    case double(Double)
+    case date(Date)
+    case data(Data)
+    case array(_PlistEncodedArray)
+    case dictionary(_PlistEncodedDictionary)
+
+    /// The equivalent Foundation property list object, for the formats written by `PropertyListSerialization`.
+    fileprivate var propertyListObject: NSObject {
+        switch self {
+        case .string(let value):          return NSString(string: value)
+        case .bool(let value):            return NSNumber(value: value)
+        case .integer(let value):         return NSNumber(value: value)
+        case .unsignedInteger(let value): return NSNumber(value: value)
+        case .float(let value):           return NSNumber(value: value)
+        case .double(let value):          return NSNumber(value: value)
+        case .date(let value):            return value._nsObject
+        case .data(let value):            return value._nsObject
+        case .array(let array):
+            return NSArray(array: array.elements.map { $0.propertyListObject })
+        case .dictionary(let dictionary):
+            let result = NSMutableDictionary(capacity: dictionary.elements.count)
+            for (key, value) in dictionary.elements {
+                result[NSString(string: key)] = value.propertyListObject
+            }
+            return result
+        }
+    }
+}
+
+fileprivate final class _PlistEncodedArray {
+    fileprivate var elements: [_PlistEncodedValue] = []
+
+    fileprivate var count: Int {
+        return self.elements.count
+    }
+
+    fileprivate func add(_ value: __owned _PlistEncodedValue) {
+        self.elements.append(value)
+    }
+
+    fileprivate func insert(_ value: __owned _PlistEncodedValue, at index: Int) {
+        self.elements.insert(value, at: index)
+    }
+}
+
+fileprivate final class _PlistEncodedDictionary {
+    fileprivate var elements: [String : _PlistEncodedValue] = [:]
+
+    fileprivate subscript(key: String) -> _PlistEncodedValue? {
+        get { return self.elements[key] }
+        set { self.elements[key] = newValue }
+    }
+}
+
+// MARK: - Binary Property List Writer
+
+/// Writes encoded values straight into the binary property list format, following the rules `__CFBinaryPlistWrite` uses.
+///
+/// Strings, numbers, dates and data are uniqued by value. Integers take the smallest unsigned width that holds them, except that negative values always take eight bytes and values above `Int64.max` take sixteen. Object references and offsets take the smallest width that holds the object count and the offset table's position.
+///
+/// The reference width depends on the total number of objects, so the values are walked twice: once to number them and once to write them. Objects are numbered in post-order so that a container's children have already been written when the container itself is.
+fileprivate struct _BinaryPlistWriter {
+    /// The key objects are uniqued by.
+    /// Floating point values are compared by bit pattern so that distinct NaNs and signed zeros survive.
+    private enum _UniquingKey : Hashable {
+        case string(_StringKey)
+        case bool(Bool)
+        case integer(Int64)
+        case unsignedInteger(UInt64)
+        case float(UInt32)
+        case double(UInt64)
+        case date(UInt64)
+        case data(Data)
+    }
+
+    /// Strings compare by their Unicode scalars rather than by canonical equivalence, as `CFEqual` does; otherwise differently normalized strings would be merged into one object.
+    private struct _StringKey : Hashable {
+        let string: String
+
+        static func ==(lhs: _StringKey, rhs: _StringKey) -> Bool {
+            return lhs.string.utf8.elementsEqual(rhs.string.utf8)
+        }
+
+        func hash(into hasher: inout Hasher) {
+            for byte in self.string.utf8 {
+                hasher.combine(byte)
+            }
+        }
+    }
+
+    private var output: [UInt8] = []
+    private var offsets: [Int] = []
+    private var uniqued: [_UniquingKey : Int] = [:]
+    private var objectCount = 0
+    private var referenceSize = 1
+
+    static func data(for value: _PlistEncodedValue) -> Data {
+        var writer = _BinaryPlistWriter()
+        writer.number(value)
+        writer.referenceSize = _BinaryPlistWriter.byteCount(UInt64(writer.objectCount))
+        writer.offsets.reserveCapacity(writer.objectCount)
+
+        writer.output.append(contentsOf: Array("bplist00".utf8))
+        let topObject = writer.write(value)
+        assert(writer.offsets.count == writer.objectCount, "Objects written do not match objects numbered")
+
+        let offsetTableOffset = writer.output.count
+        let offsetSize = _BinaryPlistWriter.byteCount(UInt64(offsetTableOffset))
+        for offset in writer.offsets {
+            writer.append(UInt64(offset), size: offsetSize)
+        }
+
+        // Trailer: five unused bytes, the sort version, the two widths, then the object count, top object and offset table position.
+        writer.output.append(contentsOf: repeatElement(0, count: 6))
+        writer.output.append(UInt8(offsetSize))
+        writer.output.append(UInt8(writer.referenceSize))
+        writer.append(UInt64(writer.objectCount), size: 8)
+        writer.append(UInt64(topObject), size: 8)
+        writer.append(UInt64(offsetTableOffset), size: 8)
+        return Data(writer.output)
+    }
+
+    private static func byteCount(_ value: UInt64) -> Int {
+        if value < 1 << 8 { return 1 }
+        if value < 1 << 16 { return 2 }
+        if value < 1 << 32 { return 4 }
+        return 8
+    }
+
+    private static func uniquingKey(for value: _PlistEncodedValue) -> _UniquingKey {
+        switch value {
+        case .string(let value):          return .string(_StringKey(string: value))
+        case .bool(let value):            return .bool(value)
+        case .integer(let value):         return .integer(value)
+        case .unsignedInteger(let value): return .unsignedInteger(value)
+        case .float(let value):           return .float(value.bitPattern)
+        case .double(let value):          return .double(value.bitPattern)
+        case .date(let value):            return .date(value.timeIntervalSinceReferenceDate.bitPattern)
+        case .data(let value):            return .data(value)
+        case .array, .dictionary:         fatalError("Containers are not uniqued")
+        }
+    }
+
+    // MARK: Numbering
+
+    private mutating func number(_ value: _PlistEncodedValue) {
+        switch value {
+        case .array(let array):
+            for element in array.elements {
+                number(element)
+            }
+            objectCount += 1
+        case .dictionary(let dictionary):
+            for (key, element) in dictionary.elements {
+                number(.string(key))
+                number(element)
+            }
+            objectCount += 1
+        default:
+            let key = _BinaryPlistWriter.uniquingKey(for: value)
+            if uniqued[key] == nil {
+                uniqued[key] = objectCount
+                objectCount += 1
+            }
+        }
+    }
+
+    // MARK: Writing
+
+    /// Writes `value` unless an equal object was already written, and returns its object number.
+    private mutating func write(_ value: _PlistEncodedValue) -> Int {
+        switch value {
+        case .array(let array):
+            var references: [Int] = []
+            references.reserveCapacity(array.count)
+            for element in array.elements {
+                references.append(write(element))
+            }
+            let object = beginObject()
+            appendMarker(0xA0, count: references.count)
+            for reference in references {
+                append(UInt64(reference), size: referenceSize)
+            }
+            return object
+
+        case .dictionary(let dictionary):
+            var keys: [Int] = []
+            var values: [Int] = []
+            keys.reserveCapacity(dictionary.elements.count)
+            values.reserveCapacity(dictionary.elements.count)
+            for (key, element) in dictionary.elements {
+                keys.append(write(.string(key)))
+                values.append(write(element))
+            }
+            let object = beginObject()
+            appendMarker(0xD0, count: keys.count)
+            for reference in keys {
+                append(UInt64(reference), size: referenceSize)
+            }
+            for reference in values {
+                append(UInt64(reference), size: referenceSize)
+            }
+            return object
+
+        default:
+            let object = uniqued[_BinaryPlistWriter.uniquingKey(for: value)]!
+            // Objects are numbered in the order they are first reached, so a value not yet written is always the next one.
+            if object == offsets.count {
+                _ = beginObject()
+                appendScalar(value)
+            }
+            return object
+        }
+    }
+
+    private mutating func beginObject() -> Int {
+        offsets.append(output.count)
+        return offsets.count - 1
+    }
+
+    private mutating func appendScalar(_ value: _PlistEncodedValue) {
+        switch value {
+        case .string(let string):
+            if string.utf8.allSatisfy({ $0 < 0x80 }) {
+                appendMarker(0x50, count: string.utf8.count)
+                output.append(contentsOf: string.utf8)
+            } else {
+                appendMarker(0x60, count: string.utf16.count)
+                for unit in string.utf16 {
+                    append(UInt64(unit), size: 2)
+                }
+            }
+        case .bool(let value):
+            output.append(value ? 0x09 : 0x08)
+        case .integer(let value):
+            appendInteger(UInt64(bitPattern: value))
+        case .unsignedInteger(let value):
+            if value > UInt64(Int64.max) {
+                // Eight byte integers are read back as signed, so larger values need the sixteen byte form.
+                output.append(0x14)
+                append(0, size: 8)
+                append(value, size: 8)
+            } else {
+                appendInteger(value)
+            }
+        case .float(let value):
+            output.append(0x22)
+            append(UInt64(value.bitPattern), size: 4)
+        case .double(let value):
+            output.append(0x23)
+            append(value.bitPattern, size: 8)
+        case .date(let value):
+            output.append(0x33)
+            append(value.timeIntervalSinceReferenceDate.bitPattern, size: 8)
+        case .data(let value):
+            appendMarker(0x40, count: value.count)
+            output.append(contentsOf: value)
+        case .array, .dictionary:
+            fatalError("Containers are not scalars")
+        }
+    }
+
+    private mutating func appendInteger(_ value: UInt64) {
+        let size = _BinaryPlistWriter.byteCount(value)
+        output.append(0x10 | UInt8(size.trailingZeroBitCount))
+        append(value, size: size)
+    }
+
+    private mutating func appendMarker(_ marker: UInt8, count: Int) {
+        if count < 15 {
+            output.append(marker | UInt8(count))
+        } else {
+            output.append(marker | 0x0F)
+            appendInteger(UInt64(count))
+        }
+    }
+
+    /// Appends the low `size` bytes of `value` in big-endian order.
+    private mutating func append(_ value: UInt64, size: Int) {
+        var shift = (size - 1) * 8
+        while shift >= 0 {
+            output.append(UInt8(truncatingIfNeeded: value >> UInt64(shift)))
+            shift -= 8
         }
     }
 }
@@ -652,6 +962,13 @@ open class PropertyListDecoder {
     /// - throws: `DecodingError.dataCorrupted` if values requested from the payload are corrupted, or if the given data is not a valid property list.
     /// - throws: An error if any value throws an error during decoding.
     open func decode<T : Decodable>(_ type: T.Type, from data: Data, format: inout PropertyListSerialization.PropertyListFormat) throws -> T {
+        // Binary property lists are read straight into Swift values; anything
+        // the direct reader declines goes through PropertyListSerialization.
+        if let topLevel = _BinaryPlistReader.read(data) {
+            format = .binary
+            return try decode(type, fromTopLevel: topLevel)
+        }
+
         let topLevel: Any
         do {
             topLevel = try PropertyListSerialization.propertyList(from: data, options: [], format: &format)
@@ -679,6 +996,204 @@ open class PropertyListDecoder {
     }
 }
 
+// MARK: - Binary Property List Reader
+
+/// Reads a binary property list straight into the values `__PlistDecoder` unboxes, without creating CF objects or bridging them.
+///
+/// Objects are read once and shared between every reference to them, as `__CFBinaryPlistCreateObject` does. Anything the decoder could not use anyway or that is not understood here (sets, UIDs, non-string keys, integers wider than 64 bits, deeply nested or malformed input) yields `nil`, and the caller falls back to `PropertyListSerialization`, which reports the appropriate error.
+fileprivate struct _BinaryPlistReader {
+    private static let trailerSize = 32
+    private static let maximumDepth = 512
+
+    private let bytes: UnsafeRawBufferPointer
+    private let offsetSize: Int
+    private let referenceSize: Int
+    private let objectCount: Int
+    private let offsetTableOffset: Int
+    private let topObject: Int
+
+    /// The end of the object data.
+    private let objectsEnd: Int
+    private var objects: [Any?]
+
+    static func read(_ data: Data) -> Any? {
+        return data.withUnsafeBytes { (buffer: UnsafeRawBufferPointer) -> Any? in
+            guard var reader = _BinaryPlistReader(buffer) else {
+                return nil
+            }
+            return reader.object(reader.topObject, depth: 0)
+        }
+    }
+
+    private init?(_ bytes: UnsafeRawBufferPointer) {
+        // Header, at least one object byte and the trailer.
+        guard bytes.count >= 8 + 1 + _BinaryPlistReader.trailerSize, bytes.starts(with: "bplist0".utf8) else {
+            return nil
+        }
+        let trailer = bytes.count - _BinaryPlistReader.trailerSize
+        self.bytes = bytes
+        self.offsetSize = Int(bytes[trailer + 6])
+        self.referenceSize = Int(bytes[trailer + 7])
+        self.objectsEnd = trailer
+
+        let objectCount = _BinaryPlistReader.readUInt(bytes, at: trailer + 8, size: 8)
+        let topObject = _BinaryPlistReader.readUInt(bytes, at: trailer + 16, size: 8)
+        let offsetTableOffset = _BinaryPlistReader.readUInt(bytes, at: trailer + 24, size: 8)
+        guard (1...8).contains(offsetSize), (1...8).contains(referenceSize),
+              objectCount > 0, topObject < objectCount,
+              offsetTableOffset >= 9, offsetTableOffset < UInt64(trailer),
+              objectCount <= UInt64(trailer - Int(offsetTableOffset)) / UInt64(offsetSize) else {
+            return nil
+        }
+        self.objectCount = Int(objectCount)
+        self.topObject = Int(topObject)
+        self.offsetTableOffset = Int(offsetTableOffset)
+        self.objects = Array(repeating: nil, count: self.objectCount)
+    }
+
+    /// Reads a big-endian unsigned integer; the caller has checked the bounds.
+    private static func readUInt(_ bytes: UnsafeRawBufferPointer, at offset: Int, size: Int) -> UInt64 {
+        var result: UInt64 = 0
+        for index in offset..<(offset + size) {
+            result = result << 8 | UInt64(bytes[index])
+        }
+        return result
+    }
+
+    /// Returns whether `count` elements of `size` bytes starting at `offset` lie within the object data.
+    private func fits(_ count: Int, of size: Int, at offset: Int) -> Bool {
+        return offset <= objectsEnd && count <= (objectsEnd - offset) / size
+    }
+
+    /// Reads the element count that follows a marker whose low nibble is 0xF, or returns the nibble itself, along with where the elements start.
+    private func elementCount(at offset: Int) -> (count: Int, start: Int)? {
+        let nibble = Int(bytes[offset] & 0x0F)
+        guard nibble == 0x0F else {
+            return (nibble, offset + 1)
+        }
+        guard fits(1, of: 1, at: offset + 1) else { return nil }
+        let marker = bytes[offset + 1]
+        let size = 1 << Int(marker & 0x0F)
+        guard marker & 0xF0 == 0x10, size <= 8, fits(size, of: 1, at: offset + 2) else { return nil }
+        let count = _BinaryPlistReader.readUInt(bytes, at: offset + 2, size: size)
+        guard count <= UInt64(Int.max) else { return nil }
+        return (Int(count), offset + 2 + size)
+    }
+
+    private func references(count: Int, at offset: Int) -> [Int]? {
+        guard fits(count, of: referenceSize, at: offset) else { return nil }
+        var references: [Int] = []
+        references.reserveCapacity(count)
+        for index in 0..<count {
+            let reference = _BinaryPlistReader.readUInt(bytes, at: offset + index * referenceSize, size: referenceSize)
+            guard reference < UInt64(objectCount) else { return nil }
+            references.append(Int(reference))
+        }
+        return references
+    }
+
+    private mutating func object(_ reference: Int, depth: Int) -> Any? {
+        if let object = objects[reference] {
+            return object
+        }
+        // Running out of depth is also how reference cycles end up being rejected.
+        guard depth < _BinaryPlistReader.maximumDepth else { return nil }
+
+        let offset = Int(_BinaryPlistReader.readUInt(bytes, at: offsetTableOffset + reference * offsetSize, size: offsetSize))
+        guard offset >= 8, offset < objectsEnd else { return nil }
+        let marker = bytes[offset]
+
+        let result: Any
+        switch marker >> 4 {
+        case 0x0:
+            switch marker {
+            case 0x00: result = NSNull()
+            case 0x08: result = NSNumber(value: false)
+            case 0x09: result = NSNumber(value: true)
+            default: return nil
+            }
+
+        case 0x1:
+            let size = 1 << Int(marker & 0x0F)
+            guard fits(size, of: 1, at: offset + 1) else { return nil }
+            switch size {
+            case 1, 2, 4:
+                result = NSNumber(value: Int64(_BinaryPlistReader.readUInt(bytes, at: offset + 1, size: size)))
+            case 8:
+                result = NSNumber(value: Int64(bitPattern: _BinaryPlistReader.readUInt(bytes, at: offset + 1, size: 8)))
+            case 16:
+                guard _BinaryPlistReader.readUInt(bytes, at: offset + 1, size: 8) == 0 else { return nil }
+                result = NSNumber(value: _BinaryPlistReader.readUInt(bytes, at: offset + 9, size: 8))
+            default:
+                return nil
+            }
+
+        case 0x2:
+            switch marker & 0x0F {
+            case 2 where fits(4, of: 1, at: offset + 1):
+                result = NSNumber(value: Float(bitPattern: UInt32(_BinaryPlistReader.readUInt(bytes, at: offset + 1, size: 4))))
+            case 3 where fits(8, of: 1, at: offset + 1):
+                result = NSNumber(value: Double(bitPattern: _BinaryPlistReader.readUInt(bytes, at: offset + 1, size: 8)))
+            default:
+                return nil
+            }
+
+        case 0x3:
+            guard marker == 0x33, fits(8, of: 1, at: offset + 1) else { return nil }
+            result = Date(timeIntervalSinceReferenceDate: Double(bitPattern: _BinaryPlistReader.readUInt(bytes, at: offset + 1, size: 8)))
+
+        case 0x4:
+            guard let (count, start) = elementCount(at: offset), fits(count, of: 1, at: start) else { return nil }
+            result = Data(bytes[start..<(start + count)])
+
+        case 0x5:
+            guard let (count, start) = elementCount(at: offset), fits(count, of: 1, at: start) else { return nil }
+            let characters = bytes[start..<(start + count)]
+            guard !characters.contains(where: { $0 >= 0x80 }) else { return nil }
+            result = String(decoding: characters, as: UTF8.self)
+
+        case 0x6:
+            guard let (count, start) = elementCount(at: offset), fits(count, of: 2, at: start) else { return nil }
+            let bytes = self.bytes
+            let units = (0..<count).lazy.map { UInt16(_BinaryPlistReader.readUInt(bytes, at: start + $0 * 2, size: 2)) }
+            result = String(decoding: units, as: UTF16.self)
+
+        case 0xA:
+            guard let (count, start) = elementCount(at: offset), let references = references(count: count, at: start) else { return nil }
+            var array: [Any] = []
+            array.reserveCapacity(count)
+            for reference in references {
+                guard let element = object(reference, depth: depth + 1) else { return nil }
+                array.append(element)
+            }
+            result = array
+
+        case 0xD:
+            guard let (count, start) = elementCount(at: offset),
+                  let keys = references(count: count, at: start),
+                  let values = references(count: count, at: start + count * referenceSize) else {
+                return nil
+            }
+            var dictionary: [String : Any] = [:]
+            dictionary.reserveCapacity(count)
+            for (key, value) in zip(keys, values) {
+                guard let key = object(key, depth: depth + 1) as? String,
+                      let value = object(value, depth: depth + 1) else {
+                    return nil
+                }
+                dictionary[key] = value
+            }
+            result = dictionary
+
+        default:
+            return nil
+        }
+
+        objects[reference] = result
+        return result
+    }
+}
+
 // MARK: - __PlistDecoder
 
 // NOTE: older overlays called this class _PlistDecoder. The two must
@@ -1804,7 +2319,6 @@ extension __PlistDecoder {
 
 // Since plists do not support null values by default, we will encode them as "$null".
 fileprivate let _plistNull = "$null"
-fileprivate let _plistNullNSString = NSString(string: _plistNull)
 
 //===----------------------------------------------------------------------===//
 // Shared Key Types
@@ -111,4 +111,107 @@ open class PropertyListSerialization : NSObject {
     open class func propertyList(with stream: InputStream, options opt: ReadOptions = [], format: UnsafeMutablePointer<PropertyListFormat>?) throws -> Any {
         return try propertyList(with: stream._stream, options: opt, format: format)
     }
+
+    /// The top level object of a binary property list, decoded on demand.
+    internal class func _lazyPropertyList(from data: Data) throws -> _BinaryPropertyListReader.Object {
+        return try _BinaryPropertyListReader(data: data).topLevelObject
+    }
+
+    internal class func _lazyPropertyList(contentsOf url: URL) throws -> _BinaryPropertyListReader.Object {
+        return try _BinaryPropertyListReader(contentsOf: url).topLevelObject
+    }
+}
+
+/// A binary property list read in place. Values are only decoded when they are
+/// asked for, so pulling a few keys out of a large file does not pay for the rest
+/// of it. Files are memory mapped where the platform allows.
+internal final class _BinaryPropertyListReader {
+    fileprivate let _reader: _CFBinaryPlistReaderRef
+
+    init(contentsOf url: URL) throws {
+        var error: Unmanaged<CFError>? = nil
+        guard let reader = _CFBinaryPlistReaderCreateWithContentsOfFile(kCFAllocatorSystemDefault, url.path._cfObject, &error) else {
+            throw error!.takeRetainedValue()._nsObject
+        }
+        _reader = reader
+    }
+
+    init(data: Data) throws {
+        var error: Unmanaged<CFError>? = nil
+        guard let reader = _CFBinaryPlistReaderCreateWithData(kCFAllocatorSystemDefault, data._cfObject, &error) else {
+            throw error!.takeRetainedValue()._nsObject
+        }
+        _reader = reader
+    }
+
+    deinit {
+        _CFBinaryPlistReaderRelease(_reader)
+    }
+
+    var topLevelObject: Object {
+        return Object(reader: self, offset: _CFBinaryPlistReaderGetTopLevelObject(_reader))
+    }
+
+    /// A value in the property list that has not been decoded yet.
+    struct Object {
+        fileprivate let reader: _BinaryPropertyListReader
+        fileprivate let offset: UInt64
+
+        var isDictionary: Bool {
+            return _CFBinaryPlistReaderGetTypeID(reader._reader, offset) == CFDictionaryGetTypeID()
+        }
+
+        var isArray: Bool {
+            return _CFBinaryPlistReaderGetTypeID(reader._reader, offset) == CFArrayGetTypeID()
+        }
+
+        /// The number of elements of an array or set or of entries of a dictionary, or nil for any other value.
+        var count: Int? {
+            let count = _CFBinaryPlistReaderGetCount(reader._reader, offset)
+            return count < 0 ? nil : count
+        }
+
+        subscript(key: String) -> Object? {
+            var value: UInt64 = 0
+            guard _CFBinaryPlistReaderGetObjectForKey(reader._reader, offset, key._cfObject, &value) else {
+                return nil
+            }
+            return Object(reader: reader, offset: value)
+        }
+
+        subscript(index: Int) -> Object? {
+            var value: UInt64 = 0
+            guard _CFBinaryPlistReaderGetObjectAtIndex(reader._reader, offset, index, &value) else {
+                return nil
+            }
+            return Object(reader: reader, offset: value)
+        }
+
+        /// Decodes the keys of a dictionary but none of its values.
+        func keys() throws -> [String] {
+            guard isDictionary, let count = count else {
+                throw NSError(domain: NSCocoaErrorDomain, code: CocoaError.propertyListReadCorrupt.rawValue, userInfo: ["NSDebugDescription" : "Value is not a dictionary"])
+            }
+            var keys: [String] = []
+            keys.reserveCapacity(count)
+            for index in 0..<count {
+                var key: UInt64 = 0
+                var value: UInt64 = 0
+                guard _CFBinaryPlistReaderGetKeyAndObjectAtIndex(reader._reader, offset, index, &key, &value),
+                    let decoded = try Object(reader: reader, offset: key).value() as? String else {
+                    throw NSError(domain: NSCocoaErrorDomain, code: CocoaError.propertyListReadCorrupt.rawValue, userInfo: ["NSDebugDescription" : "Dictionary key is not a string"])
+                }
+                keys.append(decoded)
+            }
+            return keys
+        }
+
+        /// Decodes this value and everything it contains.
+        func value(options opt: PropertyListSerialization.ReadOptions = []) throws -> Any {
+            guard let plist = _CFBinaryPlistReaderCopyObject(reader._reader, offset, CFOptionFlags(CFIndex(opt.rawValue))) else {
+                throw NSError(domain: NSCocoaErrorDomain, code: CocoaError.propertyListReadCorrupt.rawValue, userInfo: ["NSDebugDescription" : "Binary property list is corrupt"])
+            }
+            return __SwiftValue.fetch(nonOptional: plist)
+        }
+    }
 }
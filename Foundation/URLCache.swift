@@ -152,9 +152,111 @@ open class CachedURLResponse : NSObject, NSCopying {
     }
 }
 
+private class _URLCacheMemoryEntry {
+    let key: String
+    let cachedResponse: CachedURLResponse
+    let date: Date
+    let cost: Int
+    weak var newer: _URLCacheMemoryEntry?
+    var older: _URLCacheMemoryEntry?
+    init(key: String, cachedResponse: CachedURLResponse, date: Date, cost: Int) {
+        self.key = key
+        self.cachedResponse = cachedResponse
+        self.date = date
+        self.cost = cost
+    }
+}
+
+/// The location of one response in the on-disk data file. A record is the
+/// encoded response metadata immediately followed by the body bytes. The
+/// metadata starts with the record's key and body length, so a record can
+/// be checked against the index entry that points at it.
+private struct _URLCacheDiskEntry {
+    let offset: Int
+    let metadataLength: Int
+    let bodyLength: Int
+    let date: Date
+    var length: Int {
+        return metadataLength + bodyLength
+    }
+}
+
+private enum _URLCacheDecodingError : Error {
+    case truncated
+    case invalid
+}
+
+/// Little-endian encoder for the disk tier's index and record metadata.
+private struct _URLCacheEncoder {
+    var data = Data()
+
+    mutating func encode<T: FixedWidthInteger>(_ value: T) {
+        var littleEndian = value.littleEndian
+        withUnsafeBytes(of: &littleEndian) { data.append(contentsOf: $0) }
+    }
+
+    mutating func encode(_ string: String) {
+        let bytes = Array(string.utf8)
+        encode(UInt32(bytes.count))
+        data.append(contentsOf: bytes)
+    }
+
+    mutating func encode(_ string: String?) {
+        if let string = string {
+            encode(UInt8(1))
+            encode(string)
+        } else {
+            encode(UInt8(0))
+        }
+    }
+}
+
+private struct _URLCacheDecoder {
+    let bytes: [UInt8]
+    var cursor = 0
+
+    init(_ bytes: [UInt8]) {
+        self.bytes = bytes
+    }
+
+    var isAtEnd: Bool {
+        return cursor == bytes.count
+    }
+
+    mutating func decode<T: FixedWidthInteger>(_ type: T.Type) throws -> T {
+        let size = MemoryLayout<T>.size
+        guard cursor + size <= bytes.count else { throw _URLCacheDecodingError.truncated }
+        var value: T = 0
+        for byteIndex in 0..<size {
+            value |= T(bytes[cursor + byteIndex]) << (8 * byteIndex)
+        }
+        cursor += size
+        return value
+    }
+
+    mutating func decodeString() throws -> String {
+        let count = Int(try decode(UInt32.self))
+        guard cursor + count <= bytes.count else { throw _URLCacheDecodingError.truncated }
+        let string = String(decoding: bytes[cursor..<(cursor + count)], as: UTF8.self)
+        cursor += count
+        return string
+    }
+
+    mutating func decodeOptionalString() throws -> String? {
+        switch try decode(UInt8.self) {
+        case 0: return nil
+        case 1: return try decodeString()
+        default: throw _URLCacheDecodingError.invalid
+        }
+    }
+}
+
 open class URLCache : NSObject {
-    
-    /*! 
+
+    private static let _sharedLock = NSLock()
+    private static var _shared: URLCache?
+
+    /*!
         @method sharedURLCache
         @abstract Returns the shared URLCache instance.
         @discussion Unless set explicitly, this method returns an URLCache
@@ -162,7 +264,7 @@ open class URLCache : NSObject {
         <ul>
         <li>Memory capacity: 4 megabytes (4 * 1024 * 1024 bytes)
         <li>Disk capacity: 20 megabytes (20 * 1024 * 1024 bytes)
-        <li>Disk path: <nobr>(user home directory)/Library/Caches/(application bundle id)</nobr> 
+        <li>Disk path: <nobr>(user home directory)/Library/Caches/(application bundle id)</nobr>
         </ul>
         <p>Users who do not have special caching requirements or
         constraints should find the default shared cache instance
@@ -173,14 +275,52 @@ open class URLCache : NSObject {
     */
     open class var shared: URLCache {
         get {
-            NSUnimplemented()
+            _sharedLock.lock()
+            defer { _sharedLock.unlock() }
+            if let shared = _shared {
+                return shared
+            }
+            let shared = URLCache(memoryCapacity: 4 * 1024 * 1024, diskCapacity: 20 * 1024 * 1024, diskPath: nil)
+            _shared = shared
+            return shared
         }
         set {
-            NSUnimplemented()
+            _sharedLock.lock()
+            _shared = newValue
+            _sharedLock.unlock()
         }
     }
 
-    /*! 
+    private let _lock = NSLock()
+
+    // Memory tier: entries by key, also threaded on a list from the most
+    // (_newest) to the least (_oldest) recently used so that lookups move an
+    // entry to the front and eviction takes from the back, both in O(1).
+    private var _memoryEntries = [String: _URLCacheMemoryEntry]()
+    private var _newest: _URLCacheMemoryEntry?
+    private var _oldest: _URLCacheMemoryEntry?
+    private var _memoryUsage = 0
+
+    // Disk tier: an append-only data file of records, read through a memory
+    // mapping, and a compact index file mapping keys to record locations.
+    // Replaced and removed records stay in the data file as garbage until it
+    // outgrows the disk capacity, at which point the live records are
+    // rewritten into a new file.
+    //
+    // Caches with the same disk path share these files, without coordinating
+    // with each other: each one writes its own index, and a compaction by one
+    // moves the records the others point at. Every record read is therefore
+    // checked against its key and length, and a record that no longer matches
+    // is treated as missing.
+    private let _diskDirectory: URL?
+    private var _diskEntries = [String: _URLCacheDiskEntry]()
+    private var _diskFileSize = 0
+    private var _diskIndexLoaded = false
+    private var _mappedDataFile: NSData?
+
+    private static let _indexMagic = Array("UCI2".utf8)
+
+    /*!
         @method initWithMemoryCapacity:diskCapacity:diskPath:
         @abstract Initializes an URLCache with the given capacity and
         path.
@@ -193,9 +333,46 @@ open class URLCache : NSObject {
         @result an initialized URLCache, with the given capacity, backed
         by disk.
     */
-    public init(memoryCapacity: Int, diskCapacity: Int, diskPath path: String?) { NSUnimplemented() }
-    
-    /*! 
+    public init(memoryCapacity: Int, diskCapacity: Int, diskPath path: String?) {
+        self.memoryCapacity = memoryCapacity
+        self.diskCapacity = diskCapacity
+        // A cache created without disk capacity is memory-only, so it never
+        // touches a directory that another cache may be using.
+        self._diskDirectory = diskCapacity > 0 ? URLCache._diskDirectory(forPath: path) : nil
+        super.init()
+    }
+
+    /// Relative paths, and the default nil path, are resolved against a
+    /// per-application directory inside the user's caches directory.
+    private static func _diskDirectory(forPath path: String?) -> URL? {
+        if let path = path, NSString(string: path).isAbsolutePath {
+            return URL(fileURLWithPath: path, isDirectory: true)
+        }
+        guard let cachesDirectory = FileManager.default.urls(for: .cachesDirectory, in: .userDomainMask).first else {
+            return nil
+        }
+        var bundleName = Bundle.main.bundlePath.components(separatedBy: "/").last!
+        if let range = bundleName.range(of: ".", options: .backwards, range: nil, locale: nil) {
+            bundleName = String(bundleName[..<range.lowerBound])
+        }
+        return cachesDirectory
+            .appendingPathComponent(Bundle.main.bundleIdentifier ?? bundleName, isDirectory: true)
+            .appendingPathComponent(path ?? "org.swift.foundation.URLCache", isDirectory: true)
+    }
+
+    private var _dataFileURL: URL? {
+        return _diskDirectory?.appendingPathComponent("Cache.data")
+    }
+
+    private var _indexFileURL: URL? {
+        return _diskDirectory?.appendingPathComponent("Cache.index")
+    }
+
+    private static func _key(for request: URLRequest) -> String? {
+        return request.url?.absoluteString
+    }
+
+    /*!
         @method cachedResponseForRequest:
         @abstract Returns the NSCachedURLResponse stored in the cache with
         the given request.
@@ -206,79 +383,478 @@ open class URLCache : NSObject {
         request, or nil if there is no NSCachedURLResponse stored with the
         given request.
     */
-    open func cachedResponse(for request: URLRequest) -> CachedURLResponse? { NSUnimplemented() }
-    
-    /*! 
+    open func cachedResponse(for request: URLRequest) -> CachedURLResponse? {
+        return _cachedResponseAndDate(for: request)?.cachedResponse
+    }
+
+    /// Looks up a response together with the date it was stored, which the
+    /// URL loading system needs to decide whether it is still fresh.
+    internal func _cachedResponseAndDate(for request: URLRequest) -> (cachedResponse: CachedURLResponse, date: Date)? {
+        guard let key = URLCache._key(for: request) else { return nil }
+        _lock.lock()
+        defer { _lock.unlock() }
+
+        if let entry = _memoryEntries[key] {
+            _unlinkMemoryEntry(entry)
+            _linkMemoryEntryAsNewest(entry)
+            return (entry.cachedResponse, entry.date)
+        }
+
+        guard diskCapacity > 0 else { return nil }
+        _loadDiskIndexIfNeeded()
+        guard let diskEntry = _diskEntries[key] else { return nil }
+        guard let cachedResponse = _readDiskEntry(diskEntry, key: key) else {
+            // The record is unreadable; forget about it
+            _diskEntries[key] = nil
+            _writeDiskIndex()
+            return nil
+        }
+        _storeInMemory(cachedResponse, key: key, date: diskEntry.date)
+        return (cachedResponse, diskEntry.date)
+    }
+
+    /*!
         @method storeCachedResponse:forRequest:
         @abstract Stores the given NSCachedURLResponse in the cache using
         the given request.
         @param cachedResponse The cached response to store.
         @param request the NSURLRequest to use as a key for the storage.
     */
-    open func storeCachedResponse(_ cachedResponse: CachedURLResponse, for request: URLRequest) { NSUnimplemented() }
-    
-    /*! 
+    open func storeCachedResponse(_ cachedResponse: CachedURLResponse, for request: URLRequest) {
+        guard let key = URLCache._key(for: request), cachedResponse.storagePolicy != .notAllowed else { return }
+        let date = Date()
+        _lock.lock()
+        defer { _lock.unlock() }
+
+        _removeFromMemory(key: key)
+        _storeInMemory(cachedResponse, key: key, date: date)
+
+        if cachedResponse.storagePolicy == .allowed {
+            _storeOnDisk(cachedResponse, key: key, date: date)
+        } else {
+            _removeFromDisk(keys: [key])
+        }
+    }
+
+    /*!
         @method removeCachedResponseForRequest:
         @abstract Removes the NSCachedURLResponse from the cache that is
-        stored using the given request. 
+        stored using the given request.
         @discussion No action is taken if there is no NSCachedURLResponse
         stored with the given request.
         @param request the NSURLRequest to use as a key for the lookup.
     */
-    open func removeCachedResponse(for request: URLRequest) { NSUnimplemented() }
-    
-    /*! 
+    open func removeCachedResponse(for request: URLRequest) {
+        guard let key = URLCache._key(for: request) else { return }
+        _lock.lock()
+        defer { _lock.unlock() }
+
+        _removeFromMemory(key: key)
+        _removeFromDisk(keys: [key])
+    }
+
+    /*!
         @method removeAllCachedResponses
         @abstract Clears the given cache, removing all NSCachedURLResponse
         objects that it stores.
     */
-    open func removeAllCachedResponses() { NSUnimplemented() }
-    
+    open func removeAllCachedResponses() {
+        _lock.lock()
+        defer { _lock.unlock() }
+
+        _trimMemory(toCost: 0)
+        _removeAllFromDisk()
+    }
+
     /*!
      @method removeCachedResponsesSince:
      @abstract Clears the given cache of any cached responses since the provided date.
      */
-    open func removeCachedResponses(since date: Date) { NSUnimplemented() }
-    
-    /*! 
+    open func removeCachedResponses(since date: Date) {
+        _lock.lock()
+        defer { _lock.unlock() }
+
+        for (key, entry) in _memoryEntries where entry.date >= date {
+            _removeFromMemory(key: key)
+        }
+        _loadDiskIndexIfNeeded()
+        _removeFromDisk(keys: _diskEntries.filter { $0.value.date >= date }.map { $0.key })
+    }
+
+    /*!
         @method memoryCapacity
-        @abstract In-memory capacity of the receiver. 
+        @abstract In-memory capacity of the receiver.
         @discussion At the time this call is made, the in-memory cache will truncate its contents to the size given, if necessary.
-        @result The in-memory capacity, measured in bytes, for the receiver. 
+        @result The in-memory capacity, measured in bytes, for the receiver.
     */
-    open var memoryCapacity: Int
-    
-    /*! 
+    open var memoryCapacity: Int {
+        didSet {
+            _lock.lock()
+            _trimMemory(toCost: memoryCapacity)
+            _lock.unlock()
+        }
+    }
+
+    /*!
         @method diskCapacity
-        @abstract The on-disk capacity of the receiver. 
+        @abstract The on-disk capacity of the receiver.
         @discussion At the time this call is made, the on-disk cache will truncate its contents to the size given, if necessary.
         @param diskCapacity the new on-disk capacity, measured in bytes, for the receiver.
     */
-    open var diskCapacity: Int
-    
-    /*! 
+    open var diskCapacity: Int {
+        didSet {
+            _lock.lock()
+            _loadDiskIndexIfNeeded()
+            if _diskFileSize > diskCapacity {
+                _compactDisk()
+            }
+            _lock.unlock()
+        }
+    }
+
+    /*!
         @method currentMemoryUsage
         @abstract Returns the current amount of space consumed by the
         in-memory cache of the receiver.
         @discussion This size, measured in bytes, indicates the current
-        usage of the in-memory cache. 
+        usage of the in-memory cache.
         @result the current usage of the in-memory cache of the receiver.
     */
-    open var currentMemoryUsage: Int { NSUnimplemented() }
-    
-    /*! 
+    open var currentMemoryUsage: Int {
+        _lock.lock()
+        defer { _lock.unlock() }
+        return _memoryUsage
+    }
+
+    /*!
         @method currentDiskUsage
         @abstract Returns the current amount of space consumed by the
         on-disk cache of the receiver.
         @discussion This size, measured in bytes, indicates the current
-        usage of the on-disk cache. 
+        usage of the on-disk cache.
         @result the current usage of the on-disk cache of the receiver.
     */
-    open var currentDiskUsage: Int { NSUnimplemented() }
+    open var currentDiskUsage: Int {
+        _lock.lock()
+        defer { _lock.unlock() }
+        _loadDiskIndexIfNeeded()
+        return _diskFileSize
+    }
+
+    // MARK: Memory tier. All of these expect _lock to be held.
+
+    private func _linkMemoryEntryAsNewest(_ entry: _URLCacheMemoryEntry) {
+        entry.newer = nil
+        entry.older = _newest
+        _newest?.newer = entry
+        _newest = entry
+        if _oldest == nil {
+            _oldest = entry
+        }
+    }
+
+    private func _unlinkMemoryEntry(_ entry: _URLCacheMemoryEntry) {
+        entry.newer?.older = entry.older
+        entry.older?.newer = entry.newer
+        if entry === _newest {
+            _newest = entry.older
+        }
+        if entry === _oldest {
+            _oldest = entry.newer
+        }
+        entry.newer = nil
+        entry.older = nil
+    }
+
+    private func _storeInMemory(_ cachedResponse: CachedURLResponse, key: String, date: Date) {
+        let cost = cachedResponse.data.count + key.utf8.count
+        guard cost <= memoryCapacity else { return }
+        let entry = _URLCacheMemoryEntry(key: key, cachedResponse: cachedResponse, date: date, cost: cost)
+        _memoryEntries[key] = entry
+        _linkMemoryEntryAsNewest(entry)
+        _memoryUsage += cost
+        _trimMemory(toCost: memoryCapacity)
+    }
+
+    private func _removeFromMemory(key: String) {
+        guard let entry = _memoryEntries.removeValue(forKey: key) else { return }
+        _unlinkMemoryEntry(entry)
+        _memoryUsage -= entry.cost
+    }
+
+    private func _trimMemory(toCost cost: Int) {
+        while _memoryUsage > cost, let oldest = _oldest {
+            _removeFromMemory(key: oldest.key)
+        }
+    }
+
+    // MARK: Disk tier. All of these expect _lock to be held.
+
+    private func _loadDiskIndexIfNeeded() {
+        guard !_diskIndexLoaded else { return }
+        _diskIndexLoaded = true
+        guard let dataFileURL = _dataFileURL, let indexFileURL = _indexFileURL,
+              let attributes = try? FileManager.default.attributesOfItem(atPath: dataFileURL.path),
+              let fileSize = (attributes[.size] as? NSNumber)?.intValue,
+              let index = try? Data(contentsOf: indexFileURL) else {
+            return
+        }
+
+        var decoder = _URLCacheDecoder(Array(index))
+        var entries = [String: _URLCacheDiskEntry]()
+        do {
+            for byte in URLCache._indexMagic {
+                guard try decoder.decode(UInt8.self) == byte else { return }
+            }
+            while !decoder.isAtEnd {
+                let key = try decoder.decodeString()
+                let entry = _URLCacheDiskEntry(offset: Int(try decoder.decode(UInt64.self)),
+                                               metadataLength: Int(try decoder.decode(UInt32.self)),
+                                               bodyLength: Int(try decoder.decode(UInt64.self)),
+                                               date: Date(timeIntervalSinceReferenceDate: Double(bitPattern: try decoder.decode(UInt64.self))))
+                // Drop records the data file does not fully contain, e.g. after a crash mid-append
+                if entry.offset + entry.length <= fileSize {
+                    entries[key] = entry
+                }
+            }
+        } catch {
+            return
+        }
+        _diskEntries = entries
+        _diskFileSize = fileSize
+    }
+
+    private func _writeDiskIndex() {
+        guard let indexFileURL = _indexFileURL else { return }
+        var encoder = _URLCacheEncoder()
+        encoder.data.append(contentsOf: URLCache._indexMagic)
+        for (key, entry) in _diskEntries {
+            encoder.encode(key)
+            encoder.encode(UInt64(entry.offset))
+            encoder.encode(UInt32(entry.metadataLength))
+            encoder.encode(UInt64(entry.bodyLength))
+            encoder.encode(entry.date.timeIntervalSinceReferenceDate.bitPattern)
+        }
+        try? encoder.data.write(to: indexFileURL, options: .atomic)
+    }
+
+    private static func _encodeMetadata(of response: URLResponse, key: String, bodyLength: Int) -> Data? {
+        guard let url = response.url else { return nil }
+        var encoder = _URLCacheEncoder()
+        encoder.encode(key)
+        encoder.encode(UInt64(bodyLength))
+        encoder.encode(url.absoluteString)
+        encoder.encode(response.mimeType)
+        encoder.encode(Int64(response.expectedContentLength))
+        encoder.encode(response.textEncodingName)
+        if let httpResponse = response as? HTTPURLResponse {
+            encoder.encode(Int64(httpResponse.statusCode))
+            var headerFields = [String: String]()
+            for (name, value) in httpResponse.allHeaderFields {
+                guard let name = name as? String, let value = value as? String else { continue }
+                headerFields[name] = value
+            }
+            encoder.encode(UInt32(headerFields.count))
+            for (name, value) in headerFields {
+                encoder.encode(name)
+                encoder.encode(value)
+            }
+        } else {
+            encoder.encode(Int64(-1))
+        }
+        return encoder.data
+    }
+
+    /// Checks that the record header in `decoder` is the one `key` and
+    /// `entry` were stored with.
+    private static func _decodeRecordHeader(_ decoder: inout _URLCacheDecoder, key: String, entry: _URLCacheDiskEntry) throws {
+        guard try decoder.decodeString() == key, try decoder.decode(UInt64.self) == UInt64(entry.bodyLength) else {
+            throw _URLCacheDecodingError.invalid
+        }
+    }
+
+    private static func _recordMatches(_ record: UnsafeRawPointer, key: String, entry: _URLCacheDiskEntry) -> Bool {
+        var decoder = _URLCacheDecoder(Array(UnsafeRawBufferPointer(start: record, count: entry.metadataLength)))
+        return (try? _decodeRecordHeader(&decoder, key: key, entry: entry)) != nil
+    }
+
+    private static func _decodeResponse(fromMetadata metadata: [UInt8], key: String, entry: _URLCacheDiskEntry) throws -> URLResponse {
+        var decoder = _URLCacheDecoder(metadata)
+        try _decodeRecordHeader(&decoder, key: key, entry: entry)
+        guard let url = URL(string: try decoder.decodeString()) else { throw _URLCacheDecodingError.invalid }
+        let mimeType = try decoder.decodeOptionalString()
+        let expectedContentLength = Int(try decoder.decode(Int64.self))
+        let textEncodingName = try decoder.decodeOptionalString()
+        let statusCode = Int(try decoder.decode(Int64.self))
+        guard statusCode >= 0 else {
+            return URLResponse(url: url, mimeType: mimeType, expectedContentLength: expectedContentLength, textEncodingName: textEncodingName)
+        }
+        var headerFields = [String: String]()
+        let headerCount = try decoder.decode(UInt32.self)
+        for _ in 0..<headerCount {
+            let name = try decoder.decodeString()
+            headerFields[name] = try decoder.decodeString()
+        }
+        guard let response = HTTPURLResponse(url: url, statusCode: statusCode, httpVersion: "HTTP/1.1", headerFields: headerFields) else {
+            throw _URLCacheDecodingError.invalid
+        }
+        return response
+    }
+
+    /// Returns a mapping of the data file that covers at least `length`
+    /// bytes, remapping if records have been appended since the last mapping.
+    private func _mappedDataFile(covering length: Int) -> NSData? {
+        if let mapping = _mappedDataFile, mapping.length >= length {
+            return mapping
+        }
+        // NSData(contentsOf:options:) reads the whole file even when asked to
+        // map it, so go through FileHandle, which really does mmap() regular files.
+        guard let dataFileURL = _dataFileURL,
+              let fileHandle = try? FileHandle(forReadingFrom: dataFileURL) else { return nil }
+        defer { try? fileHandle.close() }
+        _mappedDataFile = try? fileHandle._readDataOfLength(Int.max, untilEOF: true, options: .alwaysMapped).toNSData()
+        guard let mapping = _mappedDataFile, mapping.length >= length else { return nil }
+        return mapping
+    }
+
+    private func _readDiskEntry(_ entry: _URLCacheDiskEntry, key: String) -> CachedURLResponse? {
+        if let cachedResponse = _readDiskEntry(entry, key: key, from: _mappedDataFile(covering: entry.offset + entry.length)) {
+            return cachedResponse
+        }
+        // The data file may have been replaced since it was last mapped
+        _mappedDataFile = nil
+        return _readDiskEntry(entry, key: key, from: _mappedDataFile(covering: entry.offset + entry.length))
+    }
+
+    private func _readDiskEntry(_ entry: _URLCacheDiskEntry, key: String, from mapping: NSData?) -> CachedURLResponse? {
+        guard let mapping = mapping else { return nil }
+        let record = mapping.bytes.advanced(by: entry.offset)
+        let metadata = Array(UnsafeRawBufferPointer(start: record, count: entry.metadataLength))
+        guard let response = try? URLCache._decodeResponse(fromMetadata: metadata, key: key, entry: entry) else { return nil }
+        // The body is handed out without copying it out of the mapping. The
+        // data file is only ever appended to or replaced, never rewritten in
+        // place, so the mapped bytes stay valid for as long as they are used.
+        let body = Data(bytesNoCopy: UnsafeMutableRawPointer(mutating: record.advanced(by: entry.metadataLength)),
+                        count: entry.bodyLength,
+                        deallocator: .custom({ _, _ in withExtendedLifetime(mapping) {} }))
+        return CachedURLResponse(response: response, data: body, userInfo: nil, storagePolicy: .allowed)
+    }
+
+    private func _storeOnDisk(_ cachedResponse: CachedURLResponse, key: String, date: Date) {
+        _loadDiskIndexIfNeeded()
+        // Like Darwin, don't let one response take more than 5% of the disk cache
+        guard diskCapacity > 0, cachedResponse.data.count <= diskCapacity / 20,
+              let directory = _diskDirectory, let dataFileURL = _dataFileURL,
+              let metadata = URLCache._encodeMetadata(of: cachedResponse.response, key: key, bodyLength: cachedResponse.data.count) else {
+            _removeFromDisk(keys: [key])
+            return
+        }
+
+        do {
+            if !FileManager.default.fileExists(atPath: dataFileURL.path) {
+                try FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true, attributes: nil)
+                _ = FileManager.default.createFile(atPath: dataFileURL.path, contents: nil, attributes: nil)
+                _diskFileSize = 0
+            }
+            let fileHandle = try FileHandle(forWritingTo: dataFileURL)
+            defer { try? fileHandle.close() }
+            let offset = Int(try fileHandle.seekToEnd())
+            try fileHandle.write(contentsOf: metadata)
+            try fileHandle.write(contentsOf: cachedResponse.data)
+            _diskEntries[key] = _URLCacheDiskEntry(offset: offset, metadataLength: metadata.count, bodyLength: cachedResponse.data.count, date: date)
+            _diskFileSize = offset + metadata.count + cachedResponse.data.count
+        } catch {
+            _diskEntries[key] = nil
+        }
+
+        if _diskFileSize > diskCapacity {
+            _compactDisk()
+        } else {
+            _writeDiskIndex()
+        }
+    }
+
+    private func _removeFromDisk(keys: [String]) {
+        _loadDiskIndexIfNeeded()
+        var removed = false
+        for key in keys where _diskEntries.removeValue(forKey: key) != nil {
+            removed = true
+        }
+        if removed {
+            _writeDiskIndex()
+        }
+    }
+
+    private func _removeAllFromDisk() {
+        _diskIndexLoaded = true
+        _diskEntries.removeAll()
+        _diskFileSize = 0
+        _mappedDataFile = nil
+        for case let url? in [_dataFileURL, _indexFileURL] {
+            try? FileManager.default.removeItem(at: url)
+        }
+    }
+
+    /// Rewrites the data file with only the live records, dropping the
+    /// oldest ones until what remains fits comfortably in the disk capacity.
+    private func _compactDisk() {
+        let target = diskCapacity - diskCapacity / 4
+        var size = 0
+        var kept = [(key: String, entry: _URLCacheDiskEntry)]()
+        for (key, entry) in _diskEntries.sorted(by: { $0.value.offset > $1.value.offset }) {
+            guard size + entry.length <= target else { break }
+            kept.append((key, entry))
+            size += entry.length
+        }
+
+        // Map the file as it is now, in case another cache has replaced it
+        _mappedDataFile = nil
+        guard size > 0, let dataFileURL = _dataFileURL,
+              let mapping = _mappedDataFile(covering: kept.map { $0.entry.offset + $0.entry.length }.max() ?? 0) else {
+            _removeAllFromDisk()
+            return
+        }
+
+        var compacted = Data(capacity: size)
+        var entries = [String: _URLCacheDiskEntry]()
+        for (key, entry) in kept.reversed() {
+            let record = mapping.bytes.advanced(by: entry.offset)
+            // Another cache sharing the directory may have moved this record
+            guard URLCache._recordMatches(record, key: key, entry: entry) else { continue }
+            entries[key] = _URLCacheDiskEntry(offset: compacted.count, metadataLength: entry.metadataLength, bodyLength: entry.bodyLength, date: entry.date)
+            compacted.append(record.assumingMemoryBound(to: UInt8.self), count: entry.length)
+        }
+        // An atomic write replaces the file rather than truncating it, which
+        // keeps existing mappings (and the Data handed out from them) valid.
+        do {
+            try compacted.write(to: dataFileURL, options: .atomic)
+        } catch {
+            _removeAllFromDisk()
+            return
+        }
+        _diskEntries = entries
+        _diskFileSize = compacted.count
+        _mappedDataFile = nil
+        _writeDiskIndex()
+    }
 }
 
 extension URLCache {
-    public func storeCachedResponse(_ cachedResponse: CachedURLResponse, for dataTask: URLSessionDataTask) { NSUnimplemented() }
-    public func getCachedResponse(for dataTask: URLSessionDataTask, completionHandler: (CachedURLResponse?) -> Void) { NSUnimplemented() }
-    public func removeCachedResponse(for dataTask: URLSessionDataTask) { NSUnimplemented() }
+    public func storeCachedResponse(_ cachedResponse: CachedURLResponse, for dataTask: URLSessionDataTask) {
+        guard let request = dataTask.currentRequest ?? dataTask.originalRequest else { return }
+        storeCachedResponse(cachedResponse, for: request)
+    }
+
+    public func getCachedResponse(for dataTask: URLSessionDataTask, completionHandler: (CachedURLResponse?) -> Void) {
+        guard let request = dataTask.currentRequest ?? dataTask.originalRequest else {
+            completionHandler(nil)
+            return
+        }
+        completionHandler(cachedResponse(for: request))
+    }
+
+    public func removeCachedResponse(for dataTask: URLSessionDataTask) {
+        guard let request = dataTask.currentRequest ?? dataTask.originalRequest else { return }
+        removeCachedResponse(for: request)
+    }
 }
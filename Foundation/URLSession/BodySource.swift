@@ -33,6 +33,28 @@ internal func createDispatchData(_ data: Data) -> DispatchData {
     return data.withUnsafeBytes { DispatchData(bytes: $0) }
 }
 
+/// Turn `DispatchData` into `Data`
+///
+/// A single region is shared with the returned `Data`, which keeps the
+/// `DispatchData` alive, so body chunks received from libcurl reach the
+/// delegate without being copied again. Anything else is copied once.
+internal func createData(_ data: DispatchData) -> Data {
+    let regions = data.regions
+    if regions.count == 1, let region = regions.first {
+        return region.withUnsafeBytes { (bytes: UnsafeRawBufferPointer) -> Data in
+            guard let baseAddress = bytes.baseAddress, bytes.count > 0 else { return Data() }
+            return Data(bytesNoCopy: UnsafeMutableRawPointer(mutating: baseAddress), count: bytes.count, deallocator: .custom({ _, _ in
+                withExtendedLifetime(data) {}
+            }))
+        }
+    }
+    var result = Data(count: data.count)
+    result.withUnsafeMutableBytes { (buffer: UnsafeMutableRawBufferPointer) -> Void in
+        _ = data.copyBytes(to: buffer.bindMemory(to: UInt8.self))
+    }
+    return result
+}
+
 /// Copy data from `DispatchData` into memory pointed to by an `UnsafeMutableBufferPointer`.
 internal func copyDispatchData<T>(_ data: DispatchData, infoBuffer buffer: UnsafeMutableBufferPointer<T>) {
     precondition(data.count <= (buffer.count * MemoryLayout<T>.size))
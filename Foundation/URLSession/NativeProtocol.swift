@@ -94,7 +94,7 @@ internal class _NativeProtocol: URLProtocol, _EasyHandleDelegate {
         }
     }
 
-    func didReceive(data: Data) -> _EasyHandle._Action {
+    func didReceive(data: DispatchData) -> _EasyHandle._Action {
         guard case .transferInProgress(var ts) = internalState else {
             fatalError("Received body data, but no transfer in progress.")
         }
@@ -102,8 +102,10 @@ internal class _NativeProtocol: URLProtocol, _EasyHandleDelegate {
         if let response = validateHeaderComplete(transferState:ts) {
             ts.response = response
         }
-        notifyDelegate(aboutReceivedData: data)
+        // Drain first, so that a download task's file has the bytes by the
+        // time its delegate hears about them.
         internalState = .transferInProgress(ts.byAppending(bodyData: data))
+        notifyDelegate(aboutReceivedData: data)
         return .proceed
     }
 
@@ -114,7 +116,7 @@ internal class _NativeProtocol: URLProtocol, _EasyHandleDelegate {
         return nil
     }
 
-    fileprivate func notifyDelegate(aboutReceivedData data: Data) {
+    fileprivate func notifyDelegate(aboutReceivedData data: DispatchData) {
         guard let t = self.task else {
             fatalError("Cannot notify")
         }
@@ -125,8 +127,9 @@ internal class _NativeProtocol: URLProtocol, _EasyHandleDelegate {
             guard let s = self.task?.session as? URLSession else {
                 fatalError()
             }
+            let chunk = createData(data)
             s.delegateQueue.addOperation {
-                dataDelegate.urlSession(s, dataTask: task, didReceive: data)
+                dataDelegate.urlSession(s, dataTask: task, didReceive: chunk)
             }
         } else if case .taskDelegate(let delegate) = t.session.behaviour(for: self.task!),
             let downloadDelegate = delegate as? URLSessionDownloadDelegate,
@@ -134,9 +137,7 @@ internal class _NativeProtocol: URLProtocol, _EasyHandleDelegate {
             guard let s = self.task?.session as? URLSession else {
                 fatalError()
             }
-            let fileHandle = try! FileHandle(forWritingTo: self.tempFileURL)
-            _ = fileHandle.seekToEndOfFile()
-            fileHandle.write(data)
+            // The bytes have already been written by the .toFile drain
             task.countOfBytesReceived  += Int64(data.count)
             s.delegateQueue.addOperation {
                 downloadDelegate.urlSession(s, downloadTask: task, didWriteData: Int64(data.count), totalBytesWritten: task.countOfBytesReceived,
@@ -241,11 +242,9 @@ internal class _NativeProtocol: URLProtocol, _EasyHandleDelegate {
         // because we deregister the task with the session on internalState being set to taskCompleted
         // we need to do the latter after the delegate/handler was notified/invoked
         if case .inMemory(let bodyData) = bodyDataDrain {
-            var data = Data()
-            if let body = bodyData {
-                data = Data(bytes: body.bytes, count: body.length)
-            }
+            let data = bodyData?.joined() ?? Data()
             self.client?.urlProtocol(self, didLoad: data)
+            storeInCacheIfAllowed(response, data: data)
             self.internalState = .taskCompleted
         } else if case .toFile(let url, let fileHandle?) = bodyDataDrain {
             self.properties[.temporaryFileURL] = url
@@ -263,6 +262,11 @@ internal class _NativeProtocol: URLProtocol, _EasyHandleDelegate {
         return .completeTask
     }
 
+    /// Offer a completed in-memory response to the session's URL cache.
+    /// Protocols that support caching override this.
+    func storeInCacheIfAllowed(_ response: URLResponse, data: Data) {
+    }
+
     func seekInputStream(to position: UInt64) throws {
         // We will reset the body source and seek forward.
         guard let session = task?.session as? URLSession else { fatalError() }
@@ -319,8 +323,12 @@ internal class _NativeProtocol: URLProtocol, _EasyHandleDelegate {
         case .noDelegate:
             return .ignore
         case .taskDelegate:
-            // Data will be forwarded to the delegate as we receive it, we don't
-            // need to do anything about it.
+            // Data will be forwarded to the delegate as we receive it. A
+            // download task also needs it written to its file, through one
+            // file handle for the whole transfer.
+            if task is URLSessionDownloadTask {
+                return .toFile(self.tempFileURL, openTempFileForAppending())
+            }
             return .ignore
         case .dataCompletionHandler:
             // Data needs to be concatenated in-memory such that we can pass it
@@ -328,11 +336,16 @@ internal class _NativeProtocol: URLProtocol, _EasyHandleDelegate {
             return .inMemory(nil)
         case .downloadCompletionHandler:
             // Data needs to be written to a file (i.e. a download task).
-            let fileHandle = try! FileHandle(forWritingTo: self.tempFileURL)
-            return .toFile(self.tempFileURL, fileHandle)
+            return .toFile(self.tempFileURL, openTempFileForAppending())
         }
     }
 
+    fileprivate func openTempFileForAppending() -> FileHandle {
+        let fileHandle = try! FileHandle(forWritingTo: self.tempFileURL)
+        _ = fileHandle.seekToEndOfFile()
+        return fileHandle
+    }
+
     func createTransferState(url: URL, workQueue: DispatchQueue) -> _TransferState {
         let drain = createTransferBodyDataDrain()
         guard let t = task else {
@@ -23,6 +23,7 @@ import SwiftFoundation
 import Foundation
 #endif
 import CoreFoundation
+import Dispatch
 
 
 
@@ -53,13 +54,46 @@ extension _NativeProtocol {
 
 extension _NativeProtocol {
     enum _DataDrain {
-        /// Concatenate in-memory
-        case inMemory(NSMutableData?)
+        /// Concatenate in-memory. Appending only collects the received chunks;
+        /// they are copied into one contiguous buffer when the task completes.
+        case inMemory(_BodyDataChunks?)
         /// Write to file
         case toFile(URL, FileHandle?)
         /// Do nothing. Might be forwarded to delegate
         case ignore
     }
+
+    /// Body data received by an in-memory drain, kept as the chunks that
+    /// were received.
+    ///
+    /// Appending to a `DispatchData` copies its list of segments every time,
+    /// which makes a body of many chunks quadratic to build, so the chunks
+    /// are only concatenated once, when the whole body is needed.
+    final class _BodyDataChunks {
+        private var chunks: [DispatchData] = []
+        private var count = 0
+
+        func append(_ chunk: DispatchData) {
+            chunks.append(chunk)
+            count += chunk.count
+        }
+
+        /// The whole body. A body received in a single chunk is not copied.
+        func joined() -> Data {
+            if chunks.count == 1 {
+                return createData(chunks[0])
+            }
+            var result = Data(count: count)
+            result.withUnsafeMutableBytes { (buffer: UnsafeMutableRawBufferPointer) -> Void in
+                let bytes = buffer.bindMemory(to: UInt8.self)
+                var offset = 0
+                for chunk in chunks {
+                    offset += chunk.copyBytes(to: UnsafeMutableBufferPointer(rebasing: bytes[offset...]))
+                }
+            }
+            return result
+        }
+    }
 }
 
 extension _NativeProtocol._TransferState {
@@ -173,21 +207,19 @@ extension _NativeProtocol._TransferState {
     }
     /// Append body data
     ///
-    /// - Important: This will mutate the existing `NSMutableData` that the
-    ///     struct may already have in place -- copying the data is too
-    ///     expensive. This behaviour
-    func byAppending(bodyData buffer: Data) -> _NativeProtocol._TransferState {
+    /// Neither drain copies `buffer` here: in-memory bodies keep it until the
+    /// transfer completes and files are written straight from it.
+    func byAppending(bodyData buffer: DispatchData) -> _NativeProtocol._TransferState {
         switch bodyDataDrain {
         case .inMemory(let bodyData):
-            let data: NSMutableData = bodyData ?? NSMutableData()
+            let data = bodyData ?? _NativeProtocol._BodyDataChunks()
             data.append(buffer)
             let drain = _NativeProtocol._DataDrain.inMemory(data)
             return _NativeProtocol._TransferState(url: url, parsedResponseHeader: parsedResponseHeader, response: response, requestBodySource: requestBodySource, bodyDataDrain: drain)
         case .toFile(_, let fileHandle):
-             //TODO: Create / open the file for writing
-             // Append to the file
-             _ = fileHandle!.seekToEndOfFile()
-             fileHandle!.write(buffer)
+             // The drain's file handle was positioned at the end of the file
+             // when it was opened and only ever appended to since.
+             try! fileHandle!.write(contentsOf: buffer)
              return self
         case .ignore:
             return self
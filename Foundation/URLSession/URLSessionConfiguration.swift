@@ -149,10 +149,11 @@ open class URLSessionConfiguration : NSObject, NSCopying {
 
     open class var ephemeral: URLSessionConfiguration {
         // Return a new ephemeral URLSessionConfiguration every time this property is invoked
-        // TODO: urlCache and urlCredentialStorage should also be ephemeral/in-memory
-        // URLCache and URLCredentialStorage are still unimplemented
+        // TODO: urlCredentialStorage should also be ephemeral/in-memory
+        // URLCredentialStorage is still unimplemented
         let ephemeralConfiguration = URLSessionConfiguration.default.copy() as! URLSessionConfiguration
         ephemeralConfiguration.httpCookieStorage = .ephemeralStorage()
+        ephemeralConfiguration.urlCache = URLCache(memoryCapacity: 4 * 1024 * 1024, diskCapacity: 0, diskPath: nil)
         return ephemeralConfiguration
     }
 
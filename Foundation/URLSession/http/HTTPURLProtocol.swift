@@ -20,7 +20,7 @@ import Dispatch
 internal class _HTTPURLProtocol: _NativeProtocol {
 
     public required init(task: URLSessionTask, cachedResponse: CachedURLResponse?, client: URLProtocolClient?) {
-        super.init(task: task, cachedResponse: cachedResponse, client: client)
+        super.init(task: task, cachedResponse: cachedResponse ?? _HTTPURLProtocol.usableCachedResponse(for: task), client: client)
     }
 
     public required init(request: URLRequest, cachedResponse: CachedURLResponse?, client: URLProtocolClient?) {
@@ -32,6 +32,46 @@ internal class _HTTPURLProtocol: _NativeProtocol {
         return true
     }
 
+    override func startLoading() {
+        if case .initial = internalState {
+            if let cachedResponse = cachedResponse {
+                deliver(cachedResponse)
+                return
+            }
+            if task is URLSessionDataTask, task?.originalRequest?.cachePolicy == .returnCacheDataDontLoad {
+                // Offline mode: nothing usable in the cache and we may not load
+                guard let request = task?.originalRequest else { fatalError("Task has no original request.") }
+                internalState = .transferFailed
+                failWith(error: NSError(domain: NSURLErrorDomain, code: NSURLErrorResourceUnavailable, userInfo: nil), request: request)
+                return
+            }
+        }
+        super.startLoading()
+    }
+
+    override func storeInCacheIfAllowed(_ response: URLResponse, data: Data) {
+        guard let task = task as? URLSessionDataTask,
+              let session = task.session as? URLSession,
+              let cache = session._configuration.urlCache,
+              let request = task.currentRequest,
+              let httpResponse = response as? HTTPURLResponse else { return }
+        let storagePolicy = _HTTPURLProtocol.cacheStoragePolicy(for: httpResponse, request: request)
+        guard storagePolicy != .notAllowed else { return }
+        let cachedResponse = CachedURLResponse(response: response, data: data, userInfo: nil, storagePolicy: storagePolicy)
+        switch session.behaviour(for: task) {
+        case .taskDelegate(let delegate as URLSessionDataDelegate):
+            session.delegateQueue.addOperation {
+                delegate.urlSession(session, dataTask: task, willCacheResponse: cachedResponse) { proposedResponse in
+                    if let proposedResponse = proposedResponse {
+                        cache.storeCachedResponse(proposedResponse, for: request)
+                    }
+                }
+            }
+        case .noDelegate, .taskDelegate, .dataCompletionHandler, .downloadCompletionHandler:
+            cache.storeCachedResponse(cachedResponse, for: request)
+        }
+    }
+
     override func didReceive(headerData data: Data, contentLength: Int64) -> _EasyHandle._Action {
         guard case .transferInProgress(let ts) = internalState else {
             fatalError("Received header data, but no transfer in progress.")
@@ -97,6 +137,7 @@ internal class _HTTPURLProtocol: _NativeProtocol {
         easyHandle.set(sessionConfig: _config)
         easyHandle.setAllowedProtocolsToHTTPAndHTTPS()
         easyHandle.set(preferredReceiveBufferSize: Int.max)
+        easyHandle.setUseSharedCaches()
         do {
             switch (task?.body, try task?.body.getBodyLength()) {
             case (nil, _):
@@ -121,6 +162,12 @@ internal class _HTTPURLProtocol: _NativeProtocol {
  
         // HTTP Options:
         easyHandle.set(followLocation: false)
+        // The multi handle always allows multiplexing (see _MultiHandle.configure(with:)).
+        // Waiting for an existing connection keeps concurrent requests to one
+        // host from each opening a connection before HTTP/2 has been negotiated.
+        // Only TLS connections negotiate HTTP/2, so plain HTTP does not wait.
+        easyHandle.setPreferHTTP2OverTLS()
+        easyHandle.set(waitForPipelining: url.scheme?.lowercased() == "https")
 
         // The httpAdditionalHeaders from session configuration has to be added to the request.
         // The request.allHTTPHeaders can override the httpAdditionalHeaders elements. Add the
@@ -457,6 +504,15 @@ fileprivate extension HTTPURLResponse {
         /// `Location`
         /// - SeeAlso: RFC 2616 section 14.30 <https://tools.ietf.org/html/rfc2616#section-14.30>
         case location = "Location"
+        /// `Cache-Control`
+        /// - SeeAlso: RFC 7234 section 5.2 <https://tools.ietf.org/html/rfc7234#section-5.2>
+        case cacheControl = "Cache-Control"
+        /// `Date`
+        /// - SeeAlso: RFC 7231 section 7.1.1.2 <https://tools.ietf.org/html/rfc7231#section-7.1.1.2>
+        case date = "Date"
+        /// `Expires`
+        /// - SeeAlso: RFC 7234 section 5.3 <https://tools.ietf.org/html/rfc7234#section-5.3>
+        case expires = "Expires"
     }
 
     func value(forHeaderField field: _Field, response: HTTPURLResponse?) -> String? {
@@ -468,3 +524,102 @@ fileprivate extension HTTPURLResponse {
         return nil
     }
 }
+
+// MARK: - Caching
+internal extension _HTTPURLProtocol {
+    /// Hands a response from the URL cache to the client in place of a
+    /// network transfer.
+    func deliver(_ cachedResponse: CachedURLResponse) {
+        guard let task = task else { fatalError("Delivering a cached response, but there's no task.") }
+        task.currentRequest = request
+        task.countOfBytesExpectedToReceive = Int64(cachedResponse.data.count)
+        task.countOfBytesReceived = Int64(cachedResponse.data.count)
+        internalState = .taskCompleted
+        client?.urlProtocol(self, didReceive: cachedResponse.response, cacheStoragePolicy: .notAllowed)
+        client?.urlProtocol(self, didLoad: cachedResponse.data)
+        client?.urlProtocolDidFinishLoading(self)
+    }
+
+    /// A response from the session's URL cache that may be used for the
+    /// task's request without contacting the server, per its cache policy.
+    ///
+    /// Stale responses are never revalidated; they are simply not used.
+    static func usableCachedResponse(for task: URLSessionTask) -> CachedURLResponse? {
+        guard task is URLSessionDataTask,
+              let request = task.originalRequest,
+              (request.httpMethod ?? "GET") == "GET",
+              let session = task.session as? URLSession,
+              let cache = session._configuration.urlCache else { return nil }
+        switch request.cachePolicy {
+        case .returnCacheDataElseLoad, .returnCacheDataDontLoad:
+            return cache.cachedResponse(for: request)
+        case .useProtocolCachePolicy:
+            guard let (cachedResponse, storedDate) = cache._cachedResponseAndDate(for: request),
+                  let response = cachedResponse.response as? HTTPURLResponse,
+                  isFresh(response, storedAt: storedDate, for: request) else { return nil }
+            return cachedResponse
+        default:
+            return nil
+        }
+    }
+
+    /// Only successful GET responses that neither side marked `no-store` are cached.
+    static func cacheStoragePolicy(for response: HTTPURLResponse, request: URLRequest) -> URLCache.StoragePolicy {
+        guard (request.httpMethod ?? "GET") == "GET", response.statusCode == 200 else { return .notAllowed }
+        let responseDirectives = cacheControlDirectives(headerValue(.cacheControl, in: response))
+        let requestDirectives = cacheControlDirectives(request.value(forHTTPHeaderField: _Field.cacheControl.rawValue))
+        if responseDirectives["no-store"] != nil || requestDirectives["no-store"] != nil {
+            return .notAllowed
+        }
+        return .allowed
+    }
+
+    /// Freshness per RFC 7234 section 4.2, using `max-age` or else `Expires`.
+    /// Responses without explicit freshness information are treated as stale.
+    static func isFresh(_ response: HTTPURLResponse, storedAt storedDate: Date, for request: URLRequest) -> Bool {
+        let responseDirectives = cacheControlDirectives(headerValue(.cacheControl, in: response))
+        let requestDirectives = cacheControlDirectives(request.value(forHTTPHeaderField: _Field.cacheControl.rawValue))
+        if responseDirectives["no-cache"] != nil || requestDirectives["no-cache"] != nil {
+            return false
+        }
+        let age = Date().timeIntervalSince(storedDate)
+        if let maxAge = requestDirectives["max-age"].flatMap({ TimeInterval($0) }), age >= maxAge {
+            return false
+        }
+        if let maxAge = responseDirectives["max-age"].flatMap({ TimeInterval($0) }) {
+            return age < maxAge
+        }
+        if let expires = headerValue(.expires, in: response).flatMap(HTTPCookie._formatter1.date(from:)) {
+            let date = headerValue(.date, in: response).flatMap(HTTPCookie._formatter1.date(from:)) ?? storedDate
+            return age < expires.timeIntervalSince(date)
+        }
+        return false
+    }
+
+    /// Splits a `Cache-Control` value into lowercased directive names and
+    /// their (unquoted) arguments; directives without an argument map to "".
+    static func cacheControlDirectives(_ value: String?) -> [String: String] {
+        var directives = [String: String]()
+        for directive in (value ?? "").components(separatedBy: ",") {
+            let parts = directive.components(separatedBy: "=")
+            let name = parts[0].trimmingCharacters(in: .whitespaces).lowercased()
+            guard !name.isEmpty else { continue }
+            let argument = parts.count > 1 ? parts[1].trimmingCharacters(in: .whitespaces) : ""
+            directives[name] = argument.trimmingCharacters(in: CharacterSet(charactersIn: "\""))
+        }
+        return directives
+    }
+
+    /// Header lookup that tolerates servers that don't use canonical case.
+    static func headerValue(_ field: _Field, in response: HTTPURLResponse) -> String? {
+        if let value = response.allHeaderFields[field.rawValue] as? String {
+            return value
+        }
+        for (name, value) in response.allHeaderFields {
+            if let name = name as? String, name.caseInsensitiveCompare(field.rawValue) == .orderedSame {
+                return value as? String
+            }
+        }
+        return nil
+    }
+}
@@ -103,7 +103,7 @@ internal extension _EasyHandle {
 internal protocol _EasyHandleDelegate: class {
     /// Handle data read from the network.
     /// - returns: the action to be taken: abort, proceed, or pause.
-    func didReceive(data: Data) -> _EasyHandle._Action
+    func didReceive(data: DispatchData) -> _EasyHandle._Action
     /// Handle header data read from the network.
     /// - returns: the action to be taken: abort, proceed, or pause.
     func didReceive(headerData data: Data, contentLength: Int64) -> _EasyHandle._Action
@@ -220,8 +220,29 @@ extension _EasyHandle {
         // We need to retain the list for as long as the rawHandle is in use.
         headerList = list
     }
-    ///TODO: Wait for pipelining/multiplexing. Unavailable on Ubuntu 14.0
+    /// Wait for pipelining/multiplexing
+    ///
+    /// Rather than opening another connection to a host that already has one
+    /// being set up, wait to find out whether that connection can carry this
+    /// transfer too.
+    /// - Note: Needs libcurl 7.43.0; older versions open a new connection instead.
     /// - SeeAlso: https://curl.haxx.se/libcurl/c/CURLOPT_PIPEWAIT.html
+    func set(waitForPipelining flag: Bool) {
+        _ = CFURLSession_easy_setopt_long(rawHandle, CFURLSessionOptionPIPEWAIT, flag ? 1 : 0)
+    }
+    /// Negotiate HTTP/2 over TLS, so that transfers to the same host can be
+    /// multiplexed over one connection. Plain HTTP stays on HTTP/1.1.
+    /// - Note: This is the default since libcurl 7.62.0 and is ignored when
+    /// libcurl was built without HTTP/2 support.
+    /// - SeeAlso: https://curl.haxx.se/libcurl/c/CURLOPT_HTTP_VERSION.html
+    func setPreferHTTP2OverTLS() {
+        _ = CFURLSession_easy_setopt_long(rawHandle, CFURLSessionOptionHTTP_VERSION, CFURLSessionHTTPVersion2TLS)
+    }
+    /// Share name resolutions and TLS sessions with every other session in the process
+    /// - SeeAlso: https://curl.haxx.se/libcurl/c/CURLOPT_SHARE.html
+    func setUseSharedCaches() {
+        try! CFURLSessionEasyHandleSetSharedCaches(rawHandle).asError()
+    }
     
     //TODO: The public API does not allow us to use CFURLSessionOptionSTREAM_DEPENDS / CFURLSessionOptionSTREAM_DEPENDS_E
     // Might be good to add support for it, though.
@@ -512,7 +533,9 @@ fileprivate extension _EasyHandle {
     /// - SeeAlso: <https://curl.haxx.se/libcurl/c/CURLOPT_WRITEFUNCTION.html>
     func didReceive(data: UnsafeMutablePointer<Int8>, size: Int, nmemb: Int) -> Int {
         let d: Int = {
-            let buffer = Data(bytes: data, count: size*nmemb)
+            // libcurl reuses its buffer once we return. This is the only copy
+            // of the body bytes: the drain and the delegate share this buffer.
+            let buffer = DispatchData(bytes: UnsafeRawBufferPointer(start: data, count: size*nmemb))
             switch delegate?.didReceive(data: buffer) {
             case .proceed?: return size * nmemb
             case .abort?: return 0
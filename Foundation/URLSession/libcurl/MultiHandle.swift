@@ -44,8 +44,8 @@ extension URLSession {
         let rawHandle = CFURLSessionMultiHandleInit()
         let queue: DispatchQueue
         let group = DispatchGroup()
-        fileprivate var easyHandles: [_EasyHandle] = []
-        fileprivate var timeoutSource: _TimeoutSource? = nil
+        fileprivate var easyHandles: [CFURLSessionEasyHandle: _EasyHandle] = [:]
+        fileprivate var timeoutSource: DispatchSourceTimer? = nil
         private var reentrantInUpdateTimeoutTimer = false
         
         init(configuration: URLSession._Configuration, workQueue: DispatchQueue) {
@@ -55,21 +55,27 @@ extension URLSession {
         }
         deinit {
             // C.f.: <https://curl.haxx.se/libcurl/c/curl_multi_cleanup.html>
-            easyHandles.forEach {
+            easyHandles.values.forEach {
                 try! CFURLSessionMultiHandleRemoveHandle(rawHandle, $0.rawHandle).asError()
             }
             try! CFURLSessionMultiHandleDeinit(rawHandle).asError()
+            timeoutSource?.cancel()
         }
     }
 }
 
 extension URLSession._MultiHandle {
     func configure(with configuration: URLSession._Configuration) {
+        // Transfers beyond the per host limit are queued by libcurl until a
+        // connection becomes available. With multiplexing they share the
+        // connections that are already open instead.
         try! CFURLSession_multi_setopt_l(rawHandle, CFURLSessionMultiOptionMAX_HOST_CONNECTIONS, numericCast(configuration.httpMaximumConnectionsPerHost)).asError()
+        // CURLPIPE_MULTIPLEX, plus CURLPIPE_HTTP1 when pipelining is requested.
+        // libcurl 7.62.0 and later ignore HTTP/1.1 pipelining.
         try! CFURLSession_multi_setopt_l(rawHandle, CFURLSessionMultiOptionPIPELINING, configuration.httpShouldUsePipelining ? 3 : 2).asError()
-        //TODO: We may want to set
-        //    CFURLSessionMultiOptionMAXCONNECTS
-        //    CFURLSessionMultiOptionMAX_TOTAL_CONNECTIONS
+        // CFURLSessionMultiOptionMAXCONNECTS is left at the libcurl default,
+        // which grows the connection cache with the number of transfers added.
+        //TODO: There is no configuration property for CFURLSessionMultiOptionMAX_TOTAL_CONNECTIONS
     }
 }
 
@@ -119,18 +125,19 @@ fileprivate extension URLSession._MultiHandle {
             let p = Unmanaged.passRetained(s).toOpaque()
             CFURLSessionMultiHandleAssign(rawHandle, socket, UnsafeMutableRawPointer(p))
             socketSources = s
-        } else if socketSources != nil && action == .unregister {
-            // We need to release the stored pointer:
+        } else if let ss = socketSources, action == .unregister {
+            // libcurl is about to close the socket, so stop watching it
+            // before releasing the stored pointer:
+            ss.tearDown()
             if let opaque = socketSourcePtr {
                 Unmanaged<_SocketSources>.fromOpaque(opaque).release()
             }
             socketSources = nil
         }
         if let ss = socketSources {
-            let handler = DispatchWorkItem { [weak self] in
-                self?.performAction(for: socket)
+            ss.updateSources(with: action, socket: socket, queue: queue) { [weak self] events in
+                self?.performAction(for: socket, events: events)
             }
-            ss.createSources(with: action, socket: socket, queue: queue, handler: handler)
         }
         return 0
     }
@@ -157,7 +164,7 @@ internal extension URLSession._MultiHandle {
         // That will initiate the registration for timeout timer and socket
         // readiness.
         let needsTimeout = self.easyHandles.isEmpty
-        self.easyHandles.append(handle)
+        self.easyHandles[handle.rawHandle] = handle
         try! CFURLSessionMultiHandleAddHandle(self.rawHandle, handle.rawHandle).asError()
         if needsTimeout {
             self.timeoutTimerFired()
@@ -165,29 +172,31 @@ internal extension URLSession._MultiHandle {
     }
     /// Remove an easy handle -- stop its transfer.
     func remove(_ handle: _EasyHandle) {
-        guard let idx = self.easyHandles.firstIndex(of: handle) else {
+        guard self.easyHandles.removeValue(forKey: handle.rawHandle) != nil else {
             fatalError("Handle not in list.")
         }
-        self.easyHandles.remove(at: idx)
         try! CFURLSessionMultiHandleRemoveHandle(self.rawHandle, handle.rawHandle).asError()
     }
 }
 
 fileprivate extension URLSession._MultiHandle {
     /// This gets called when we should ask curl to perform action on a socket.
-    func performAction(for socket: CFURLSession_socket_t) {
-        try! readAndWriteAvailableData(on: socket)
+    ///
+    /// - Parameter events: The `CFURLSessionCSelect…` readiness we saw. Passing
+    ///   it along saves libcurl from polling the socket itself to find out.
+    func performAction(for socket: CFURLSession_socket_t, events: Int32) {
+        try! readAndWriteAvailableData(on: socket, events: events)
     }
     /// This gets called when our timeout timer fires.
     ///
     /// libcurl relies on us calling curl_multi_socket_action() every now and then.
     func timeoutTimerFired() {
-        try! readAndWriteAvailableData(on: CFURLSessionSocketTimeout)
+        try! readAndWriteAvailableData(on: CFURLSessionSocketTimeout, events: 0)
     }
     /// reads/writes available data given an action
-    func readAndWriteAvailableData(on socket: CFURLSession_socket_t) throws {
+    func readAndWriteAvailableData(on socket: CFURLSession_socket_t, events: Int32) throws {
         var runningHandlesCount = Int32(0)
-        try CFURLSessionMultiHandleAction(rawHandle, socket, 0, &runningHandlesCount).asError()
+        try CFURLSessionMultiHandleAction(rawHandle, socket, events, &runningHandlesCount).asError()
         //TODO: Do we remove the timeout timer here if / when runningHandles == 0 ?
         readMessages()
     }
@@ -210,10 +219,9 @@ fileprivate extension URLSession._MultiHandle {
     /// Transfer completed.
     func completedTransfer(forEasyHandle handle: CFURLSessionEasyHandle, easyCode: CFURLSessionEasyCode) {
         // Look up the matching wrapper:
-        guard let idx = easyHandles.firstIndex(where: { $0.rawHandle == handle }) else {
+        guard let easyHandle = easyHandles[handle] else {
             fatalError("Transfer completed for easy handle, but it is not in the list of added handles.")
         }
-        let easyHandle = easyHandles[idx]
         // Find the NSURLError code
         var error: NSError?
         if let errorCode = easyHandle.urlErrorCode(for: easyCode) {
@@ -359,22 +367,29 @@ fileprivate extension URLSession._MultiHandle {
     }
     
     func updateTimeoutTimer(to timeout: _Timeout) {
-        // Set up a timeout timer based on the given value:
+        // Set up a timeout timer based on the given value. libcurl asks for
+        // a new timeout after nearly every action, so a single timer source
+        // is kept around and rescheduled rather than replaced each time.
         switch timeout {
         case .none:
-            timeoutSource = nil
+            timeoutSource?.schedule(deadline: .distantFuture)
         case .immediate:
-            timeoutSource = nil
+            timeoutSource?.schedule(deadline: .distantFuture)
             queue.async { self.timeoutTimerFired() }
         case .milliseconds(let milliseconds):
-            if (timeoutSource == nil) || timeoutSource!.milliseconds != milliseconds {
-                //TODO: Could simply change the existing timer by using DispatchSourceTimer again.
-                let block = DispatchWorkItem { [weak self] in
-                    self?.timeoutTimerFired()
-                }
-                timeoutSource = _TimeoutSource(queue: queue, milliseconds: milliseconds, handler: block)
-            }
+            let source = timeoutSource ?? makeTimeoutSource()
+            let delay = max(1, milliseconds - 1)
+            source.schedule(deadline: .now() + .milliseconds(delay), repeating: .milliseconds(delay), leeway: (milliseconds == 1) ? .microseconds(1) : .milliseconds(1))
+        }
+    }
+    func makeTimeoutSource() -> DispatchSourceTimer {
+        let source = DispatchSource.makeTimerSource(queue: queue)
+        source.setEventHandler { [weak self] in
+            self?.timeoutTimerFired()
         }
+        source.resume()
+        timeoutSource = source
+        return source
     }
     enum _Timeout {
         case milliseconds(Int)
@@ -408,49 +423,70 @@ fileprivate class _SocketSources {
     var readSource: DispatchSource?
     var writeSource: DispatchSource?
 
-    func createReadSource(socket: CFURLSession_socket_t, queue: DispatchQueue, handler: DispatchWorkItem) {
+    func createReadSource(socket: CFURLSession_socket_t, queue: DispatchQueue, handler: @escaping (Int32) -> Void) {
         guard readSource == nil else { return }
 #if os(Windows)
         let s = DispatchSource.makeReadSource(handle: HANDLE(bitPattern: Int(socket))!, queue: queue)
 #else
         let s = DispatchSource.makeReadSource(fileDescriptor: socket, queue: queue)
 #endif
-        s.setEventHandler(handler: handler)
+        s.setEventHandler { handler(CFURLSessionCSelectIn) }
         readSource = s as? DispatchSource
         s.resume()
     }
 
-    func createWriteSource(socket: CFURLSession_socket_t, queue: DispatchQueue, handler: DispatchWorkItem) {
+    func createWriteSource(socket: CFURLSession_socket_t, queue: DispatchQueue, handler: @escaping (Int32) -> Void) {
         guard writeSource == nil else { return }
 #if os(Windows)
         let s = DispatchSource.makeWriteSource(handle: HANDLE(bitPattern: Int(socket))!, queue: queue)
 #else
         let s = DispatchSource.makeWriteSource(fileDescriptor: socket, queue: queue)
 #endif
-        s.setEventHandler(handler: handler)
+        s.setEventHandler { handler(CFURLSessionCSelectOut) }
         writeSource = s as? DispatchSource
         s.resume()
     }
 
-    func tearDown() {
+    func tearDownReadSource() {
         if let s = readSource {
             s.cancel()
         }
         readSource = nil
+    }
+
+    func tearDownWriteSource() {
         if let s = writeSource {
             s.cancel()
         }
         writeSource = nil
     }
+
+    func tearDown() {
+        tearDownReadSource()
+        tearDownWriteSource()
+    }
+
+    deinit {
+        tearDown()
+    }
 }
 extension _SocketSources {
-    /// Create a read and/or write source as specified by the action.
-    func createSources(with action: URLSession._MultiHandle._SocketRegisterAction, socket: CFURLSession_socket_t, queue: DispatchQueue, handler: DispatchWorkItem) {
+    /// Create and cancel read and write sources so that exactly the ones
+    /// specified by the action remain.
+    ///
+    /// A source that is no longer wanted has to go: a write source left on
+    /// a connected socket would fire continuously while libcurl waits for
+    /// the response.
+    func updateSources(with action: URLSession._MultiHandle._SocketRegisterAction, socket: CFURLSession_socket_t, queue: DispatchQueue, handler: @escaping (Int32) -> Void) {
         if action.needsReadSource {
             createReadSource(socket: socket, queue: queue, handler: handler)
+        } else {
+            tearDownReadSource()
         }
         if action.needsWriteSource {
             createWriteSource(socket: socket, queue: queue, handler: handler)
+        } else {
+            tearDownWriteSource()
         }
     }
 }
@@ -645,6 +645,14 @@ public class TestURLSessionServer {
 
         }
 
+        if uri == "/largeBody" {
+            // Large enough to reach the client as many separate chunks
+            let body = Data((0..<(2 * 1024 * 1024)).map { UInt8(truncatingIfNeeded: $0 % 251) })
+            return _HTTPResponse(response: .OK,
+                                 headers: "Content-Length: \(body.count)",
+                                 bodyData: body)
+        }
+
         if uri == "/gzipped-response" {
             // This is "Hello World!" gzipped.
             let helloWorld = Data([0x1f, 0x8b, 0x08, 0x00, 0x6d, 0xca, 0xb2, 0x5c,
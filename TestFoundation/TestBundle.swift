@@ -564,6 +564,43 @@ class TestBundle : XCTestCase {
     func test_bundleForClass() {
         XCTAssertEqual(testBundle(), Bundle(for: type(of: self)))
     }
+
+#if !os(Windows)
+    func test_resourceIndex() throws {
+        let root = URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent(ProcessInfo.processInfo.globallyUniqueString)
+        let bundleURL = root.appendingPathComponent("Indexed.bundle")
+        let resources = bundleURL.appendingPathComponent("Resources")
+        let indexDirectory = root.appendingPathComponent("Index")
+        try FileManager.default.createDirectory(at: resources, withIntermediateDirectories: true)
+        try FileManager.default.createDirectory(at: indexDirectory, withIntermediateDirectories: true)
+        defer { try? FileManager.default.removeItem(at: root) }
+
+        for index in 0..<2000 {
+            try Data().write(to: resources.appendingPathComponent("resource\(index).txt"))
+        }
+        // Indexes are only saved for directories that have not changed within the last second
+        let past = Date(timeIntervalSinceNow: -3600)
+        try FileManager.default.setAttributes([.modificationDate: past], ofItemAtPath: resources.path)
+
+        setenv("CFBundleResourceIndexDirectory", indexDirectory.path, 1)
+        defer { unsetenv("CFBundleResourceIndexDirectory") }
+
+        XCTAssertNotNil(Bundle.url(forResource: "resource1", withExtension: "txt", subdirectory: nil, in: bundleURL))
+        let indexFiles = try FileManager.default.contentsOfDirectory(atPath: indexDirectory.path)
+        XCTAssertEqual(indexFiles.filter { $0.hasSuffix(".cfbundleindex") }.count, 1)
+
+        // While the directory's modification time is unchanged lookups are answered from the index, even for a file removed behind its back
+        try FileManager.default.removeItem(at: resources.appendingPathComponent("resource1999.txt"))
+        try FileManager.default.setAttributes([.modificationDate: past], ofItemAtPath: resources.path)
+        XCTAssertEqual(Bundle.url(forResource: "resource1999", withExtension: "txt", subdirectory: nil, in: bundleURL)?.lastPathComponent, "resource1999.txt")
+        XCTAssertNil(Bundle.url(forResource: "missing", withExtension: "txt", subdirectory: nil, in: bundleURL))
+
+        // Any change to the directory invalidates the index
+        try Data().write(to: resources.appendingPathComponent("added.txt"))
+        XCTAssertNotNil(Bundle.url(forResource: "added", withExtension: "txt", subdirectory: nil, in: bundleURL))
+        XCTAssertNil(Bundle.url(forResource: "resource1999", withExtension: "txt", subdirectory: nil, in: bundleURL))
+    }
+#endif
     
     static var allTests: [(String, (TestBundle) -> () throws -> Void)] {
         var tests: [(String, (TestBundle) -> () throws -> Void)] = [
@@ -581,6 +618,10 @@ class TestBundle : XCTestCase {
             ("test_bundleForClass", testExpectedToFailOnWindows(test_bundleForClass, "Functionality not yet implemented on Windows. SR-XXXX")),
         ]
         
+        #if !os(Windows)
+        tests.append(("test_resourceIndex", test_resourceIndex))
+        #endif
+
         #if NS_FOUNDATION_ALLOWS_TESTABLE_IMPORT
         tests.append(contentsOf: [
             ("test_mainBundleExecutableURL", test_mainBundleExecutableURL),
@@ -9,6 +9,14 @@
 
 import Dispatch
 
+#if NS_FOUNDATION_ALLOWS_TESTABLE_IMPORT
+    #if canImport(SwiftFoundationNetworking) && !DEPLOYMENT_RUNTIME_OBJC
+        @testable import SwiftFoundationNetworking
+    #else
+        @testable import FoundationNetworking
+    #endif
+#endif
+
 class TestHTTPCookieStorage: XCTestCase {
 
     enum StorageType {
@@ -386,8 +394,93 @@ class TestHTTPCookieStorage: XCTestCase {
         XCTAssertEqual(result, [cookie, cookie3, cookie2])
     }
     
+    func test_manyCookies() {
+        let storage = cookieStorage(for: .groupContainer("test"))
+        let domains = 100
+        let cookiesPerDomain = 20
+        let expires = Date(timeIntervalSinceNow: 1000)
+        for domain in 0..<domains {
+            let url = URL(string: "https://domain\(domain).org")!
+            let cookies = (0..<cookiesPerDomain).map { index in
+                HTTPCookie(properties: [
+                    .name: "Cookie\(index)",
+                    .value: "\(domain)",
+                    .path: "/",
+                    .domain: index % 2 == 0 ? "domain\(domain).org" : ".domain\(domain).org",
+                    .expires: expires,
+                ])!
+            }
+            storage.setCookies(cookies, for: url, mainDocumentURL: nil)
+        }
+        XCTAssertEqual(storage.cookies!.count, domains * cookiesPerDomain)
+
+        // Only the cookies with a leading dot in their domain are valid for subdomains
+        let resultsQ = DispatchQueue(label: "TestHTTPCookieStorage.resultsQ")
+        var mismatchedDomains: [Int] = []
+        DispatchQueue.concurrentPerform(iterations: domains) { domain in
+            let domainCookies = storage.cookies(for: URL(string: "https://domain\(domain).org")!)!
+            let subdomainCookies = storage.cookies(for: URL(string: "https://www.domain\(domain).org/path")!)!
+            if domainCookies.count != cookiesPerDomain || subdomainCookies.count != cookiesPerDomain / 2 ||
+                !subdomainCookies.allSatisfy({ $0.value == "\(domain)" && $0.domain.hasPrefix(".") }) {
+                resultsQ.sync { mismatchedDomains.append(domain) }
+            }
+        }
+        XCTAssertEqual(mismatchedDomains, [])
+        XCTAssertEqual(storage.cookies(for: URL(string: "https://otherdomain1.org")!)!, [])
+
+        // Replacing a cookie with a session-only one keeps a single cookie under its key
+        let sessionCookie = HTTPCookie(properties: [.name: "Cookie1", .value: "session", .path: "/", .domain: ".domain1.org"])!
+        storage.setCookie(sessionCookie)
+        XCTAssertEqual(storage.cookies(for: URL(string: "https://www.domain1.org")!)!.filter { $0.name == "Cookie1" }, [sessionCookie])
+
+        storage.deleteCookie(sessionCookie)
+        XCTAssertEqual(storage.cookies(for: URL(string: "https://www.domain1.org")!)!.count, cookiesPerDomain / 2 - 1)
+        storage.removeCookies(since: Date(timeIntervalSince1970: 0))
+        XCTAssertEqual(storage.cookies!.count, 0)
+        XCTAssertEqual(storage.cookies(for: URL(string: "https://domain0.org")!)!, [])
+    }
+
+#if NS_FOUNDATION_ALLOWS_TESTABLE_IMPORT
+    func test_storagesSharingAPersistentStore() {
+        let name = "sharedStoreTest"
+        let first = HTTPCookieStorage(cookieStorageName: name)
+        first.removeCookies(since: Date(timeIntervalSince1970: 0))
+        defer { first.removeCookies(since: Date(timeIntervalSince1970: 0)) }
+
+        let expires = Date(timeIntervalSinceNow: 1000)
+        func cookie(_ name: String, value: String = "1") -> HTTPCookie {
+            return HTTPCookie(properties: [.name: name, .value: value, .path: "/", .domain: "swift.org", .expires: expires])!
+        }
+        func names(_ storage: HTTPCookieStorage) -> [String] {
+            return storage.cookies!.map { $0.name }.sorted()
+        }
+
+        // A new storage loads the snapshot and replays the journal over it
+        first.setCookie(cookie("A"))
+        let second = HTTPCookieStorage(cookieStorageName: name)
+        XCTAssertEqual(names(second), ["A"])
+
+        // Neither storage overwrites what the other has appended, and each catches up when it next writes
+        second.setCookie(cookie("B"))
+        first.setCookie(cookie("C"))
+        XCTAssertEqual(names(first), ["A", "B", "C"])
+        XCTAssertEqual(names(HTTPCookieStorage(cookieStorageName: name)), ["A", "B", "C"])
+
+        // Enough changes for the first storage to rewrite the snapshot; the second then reloads from it
+        first.deleteCookie(cookie("A"))
+        let padding = String(repeating: "x", count: 1000)
+        for round in 0..<100 {
+            first.setCookie(cookie("C", value: "\(round)-\(padding)"))
+        }
+        second.setCookie(cookie("D"))
+        XCTAssertEqual(names(second), ["B", "C", "D"])
+        XCTAssertEqual(second.cookies!.first { $0.name == "C" }?.value, "99-\(padding)")
+        XCTAssertEqual(names(HTTPCookieStorage(cookieStorageName: name)), ["B", "C", "D"])
+    }
+#endif
+
     static var allTests: [(String, (TestHTTPCookieStorage) -> () throws -> Void)] {
-        return [
+        var tests: [(String, (TestHTTPCookieStorage) -> () throws -> Void)] = [
             ("test_sharedCookieStorageAccessedFromMultipleThreads", test_sharedCookieStorageAccessedFromMultipleThreads),
             ("test_BasicStorageAndRetrieval", test_BasicStorageAndRetrieval),
             ("test_deleteCookie", test_deleteCookie),
@@ -398,7 +491,14 @@ class TestHTTPCookieStorage: XCTestCase {
             ("test_descriptionCookie", test_descriptionCookie),
             ("test_cookieDomainMatching", test_cookieDomainMatching),
             ("test_sorting", test_sorting),
+            ("test_manyCookies", test_manyCookies),
         ]
+
+        #if NS_FOUNDATION_ALLOWS_TESTABLE_IMPORT
+        tests.append(("test_storagesSharingAPersistentStore", test_storagesSharingAPersistentStore))
+        #endif
+
+        return tests
     }
 
 }
@@ -93,6 +93,7 @@ extension TestJSONSerialization {
             ("test_deserialize_emptyArray_withData", test_deserialize_emptyArray_withData),
             ("test_deserialize_multiStringArray_withData", test_deserialize_multiStringArray_withData),
             ("test_deserialize_unicodeString_withData", test_deserialize_unicodeString_withData),
+            ("test_deserialize_utf8Strings_withData", test_deserialize_utf8Strings_withData),
             ("test_deserialize_stringWithSpacesAtStart_withData", test_deserialize_stringWithSpacesAtStart_withData),
 
 
@@ -125,6 +126,7 @@ extension TestJSONSerialization {
             ("test_deserialize_emptyArray_withStream", test_deserialize_emptyArray_withStream),
             ("test_deserialize_multiStringArray_withStream", test_deserialize_multiStringArray_withStream),
             ("test_deserialize_unicodeString_withStream", test_deserialize_unicodeString_withStream),
+            ("test_deserialize_utf8Strings_withStream", test_deserialize_utf8Strings_withStream),
             ("test_deserialize_stringWithSpacesAtStart_withStream", test_deserialize_stringWithSpacesAtStart_withStream),
 
 
@@ -175,6 +177,10 @@ extension TestJSONSerialization {
         deserialize_unicodeString(objectType: .data)
     }
 
+    func test_deserialize_utf8Strings_withData() {
+        deserialize_utf8Strings(objectType: .data)
+    }
+
     func test_deserialize_stringWithSpacesAtStart_withData() {
         deserialize_stringWithSpacesAtStart(objectType: .data)
     }
@@ -273,6 +279,10 @@ extension TestJSONSerialization {
         deserialize_unicodeString(objectType: .stream)
     }
 
+    func test_deserialize_utf8Strings_withStream() {
+        deserialize_utf8Strings(objectType: .stream)
+    }
+
     func test_deserialize_stringWithSpacesAtStart_withStream() {
         deserialize_stringWithSpacesAtStart(objectType: .stream)
     }
@@ -450,6 +460,29 @@ extension TestJSONSerialization {
         }
     }
 
+    func deserialize_utf8Strings(objectType: ObjectType) {
+        // Long enough to span several reads when parsed from a stream
+        let long = String(repeating: "0123456789abcdef", count: 8192)
+        let subject = "{\"ascii\": \"plain\", \"\": \"\", \"Ģ😢\": \"naïve \\u2728 \\\"q\\\"\", \"long\": \"\(long)\"}"
+        do {
+            guard let data = subject.data(using: .utf8) else {
+                XCTFail("Unable to convert string to data")
+                return
+            }
+            let result = try getjsonObjectResult(data, objectType) as? [String: Any]
+            XCTAssertEqual(result?["ascii"] as? String, "plain")
+            XCTAssertEqual(result?[""] as? String, "")
+            XCTAssertEqual(result?["Ģ😢"] as? String, "naïve \u{2728} \"q\"")
+            XCTAssertEqual(result?["long"] as? String, long)
+        } catch {
+            XCTFail("Unexpected error: \(error)")
+        }
+
+        // Invalid UTF-8 must still be rejected
+        let invalid = Data([0x5B, 0x22, 0x61, 0xFF, 0x22, 0x5D]) // ["a\xFF"]
+        XCTAssertThrowsError(try getjsonObjectResult(invalid, objectType))
+    }
+
     //MARK: - Value parsing
     func deserialize_values(objectType: ObjectType) {
         let subject = "[true, false, \"hello\", null, {}, []]"
@@ -1009,6 +1042,8 @@ extension TestJSONSerialization {
             ("test_jsonObjectToOutputStreamBuffer", test_jsonObjectToOutputStreamBuffer),
             ("test_jsonObjectToOutputStreamFile", test_jsonObjectToOutputStreamFile),
             ("test_jsonObjectToOutputStreamInsufficientBuffer", test_jsonObjectToOutputStreamInsufficientBuffer),
+            ("test_jsonObjectToOutputStreamLargeDocument", test_jsonObjectToOutputStreamLargeDocument),
+            ("test_jsonObjectToOutputStreamInvalidObject", test_jsonObjectToOutputStreamInvalidObject),
             ("test_booleanJSONObject", test_booleanJSONObject),
             ("test_serialize_dictionaryWithDecimal", test_serialize_dictionaryWithDecimal),
             ("test_serializeDecimalNumberJSONObject", test_serializeDecimalNumberJSONObject),
@@ -1461,18 +1496,41 @@ extension TestJSONSerialization {
         let buffer = Array<UInt8>(repeating: 0, count: 10)
         let outputStream = OutputStream(toBuffer: UnsafeMutablePointer(mutating: buffer), capacity: buffer.count)
         outputStream.open()
+        // Nothing fits, so the stream's error is thrown
+        XCTAssertThrowsError(try JSONSerialization.writeJSONObject(dict, toStream: outputStream, options: []))
+        outputStream.close()
+        XCTAssertNotEqual(NSString(bytes: buffer, length: buffer.count, encoding: String.Encoding.utf8.rawValue), "{\"a\":{\"b\":1}}")
+#endif
+    }
+    
+    func test_jsonObjectToOutputStreamLargeDocument() {
+        let array: [Any] = (0..<20000).map { ["index": $0, "name": "item \($0)", "ratio": Double($0) / 8] }
         do {
-            let result = try JSONSerialization.writeJSONObject(dict, toStream: outputStream, options: [])
+            let expected = try JSONSerialization.data(withJSONObject: array, options: [])
+            let outputStream = OutputStream.toMemory()
+            outputStream.open()
+            let result = try JSONSerialization.writeJSONObject(array, toStream: outputStream, options: [])
             outputStream.close()
-            if(result > -1) {
-                XCTAssertNotEqual(NSString(bytes: buffer, length: buffer.count, encoding: String.Encoding.utf8.rawValue), "{\"a\":{\"b\":1}}")
-            }
+            XCTAssertEqual(result, expected.count)
+            let written = outputStream.property(forKey: Stream.PropertyKey.dataWrittenToMemoryStreamKey) as? NSData
+            XCTAssertEqual(written.map { Data(referencing: $0) }, expected)
         } catch {
-            XCTFail("Error occurred while writing to stream")
+            XCTFail("Error thrown: \(error)")
         }
-#endif
     }
-    
+
+    func test_jsonObjectToOutputStreamInvalidObject() {
+        // The invalid value comes after enough valid output to fill a large write
+        var array: [Any] = (0..<20000).map { ["index": $0, "name": "item \($0)"] }
+        array.append(Double.nan)
+        let outputStream = OutputStream.toMemory()
+        outputStream.open()
+        XCTAssertThrowsError(try JSONSerialization.writeJSONObject(array, toStream: outputStream, options: []))
+        outputStream.close()
+        let written = outputStream.property(forKey: Stream.PropertyKey.dataWrittenToMemoryStreamKey) as? NSData
+        XCTAssertEqual(written?.length ?? 0, 0)
+    }
+
     func test_booleanJSONObject() {
         do {
             let objectLikeBoolArray = try JSONSerialization.data(withJSONObject: [true, NSNumber(value: false), NSNumber(value: true)] as Array<Any>)
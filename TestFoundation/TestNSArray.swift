@@ -28,6 +28,8 @@ class TestNSArray : XCTestCase {
             ("test_removeObjectsInArray", test_removeObjectsInArray),
             ("test_sortedArrayUsingComparator", test_sortedArrayUsingComparator),
             ("test_sortedArrayWithOptionsUsingComparator", test_sortedArrayWithOptionsUsingComparator),
+            ("test_sortedArrayConcurrentIsStable", test_sortedArrayConcurrentIsStable),
+            ("test_cfArraySortValuesIsStable", test_cfArraySortValuesIsStable),
             ("test_arrayReplacement", test_arrayReplacement),
             ("test_arrayReplaceObjectsInRangeFromRange", test_arrayReplaceObjectsInRangeFromRange),
             ("test_sortUsingFunction", test_sortUsingFunction),
@@ -538,6 +540,47 @@ class TestNSArray : XCTestCase {
         XCTAssertTrue(emptyArray.isEmpty)
     }
 
+    func test_sortedArrayConcurrentIsStable() {
+        // Large enough to be split across several cores, with many equal keys so that stability shows
+        let count = 100_000
+        let values = (0..<count).map { ($0 * 7919) % count }
+        let input = NSArray(array: values.map { NSNumber(value: $0) })
+        let comparator: (Any, Any) -> ComparisonResult = { left, right in
+            let l = (left as! NSNumber).intValue % 1000
+            let r = (right as! NSNumber).intValue % 1000
+            return l < r ? .orderedAscending : (l > r ? .orderedDescending : .orderedSame)
+        }
+        let expected = values.indices.sorted { (values[$0] % 1000, $0) < (values[$1] % 1000, $1) }.map { values[$0] }
+
+        for options: NSSortOptions in [[.concurrent], [.concurrent, .stable]] {
+            let result = input.sortedArray(options: options, usingComparator: comparator).map { ($0 as! NSNumber).intValue }
+            XCTAssertEqual(result, expected)
+        }
+
+        let mutableInput = input.mutableCopy() as! NSMutableArray
+        mutableInput.sort(options: [.concurrent, .stable], usingComparator: comparator)
+        XCTAssertEqual(mutableInput.map { ($0 as! NSNumber).intValue }, expected)
+    }
+
+    func test_cfArraySortValuesIsStable() {
+        // CFArraySortValues spreads ranges of 16K values or more across cores when the comparator is CFStringCompare
+        let count = 40_000
+        let strings = (0..<count).map { NSString(string: "key \(($0 * 7919) % 1000)") }
+        var callBacks = kCFTypeArrayCallBacks
+        let array = CFArrayCreateMutable(kCFAllocatorDefault, count, &callBacks)!
+        for string in strings {
+            CFArrayAppendValue(array, UnsafeRawPointer(Unmanaged.passUnretained(string).toOpaque()))
+        }
+        let compare: @convention(c) (CFString?, CFString?, CFStringCompareFlags) -> CFComparisonResult = CFStringCompare
+        CFArraySortValues(array, CFRange(location: 0, length: count), unsafeBitCast(compare, to: CFComparatorFunction.self), nil)
+
+        // Equal strings are distinct objects, so their order shows whether the sort was stable
+        let expected = strings.indices.sorted { (strings[$0] as String, $0) < (strings[$1] as String, $1) }.map { ObjectIdentifier(strings[$0]) }
+        let result = (0..<count).map { ObjectIdentifier(Unmanaged<NSString>.fromOpaque(CFArrayGetValueAtIndex(array, $0)!).takeUnretainedValue()) }
+        XCTAssertEqual(CFArrayGetCount(array), count)
+        XCTAssertTrue(result == expected)
+    }
+
     func test_sortUsingFunction() {
         let inputNumbers = [11, 120, 215, 11, 1, -22, 35, -89, 65]
         let mutableInput = NSArray(array: inputNumbers).mutableCopy() as! NSMutableArray
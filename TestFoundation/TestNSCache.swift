@@ -17,7 +17,8 @@ class TestNSCache : XCTestCase {
             ("test_countLimit", test_countLimit),
             ("test_hashableKey", test_hashableKey),
             ("test_nonHashableKey", test_nonHashableKey),
-            ("test_objectCorrectlyReleased", test_objectCorrectlyReleased)
+            ("test_objectCorrectlyReleased", test_objectCorrectlyReleased),
+            ("test_evictionOrder", test_evictionOrder),
         ]
     }
     
@@ -209,4 +210,47 @@ class TestNSCache : XCTestCase {
         XCTAssertNil(weakObject2, "removed cached object not released")
         XCTAssertNil(weakObject3, "removed cached object not released")
     }
+    
+    class TestCacheDelegate: NSObject, NSCacheDelegate {
+        var evictedObjects = [NSString]()
+        
+        func cache(_ cache: NSCache<AnyObject, AnyObject>, willEvictObject obj: Any) {
+            evictedObjects.append(obj as! NSString)
+        }
+    }
+    
+    func test_evictionOrder() {
+        let cache = NSCache<NSString, NSString>()
+        let delegate = TestCacheDelegate()
+        cache.delegate = delegate
+        cache.countLimit = 1000
+        
+        // Cheaper entries go first; equally cheap entries go in the order they were set
+        for index in 0..<2000 {
+            cache.setObject("value\(index)" as NSString, forKey: "key\(index)" as NSString, cost: index % 2)
+        }
+        let expectedEvictions = (0..<1000).map { "value\(2 * $0)" as NSString }
+        XCTAssertEqual(delegate.evictedObjects, expectedEvictions)
+        XCTAssertNotNil(cache.object(forKey: "key1"))
+        XCTAssertNil(cache.object(forKey: "key1998"))
+        
+        // Setting an existing key again moves it behind the entries of the same cost
+        delegate.evictedObjects.removeAll()
+        cache.setObject("value1", forKey: "key1", cost: 1)
+        cache.setObject("value2000", forKey: "key2000", cost: 1)
+        XCTAssertEqual(delegate.evictedObjects, ["value3"])
+        
+        // Entries made cheaper are evicted earlier
+        delegate.evictedObjects.removeAll()
+        cache.setObject("value1999", forKey: "key1999", cost: 0)
+        cache.setObject("value2001", forKey: "key2001", cost: 1)
+        XCTAssertEqual(delegate.evictedObjects, ["value1999"])
+        
+        cache.removeObject(forKey: "key5")
+        XCTAssertNil(cache.object(forKey: "key5"))
+        cache.removeAllObjects()
+        XCTAssertNil(cache.object(forKey: "key7"))
+        cache.setObject("value", forKey: "key", cost: 1)
+        XCTAssertEqual(cache.object(forKey: "key"), "value")
+    }
 }
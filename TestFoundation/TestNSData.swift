@@ -7,6 +7,8 @@
 // See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
 //
 
+import CoreFoundation
+
 class TestNSData: LoopbackServerTest {
     
     class AllOnesImmutableData : NSData {
@@ -234,6 +236,8 @@ class TestNSData: LoopbackServerTest {
             ("test_base64DecodeWithPadding1", test_base64DecodeWithPadding1),
             ("test_base64DecodeWithPadding2", test_base64DecodeWithPadding2),
             ("test_rangeOfData", test_rangeOfData),
+            ("test_rangeOfDataInLargePayload", test_rangeOfDataInLargePayload),
+            ("test_dataSearcherOverSeveralBuffers", test_dataSearcherOverSeveralBuffers),
             ("test_initNSMutableData()", test_initNSMutableData),
             ("test_initNSMutableDataWithLength", test_initNSMutableDataWithLength),
             ("test_initNSMutableDataWithCapacity", test_initNSMutableDataWithCapacity),
@@ -831,6 +835,64 @@ class TestNSData: LoopbackServerTest {
         
     }
 
+    func test_rangeOfDataInLargePayload() {
+        // Short needles are found by filtering on their first and last byte, long ones with Boyer-Moore
+        let boundary = Data("\r\n--boundary".utf8)
+        let record = Data((0..<64).map { UInt8(0x80 + $0) })
+        var payload = Data(repeating: 0x2D, count: 100_000)
+        payload.append(boundary)
+        payload.append(record)
+        payload.append(Data(repeating: 0x2D, count: 100_000))
+        payload.append(record)
+        payload.append(boundary)
+        payload.append(Data(repeating: 0x2D, count: 1000))
+
+        let firstBoundary = 100_000..<(100_000 + boundary.count)
+        let firstRecord = firstBoundary.upperBound..<(firstBoundary.upperBound + record.count)
+        let secondRecord = (firstRecord.upperBound + 100_000)..<(firstRecord.upperBound + 100_000 + record.count)
+        let secondBoundary = secondRecord.upperBound..<(secondRecord.upperBound + boundary.count)
+
+        XCTAssertEqual(payload.range(of: boundary), firstBoundary)
+        XCTAssertEqual(payload.range(of: boundary, options: .backwards), secondBoundary)
+        XCTAssertEqual(payload.range(of: record), firstRecord)
+        XCTAssertEqual(payload.range(of: record, options: .backwards), secondRecord)
+        XCTAssertEqual(payload.range(of: boundary, in: firstBoundary.upperBound..<payload.count), secondBoundary)
+        XCTAssertEqual(payload.range(of: record, options: .backwards, in: 0..<(secondRecord.upperBound - 1)), firstRecord)
+        XCTAssertNil(payload.range(of: boundary, options: .anchored))
+        XCTAssertEqual(payload.range(of: boundary, options: .anchored, in: firstBoundary.lowerBound..<payload.count), firstBoundary)
+        XCTAssertEqual(payload.range(of: record, options: [.anchored, .backwards], in: 0..<secondRecord.upperBound), secondRecord)
+        XCTAssertNil(payload.range(of: record + record))
+
+        // Ranges found in a slice are in terms of the slice's indices
+        let slice = payload[firstRecord.lowerBound..<payload.count]
+        XCTAssertEqual(slice.range(of: boundary), secondBoundary)
+        XCTAssertEqual(slice.range(of: record, options: .anchored), firstRecord)
+    }
+
+    func test_dataSearcherOverSeveralBuffers() {
+        // A searcher is planned once for its needle and options, then run over each buffer
+        let boundary = Array("\r\n--boundary".utf8)
+        let record = (0..<64).map { UInt8(0x80 + $0) }
+        let buffers: [[UInt8]] = [
+            Array(repeating: 0x2D, count: 1000) + boundary + record,
+            record + Array(repeating: 0x2D, count: 5000) + boundary + Array(repeating: 0x2D, count: 10),
+            Array(repeating: 0x2D, count: 100),
+        ]
+        for needle in [boundary, record] {
+            for options in [NSData.SearchOptions(), .backwards] {
+                let searcher = _CFDataSearcherCreate(kCFAllocatorSystemDefault, needle, needle.count, CFDataSearchFlags(rawValue: options.rawValue))
+                defer { _CFDataSearcherRelease(searcher) }
+                for buffer in buffers {
+                    let expected = Data(buffer).range(of: Data(needle), options: options)
+                    let found = _CFDataSearcherFindInBytes(searcher, buffer, buffer.count, CFRangeMake(0, buffer.count))
+                    XCTAssertEqual(found.location == kCFNotFound ? nil : found.location..<(found.location + found.length), expected)
+                }
+                let subrange = _CFDataSearcherFindInBytes(searcher, buffers[1], buffers[1].count, CFRangeMake(1, buffers[1].count - 11))
+                XCTAssertEqual(subrange.location, needle == boundary ? 5064 : kCFNotFound)
+            }
+        }
+    }
+
     // Check all of the NSMutableData constructors are available.
     func test_initNSMutableData() {
         let mData = NSMutableData()
@@ -7,6 +7,8 @@
 // See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
 //
 
+import CoreFoundation
+
 class TestNSDictionary : XCTestCase {
     func test_BasicConstruction() {
         let dict = NSDictionary()
@@ -255,6 +257,80 @@ class TestNSDictionary : XCTestCase {
         XCTAssertEqual(dictionary[3 as NSNumber] as? String, "k")
     }
     
+    func test_removeAndReinsertInCFDictionary() {
+        // CFDictionaries with CFEqual/CFHash key callbacks use the grouped hash style.
+        // Churn it: removals leave deleted buckets behind, reinsertion has to reuse
+        // them, and removing almost everything forces rehashes with deleted buckets
+        var keyCallBacks = kCFTypeDictionaryKeyCallBacks
+        var valueCallBacks = kCFTypeDictionaryValueCallBacks
+        let dict = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, &keyCallBacks, &valueCallBacks)!
+        // Keys are new instances every time, so lookups go through the equal callback
+        func set(_ i: Int, _ value: Int) {
+            let k = "key \(i)" as NSString, v = NSNumber(value: value)
+            CFDictionarySetValue(dict, UnsafeRawPointer(Unmanaged.passUnretained(k).toOpaque()), UnsafeRawPointer(Unmanaged.passUnretained(v).toOpaque()))
+        }
+        func value(_ i: Int) -> Int? {
+            let k = "key \(i)" as NSString
+            guard let v = CFDictionaryGetValue(dict, UnsafeRawPointer(Unmanaged.passUnretained(k).toOpaque())) else { return nil }
+            return Unmanaged<NSNumber>.fromOpaque(v).takeUnretainedValue().intValue
+        }
+        func remove(_ i: Int) {
+            let k = "key \(i)" as NSString
+            CFDictionaryRemoveValue(dict, UnsafeRawPointer(Unmanaged.passUnretained(k).toOpaque()))
+        }
+
+        let count = 4096
+        for i in 0..<count { set(i, i) }
+        XCTAssertEqual(CFDictionaryGetCount(dict), count)
+
+        for i in stride(from: 0, to: count, by: 2) { remove(i) }
+        XCTAssertEqual(CFDictionaryGetCount(dict), count / 2)
+        XCTAssertEqual((0..<count).filter { value($0) != ($0 % 2 == 0 ? nil : $0) }, [])
+
+        for i in stride(from: 0, to: count, by: 2) { set(i, -i) }
+        XCTAssertEqual(CFDictionaryGetCount(dict), count)
+        XCTAssertEqual((0..<count).filter { value($0) != ($0 % 2 == 0 ? -$0 : $0) }, [])
+
+        var expected = (0..<count).map { $0 % 2 == 0 ? -$0 : $0 }
+        for round in 0..<8 {
+            for i in 0..<count where i % 64 != round { remove(i) }
+            XCTAssertEqual(CFDictionaryGetCount(dict), count / 64)
+            XCTAssertEqual((0..<count).filter { value($0) != ($0 % 64 == round ? expected[$0] : nil) }, [], "round \(round)")
+            for i in 0..<count where i % 64 != round {
+                set(i, i + round)
+                expected[i] = i + round
+            }
+            XCTAssertEqual(CFDictionaryGetCount(dict), count)
+            XCTAssertEqual((0..<count).filter { value($0) != expected[$0] }, [], "round \(round)")
+        }
+
+        XCTAssertNil(value(count))
+        CFDictionaryRemoveAllValues(dict)
+        XCTAssertEqual(CFDictionaryGetCount(dict), 0)
+        XCTAssertNil(value(0))
+    }
+
+    func test_largeDictionaryRoundTrip() {
+        // Large enough for the grouped hash style to spread keys over many groups
+        var dict = [String: Int]()
+        for i in 0..<2000 {
+            dict["key \(i)"] = i
+        }
+        for format in [PropertyListSerialization.PropertyListFormat.binary, .xml] {
+            do {
+                let data = try PropertyListSerialization.data(fromPropertyList: dict, format: format, options: 0)
+                let decoded = try PropertyListSerialization.propertyList(from: data, options: [], format: nil) as? [String: Int]
+                XCTAssertEqual(decoded?.count, dict.count)
+                XCTAssertEqual(decoded?["key 0"], 0)
+                XCTAssertEqual(decoded?["key 1999"], 1999)
+                XCTAssertNil(decoded?["key 2000"])
+                XCTAssertEqual(decoded ?? [:], dict)
+            } catch {
+                XCTFail("Failed to round trip a large dictionary: \(error)")
+            }
+        }
+    }
+
     static var allTests: [(String, (TestNSDictionary) -> () throws -> Void)] {
         return [
             ("test_BasicConstruction", test_BasicConstruction),
@@ -270,6 +346,8 @@ class TestNSDictionary : XCTestCase {
             ("test_valueForKey", test_valueForKey),
             ("test_valueForKeyWithNestedDict", test_valueForKeyWithNestedDict),
             ("test_sharedKeySets", test_sharedKeySets),
+            ("test_removeAndReinsertInCFDictionary", test_removeAndReinsertInCFDictionary),
+            ("test_largeDictionaryRoundTrip", test_largeDictionaryRoundTrip),
         ]
     }
 }
@@ -7,6 +7,8 @@
 // See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
 //
 
+import CoreFoundation
+
 class TestNSSet : XCTestCase {
     func test_BasicConstruction() {
         let set = NSSet()
@@ -278,6 +280,51 @@ class TestNSSet : XCTestCase {
         }
     }
     
+    func test_removeAndReinsertInCFSet() {
+        // Same churn as the CFDictionary test, for a grouped hash CFSet
+        var callBacks = kCFTypeSetCallBacks
+        let set = CFSetCreateMutable(kCFAllocatorDefault, 0, &callBacks)!
+        func add(_ i: Int) {
+            let v = "value \(i)" as NSString
+            CFSetAddValue(set, UnsafeRawPointer(Unmanaged.passUnretained(v).toOpaque()))
+        }
+        func contains(_ i: Int) -> Bool {
+            let v = "value \(i)" as NSString
+            return CFSetContainsValue(set, UnsafeRawPointer(Unmanaged.passUnretained(v).toOpaque()))
+        }
+        func remove(_ i: Int) {
+            let v = "value \(i)" as NSString
+            CFSetRemoveValue(set, UnsafeRawPointer(Unmanaged.passUnretained(v).toOpaque()))
+        }
+
+        let count = 4096
+        for i in 0..<count { add(i) }
+        XCTAssertEqual(CFSetGetCount(set), count)
+
+        for i in stride(from: 0, to: count, by: 2) { remove(i) }
+        XCTAssertEqual(CFSetGetCount(set), count / 2)
+        XCTAssertEqual((0..<count).filter { contains($0) != ($0 % 2 == 1) }, [])
+
+        for i in stride(from: 0, to: count, by: 2) { add(i) }
+        for i in 0..<count { add(i) }
+        XCTAssertEqual(CFSetGetCount(set), count)
+        XCTAssertEqual((0..<count).filter { !contains($0) }, [])
+
+        for round in 0..<8 {
+            for i in 0..<count where i % 64 != round { remove(i) }
+            XCTAssertEqual(CFSetGetCount(set), count / 64)
+            XCTAssertEqual((0..<count).filter { contains($0) != ($0 % 64 == round) }, [], "round \(round)")
+            for i in 0..<count where i % 64 != round { add(i) }
+            XCTAssertEqual(CFSetGetCount(set), count)
+            XCTAssertEqual((0..<count).filter { !contains($0) }, [], "round \(round)")
+        }
+
+        XCTAssertFalse(contains(count))
+        CFSetRemoveAllValues(set)
+        XCTAssertEqual(CFSetGetCount(set), 0)
+        XCTAssertFalse(contains(0))
+    }
+
     static var allTests: [(String, (TestNSSet) -> () throws -> Void)] {
         return [
             ("test_BasicConstruction", test_BasicConstruction),
@@ -298,6 +345,7 @@ class TestNSSet : XCTestCase {
             ("test_description", test_description),
             ("test_codingRoundtrip", test_codingRoundtrip),
             ("test_loadedValuesMatch", test_loadedValuesMatch),
+            ("test_removeAndReinsertInCFSet", test_removeAndReinsertInCFSet),
         ]
     }
     
@@ -55,6 +55,7 @@ class TestNSString: LoopbackServerTest {
             ("test_longLongValue", test_longLongValue ),
             ("test_rangeOfCharacterFromSet", test_rangeOfCharacterFromSet ),
             ("test_CFStringCreateMutableCopy", test_CFStringCreateMutableCopy),
+            ("test_CFMutableStringLargeEdits", test_CFMutableStringLargeEdits),
             /* ⚠️ */ ("test_FromContentsOfURL", testExpectedToFail(test_FromContentsOfURL,
             /* ⚠️ */     "test_FromContentsOfURL is flaky on CI, with unclear causes. https://bugs.swift.org/browse/SR-10514")),
             ("test_FromContentOfFileUsedEncodingIgnored", test_FromContentOfFileUsedEncodingIgnored),
@@ -75,6 +76,8 @@ class TestNSString: LoopbackServerTest {
             ("test_deletingLastPathComponent", test_deletingLastPathComponent),
             ("test_getCString_simple", test_getCString_simple),
             ("test_getCString_nonASCII_withASCIIAccessor", test_getCString_nonASCII_withASCIIAccessor),
+            ("test_utf8Conversions", test_utf8Conversions),
+            ("test_rangeOfLiteralString", test_rangeOfLiteralString),
             ("test_NSHomeDirectoryForUser", test_NSHomeDirectoryForUser),
             ("test_resolvingSymlinksInPath", test_resolvingSymlinksInPath),
             ("test_expandingTildeInPath", test_expandingTildeInPath),
@@ -98,6 +101,8 @@ class TestNSString: LoopbackServerTest {
             ("test_commonPrefix", test_commonPrefix),
             ("test_lineRangeFor", test_lineRangeFor),
             ("test_fileSystemRepresentation", test_fileSystemRepresentation),
+            ("test_hashIsConsistentAcrossRepresentations", test_hashIsConsistentAcrossRepresentations),
+            ("test_seededHashIsConsistentAcrossRepresentations", test_seededHashIsConsistentAcrossRepresentations),
         ]
     }
 
@@ -590,6 +595,89 @@ class TestNSString: LoopbackServerTest {
         XCTAssertEqual(nsstring, nsstring.mutableCopy() as! NSString)
     }
     
+    func test_CFMutableStringLargeEdits() {
+        func characters(of string: CFString) -> [UInt16] {
+            var characters = [UInt16](repeating: 0, count: CFStringGetLength(string))
+            CFStringGetCharacters(string, CFRangeMake(0, characters.count), &characters)
+            return characters
+        }
+
+        // Long mutable strings move into a CFStorage on their first edit away from the end
+        for unit in [Array("abcdefgh".utf16), Array("abcdefg\u{3042}".utf16)] {
+            var expected = [UInt16]()
+            for _ in 0..<(20 * 1024) {
+                expected += unit
+            }
+            let string = CFStringCreateMutable(kCFAllocatorSystemDefault, 0)!
+            CFStringAppendCharacters(string, expected, expected.count)
+
+            let insertion = Array("xyz".utf16)
+            let insertedString = CFStringCreateWithCharacters(kCFAllocatorSystemDefault, insertion, insertion.count)!
+            var seed: UInt32 = 1
+            func nextIndex(below bound: Int) -> Int {
+                seed = seed &* 1103515245 &+ 12345
+                return Int((seed >> 16) % UInt32(bound))
+            }
+
+            for iteration in 0..<600 {
+                let location = nextIndex(below: expected.count)
+                switch iteration % 3 {
+                case 0:
+                    CFStringInsert(string, location, insertedString)
+                    expected.insert(contentsOf: insertion, at: location)
+                case 1:
+                    let length = min(nextIndex(below: 64), expected.count - location)
+                    CFStringDelete(string, CFRangeMake(location, length))
+                    expected.removeSubrange(location..<(location + length))
+                default:
+                    CFStringAppendCharacters(string, insertion, insertion.count)
+                    expected += insertion
+                }
+                XCTAssertEqual(CFStringGetLength(string), expected.count)
+                if location < expected.count {
+                    XCTAssertEqual(CFStringGetCharacterAtIndex(string, location), expected[location])
+                }
+            }
+
+            XCTAssertEqual(characters(of: string), expected)
+
+            // Reading a store-backed string leaves it alone, so it is safe from several threads at once
+            let copy = CFStringCreateCopy(kCFAllocatorSystemDefault, string)!
+            XCTAssertEqual(characters(of: copy), expected)
+            let hash = CFHash(copy)
+            let utf8Length = String(decoding: expected, as: UTF16.self).utf8.count
+            let lock = NSLock()
+            var failures = 0
+            DispatchQueue.concurrentPerform(iterations: 8) { index in
+                let substring = CFStringCreateWithSubstring(kCFAllocatorSystemDefault, string, CFRangeMake(index * 100, 100))!
+                var usedLength = 0
+                let converted = CFStringGetBytes(string, CFRangeMake(0, expected.count), kCFStringEncodingUTF8, 0, false, nil, 0, &usedLength)
+                if CFHash(string) != hash || !CFEqual(string, copy) || characters(of: substring) != Array(expected[(index * 100)..<(index * 100 + 100)]) || converted != expected.count || usedLength != utf8Length {
+                    lock.lock()
+                    failures += 1
+                    lock.unlock()
+                }
+            }
+            XCTAssertEqual(failures, 0)
+            XCTAssertEqual(characters(of: string), expected)
+
+            // C strings are appended to the store too, and the hash reads it in place
+            CFStringAppendCString(string, "abc", kCFStringEncodingASCII)
+            expected += Array("abc".utf16)
+            XCTAssertEqual(characters(of: string), expected)
+            XCTAssertEqual(CFHash(string), CFHash(CFStringCreateCopy(kCFAllocatorSystemDefault, string)!))
+
+            CFStringDelete(string, CFRangeMake(0, 1000))
+            expected.removeSubrange(0..<1000)
+            XCTAssertEqual(characters(of: string), expected)
+
+            CFStringDelete(string, CFRangeMake(0, expected.count))
+            XCTAssertEqual(CFStringGetLength(string), 0)
+            CFStringAppendCharacters(string, insertion, insertion.count)
+            XCTAssertEqual(characters(of: string), insertion)
+        }
+    }
+
     // This test verifies that CFStringGetBytes with a UTF16 encoding works on an NSString backed by a Swift string
     func test_swiftStringUTF16() {
         let testString = "hello world"
@@ -991,7 +1079,80 @@ class TestNSString: LoopbackServerTest {
         XCTAssertTrue(res, "getCString should work on UTF8 encoding")
         XCTAssertEqual(chars, expected, "getCString on \(str) should have resulted in \(expected) but got \(chars)")
     }
+
+    func test_utf8Conversions() {
+        // ASCII runs of varying lengths and alignments around non-ASCII text
+        let asciiRun = String(repeating: "The quick brown fox. ", count: 5)
+        let samples: [String] = [
+            asciiRun,
+            "Grüße aus Köln, ça va? " + asciiRun + "Ærøskøbing",
+            "日本語のテキスト" + asciiRun + "中文",
+            "👍🏽🚀" + String(asciiRun.prefix(17)) + "🇨🇭" + String(asciiRun.prefix(33)) + "x",
+            String(repeating: "a", count: 15) + "é" + String(repeating: "b", count: 16) + "ü" + String(repeating: "c", count: 31),
+        ]
+
+        for sample in samples {
+            let utf8 = Array(sample.utf8)
+            let decoded = NSString(bytes: utf8, length: utf8.count, encoding: String.Encoding.utf8.rawValue)
+            XCTAssertEqual(decoded?.length, sample.utf16.count)
+            XCTAssertEqual(decoded.map { String._unconditionallyBridgeFromObjectiveC($0) }, sample)
+
+            let string = NSString(string: sample)
+            XCTAssertEqual(string.data(using: String.Encoding.utf8.rawValue).map { Array($0) }, utf8)
+            XCTAssertEqual(string.lengthOfBytes(using: String.Encoding.utf8.rawValue), utf8.count)
+
+            var chars = [Int8](repeating: 0x7F, count: utf8.count + 1)
+            let count = chars.count
+            let res = chars.withUnsafeMutableBufferPointer {
+                string.getCString($0.baseAddress!, maxLength: count, encoding: String.Encoding.utf8.rawValue)
+            }
+            XCTAssertTrue(res)
+            XCTAssertEqual(chars, utf8.map { Int8(bitPattern: $0) } + [0])
+
+            // An invalid byte after a long ASCII run is still rejected
+            let invalid = utf8 + [0xFF] + Array(asciiRun.utf8)
+            XCTAssertNil(NSString(bytes: invalid, length: invalid.count, encoding: String.Encoding.utf8.rawValue))
+        }
+    }
     
+    func test_rangeOfLiteralString() {
+        // Long haystacks in both eight-bit and UTF-16 storage
+        let filler = String(repeating: "abcabd", count: 50)
+        let haystack = filler + "needle" + filler + "needle" + filler
+        let first = NSRange(location: filler.utf16.count, length: 6)
+        let second = NSRange(location: filler.utf16.count * 2 + 6, length: 6)
+
+        func eightBit(_ string: String) -> NSString {
+            let bytes = Array(string.utf8)
+            return NSString(bytes: bytes, length: bytes.count, encoding: String.Encoding.ascii.rawValue)!
+        }
+        func utf16(_ string: String) -> NSString {
+            let characters = Array(string.utf16)
+            return NSString(characters: characters, length: characters.count)
+        }
+
+        for haystack in [eightBit(haystack), utf16(haystack)] {
+            let needle = "needle"
+            XCTAssertEqual(haystack.range(of: needle), first)
+            XCTAssertEqual(haystack.range(of: needle, options: .backwards), second)
+            XCTAssertEqual(haystack.range(of: needle, options: .anchored).location, NSNotFound)
+            XCTAssertEqual(haystack.range(of: needle, options: [.backwards, .anchored]).location, NSNotFound)
+            XCTAssertEqual(haystack.range(of: needle, options: [], range: NSRange(location: first.location + 1, length: haystack.length - first.location - 1)), second)
+            XCTAssertEqual(haystack.range(of: needle, options: .backwards, range: NSRange(location: 0, length: second.location + 5)), first)
+            XCTAssertEqual(haystack.range(of: needle, options: .anchored, range: NSRange(location: first.location, length: 6)), first)
+            XCTAssertEqual(haystack.range(of: needle, options: [.backwards, .anchored], range: NSRange(location: 0, length: second.location + 6)), second)
+            XCTAssertEqual(haystack.range(of: "NEEDLE", options: .caseInsensitive), first)
+            XCTAssertEqual(haystack.range(of: "abd" + needle).location, first.location - 3)
+            XCTAssertEqual(haystack.range(of: "needles").location, NSNotFound)
+            XCTAssertEqual(haystack.components(separatedBy: "needle").count, 3)
+            XCTAssertEqual(haystack.components(separatedBy: "abd").count, 151)
+        }
+
+        let nonLatin = utf16(filler + "\u{3042}\u{3044}" + filler)
+        XCTAssertEqual(nonLatin.range(of: "\u{3042}\u{3044}"), NSRange(location: filler.utf16.count, length: 2))
+        XCTAssertEqual(nonLatin.range(of: "b\u{3042}").location, NSNotFound)
+    }
+
     func test_NSHomeDirectoryForUser() {
         let homeDir = NSHomeDirectoryForUser(nil)
         let userName = NSUserName()
@@ -1424,4 +1585,52 @@ extension TestNSString {
         result.deallocate()
     #endif
     }
+
+    func test_hashIsConsistentAcrossRepresentations() {
+        let path = String(repeating: "some/nested/directory/", count: 10)
+        let strings = ["", "short", "http://example.com/" + path + "index.html", "http://example.com/\u{00E9}/" + path + "\u{4E2D}.html"]
+        for string in strings {
+            let swiftBacked = NSString(string: string)
+            let mutable = NSMutableString(string: string)
+            let characters = Array(string.utf16)
+            let fromCharacters = NSString(characters: characters, length: characters.count)
+            let fromCString = string.withCString { NSString(utf8String: $0)! }
+            XCTAssertEqual(swiftBacked.hash, mutable.hash, "\(string)")
+            XCTAssertEqual(swiftBacked.hash, fromCharacters.hash, "\(string)")
+            XCTAssertEqual(swiftBacked.hash, fromCString.hash, "\(string)")
+        }
+    }
+
+    func test_seededHashIsConsistentAcrossRepresentations() throws {
+#if !os(Android)
+        // The hash function is picked once per process, so the seeded one has to be checked in a child process
+        let path = String(repeating: "some/nested/directory/", count: 10)
+        let strings = ["", "short", "http://example.com/" + path + "a/" + path + "index.html", "http://example.com/" + path + "b/" + path + "index.html",
+                       "http://example.com/\u{00E9}/" + path + "\u{4E2D}.html"]
+        func hashes(_ environment: [String: String]) throws -> [[String]] {
+            var environment = environment
+            for (key, value) in ProcessInfo.processInfo.environment where !key.hasPrefix("CFSTRING_") {
+                environment[key] = value
+            }
+            let (output, _) = try runTask([xdgTestHelperURL().path, "--string-hashes"] + strings, environment: environment)
+            let lines = output.split(separator: "\n").map { $0.split(separator: " ").map(String.init) }
+            XCTAssertEqual(lines.count, strings.count)
+            for (line, string) in zip(lines, strings) {
+                XCTAssertEqual(line.count, 4, "\(string)")
+                XCTAssertEqual(Set(line).count, 1, "\(string): \(line)")
+            }
+            return lines
+        }
+
+        let random = try hashes(["CFSTRING_SEEDED_HASH": "1"])
+        let seed1 = try hashes(["CFSTRING_HASH_SEED": "1"])
+        let seed2 = try hashes(["CFSTRING_HASH_SEED": "2"])
+        XCTAssertEqual(seed1, try hashes(["CFSTRING_HASH_SEED": "1"]))
+        XCTAssertNotEqual(seed1, seed2)
+        XCTAssertNotEqual(random, seed1)
+        // Strings differing only in the middle collide under the sampled hash, but not under the seeded one
+        XCTAssertNotEqual(seed1[2], seed1[3])
+        XCTAssertNotEqual(random[2], random[3])
+#endif
+    }
 }
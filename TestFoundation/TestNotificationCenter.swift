@@ -16,6 +16,8 @@ class TestNotificationCenter : XCTestCase {
             ("test_postMultipleNotifications", test_postMultipleNotifications),
             ("test_addObserverForNilName", test_addObserverForNilName),
             ("test_removeObserver", test_removeObserver),
+            ("test_removeObserverForNameAndObject", test_removeObserverForNameAndObject),
+            ("test_postNotificationToManyObservers", test_postNotificationToManyObservers),
             ("test_observeOnPostingQueue", test_observeOnPostingQueue),
             ("test_observeOnSpecificQueuePostFromMainQueue", test_observeOnSpecificQueuePostFromMainQueue),
             ("test_observeOnSpecificQueuePostFromObservedQueue", test_observeOnSpecificQueuePostFromObservedQueue),
@@ -142,6 +144,64 @@ class TestNotificationCenter : XCTestCase {
         notificationCenter.post(name: notificationName, object: nil)
         XCTAssertTrue(flag)
     }
+
+    func test_removeObserverForNameAndObject() {
+        let notificationCenter = NotificationCenter()
+        let notificationName = Notification.Name(rawValue: "test_removeObserverForNameAndObject_name")
+        let otherNotificationName = Notification.Name(rawValue: "test_removeObserverForNameAndObject_name_other")
+        let sender = NSObject()
+        var count = 0
+        let observer = notificationCenter.addObserver(forName: nil, object: sender, queue: nil) { _ in
+            count += 1
+        }
+
+        // Neither the name nor the object matches, so nothing is removed
+        notificationCenter.removeObserver(observer, name: notificationName, object: NSObject())
+        notificationCenter.post(name: notificationName, object: sender)
+        XCTAssertEqual(count, 1)
+
+        notificationCenter.removeObserver(observer, name: otherNotificationName, object: nil)
+        notificationCenter.post(name: otherNotificationName, object: sender)
+        XCTAssertEqual(count, 2)
+
+        notificationCenter.removeObserver(observer, name: nil, object: sender)
+        notificationCenter.post(name: notificationName, object: sender)
+        XCTAssertEqual(count, 2)
+    }
+
+    func test_postNotificationToManyObservers() {
+        let notificationCenter = NotificationCenter()
+        let names = (0..<10).map { Notification.Name(rawValue: "test_postNotificationToManyObservers_\($0)") }
+        let senders = (0..<10).map { _ in NSObject() }
+        var received = [Int]()
+        var observers = [NSObjectProtocol]()
+
+        for index in 0..<1000 {
+            let name: Notification.Name? = index % 100 == 0 ? nil : names[index % names.count]
+            let sender: NSObject? = index % 7 == 0 ? nil : senders[index % senders.count]
+            observers.append(notificationCenter.addObserver(forName: name, object: sender, queue: nil) { _ in
+                received.append(index)
+            })
+        }
+
+        // Observers are notified in the order they were added
+        notificationCenter.post(name: names[3], object: senders[3])
+        let expected = (0..<1000).filter { index in
+            (index % 100 == 0 || index % names.count == 3) && (index % 7 == 0 || index % senders.count == 3)
+        }
+        XCTAssertEqual(received, expected)
+
+        received.removeAll()
+        notificationCenter.post(name: names[3], object: nil)
+        XCTAssertEqual(received, (0..<1000).filter { index in (index % 100 == 0 || index % names.count == 3) && index % 7 == 0 })
+
+        for observer in observers {
+            removeObserver(observer, notificationCenter: notificationCenter)
+        }
+        received.removeAll()
+        notificationCenter.post(name: names[3], object: senders[3])
+        XCTAssertEqual(received, [])
+    }
     
     func test_observeOnPostingQueue() {
         let notificationCenter = NotificationCenter()
@@ -12,6 +12,7 @@ class TestPropertyListEncoder : XCTestCase {
         return [
             ("test_basicEncodeDecode", test_basicEncodeDecode),
             ("test_xmlDecoder", test_xmlDecoder),
+            ("test_binaryRoundTrip", test_binaryRoundTrip),
         ]
     }
 }
@@ -144,3 +145,48 @@ extension TestPropertyListEncoder {
         XCTAssertEqual(decodedInfoPlist, resultInfoPlist)
     }
 }
+
+extension TestPropertyListEncoder {
+    struct Model: Codable, Equatable {
+        let id: Int
+        let name: String
+        let tags: [String]
+        let score: Double
+        let ratio: Float
+        let large: UInt64
+        let small: Int8
+        let flag: Bool
+        let note: String?
+        let payload: Data
+        let created: Date
+    }
+
+    func test_binaryRoundTrip() throws {
+        let models = (0..<2000).map { (index: Int) -> Model in
+            Model(id: index - 1000,
+                  name: index % 2 == 0 ? "model \(index)" : "modèle \(index) ✓",
+                  tags: ["shared", "tag \(index % 7)"],
+                  score: Double(index) / 3,
+                  ratio: Float(index) / 7,
+                  large: index % 3 == 0 ? UInt64.max - UInt64(index) : UInt64(index),
+                  small: Int8(truncatingIfNeeded: index),
+                  flag: index % 5 == 0,
+                  note: index % 4 == 0 ? nil : "note",
+                  payload: Data(repeating: UInt8(truncatingIfNeeded: index), count: index % 20),
+                  created: Date(timeIntervalSinceReferenceDate: Double(index) * 86400.5))
+        }
+
+        let binary = try PropertyListEncoder().encode(models)
+        let decoder = PropertyListDecoder()
+        var format: PropertyListSerialization.PropertyListFormat = .xml
+        let decoded = try decoder.decode([Model].self, from: binary, format: &format)
+        XCTAssertEqual(decoded, models)
+        XCTAssertEqual(format, .binary)
+
+        // CF must read what the encoder writes, and the decoder must read what CF writes
+        let plist = try PropertyListSerialization.propertyList(from: binary, options: [], format: nil)
+        XCTAssertEqual((plist as? NSArray)?.count, models.count)
+        let rewritten = try PropertyListSerialization.data(fromPropertyList: plist, format: .binary, options: 0)
+        XCTAssertEqual(try decoder.decode([Model].self, from: rewritten), models)
+    }
+}
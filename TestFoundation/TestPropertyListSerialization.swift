@@ -7,13 +7,29 @@
 // See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
 //
 
+#if NS_FOUNDATION_ALLOWS_TESTABLE_IMPORT
+    #if canImport(SwiftFoundation) && !DEPLOYMENT_RUNTIME_OBJC
+        @testable import SwiftFoundation
+    #else
+        @testable import Foundation
+    #endif
+#endif
+
 class TestPropertyListSerialization : XCTestCase {
     static var allTests: [(String, (TestPropertyListSerialization) -> () throws -> Void)] {
-        return [
+        var tests: [(String, (TestPropertyListSerialization) -> () throws -> Void)] = [
             ("test_BasicConstruction", test_BasicConstruction),
             ("test_decodeData", test_decodeData),
             ("test_decodeStream", test_decodeStream),
+            ("test_binaryWritesSharedObjectsOnce", test_binaryWritesSharedObjectsOnce),
+            ("test_binaryWritesFirstOfEqualValues", test_binaryWritesFirstOfEqualValues),
         ]
+
+        #if NS_FOUNDATION_ALLOWS_TESTABLE_IMPORT
+        tests.append(("test_lazyBinaryReader", test_lazyBinaryReader))
+        #endif
+
+        return tests
     }
     
     func test_BasicConstruction() {
@@ -79,4 +95,70 @@ class TestPropertyListSerialization : XCTestCase {
             XCTFail("value stored is not a string")
         }
     }
+
+    func test_binaryWritesSharedObjectsOnce() throws {
+        var contents: [String: Int] = [:]
+        for i in 0..<20 {
+            contents["key \(i)"] = i
+        }
+        let shared = NSDictionary(dictionary: contents)
+        let plist = NSArray(array: Array(repeating: shared, count: 100))
+
+        let data = try PropertyListSerialization.data(fromPropertyList: plist, format: .binary, options: 0)
+        // Each copy written out would need over 40 bytes of object references alone
+        XCTAssertLessThan(data.count, 1024)
+
+        let decoded = try PropertyListSerialization.propertyList(from: data, options: [], format: nil) as? [[String: Int]]
+        XCTAssertEqual(decoded?.count, 100)
+        XCTAssertEqual(decoded?.first, contents)
+        XCTAssertEqual(decoded?.last, contents)
+    }
+
+    func test_binaryWritesFirstOfEqualValues() throws {
+        // 1 and 1.0 are equal and share one object, which must be the one met first
+        let mixed = NSArray(array: [NSNumber(value: 1), NSNumber(value: 1.0)])
+        let integers = NSArray(array: [NSNumber(value: 1), NSNumber(value: 1)])
+        let data = try PropertyListSerialization.data(fromPropertyList: mixed, format: .binary, options: 0)
+        XCTAssertEqual(data, try PropertyListSerialization.data(fromPropertyList: integers, format: .binary, options: 0))
+    }
+
+#if NS_FOUNDATION_ALLOWS_TESTABLE_IMPORT
+    func test_lazyBinaryReader() throws {
+        var records: [[String: Any]] = []
+        for i in 0..<500 {
+            records.append(["name": "record \(i)", "index": i, "payload": Data(repeating: UInt8(truncatingIfNeeded: i), count: 64)])
+        }
+        let plist: [String: Any] = ["version": 3, "records": records, "settings": ["enabled": true, "title": "Lazy"]]
+        let data = try PropertyListSerialization.data(fromPropertyList: plist, format: .binary, options: 0)
+
+        let url = URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent(ProcessInfo.processInfo.globallyUniqueString)
+        try data.write(to: url)
+        defer { try? FileManager.default.removeItem(at: url) }
+
+        for root in [try PropertyListSerialization._lazyPropertyList(contentsOf: url), try PropertyListSerialization._lazyPropertyList(from: data)] {
+            XCTAssertTrue(root.isDictionary)
+            XCTAssertEqual(root.count, 3)
+            XCTAssertEqual(Set(try root.keys()), ["version", "records", "settings"])
+            XCTAssertEqual(try root["version"]?.value() as? Int, 3)
+            XCTAssertNil(root["missing"])
+
+            let recordsObject = try root["records"].unwrapped()
+            XCTAssertTrue(recordsObject.isArray)
+            XCTAssertEqual(recordsObject.count, 500)
+            XCTAssertNil(recordsObject[500])
+            XCTAssertNil(recordsObject[-1])
+            let record = try recordsObject[321].unwrapped()
+            XCTAssertEqual(try record["name"]?.value() as? String, "record 321")
+            XCTAssertEqual(try record["payload"]?.value() as? Data, Data(repeating: 65, count: 64))
+            XCTAssertNil(record["name"]?.count)
+
+            let settings = try root["settings"].unwrapped().value() as? [String: Any]
+            XCTAssertEqual(settings?["enabled"] as? Bool, true)
+            XCTAssertEqual(settings?["title"] as? String, "Lazy")
+        }
+
+        XCTAssertThrowsError(try PropertyListSerialization._lazyPropertyList(from: Data("not a plist".utf8)))
+        XCTAssertThrowsError(try PropertyListSerialization._lazyPropertyList(contentsOf: url.appendingPathExtension("missing")))
+    }
+#endif
 }
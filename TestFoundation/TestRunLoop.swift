@@ -7,12 +7,17 @@
 // See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
 //
 
+import CoreFoundation
+import Dispatch
+
 class TestRunLoop : XCTestCase {
     static var allTests : [(String, (TestRunLoop) -> () throws -> Void)] {
         return [
             ("test_constants", test_constants),
             ("test_runLoopInit", test_runLoopInit),
             ("test_commonModes", test_commonModes),
+            ("test_stopWithOtherPortsReady", test_stopWithOtherPortsReady),
+            ("test_socketCallBacks", test_socketCallBacks),
             // these tests do not work the same as Darwin https://bugs.swift.org/browse/SR-399
 //            ("test_runLoopRunMode", test_runLoopRunMode),
 //            ("test_runLoopLimitDate", test_runLoopLimitDate),
@@ -92,4 +97,84 @@ class TestRunLoop : XCTestCase {
         
         waitForExpectations(timeout: 10)
     }
+
+    func test_stopWithOtherPortsReady() {
+        // The timer's port and the main queue's port are ready before the run loop waits, so they are
+        // woken up for together. Whichever is serviced first stops the run loop; the other has to be
+        // left for the next run rather than serviced anyway, or lost.
+        var serviced: [String] = []
+        let timer = Timer(fire: Date(timeIntervalSinceNow: -1), interval: 0, repeats: false) { _ in
+            serviced.append("timer")
+            CFRunLoopStop(CFRunLoopGetCurrent())
+        }
+        RunLoop.current.add(timer, forMode: .default)
+        defer { timer.invalidate() }
+        DispatchQueue.main.async {
+            serviced.append("main queue")
+            CFRunLoopStop(CFRunLoopGetCurrent())
+        }
+
+        _ = CFRunLoopRunInMode(kCFRunLoopDefaultMode, 1, false)
+        XCTAssertEqual(serviced.count, 1)
+        _ = CFRunLoopRunInMode(kCFRunLoopDefaultMode, 1, false)
+        XCTAssertEqual(serviced.sorted(), ["main queue", "timer"])
+    }
+
+    func test_socketCallBacks() {
+#if os(Linux)
+        // The CFSocket manager thread watches sockets with an epoll set, which has to follow the
+        // callbacks being enabled, disabled and invalidated
+        final class Reads { var count = 0 }
+        let reads = Reads()
+        var context = CFSocketContext(version: 0, info: Unmanaged.passUnretained(reads).toOpaque(), retain: nil, release: nil, copyDescription: nil)
+
+        func makeSocket() -> (socket: CFSocket, peer: Int32) {
+            var fds: [Int32] = [0, 0]
+            XCTAssertEqual(socketpair(AF_UNIX, Int32(SOCK_STREAM.rawValue), 0, &fds), 0)
+            let socket: CFSocket = CFSocketCreateWithNative(nil, fds[0], CFOptionFlags(kCFSocketReadCallBack), { (socket, _, _, _, info) in
+                var byte: UInt8 = 0
+                _ = read(CFSocketGetNative(socket), &byte, 1)
+                Unmanaged<Reads>.fromOpaque(info!).takeUnretainedValue().count += 1
+            }, &context)
+            CFRunLoopAddSource(CFRunLoopGetCurrent(), CFSocketCreateRunLoopSource(kCFAllocatorDefault, socket, 0), kCFRunLoopDefaultMode)
+            return (socket, fds[1])
+        }
+        func send(to peer: Int32) {
+            var byte: UInt8 = 1
+            XCTAssertEqual(write(peer, &byte, 1), 1)
+        }
+        func run(untilReads count: Int, timeout: TimeInterval) {
+            let deadline = Date(timeIntervalSinceNow: timeout)
+            while reads.count < count && Date() < deadline {
+                _ = CFRunLoopRunInMode(kCFRunLoopDefaultMode, 0.05, true)
+            }
+        }
+
+        let first = makeSocket()
+        send(to: first.peer)
+        run(untilReads: 1, timeout: 5)
+        XCTAssertEqual(reads.count, 1)
+
+        CFSocketDisableCallBacks(first.socket, CFOptionFlags(kCFSocketReadCallBack))
+        send(to: first.peer)
+        run(untilReads: 2, timeout: 0.5)
+        XCTAssertEqual(reads.count, 1, "a disabled callback was called")
+
+        CFSocketEnableCallBacks(first.socket, CFOptionFlags(kCFSocketReadCallBack))
+        run(untilReads: 2, timeout: 5)
+        XCTAssertEqual(reads.count, 2, "data that arrived while the callback was disabled was not reported")
+
+        // The invalidated socket's descriptor is closed, and usually reused for the next socket
+        CFSocketInvalidate(first.socket)
+        XCTAssertFalse(CFSocketIsValid(first.socket))
+        close(first.peer)
+
+        let second = makeSocket()
+        send(to: second.peer)
+        run(untilReads: 3, timeout: 5)
+        XCTAssertEqual(reads.count, 3)
+        CFSocketInvalidate(second.socket)
+        close(second.peer)
+#endif
+    }
 }
@@ -256,6 +256,29 @@ class TestTimeZone: XCTestCase {
         XCTAssertEqual(aest.nextDaylightSavingTimeTransition(after: dt2)?.description, "2018-10-06 16:00:00 +0000")
     }
 
+    func test_repeatedCreation() throws {
+        let identifiers = ["America/New_York", "Europe/London", "Asia/Tokyo", "Australia/Sydney", "AST"]
+        let expected = try identifiers.map { try TimeZone(identifier: $0).unwrapped() }
+        let date = Date(timeIntervalSinceReferenceDate: 567_000_000)
+
+        // Zones created again, from any thread, are indistinguishable from the first ones
+        var mismatches = [Int](repeating: 0, count: identifiers.count)
+        let lock = NSLock()
+        DispatchQueue.concurrentPerform(iterations: 200) { iteration in
+            let index = iteration % identifiers.count
+            let tz = TimeZone(identifier: identifiers[index])
+            if tz != expected[index] || tz?.secondsFromGMT(for: date) != expected[index].secondsFromGMT(for: date) || tz?.abbreviation(for: date) != expected[index].abbreviation(for: date) {
+                lock.lock()
+                mismatches[index] += 1
+                lock.unlock()
+            }
+        }
+        XCTAssertEqual(mismatches, [Int](repeating: 0, count: identifiers.count))
+        XCTAssertEqual(expected[4].identifier, "America/Halifax")
+        XCTAssertNil(TimeZone(identifier: "Foundation/NoSuchZone"))
+        XCTAssertNil(TimeZone(identifier: "Foundation/NoSuchZone"))
+    }
+
     static var allTests: [(String, (TestTimeZone) -> () throws -> Void)] {
         var tests: [(String, (TestTimeZone) -> () throws -> Void)] = [
             ("test_abbreviation", test_abbreviation),
@@ -275,6 +298,7 @@ class TestTimeZone: XCTestCase {
             ("test_systemTimeZoneName", test_systemTimeZoneName),
             ("test_autoupdatingTimeZone", test_autoupdatingTimeZone),
             ("test_nextDaylightSavingTimeTransition", test_nextDaylightSavingTimeTransition),
+            ("test_repeatedCreation", test_repeatedCreation),
         ]
         
         #if !os(Windows)
@@ -14,6 +14,7 @@ class TestTimer : XCTestCase {
             ("test_timerTickOnce", test_timerTickOnce),
             ("test_timerRepeats", test_timerRepeats),
             ("test_timerInvalidate", test_timerInvalidate),
+            ("test_manyTimersRescheduled", test_manyTimersRescheduled),
         ]
     }
     
@@ -95,4 +96,31 @@ class TestTimer : XCTestCase {
         XCTAssertTrue(flag)
     }
 
+    func test_manyTimersRescheduled() {
+        let count = 1000
+        let start = Date()
+        var fired: [Int] = []
+
+        // Schedule everything far in the future, then pull each timer in to a distinct slot, in an order unrelated to the slots
+        let timers = (0..<count).map { index in
+            Timer(fire: start.addingTimeInterval(3600), interval: 0, repeats: false) { _ in fired.append(index) }
+        }
+        let runLoop = RunLoop.current
+        for timer in timers {
+            runLoop.add(timer, forMode: .default)
+        }
+        for index in 0..<count {
+            let slot = (index * 7919) % count
+            timers[index].fireDate = start.addingTimeInterval(3600 - Double(index))
+            timers[index].fireDate = start.addingTimeInterval(0.05 + Double(slot) * 0.0001)
+        }
+        for index in stride(from: 0, to: count, by: 10) {
+            timers[index].invalidate()
+        }
+
+        runLoop.run(until: start.addingTimeInterval(0.5))
+
+        let expected = (0..<count).filter { $0 % 10 != 0 }.sorted { ($0 * 7919) % count < ($1 * 7919) % count }
+        XCTAssertEqual(fired, expected)
+    }
 }
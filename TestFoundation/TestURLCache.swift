@@ -0,0 +1,186 @@
+// This source file is part of the Swift.org open source project
+//
+// Copyright (c) 2019 Apple Inc. and the Swift project authors
+// Licensed under Apache License v2.0 with Runtime Library Exception
+//
+// See http://swift.org/LICENSE.txt for license information
+// See http://swift.org/CONTRIBUTORS.txt for the list of Swift project authors
+//
+
+class TestURLCache : XCTestCase {
+
+    static var allTests: [(String, (TestURLCache) -> () throws -> Void)] {
+        return [
+            ("test_storeAndRetrieveFromMemory", test_storeAndRetrieveFromMemory),
+            ("test_memoryEvictionIsLeastRecentlyUsed", test_memoryEvictionIsLeastRecentlyUsed),
+            ("test_diskPersistsAcrossInstances", test_diskPersistsAcrossInstances),
+            ("test_diskUsageStaysWithinCapacity", test_diskUsageStaysWithinCapacity),
+            ("test_removeCachedResponses", test_removeCachedResponses),
+            ("test_cachesSharingADiskPath", test_cachesSharingADiskPath),
+        ]
+    }
+
+    private var diskPath: String!
+
+    override func setUp() {
+        super.setUp()
+        diskPath = URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent(ProcessInfo.processInfo.globallyUniqueString).path
+    }
+
+    override func tearDown() {
+        try? FileManager.default.removeItem(atPath: diskPath)
+        super.tearDown()
+    }
+
+    private func cachedResponse(_ urlString: String, bodySize: Int = 16, headerFields: [String: String]? = nil) throws -> (CachedURLResponse, URLRequest) {
+        let url = try URL(string: urlString).unwrapped()
+        let response = try HTTPURLResponse(url: url, statusCode: 200, httpVersion: "HTTP/1.1", headerFields: headerFields).unwrapped()
+        let data = Data((0..<bodySize).map { UInt8(truncatingIfNeeded: $0) })
+        return (CachedURLResponse(response: response, data: data), URLRequest(url: url))
+    }
+
+    func test_storeAndRetrieveFromMemory() throws {
+        let cache = URLCache(memoryCapacity: 1024 * 1024, diskCapacity: 0, diskPath: nil)
+        let (cachedResponse, request) = try self.cachedResponse("http://example.com/a")
+
+        XCTAssertNil(cache.cachedResponse(for: request))
+        cache.storeCachedResponse(cachedResponse, for: request)
+        XCTAssertEqual(cache.cachedResponse(for: request), cachedResponse)
+        XCTAssertGreaterThanOrEqual(cache.currentMemoryUsage, cachedResponse.data.count)
+        XCTAssertEqual(cache.currentDiskUsage, 0)
+
+        let notAllowed = CachedURLResponse(response: cachedResponse.response, data: cachedResponse.data, userInfo: nil, storagePolicy: .notAllowed)
+        let otherRequest = URLRequest(url: try URL(string: "http://example.com/b").unwrapped())
+        cache.storeCachedResponse(notAllowed, for: otherRequest)
+        XCTAssertNil(cache.cachedResponse(for: otherRequest))
+    }
+
+    func test_memoryEvictionIsLeastRecentlyUsed() throws {
+        let cache = URLCache(memoryCapacity: 300, diskCapacity: 0, diskPath: nil)
+        let (first, firstRequest) = try cachedResponse("http://example.com/1", bodySize: 100)
+        let (second, secondRequest) = try cachedResponse("http://example.com/2", bodySize: 100)
+        let (third, thirdRequest) = try cachedResponse("http://example.com/3", bodySize: 100)
+
+        cache.storeCachedResponse(first, for: firstRequest)
+        cache.storeCachedResponse(second, for: secondRequest)
+        // Touch the first entry so that the second becomes the least recently used
+        XCTAssertNotNil(cache.cachedResponse(for: firstRequest))
+        cache.storeCachedResponse(third, for: thirdRequest)
+
+        XCTAssertNotNil(cache.cachedResponse(for: firstRequest))
+        XCTAssertNil(cache.cachedResponse(for: secondRequest))
+        XCTAssertNotNil(cache.cachedResponse(for: thirdRequest))
+        XCTAssertLessThanOrEqual(cache.currentMemoryUsage, 300)
+
+        cache.memoryCapacity = 0
+        XCTAssertEqual(cache.currentMemoryUsage, 0)
+        XCTAssertNil(cache.cachedResponse(for: firstRequest))
+    }
+
+    func test_diskPersistsAcrossInstances() throws {
+        let headerFields = ["Content-Type": "text/plain; charset=utf-8", "Cache-Control": "max-age=60"]
+        let (cachedResponse, request) = try self.cachedResponse("http://example.com/persisted", bodySize: 1000, headerFields: headerFields)
+
+        let cache = URLCache(memoryCapacity: 0, diskCapacity: 1024 * 1024, diskPath: diskPath)
+        cache.storeCachedResponse(cachedResponse, for: request)
+        XCTAssertGreaterThan(cache.currentDiskUsage, cachedResponse.data.count)
+
+        let reopened = URLCache(memoryCapacity: 0, diskCapacity: 1024 * 1024, diskPath: diskPath)
+        let restored = try reopened.cachedResponse(for: request).unwrapped()
+        XCTAssertEqual(restored.data, cachedResponse.data)
+        XCTAssertEqual(restored.response.url, cachedResponse.response.url)
+        XCTAssertEqual(restored.response.mimeType, "text/plain")
+        let restoredResponse = try (restored.response as? HTTPURLResponse).unwrapped()
+        XCTAssertEqual(restoredResponse.statusCode, 200)
+        XCTAssertEqual(restoredResponse.allHeaderFields["Cache-Control"] as? String, "max-age=60")
+
+        // In-memory-only responses must not reach the disk
+        let (memoryOnly, memoryOnlyRequest) = try self.cachedResponse("http://example.com/memory-only")
+        cache.storeCachedResponse(CachedURLResponse(response: memoryOnly.response, data: memoryOnly.data, userInfo: nil, storagePolicy: .allowedInMemoryOnly), for: memoryOnlyRequest)
+        XCTAssertNil(URLCache(memoryCapacity: 0, diskCapacity: 1024 * 1024, diskPath: diskPath).cachedResponse(for: memoryOnlyRequest))
+    }
+
+    func test_diskUsageStaysWithinCapacity() throws {
+        let capacity = 64 * 1024
+        let cache = URLCache(memoryCapacity: 0, diskCapacity: capacity, diskPath: diskPath)
+        for index in 0..<100 {
+            let (cachedResponse, request) = try self.cachedResponse("http://example.com/\(index)", bodySize: 2048)
+            cache.storeCachedResponse(cachedResponse, for: request)
+            XCTAssertLessThanOrEqual(cache.currentDiskUsage, capacity)
+        }
+        // The most recently stored responses survive compaction
+        let (latest, latestRequest) = try cachedResponse("http://example.com/99", bodySize: 2048)
+        XCTAssertEqual(cache.cachedResponse(for: latestRequest)?.data, latest.data)
+        XCTAssertNil(cache.cachedResponse(for: try cachedResponse("http://example.com/0").1))
+
+        // Responses over 5% of the disk capacity are not written to disk
+        let (large, largeRequest) = try cachedResponse("http://example.com/large", bodySize: capacity / 10)
+        cache.storeCachedResponse(large, for: largeRequest)
+        XCTAssertNil(cache.cachedResponse(for: largeRequest))
+    }
+
+    func test_removeCachedResponses() throws {
+        let cache = URLCache(memoryCapacity: 1024 * 1024, diskCapacity: 1024 * 1024, diskPath: diskPath)
+        let (old, oldRequest) = try cachedResponse("http://example.com/old")
+        let (new, newRequest) = try cachedResponse("http://example.com/new")
+        let (removed, removedRequest) = try cachedResponse("http://example.com/removed")
+
+        cache.storeCachedResponse(old, for: oldRequest)
+        cache.storeCachedResponse(removed, for: removedRequest)
+        let boundary = Date()
+        Thread.sleep(forTimeInterval: 0.01)
+        cache.storeCachedResponse(new, for: newRequest)
+
+        cache.removeCachedResponse(for: removedRequest)
+        XCTAssertNil(cache.cachedResponse(for: removedRequest))
+
+        cache.removeCachedResponses(since: boundary)
+        XCTAssertNotNil(cache.cachedResponse(for: oldRequest))
+        XCTAssertNil(cache.cachedResponse(for: newRequest))
+        XCTAssertNil(URLCache(memoryCapacity: 0, diskCapacity: 1024 * 1024, diskPath: diskPath).cachedResponse(for: newRequest))
+
+        cache.removeAllCachedResponses()
+        XCTAssertNil(cache.cachedResponse(for: oldRequest))
+        XCTAssertEqual(cache.currentMemoryUsage, 0)
+        XCTAssertEqual(cache.currentDiskUsage, 0)
+    }
+
+    func test_cachesSharingADiskPath() throws {
+        func response(_ name: String, fill: UInt8) throws -> (CachedURLResponse, URLRequest) {
+            let url = try URL(string: "http://example.com/\(name)").unwrapped()
+            let response = try HTTPURLResponse(url: url, statusCode: 200, httpVersion: "HTTP/1.1", headerFields: nil).unwrapped()
+            return (CachedURLResponse(response: response, data: Data(repeating: fill, count: 2048)), URLRequest(url: url))
+        }
+
+        let capacity = 64 * 1024
+        let first = URLCache(memoryCapacity: 0, diskCapacity: capacity, diskPath: diskPath)
+        for index in 0..<10 {
+            let (cachedResponse, request) = try response("first/\(index)", fill: UInt8(index))
+            first.storeCachedResponse(cachedResponse, for: request)
+        }
+
+        // The second cache compacts the shared data file several times,
+        // moving or dropping the records the first one's index points at
+        let second = URLCache(memoryCapacity: 0, diskCapacity: capacity, diskPath: diskPath)
+        for index in 0..<100 {
+            let (cachedResponse, request) = try response("second/\(index)", fill: UInt8(100 + index))
+            second.storeCachedResponse(cachedResponse, for: request)
+        }
+
+        // Stale index entries must read as misses, never as another record's bytes
+        for index in 0..<10 {
+            let (expected, request) = try response("first/\(index)", fill: UInt8(index))
+            if let cached = first.cachedResponse(for: request) {
+                XCTAssertEqual(cached.data, expected.data, "first/\(index)")
+            }
+        }
+        let (latest, latestRequest) = try response("second/99", fill: 199)
+        XCTAssertEqual(second.cachedResponse(for: latestRequest)?.data, latest.data)
+
+        // Both can still store and read back after the other has rewritten the files
+        let (stored, storedRequest) = try response("first/new", fill: 42)
+        first.storeCachedResponse(stored, for: storedRequest)
+        XCTAssertEqual(first.cachedResponse(for: storedRequest)?.data, stored.data)
+        XCTAssertEqual(second.cachedResponse(for: latestRequest)?.data, latest.data)
+    }
+}
@@ -15,6 +15,7 @@ class TestURLSession : LoopbackServerTest {
             ("test_dataTaskWithURLRequest", test_dataTaskWithURLRequest),
             ("test_dataTaskWithURLCompletionHandler", test_dataTaskWithURLCompletionHandler),
             ("test_dataTaskWithURLRequestCompletionHandler", test_dataTaskWithURLRequestCompletionHandler),
+            ("test_dataTaskWithCachedResponse", test_dataTaskWithCachedResponse),
             // ("test_dataTaskWithHttpInputStream", test_dataTaskWithHttpInputStream), - Flaky test
             ("test_gzippedDataTask", test_gzippedDataTask),
             ("test_downloadTaskWithURL", test_downloadTaskWithURL),
@@ -22,6 +23,7 @@ class TestURLSession : LoopbackServerTest {
             ("test_downloadTaskWithRequestAndHandler", test_downloadTaskWithRequestAndHandler),
             ("test_downloadTaskWithURLAndHandler", test_downloadTaskWithURLAndHandler),
             ("test_gzippedDownloadTask", test_gzippedDownloadTask),
+            ("test_largeBody", test_largeBody),
             ("test_finishTaskAndInvalidate", test_finishTasksAndInvalidate),
             ("test_taskError", test_taskError),
             ("test_taskCopy", test_taskCopy),
@@ -41,6 +43,8 @@ class TestURLSession : LoopbackServerTest {
             ("test_dataTaskWithSharedDelegate", test_dataTaskWithSharedDelegate),
             // ("test_simpleUploadWithDelegate", test_simpleUploadWithDelegate), - Server needs modification
             ("test_concurrentRequests", test_concurrentRequests),
+            ("test_manyRequestsOnOneSession", test_manyRequestsOnOneSession),
+            ("test_concurrentRequestsWithConnectionLimit", test_concurrentRequestsWithConnectionLimit),
             ("test_disableCookiesStorage", test_disableCookiesStorage),
             ("test_cookiesStorage", test_cookiesStorage),
             ("test_cookieStorageForEphmeralConfiguration", test_cookieStorageForEphmeralConfiguration),
@@ -132,6 +136,42 @@ class TestURLSession : LoopbackServerTest {
         task.resume()
         waitForExpectations(timeout: 12)
     }
+
+    func test_dataTaskWithCachedResponse() {
+        let urlString = "http://127.0.0.1:\(TestURLSession.serverPort)/USA"
+        let cache = URLCache(memoryCapacity: 1024 * 1024, diskCapacity: 0, diskPath: nil)
+        let config = URLSessionConfiguration.default
+        config.timeoutIntervalForRequest = 8
+        config.urlCache = cache
+        let session = URLSession(configuration: config, delegate: nil, delegateQueue: nil)
+        var cacheOnlyRequest = URLRequest(url: URL(string: urlString)!)
+        cacheOnlyRequest.cachePolicy = .returnCacheDataDontLoad
+
+        // Nothing has been cached yet, so a cache-only request must fail
+        var expect = expectation(description: "GET \(urlString): cache only, before loading")
+        session.dataTask(with: cacheOnlyRequest) { data, response, error in
+            defer { expect.fulfill() }
+            XCTAssertEqual((error as? URLError)?.code, .resourceUnavailable)
+        }.resume()
+        waitForExpectations(timeout: 12)
+
+        expect = expectation(description: "GET \(urlString): load and cache")
+        session.dataTask(with: URLRequest(url: URL(string: urlString)!)) { data, response, error in
+            defer { expect.fulfill() }
+            XCTAssertNil(error)
+        }.resume()
+        waitForExpectations(timeout: 12)
+        XCTAssertNotNil(cache.cachedResponse(for: URLRequest(url: URL(string: urlString)!)))
+
+        expect = expectation(description: "GET \(urlString): cache only, after loading")
+        session.dataTask(with: cacheOnlyRequest) { data, response, error in
+            defer { expect.fulfill() }
+            XCTAssertNil(error)
+            XCTAssertEqual((response as? HTTPURLResponse)?.statusCode, 200)
+            XCTAssertEqual(data.flatMap { String(data: $0, encoding: .utf8) }, "Washington, D.C.")
+        }.resume()
+        waitForExpectations(timeout: 12)
+    }
     
     func test_dataTaskWithHttpInputStream() {
         let urlString = "http://127.0.0.1:\(TestURLSession.serverPort)/echo"
@@ -261,6 +301,33 @@ class TestURLSession : LoopbackServerTest {
         }
     }
 
+    func test_largeBody() {
+        // The body arrives from libcurl in many chunks, which have to end up
+        // intact in the completion handler's Data and in the downloaded file
+        let urlString = "http://127.0.0.1:\(TestURLSession.serverPort)/largeBody"
+        let url = URL(string: urlString)!
+        let expectedBody = Data((0..<(2 * 1024 * 1024)).map { UInt8(truncatingIfNeeded: $0 % 251) })
+
+        let config = URLSessionConfiguration.default
+        config.timeoutIntervalForRequest = 8
+        let session = URLSession(configuration: config, delegate: nil, delegateQueue: nil)
+        let dataExpectation = expectation(description: "GET \(urlString): with a completion handler")
+        session.dataTask(with: url) { data, _, error in
+            XCTAssertNil(error)
+            XCTAssertEqual(data?.count, expectedBody.count)
+            XCTAssertTrue(data == expectedBody, "Received body does not match what the server sent")
+            dataExpectation.fulfill()
+        }.resume()
+
+        let d = DownloadTask(with: expectation(description: "Download GET \(urlString): with a delegate"))
+        d.run(with: url)
+        waitForExpectations(timeout: 30)
+        XCTAssertEqual(d.totalBytesWritten, Int64(expectedBody.count))
+        XCTAssertEqual(d.downloadedData?.count, expectedBody.count)
+        XCTAssertTrue(d.downloadedData == expectedBody, "Downloaded file does not match what the server sent")
+        session.finishTasksAndInvalidate()
+    }
+
     func test_finishTasksAndInvalidate() {
         let urlString = "http://127.0.0.1:\(TestURLSession.serverPort)/Nepal"
         let invalidateExpectation = expectation(description: "Session invalidation")
@@ -618,6 +685,62 @@ class TestURLSession : LoopbackServerTest {
         }
     }
 
+    func test_manyRequestsOnOneSession() {
+        // Back-to-back requests reuse the session's connection, so the same
+        // socket is registered and unregistered for reading and writing many times over
+        let config = URLSessionConfiguration.default
+        config.timeoutIntervalForRequest = 8
+        let session = URLSession(configuration: config, delegate: nil, delegateQueue: nil)
+        let url = URL(string: "http://127.0.0.1:\(TestURLSession.serverPort)/USA")!
+        let requests = 100
+        var completed = 0
+        let done = expectation(description: "\(requests) sequential GETs of \(url)")
+
+        func request() {
+            session.dataTask(with: url) { data, response, error in
+                XCTAssertNil(error)
+                XCTAssertEqual((response as? HTTPURLResponse)?.statusCode, 200)
+                XCTAssertEqual(data.flatMap { String(data: $0, encoding: .utf8) }, "Washington, D.C.")
+                completed += 1
+                if completed == requests || error != nil {
+                    done.fulfill()
+                } else {
+                    request()
+                }
+            }.resume()
+        }
+        request()
+        waitForExpectations(timeout: 60)
+        XCTAssertEqual(completed, requests)
+        session.finishTasksAndInvalidate()
+    }
+
+    func test_concurrentRequestsWithConnectionLimit() {
+        // Requests over the per host limit are queued rather than failed, and
+        // a second session using the shared DNS/TLS caches still gets its own connections
+        let url = URL(string: "http://127.0.0.1:\(TestURLSession.serverPort)/Peru")!
+        let requestsPerSession = 20
+        var sessions: [URLSession] = []
+        for _ in 0..<2 {
+            let config = URLSessionConfiguration.default
+            config.timeoutIntervalForRequest = 8
+            config.httpMaximumConnectionsPerHost = 1
+            let session = URLSession(configuration: config, delegate: nil, delegateQueue: nil)
+            sessions.append(session)
+            for index in 0..<requestsPerSession {
+                let done = expectation(description: "GET \(url) [\(index)] with one connection per host")
+                session.dataTask(with: url) { data, response, error in
+                    XCTAssertNil(error)
+                    XCTAssertEqual((response as? HTTPURLResponse)?.statusCode, 200)
+                    XCTAssertEqual(data.flatMap { String(data: $0, encoding: .utf8) }, "Lima")
+                    done.fulfill()
+                }.resume()
+            }
+        }
+        waitForExpectations(timeout: 60)
+        sessions.forEach { $0.finishTasksAndInvalidate() }
+    }
+
     func test_disableCookiesStorage() {
         let config = URLSessionConfiguration.default
         config.timeoutIntervalForRequest = 5
@@ -1129,6 +1252,7 @@ extension DataTask : URLSessionTaskDelegate {
 
 class DownloadTask : NSObject {
     var totalBytesWritten: Int64 = 0
+    var downloadedData: Data? = nil
     let dwdExpectation: XCTestExpectation!
     var session: URLSession! = nil
     var task: URLSessionDownloadTask! = nil
@@ -1168,6 +1292,8 @@ extension DownloadTask : URLSessionDownloadDelegate {
         } catch {
             XCTFail("Unable to calculate size of the downloaded file")
         }
+        // The file is removed once this returns
+        downloadedData = try? Data(contentsOf: location)
         dwdExpectation.fulfill()
     }
 }
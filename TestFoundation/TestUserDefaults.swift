@@ -32,6 +32,8 @@ class TestUserDefaults : XCTestCase {
 			("test_setValue_DoubleFromString", test_setValue_DoubleFromString ),
 			("test_volatileDomains", test_volatileDomains),
 			("test_persistentDomain", test_persistentDomain ),
+			("test_synchronizeLargeDomain", test_synchronizeLargeDomain ),
+			("test_journaledDomainIsReadByAnotherProcess", test_journaledDomainIsReadByAnotherProcess ),
 		]
 	}
 
@@ -343,4 +345,66 @@ class TestUserDefaults : XCTestCase {
 		
 		NotificationCenter.default.removeObserver(observer)
 	}
+
+	func test_synchronizeLargeDomain() {
+		let domainName = "org.swift.Foundation.TestSynchronizeLargeDomain"
+		let defaults = UserDefaults(suiteName: domainName)!
+		defaults.removePersistentDomain(forName: domainName)
+		defer { defaults.removePersistentDomain(forName: domainName) }
+
+		for index in 0..<10_000 {
+			defaults.set(index, forKey: "Key \(index)")
+		}
+		XCTAssertTrue(defaults.synchronize())
+
+		// Each of these only changes a couple of keys; enough of them that the changes outgrow the domain they apply to
+		let padding = String(repeating: "x", count: 256)
+		for round in 0..<500 {
+			defaults.set("\(round) \(padding)", forKey: "Key \(round)")
+			defaults.removeObject(forKey: "Key \(9_999 - round)")
+			XCTAssertTrue(defaults.synchronize())
+		}
+
+		let returned = defaults.persistentDomain(forName: domainName)
+		XCTAssertEqual(returned?.count, 9_500)
+		XCTAssertEqual(returned?["Key 0"] as? String, "0 \(padding)")
+		XCTAssertEqual(returned?["Key 499"] as? String, "499 \(padding)")
+		XCTAssertEqual(returned?["Key 500"] as? Int, 500)
+		XCTAssertNil(returned?["Key 9999"])
+		XCTAssertEqual(defaults.integer(forKey: "Key 9499"), 9_499)
+	}
+
+	func test_journaledDomainIsReadByAnotherProcess() throws {
+#if !os(Android)
+		let domainName = "org.swift.Foundation.TestJournaledDomain"
+		let defaults = UserDefaults(suiteName: domainName)!
+		defaults.removePersistentDomain(forName: domainName)
+		defer { defaults.removePersistentDomain(forName: domainName) }
+
+		for index in 0..<1_000 {
+			defaults.set(index, forKey: "Key \(index)")
+		}
+		XCTAssertTrue(defaults.synchronize())
+
+		// Small changes like these are appended to the domain's journal rather than rewriting its file
+		for round in 0..<10 {
+			defaults.set("changed \(round)", forKey: "Key \(round)")
+			defaults.removeObject(forKey: "Key \(999 - round)")
+			XCTAssertTrue(defaults.synchronize())
+		}
+
+		// A fresh process has nothing cached, so it only sees the changes if it replays the journal over the file
+		let (output, _) = try runTask([xdgTestHelperURL().path, "--print-defaults", domainName, "Key 0", "Key 9", "Key 10", "Key 990", "Key 989"])
+		XCTAssertEqual(output, "990\nchanged 0\nchanged 9\n10\nnil\n989\n")
+
+		// Emptying the domain removes its file along with its journal, so nothing is replayed into a new domain of the same name
+		defaults.removePersistentDomain(forName: domainName)
+		XCTAssertTrue(defaults.synchronize())
+		defaults.set("new", forKey: "Key 0")
+		XCTAssertTrue(defaults.synchronize())
+		let (newOutput, _) = try runTask([xdgTestHelperURL().path, "--print-defaults", domainName, "Key 0", "Key 1"])
+		XCTAssertEqual(newOutput, "1\nnew\nnil\n")
+#endif
+	}
 }
+
@@ -205,6 +205,36 @@ func cat(_ args: ArraySlice<String>.Iterator) {
     exit(exitCode)
 }
 
+// Used by TestNSString: test_seededHashIsConsistentAcrossRepresentations()
+// Prints one line per argument with the hashes of different NSString representations of it
+func printStringHashes(_ args: ArraySlice<String>.Iterator) {
+    var args = args
+    while let string = args.next() {
+        let characters = Array(string.utf16)
+        let hashes = [
+            NSString(string: string).hash,
+            NSMutableString(string: string).hash,
+            NSString(characters: characters, length: characters.count).hash,
+            string.withCString { NSString(utf8String: $0)!.hash },
+        ]
+        print(hashes.map { String($0) }.joined(separator: " "))
+    }
+}
+
+// Used by TestUserDefaults: test_journaledDomainIsReadByAnotherProcess()
+// Prints the number of keys in a persistent domain, then one line with the value of each key asked for
+func printDefaults(_ args: ArraySlice<String>.Iterator) {
+    var args = args
+    guard let domainName = args.next() else {
+        fatalError("--print-defaults requires a domain name")
+    }
+    let domain = UserDefaults.standard.persistentDomain(forName: domainName) ?? [:]
+    print(domain.count)
+    while let key = args.next() {
+        print(domain[key].map { String(describing: $0) } ?? "nil")
+    }
+}
+
 // -----
 
 var arguments = ProcessInfo.processInfo.arguments.dropFirst().makeIterator()
@@ -229,6 +259,12 @@ case "--env":
 case "--cat":
     cat(arguments)
 
+case "--string-hashes":
+    printStringHashes(arguments)
+
+case "--print-defaults":
+    printDefaults(arguments)
+
 case "--exit":
     let code = Int32(arguments.next() ?? "0") ?? 0
     exit(code)